@@ -127,8 +127,9 @@ The in progress writes must error when the port is closed with an error object t
 
   /**
    * Changes connection settings on an open port. Only `baudRate` is supported.
-   * @param {object=} options Only supports `baudRate`.
+   * @param {object=} options Only supports `baudRate` and `flush`.
    * @param {number=} [options.baudRate] If provided a baud rate that the bindings do not support, it should reject.
+   * @param {boolean=} [options.flush=true] Whether to throw away unread and unsent data when the baud rate changes, bindings that can't keep it may ignore `false`.
    * @returns {Promise} Resolves once the port's baud rate changes.
    * @rejects {TypeError} When given invalid arguments, a `TypeError` is rejected.
    */
@@ -193,6 +194,18 @@ The in progress writes must error when the port is closed with an error object t
     }
   }
 
+  /**
+   * Get the number of bytes waiting in the OS input and output queues of the open port. The output queue is data that was written but not transmitted yet.
+   * @returns {Promise} Resolves with `{ input, output }` byte counts.
+   * @rejects {TypeError} When given invalid arguments, a `TypeError` is rejected.
+   */
+  async getQueueSizes() {
+    debug('getQueueSizes')
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+  }
+
   /**
    * Flush (discard) data received but not read, and written but not transmitted.
    * @returns {Promise} Resolves once the flush operation finishes.
@@ -0,0 +1,118 @@
+const INITIAL_CAPACITY = 16
+
+/**
+ * A ring of buffers waiting to be read. Pushing keeps a reference instead of copying and reading copies straight into the reader's buffer, so neither gets slower as the queue grows. Each chunk can carry the time its first byte arrives, bytes of a chunk then arrive one every `charMs`.
+ */
+class ChunkQueue {
+  constructor() {
+    this.chunks = new Array(INITIAL_CAPACITY)
+    this.times = new Float64Array(INITIAL_CAPACITY)
+    this.head = 0
+    this.count = 0
+    // bytes of the head chunk that were already read
+    this.offset = 0
+    this.length = 0
+  }
+
+  grow() {
+    const capacity = this.chunks.length * 2
+    const chunks = new Array(capacity)
+    const times = new Float64Array(capacity)
+    for (let i = 0; i < this.count; i++) {
+      const slot = (this.head + i) & (this.chunks.length - 1)
+      chunks[i] = this.chunks[slot]
+      times[i] = this.times[slot]
+    }
+    this.chunks = chunks
+    this.times = times
+    this.head = 0
+  }
+
+  /**
+   * @param {Buffer} chunk kept as is, it must not change until it's read
+   * @param {number} [arrivesAt=0] when the first byte of the chunk arrives
+   */
+  push(chunk, arrivesAt = 0) {
+    if (chunk.length === 0) {
+      return
+    }
+    if (this.count === this.chunks.length) {
+      this.grow()
+    }
+    const slot = (this.head + this.count) & (this.chunks.length - 1)
+    this.chunks[slot] = chunk
+    this.times[slot] = arrivesAt
+    this.count++
+    this.length += chunk.length
+  }
+
+  /**
+   * Bytes that can be read at `now`
+   * @param {number} [now=0]
+   * @param {number} [charMs=0] time each byte takes to arrive, `0` to have every chunk arrive at once
+   */
+  available(now = 0, charMs = 0) {
+    if (!(charMs > 0)) {
+      return this.length
+    }
+    const mask = this.chunks.length - 1
+    let total = 0
+    for (let i = 0; i < this.count; i++) {
+      const slot = (this.head + i) & mask
+      const chunk = this.chunks[slot]
+      const skipped = i === 0 ? this.offset : 0
+      const arrived = Math.min(chunk.length, Math.floor((now - this.times[slot]) / charMs))
+      if (arrived > skipped) {
+        total += arrived - skipped
+      }
+      if (arrived < chunk.length) {
+        break
+      }
+    }
+    return total
+  }
+
+  /**
+   * When the next unread byte arrives, `Infinity` if the queue is empty
+   * @param {number} charMs
+   */
+  nextArrival(charMs) {
+    if (this.count === 0) {
+      return Infinity
+    }
+    return this.times[this.head] + (this.offset + 1) * charMs
+  }
+
+  /**
+   * Copies up to `length` bytes into `buffer` and drops them from the queue
+   * @returns {number} bytes read
+   */
+  read(buffer, offset, length) {
+    let bytesRead = 0
+    while (bytesRead < length && this.count > 0) {
+      const chunk = this.chunks[this.head]
+      const copied = chunk.copy(buffer, offset + bytesRead, this.offset, this.offset + length - bytesRead)
+      bytesRead += copied
+      this.offset += copied
+      if (this.offset === chunk.length) {
+        this.chunks[this.head] = undefined
+        this.head = (this.head + 1) & (this.chunks.length - 1)
+        this.count--
+        this.offset = 0
+      }
+    }
+    this.length -= bytesRead
+    return bytesRead
+  }
+
+  clear() {
+    this.chunks = new Array(INITIAL_CAPACITY)
+    this.times = new Float64Array(INITIAL_CAPACITY)
+    this.head = 0
+    this.count = 0
+    this.offset = 0
+    this.length = 0
+  }
+}
+
+module.exports = ChunkQueue
@@ -0,0 +1,60 @@
+const ChunkQueue = require('./chunk-queue')
+
+const readAll = (queue, length = queue.length) => {
+  const buffer = Buffer.alloc(length)
+  const bytesRead = queue.read(buffer, 0, length)
+  return buffer.slice(0, bytesRead).toString()
+}
+
+describe('ChunkQueue', () => {
+  it('reads across chunks', () => {
+    const queue = new ChunkQueue()
+    queue.push(Buffer.from('abc'))
+    queue.push(Buffer.from(''))
+    queue.push(Buffer.from('defg'))
+    assert.equal(queue.length, 7)
+    assert.equal(readAll(queue, 2), 'ab')
+    assert.equal(readAll(queue, 3), 'cde')
+    assert.equal(queue.length, 2)
+    assert.equal(readAll(queue, 10), 'fg')
+    assert.equal(queue.length, 0)
+    assert.equal(readAll(queue, 10), '')
+  })
+
+  it('grows past its initial capacity in order', () => {
+    const queue = new ChunkQueue()
+    let expected = ''
+    for (let i = 0; i < 100; i++) {
+      queue.push(Buffer.from(String(i % 10)))
+      expected += String(i % 10)
+      if (i === 10) {
+        expected = expected.slice(5)
+        assert.equal(readAll(queue, 5), '01234')
+      }
+    }
+    assert.equal(readAll(queue), expected)
+  })
+
+  it('releases bytes at the character time', () => {
+    const queue = new ChunkQueue()
+    queue.push(Buffer.from('abcd'), 100)
+    queue.push(Buffer.from('ef'), 104)
+    assert.equal(queue.available(100, 1), 0)
+    assert.equal(queue.nextArrival(1), 101)
+    assert.equal(queue.available(102.5, 1), 2)
+    assert.equal(readAll(queue, 2), 'ab')
+    assert.equal(queue.available(102.5, 1), 0)
+    assert.equal(queue.nextArrival(1), 103)
+    assert.equal(queue.available(105, 1), 3)
+    assert.equal(queue.available(200, 1), 4)
+    assert.equal(queue.available(0), 4)
+  })
+
+  it('clears', () => {
+    const queue = new ChunkQueue()
+    queue.push(Buffer.from('abc'))
+    queue.clear()
+    assert.equal(queue.length, 0)
+    assert.equal(queue.nextArrival(1), Infinity)
+  })
+})
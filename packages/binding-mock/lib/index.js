@@ -1,5 +1,7 @@
 const AbstractBinding = require('@serialport/binding-abstract')
 const debug = require('debug')('serialport/binding-mock')
+const ChunkQueue = require('./chunk-queue')
+const Simulation = require('./simulation')
 const { wrapWithHiddenComName } = require('./legacy')
 
 let ports = {}
@@ -9,6 +11,15 @@ function resolveNextTick(value) {
   return new Promise(resolve => process.nextTick(() => resolve(value)))
 }
 
+const delay = ms => new Promise(resolve => setTimeout(resolve, ms))
+
+// at full speed stop and let the reader catch up once this much is waiting
+const REPLAY_HIGH_WATER = 64 * 1024
+
+// ms a character takes on the wire, start and stop bits included
+const charMs = ({ baudRate, dataBits = 8, parity = 'none', stopBits = 1 }) =>
+  ((1 + dataBits + (parity === 'none' ? 0 : 1) + stopBits) * 1000) / baudRate
+
 const cancelError = message => {
   const err = new Error(message)
   err.canceled = true
@@ -25,8 +36,23 @@ class MockBinding extends AbstractBinding {
     this.isOpen = false
     this.port = null
     this.lastWrite = null
-    this.recording = Buffer.alloc(0)
+    this.recordingChunks = []
     this.writeOperation = null // in flight promise or null
+    this.readTimer = null
+  }
+
+  /**
+   * Everything written while the port's `record` option was on
+   */
+  get recording() {
+    if (this.recordingChunks.length !== 1) {
+      this.recordingChunks = [Buffer.concat(this.recordingChunks)]
+    }
+    return this.recordingChunks[0]
+  }
+
+  set recording(buffer) {
+    this.recordingChunks = [buffer]
   }
 
   // Reset mocks
@@ -42,6 +68,8 @@ class MockBinding extends AbstractBinding {
       echo: false,
       record: false,
       readyData: Buffer.from('READY'),
+      baudTiming: false,
+      device: null,
       manufacturer: 'The J5 Robotics Company',
       vendorId: undefined,
       productId: undefined,
@@ -49,9 +77,15 @@ class MockBinding extends AbstractBinding {
     }
 
     ports[path] = {
-      data: Buffer.alloc(0),
+      received: new ChunkQueue(),
       echo: opt.echo,
       record: opt.record,
+      baudTiming: opt.baudTiming,
+      // sees every write, see Simulation
+      device: opt.device,
+      // when the last byte queued in each direction is done, with baudTiming
+      rxFreeAt: 0,
+      txFreeAt: 0,
       readyData: Buffer.from(opt.readyData),
       info: {
         path,
@@ -63,7 +97,7 @@ class MockBinding extends AbstractBinding {
         productId: opt.productId,
       },
     }
-    debug(serialNumber, 'created port', JSON.stringify({ path, opt }))
+    debug(serialNumber, 'created port', JSON.stringify({ path, opt: { ...opt, device: Boolean(opt.device) } }))
   }
 
   static async list() {
@@ -75,17 +109,83 @@ class MockBinding extends AbstractBinding {
     if (!this.isOpen) {
       throw new Error('Port must be open to pretend to receive data')
     }
-    if (!Buffer.isBuffer(data)) {
-      data = Buffer.from(data)
+    this.receive(Buffer.from(data))
+  }
+
+  // ms per character with baudTiming, otherwise 0 and everything arrives at once
+  get charMs() {
+    const opt = this.port && this.port.openOpt
+    return this.port.baudTiming && opt && opt.baudRate > 0 ? charMs(opt) : 0
+  }
+
+  // queues `data` without copying it, with baudTiming the bytes arrive one character time apart after anything received before
+  receive(data, startAt = Date.now()) {
+    const port = this.port
+    let arrivesAt = 0
+    if (this.charMs) {
+      arrivesAt = Math.max(startAt, port.rxFreeAt)
+      port.rxFreeAt = arrivesAt + data.length * this.charMs
     }
     debug(this.serialNumber, 'emitting data - pending read:', Boolean(this.pendingRead))
-    this.port.data = Buffer.concat([this.port.data, data])
+    port.received.push(data, arrivesAt)
     if (this.pendingRead) {
-      process.nextTick(this.pendingRead)
-      this.pendingRead = null
+      this.wakeRead()
     }
   }
 
+  wakeRead(err) {
+    const pendingRead = this.pendingRead
+    this.pendingRead = null
+    clearTimeout(this.readTimer)
+    this.readTimer = null
+    process.nextTick(pendingRead, err)
+  }
+
+  /**
+   * Plays the received data of a capture into the port as if it arrived on the wire, written data in the capture is ignored
+   * @param {Iterable<object>} records `{ direction, portId, timestamp, data }` in timestamp order, like a `CaptureReader` from `@serialport/bindings/lib/capture`
+   * @param {object} [options]
+   * @param {number} [options.speed=1] `1` for the original timing, `2` for twice as fast, `Infinity` for as fast as the port is read
+   * @param {number} [options.portId] only replay this port's records, all of them by default
+   * @returns {Promise} Resolves with `{ records, bytes }` replayed once the capture is done or the port closed.
+   */
+  async replay(records, { speed = 1, portId } = {}) {
+    if (!this.isOpen) {
+      throw new Error('Port must be open to replay a capture')
+    }
+    if (!(speed > 0)) {
+      throw new TypeError('"speed" must be a positive number')
+    }
+    const startedAt = Date.now()
+    const replayed = { records: 0, bytes: 0 }
+    let firstTimestamp = null
+    for (const record of records) {
+      if (record.direction !== 'rx' || (portId !== undefined && record.portId !== portId)) {
+        continue
+      }
+      if (firstTimestamp === null) {
+        firstTimestamp = record.timestamp
+      }
+      if (speed !== Infinity) {
+        const wait = (record.timestamp - firstTimestamp) / speed - (Date.now() - startedAt)
+        if (wait > 0) {
+          await delay(wait)
+        }
+      } else if (this.port && this.port.received.length > REPLAY_HIGH_WATER) {
+        await new Promise(resolve => setImmediate(resolve))
+      }
+      if (!this.isOpen) {
+        break
+      }
+      // records aren't changed once read, no need to copy them
+      this.receive(Buffer.isBuffer(record.data) ? record.data : Buffer.from(record.data))
+      replayed.records++
+      replayed.bytes += record.data.length
+    }
+    debug(this.serialNumber, 'replayed', replayed.records, 'records')
+    return replayed
+  }
+
   async open(path, opt) {
     debug(null, `opening path ${path}`)
     const port = (this.port = ports[path])
@@ -127,24 +227,29 @@ class MockBinding extends AbstractBinding {
     await super.close()
     delete port.openOpt
     // reset data on close
-    port.data = Buffer.alloc(0)
+    port.received.clear()
+    port.rxFreeAt = 0
+    port.txFreeAt = 0
     debug(this.serialNumber, 'port is closed')
     delete this.port
     delete this.serialNumber
     this.isOpen = false
     if (this.pendingRead) {
-      this.pendingRead(cancelError('port is closed'))
+      this.wakeRead(cancelError('port is closed'))
     }
   }
 
   async read(buffer, offset, length) {
     debug(this.serialNumber, 'reading', length, 'bytes')
     await super.read(buffer, offset, length)
-    await resolveNextTick()
     if (!this.isOpen) {
       throw cancelError('Read canceled')
     }
-    if (this.port.data.length <= 0) {
+    const received = this.port.received
+    const charMs = this.charMs
+    const now = Date.now()
+    const available = received.available(now, charMs)
+    if (available <= 0) {
       return new Promise((resolve, reject) => {
         this.pendingRead = err => {
           if (err) {
@@ -152,11 +257,13 @@ class MockBinding extends AbstractBinding {
           }
           this.read(buffer, offset, length).then(resolve, reject)
         }
+        if (received.length > 0) {
+          // the bytes are still on the wire
+          this.readTimer = setTimeout(() => this.wakeRead(), Math.max(1, Math.ceil(received.nextArrival(charMs) - now)))
+        }
       })
     }
-    const data = this.port.data.slice(0, length)
-    const bytesRead = data.copy(buffer, offset)
-    this.port.data = this.port.data.slice(length)
+    const bytesRead = received.read(buffer, offset, Math.min(length, available))
     debug(this.serialNumber, 'read', bytesRead, 'bytes')
     return { bytesRead, buffer }
   }
@@ -171,17 +278,28 @@ class MockBinding extends AbstractBinding {
       if (!this.isOpen) {
         throw new Error('Write canceled')
       }
-      const data = (this.lastWrite = Buffer.from(buffer)) // copy
+      // the only copy, shared by lastWrite, the recording and the echo
+      const data = (this.lastWrite = Buffer.from(buffer))
       if (this.port.record) {
-        this.recording = Buffer.concat([this.recording, data])
+        this.recordingChunks.push(data)
+      }
+      if (this.port.device) {
+        this.port.device.write(data, this)
       }
+      const startAt = Date.now()
       if (this.port.echo) {
         process.nextTick(() => {
           if (this.isOpen) {
-            this.emitData(data)
+            this.receive(data, startAt)
           }
         })
       }
+      if (this.charMs) {
+        // done once the last byte is on the wire
+        const port = this.port
+        port.txFreeAt = Math.max(startAt, port.txFreeAt) + data.length * this.charMs
+        await delay(port.txFreeAt - startAt)
+      }
       this.writeOperation = null
       debug(this.serialNumber, 'writing finished')
     })
@@ -217,10 +335,21 @@ class MockBinding extends AbstractBinding {
     }
   }
 
+  // Nothing is ever waiting to be transmitted
+  async getQueueSizes() {
+    await super.getQueueSizes()
+    await resolveNextTick()
+    return {
+      input: this.port.received.available(Date.now(), this.charMs),
+      output: 0,
+    }
+  }
+
   async flush() {
     await super.flush()
     await resolveNextTick()
-    this.port.data = Buffer.alloc(0)
+    this.port.received.clear()
+    this.port.rxFreeAt = 0
   }
 
   async drain() {
@@ -230,4 +359,6 @@ class MockBinding extends AbstractBinding {
   }
 }
 
+MockBinding.Simulation = Simulation
+
 module.exports = MockBinding
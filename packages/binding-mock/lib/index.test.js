@@ -39,6 +39,113 @@ describe('BindingMock', () => {
         })
       })
     })
+
+    describe('write', () => {
+      afterEach(() => {
+        BindingMock.reset()
+      })
+
+      it('should record every write', async () => {
+        BindingMock.createPort('/dev/ttyUSB0', { record: true })
+        await binding.open('/dev/ttyUSB0', {})
+        await binding.write(Buffer.from('abc'))
+        await binding.write(Buffer.from('def'))
+        assert.deepEqual(binding.recording, Buffer.from('abcdef'))
+        await binding.write(Buffer.from('g'))
+        assert.deepEqual(binding.recording, Buffer.from('abcdefg'))
+      })
+
+      it('should echo the written data', async () => {
+        BindingMock.createPort('/dev/ttyUSB0', { echo: true, readyData: Buffer.alloc(0) })
+        await binding.open('/dev/ttyUSB0', {})
+        const data = Buffer.from('echo')
+        await binding.write(data)
+        data.fill(0)
+        const { bytesRead, buffer } = await binding.read(Buffer.alloc(10), 0, 10)
+        assert.equal(buffer.slice(0, bytesRead).toString(), 'echo')
+      })
+    })
+
+    describe('baudTiming', () => {
+      beforeEach(async () => {
+        BindingMock.createPort('/dev/ttyUSB0', { baudTiming: true })
+        // 1ms a character
+        await binding.open('/dev/ttyUSB0', { baudRate: 10000, dataBits: 8, parity: 'none', stopBits: 1 })
+      })
+
+      afterEach(() => {
+        BindingMock.reset()
+      })
+
+      it('should release received bytes at the baud rate', async () => {
+        const start = Date.now()
+        binding.emitData(Buffer.alloc(20))
+        let total = 0
+        while (total < 20) {
+          const { bytesRead } = await binding.read(Buffer.alloc(20), 0, 20)
+          total += bytesRead
+        }
+        assert.isAtLeast(Date.now() - start, 19)
+      })
+
+      it('should only report the bytes that arrived', async () => {
+        binding.emitData(Buffer.alloc(100))
+        const { input } = await binding.getQueueSizes()
+        assert.isBelow(input, 100)
+      })
+
+      it('should take the transmit time to write', async () => {
+        const start = Date.now()
+        await binding.write(Buffer.alloc(20))
+        assert.isAtLeast(Date.now() - start, 19)
+      })
+    })
+
+    describe('replay', () => {
+      const records = [
+        { direction: 'rx', portId: 0, timestamp: 100, data: Buffer.from('one') },
+        { direction: 'tx', portId: 0, timestamp: 110, data: Buffer.from('request') },
+        { direction: 'rx', portId: 1, timestamp: 115, data: Buffer.from('other') },
+        { direction: 'rx', portId: 0, timestamp: 130, data: Buffer.from('two') },
+      ]
+
+      beforeEach(async () => {
+        BindingMock.createPort('/dev/ttyUSB0')
+        await binding.open('/dev/ttyUSB0', {})
+      })
+
+      afterEach(() => {
+        BindingMock.reset()
+      })
+
+      it('should reject when the port is closed', async () => {
+        await binding.close()
+        await shouldReject(binding.replay(records))
+      })
+
+      it('should reject a bad speed', async () => {
+        await shouldReject(binding.replay(records, { speed: 0 }), TypeError)
+      })
+
+      it('should emit the received data of a port', async () => {
+        const replayed = await binding.replay(records, { speed: Infinity, portId: 0 })
+        assert.deepEqual(replayed, { records: 2, bytes: 6 })
+        const { bytesRead, buffer } = await binding.read(Buffer.alloc(10), 0, 10)
+        assert.equal(buffer.slice(0, bytesRead).toString(), 'onetwo')
+      })
+
+      it('should keep the time between records', async () => {
+        const start = Date.now()
+        await binding.replay(records, { portId: 0 })
+        assert.isAtLeast(Date.now() - start, 25)
+      })
+
+      it('should scale the timing', async () => {
+        const start = Date.now()
+        await binding.replay(records, { speed: 10 })
+        assert.isBelow(Date.now() - start, 25)
+      })
+    })
   })
 
   describe('static method', () => {
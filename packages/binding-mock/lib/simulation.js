@@ -0,0 +1,257 @@
+const debug = require('debug')('serialport/binding-mock/simulation')
+
+// bits on the wire per character, start bit included
+const charBits = ({ dataBits = 8, parity = 'none', stopBits = 1 }) => 1 + dataBits + (parity === 'none' ? 0 : 1) + stopBits
+
+const settle = () => new Promise(resolve => setImmediate(resolve))
+
+/**
+ * Events ordered by time and then by when they were scheduled, a binary heap so scheduling and running one costs O(log n) however many ports are simulated
+ */
+class EventQueue {
+  constructor() {
+    this.events = []
+    this.seq = 0
+  }
+
+  get size() {
+    return this.events.length
+  }
+
+  peek() {
+    return this.events[0]
+  }
+
+  static before(a, b) {
+    return a.at < b.at || (a.at === b.at && a.seq < b.seq)
+  }
+
+  push(at, fn, arg) {
+    const events = this.events
+    const event = { at, seq: this.seq++, fn, arg }
+    let i = events.length
+    events.push(event)
+    while (i > 0) {
+      const parent = (i - 1) >> 1
+      if (!EventQueue.before(event, events[parent])) {
+        break
+      }
+      events[i] = events[parent]
+      i = parent
+    }
+    events[i] = event
+    return event
+  }
+
+  pop() {
+    const events = this.events
+    const top = events[0]
+    const last = events.pop()
+    if (events.length > 0) {
+      let i = 0
+      for (;;) {
+        let child = 2 * i + 1
+        if (child >= events.length) {
+          break
+        }
+        if (child + 1 < events.length && EventQueue.before(events[child + 1], events[child])) {
+          child++
+        }
+        if (!EventQueue.before(events[child], last)) {
+          break
+        }
+        events[i] = events[child]
+        i = child
+      }
+      events[i] = last
+    }
+    return top
+  }
+}
+
+const findRequest = (pattern, pending) => {
+  if (Buffer.isBuffer(pattern)) {
+    const index = pending.indexOf(pattern)
+    return index === -1 ? null : { end: index + pattern.length, match: null }
+  }
+  if (pattern instanceof RegExp) {
+    const match = pattern.exec(pending.toString('latin1'))
+    return match ? { end: match.index + match[0].length, match } : null
+  }
+  const end = pattern(pending)
+  return end > 0 ? { end, match: null } : null
+}
+
+/**
+ * The state of one simulated device, the model is shared so each port only costs its unanswered request bytes
+ */
+class SimulatedDevice {
+  constructor(simulation, path, model) {
+    this.simulation = simulation
+    this.path = path
+    this.model = model
+    this.pending = null
+    // virtual time the device is done receiving and sending what's already on the wire
+    this.rxFreeAt = 0
+    this.txFreeAt = 0
+    this.requests = 0
+  }
+
+  charMs(binding) {
+    const settings = { ...binding.port.openOpt, ...this.model }
+    return settings.baudRate > 0 ? (charBits(settings) * 1000) / settings.baudRate : 0
+  }
+
+  // called by MockBinding for every write to the port
+  write(data, binding) {
+    const simulation = this.simulation
+    const arrivesAt = Math.max(simulation.now, this.rxFreeAt) + data.length * this.charMs(binding)
+    this.rxFreeAt = arrivesAt
+    simulation.schedule(arrivesAt, () => this.receive(data, binding))
+  }
+
+  receive(data, binding) {
+    const { responders = [], turnaroundMs = 0, maxRequestLength = 4096 } = this.model
+    let pending = this.pending ? Buffer.concat([this.pending, data]) : data
+    for (;;) {
+      let found = null
+      let responder
+      for (let i = 0; i < responders.length && !found; i++) {
+        responder = responders[i]
+        found = findRequest(responder.request, pending)
+      }
+      if (!found) {
+        break
+      }
+      const request = pending.slice(0, found.end)
+      pending = pending.slice(found.end)
+      this.requests++
+      const response = typeof responder.response === 'function' ? responder.response(request, found.match, this) : responder.response
+      if (response && response.length > 0) {
+        this.send(Buffer.from(response), binding, responder.turnaroundMs === undefined ? turnaroundMs : responder.turnaroundMs)
+      }
+    }
+    // keep only the tail of whatever doesn't match anything
+    this.pending = pending.length > 0 ? pending.slice(-maxRequestLength) : null
+  }
+
+  send(response, binding, turnaroundMs) {
+    const simulation = this.simulation
+    const arrivesAt = Math.max(simulation.now + turnaroundMs, this.txFreeAt) + response.length * this.charMs(binding)
+    this.txFreeAt = arrivesAt
+    simulation.schedule(arrivesAt, () => {
+      // the port may have been closed or reopened by another binding meanwhile
+      if (binding.isOpen && binding.port && binding.port.device === this) {
+        binding.receive(response)
+      }
+    })
+  }
+}
+
+/**
+ * A discrete event simulation with a virtual clock. Devices answer requests written to mock ports after a turnaround time and the time the bytes take at the line rate, all on the virtual clock, so thousands of `SerialPort` instances can talk to them much faster than real time.
+ *
+ * Code under test sees the virtual time through `now`, `setTimeout()` and `sleep()`. Between events the simulation waits for `setImmediate()`, enough for the streams and promise chains that react to an event to run.
+ */
+class Simulation {
+  /**
+   * @param {object} [options]
+   * @param {Function} [options.createPort] how to create mock ports, `MockBinding.createPort` by default
+   */
+  constructor({ createPort } = {}) {
+    this.now = 0
+    this.queue = new EventQueue()
+    this.devices = new Map()
+    this.running = false
+    this.eventsRun = 0
+    this.createPort = createPort || require('./index').createPort
+  }
+
+  /**
+   * Creates a mock port with a device on the other end
+   * @param {string} path
+   * @param {object} model shared by every device of the same kind, don't change it while the simulation runs
+   * @param {object[]} model.responders checked in order, each `{ request, response, turnaroundMs }`. `request` is a `Buffer` to find, a `RegExp` run on the bytes as latin1 or a `function(pending)` returning the length of a complete request or 0. `response` is a `Buffer` or a `function(request, match, device)` returning one, nothing to stay silent.
+   * @param {number} [model.turnaroundMs=0] time between receiving a request and starting the response
+   * @param {number} [model.baudRate] line rate, the port's `baudRate` by default. `dataBits`, `parity` and `stopBits` are taken the same way.
+   * @param {number} [model.maxRequestLength=4096] unmatched bytes to hold on to
+   * @param {object} [portOptions] passed on to `createPort()`
+   * @returns {SimulatedDevice}
+   */
+  addDevice(path, model, portOptions = {}) {
+    const device = new SimulatedDevice(this, path, model)
+    this.devices.set(path, device)
+    this.createPort(path, { readyData: Buffer.alloc(0), ...portOptions, device })
+    return device
+  }
+
+  /**
+   * Runs `fn(arg)` at virtual time `at`
+   */
+  schedule(at, fn, arg) {
+    return this.queue.push(Math.max(at, this.now), fn, arg)
+  }
+
+  /**
+   * Like the global `setTimeout()` but on the virtual clock
+   */
+  setTimeout(fn, ms = 0, arg) {
+    return this.schedule(this.now + ms, fn, arg)
+  }
+
+  clearTimeout(event) {
+    if (event) {
+      event.fn = null
+    }
+  }
+
+  /**
+   * @returns {Promise} Resolves at `now + ms` virtual time.
+   */
+  sleep(ms) {
+    return new Promise(resolve => this.setTimeout(resolve, ms))
+  }
+
+  /**
+   * Runs events in order, everything due at the same virtual time runs before the simulation settles
+   * @param {object} [options]
+   * @param {number} [options.until=Infinity] virtual time to stop at, the clock is left there
+   * @param {number} [options.maxEvents=Infinity] stop after this many events
+   * @returns {Promise} Resolves with `{ now, events }` once there's nothing left to run.
+   */
+  async run({ until = Infinity, maxEvents = Infinity } = {}) {
+    if (this.running) {
+      throw new Error('Simulation is already running')
+    }
+    this.running = true
+    const startedWith = this.eventsRun
+    try {
+      await settle()
+      const queue = this.queue
+      while (queue.size > 0 && this.eventsRun - startedWith < maxEvents && queue.peek().at <= until) {
+        const at = queue.peek().at
+        this.now = at
+        while (queue.size > 0 && queue.peek().at === at && this.eventsRun - startedWith < maxEvents) {
+          const { fn, arg } = queue.pop()
+          if (fn) {
+            fn(arg)
+            this.eventsRun++
+          }
+        }
+        await settle()
+      }
+      if (until !== Infinity && this.now < until && this.eventsRun - startedWith < maxEvents) {
+        this.now = until
+      }
+    } finally {
+      this.running = false
+    }
+    debug('ran', this.eventsRun - startedWith, 'events up to', this.now)
+    return { now: this.now, events: this.eventsRun - startedWith }
+  }
+}
+
+Simulation.EventQueue = EventQueue
+Simulation.SimulatedDevice = SimulatedDevice
+
+module.exports = Simulation
@@ -0,0 +1,126 @@
+const MockBinding = require('./')
+const Simulation = require('./simulation')
+
+const { EventQueue } = Simulation
+
+const ping = {
+  baudRate: 9600,
+  turnaroundMs: 5,
+  responders: [
+    { request: Buffer.from('PING\n'), response: Buffer.from('PONG\n') },
+    { request: /^READ (\d+)\n/, response: (request, match) => Buffer.from(`VALUE ${match[1] * 2}\n`) },
+    { request: Buffer.from('QUIET\n'), response: null },
+  ],
+}
+
+const readLine = async binding => {
+  let line = ''
+  while (!line.endsWith('\n')) {
+    const { bytesRead, buffer } = await binding.read(Buffer.alloc(64), 0, 64)
+    line += buffer.slice(0, bytesRead).toString()
+  }
+  return line
+}
+
+describe('Simulation', () => {
+  afterEach(() => {
+    MockBinding.reset()
+  })
+
+  describe('EventQueue', () => {
+    it('orders events by time and then by when they were added', () => {
+      const queue = new EventQueue()
+      const times = [5, 1, 3, 1, 9, 0, 3]
+      times.forEach((at, i) => queue.push(at, null, i))
+      const order = []
+      while (queue.size > 0) {
+        order.push(queue.pop().arg)
+      }
+      assert.deepEqual(order, [5, 1, 3, 2, 6, 0, 4])
+    })
+  })
+
+  it('runs timers on the virtual clock', async () => {
+    const sim = new Simulation()
+    const fired = []
+    sim.setTimeout(() => fired.push(sim.now), 1000)
+    const cleared = sim.setTimeout(() => fired.push('cleared'), 500)
+    sim.clearTimeout(cleared)
+    sim.setTimeout(async () => {
+      await sim.sleep(5000)
+      fired.push(sim.now)
+    }, 10)
+    const start = Date.now()
+    const result = await sim.run()
+    assert.deepEqual(fired, [1000, 5010])
+    assert.deepEqual(result, { now: 5010, events: 3 })
+    assert.isBelow(Date.now() - start, 1000)
+  })
+
+  it('stops at until and leaves the clock there', async () => {
+    const sim = new Simulation()
+    sim.setTimeout(() => {}, 100)
+    sim.setTimeout(() => {}, 300)
+    assert.deepEqual(await sim.run({ until: 200 }), { now: 200, events: 1 })
+    assert.deepEqual(await sim.run(), { now: 300, events: 1 })
+  })
+
+  it('answers requests after the line time and the turnaround', async () => {
+    const sim = new Simulation()
+    sim.addDevice('/dev/sim0', ping)
+    const binding = new MockBinding()
+    await binding.open('/dev/sim0', { baudRate: 115200 })
+    const answers = []
+    const client = (async () => {
+      await binding.write(Buffer.from('PING\n'))
+      answers.push([await readLine(binding), sim.now])
+      await binding.write(Buffer.from('QUIET\nREAD 21\n'))
+      answers.push([await readLine(binding), sim.now])
+    })()
+    await sim.run()
+    await client
+    // 5 bytes out, 5ms turnaround, 5 bytes back at 9600 baud
+    assert.equal(answers[0][0], 'PONG\n')
+    assert.closeTo(answers[0][1], 5 + 10 * (10000 / 9600), 0.001)
+    assert.equal(answers[1][0], 'VALUE 42\n')
+    assert.equal(sim.devices.get('/dev/sim0').requests, 3)
+  })
+
+  it('handles requests split over writes', async () => {
+    const sim = new Simulation()
+    sim.addDevice('/dev/sim0', { responders: ping.responders })
+    const binding = new MockBinding()
+    await binding.open('/dev/sim0', {})
+    const client = (async () => {
+      await binding.write(Buffer.from('garbagePI'))
+      await binding.write(Buffer.from('NG\n'))
+      return readLine(binding)
+    })()
+    await sim.run()
+    assert.equal(await client, 'PONG\n')
+  })
+
+  it('simulates thousands of ports', async () => {
+    const sim = new Simulation()
+    const count = 2000
+    const bindings = []
+    for (let i = 0; i < count; i++) {
+      sim.addDevice(`/dev/sim${i}`, ping)
+      bindings.push(new MockBinding())
+    }
+    await Promise.all(bindings.map((binding, i) => binding.open(`/dev/sim${i}`, { baudRate: 9600 })))
+    const polls = 5
+    const clients = bindings.map(async binding => {
+      for (let i = 0; i < polls; i++) {
+        await binding.write(Buffer.from(`READ ${i}\n`))
+        assert.equal(await readLine(binding), `VALUE ${i * 2}\n`)
+        await sim.sleep(1000)
+      }
+    })
+    const start = Date.now()
+    await sim.run()
+    await Promise.all(clients)
+    assert.isAbove(sim.now, polls * 1000)
+    assert.isBelow(Date.now() - start, sim.now)
+  })
+})
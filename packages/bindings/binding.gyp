@@ -50,7 +50,10 @@
           'sources': [
             'src/serialport_unix.cpp',
             'src/poller.cpp',
-            'src/serialport_linux.cpp'
+            'src/serialport_linux.cpp',
+            'src/uring.cpp',
+            'src/uring_linux.cpp',
+            'src/tty_index.cpp'
           ]
         }
       ],
@@ -59,7 +62,10 @@
           'sources': [
             'src/serialport_unix.cpp',
             'src/poller.cpp',
-            'src/serialport_linux.cpp'
+            'src/serialport_linux.cpp',
+            'src/uring.cpp',
+            'src/uring_linux.cpp',
+            'src/tty_index.cpp'
           ]
         }
       ],
@@ -67,7 +73,18 @@
         {
           'sources': [
             'src/serialport_unix.cpp',
-            'src/poller.cpp'
+            'src/poller.cpp',
+            'src/ring_reader.cpp',
+            'src/framer.cpp',
+            'src/framing.cpp',
+            'src/capture.cpp',
+            'src/virtual_port.cpp',
+            'src/bridge.cpp',
+            'src/tap.cpp',
+            'src/file_writer.cpp',
+            'src/flow_guard.cpp',
+            'src/port_state.cpp',
+            'src/modem_watcher.cpp'
           ]
         }
       ]
@@ -0,0 +1,56 @@
+/* eslint-disable mocha/no-pending-tests, node/no-unsupported-features/node-builtins */
+const { Worker } = require('worker_threads')
+
+const runInWorker = (source, workerData) => {
+  return new Promise((resolve, reject) => {
+    const worker = new Worker(source, { eval: true, workerData })
+    worker.once('message', resolve)
+    worker.once('error', reject)
+    worker.once('exit', code => code && reject(new Error(`worker exited with code ${code}`)))
+  })
+}
+
+describe('bindings in a worker thread', () => {
+  it('lists ports', async () => {
+    const ports = await runInWorker(`
+      const { parentPort, workerData } = require('worker_threads')
+      const Binding = require(workerData.bindingPath)
+      Binding.list().then(ports => parentPort.postMessage(ports.map(port => port.path)))
+    `, { bindingPath: require.resolve('./index') })
+    assert.isArray(ports)
+  })
+
+  if (!process.env.TEST_PORT) {
+    it('Cannot be tested further. Set the TEST_PORT env var with an available serialport for more testing.')
+    return
+  }
+
+  it('opens, writes and closes a port', async () => {
+    const result = await runInWorker(`
+      const { parentPort, workerData } = require('worker_threads')
+      const Binding = require(workerData.bindingPath)
+      const binding = new Binding()
+      binding.open(workerData.path, workerData.options)
+        .then(() => binding.write(Buffer.from('worker')))
+        .then(() => binding.drain())
+        .then(() => binding.close())
+        .then(() => parentPort.postMessage('closed'))
+    `, {
+      bindingPath: require.resolve('./index'),
+      path: process.env.TEST_PORT,
+      options: {
+        baudRate: 9600,
+        dataBits: 8,
+        hupcl: true,
+        lock: true,
+        parity: 'none',
+        rtscts: false,
+        stopBits: 1,
+        xany: false,
+        xoff: false,
+        xon: false,
+      },
+    })
+    assert.equal(result, 'closed')
+  })
+})
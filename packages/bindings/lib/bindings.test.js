@@ -540,6 +540,171 @@ function testBinding(bindingName, Binding, testPort) {
           })
         })
       })
+
+      describe('#getQueueSizes', () => {
+        it('errors asynchronously when not open', done => {
+          const binding = new Binding()
+          let noZalgo = false
+          binding.getQueueSizes().catch(err => {
+            assert.instanceOf(err, Error)
+            assert(noZalgo)
+            done()
+          })
+          noZalgo = true
+        })
+
+        if (!testPort) {
+          it('Cannot be tested further. Set the TEST_PORT env var with an available serialport for more testing.')
+          return
+        }
+
+        let binding
+        beforeEach(() => {
+          binding = new Binding()
+          return binding.open(testPort, defaultOpenOptions)
+        })
+
+        afterEach(() => binding.close())
+
+        testFeature('queueSizes.get', 'gets the input and output queue sizes', async () => {
+          await binding.drain()
+          const { input, output } = await binding.getQueueSizes()
+          assert.isAtLeast(input, 0)
+          assert.equal(output, 0)
+        })
+      })
+
+      if (bindingName === 'linux') {
+        describe('#detach', () => {
+          if (!testPort) {
+            it('Cannot be tested. Set the TEST_PORT env var with an available serialport for more testing.')
+            return
+          }
+
+          it('hands the open port over to another binding', async () => {
+            const binding = new Binding()
+            await binding.open(testPort, defaultOpenOptions)
+            const state = await binding.detach()
+            assert.isFalse(binding.isOpen)
+            assert.isNumber(state.fd)
+            assert.equal(state.path, testPort)
+
+            const binding2 = new Binding()
+            await binding2.attach(state.fd, state)
+            assert.isTrue(binding2.isOpen)
+            await binding2.write(Buffer.from('attached'))
+            await binding2.close()
+          })
+
+          it('rejects when not open', async () => {
+            await shouldReject(new Binding().detach())
+          })
+        })
+
+        describe('#startRingReader', () => {
+          const { RingConsumer } = require('./ring-reader')
+          if (!testPort) {
+            it('Cannot be tested. Set the TEST_PORT env var with an available serialport for more testing.')
+            return
+          }
+
+          it('reads the echo into the shared ring', async () => {
+            const binding = new Binding()
+            await binding.open(testPort, defaultOpenOptions)
+            const ringReader = await binding.startRingReader({ capacity: 4096 })
+            const consumer = new RingConsumer(ringReader.buffer)
+            await binding.write(Buffer.from('ring'))
+            const received = []
+            while (Buffer.concat(received).indexOf('ring') === -1) {
+              assert.isTrue(await consumer.waitAsync(1000))
+              consumer.consume(data => received.push(Buffer.from(data)))
+            }
+            await binding.stopRingReader()
+            assert.equal(consumer.state, 'closed')
+            await binding.close()
+          })
+
+          it('rejects when not open', async () => {
+            await shouldReject(new Binding().startRingReader())
+          })
+        })
+
+        describe('#transact', () => {
+          if (!testPort) {
+            it('Cannot be tested. Set the TEST_PORT env var with an available serialport for more testing.')
+            return
+          }
+
+          let binding
+          beforeEach(async () => {
+            binding = new Binding()
+            await binding.open(testPort, defaultOpenOptions)
+          })
+
+          afterEach(() => binding.close())
+
+          it('resolves with the echoed response', async () => {
+            const response = await binding.transact(Buffer.from('ping\n'), { until: { delimiter: '\n' }, discardInput: true })
+            assert.deepEqual(response, Buffer.from('ping\n'))
+          })
+
+          it('times out waiting for a longer response', async () => {
+            const err = await shouldReject(binding.transact(Buffer.from('ping'), { until: { length: 100 }, timeoutMs: 50 }))
+            assert.equal(err.code, 'ETIMEDOUT')
+          })
+
+          it('holds a pending read back until it is done', async () => {
+            const buffer = Buffer.alloc(64)
+            const read = binding.read(buffer, 0, 64)
+            const response = await binding.transact(Buffer.from('pong\n'), { until: { delimiter: '\n' }, discardInput: true })
+            assert.deepEqual(response, Buffer.from('pong\n'))
+            await binding.write(Buffer.from('after'))
+            const { bytesRead } = await read
+            assert.isAbove(bytesRead, 0)
+          })
+        })
+
+        describe('bindingOptions.maxQueueMs', () => {
+          if (!testPort) {
+            it('Cannot be tested. Set the TEST_PORT env var with an available serialport for more testing.')
+            return
+          }
+
+          let binding
+          beforeEach(async () => {
+            binding = new Binding({ bindingOptions: { maxQueueMs: 5 } })
+            await binding.open(testPort, defaultOpenOptions)
+          })
+
+          afterEach(() => binding.close())
+
+          it('keeps the output queue within the budget', async () => {
+            const write = binding.write(Buffer.alloc(4096, 'a'))
+            await new Promise(resolve => setTimeout(resolve, 10))
+            const { output } = await binding.getQueueSizes()
+            assert.isAtMost(output, binding.writeQueue.budget)
+            await write
+          })
+
+          it('drops queued data on flush', async () => {
+            const write = binding.write(Buffer.alloc(4096, 'a'))
+            await binding.flush()
+            await write
+            assert.equal(binding.writeQueue.length, 0)
+          })
+
+          it('writes the high lane ahead of queued bulk data', async () => {
+            let bulkDone = false
+            const bulk = binding.write(Buffer.alloc(4096, 'a')).then(() => {
+              bulkDone = true
+            })
+            await binding.write(Buffer.from('stop'), { lane: 'high' })
+            assert.isFalse(bulkDone)
+            assert.equal(binding.writeStats().lanes.high.writes, 1)
+            await bulk
+          })
+        })
+      }
     })
   })
 }
@@ -0,0 +1,122 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/bridge')
+const EventEmitter = require('events')
+const BridgeBindings = require('bindings')('bindings.node').Bridge
+
+const MODEM_LINES = ['cts', 'dsr', 'dcd']
+
+// the fd of a net.Socket, libuv stops reading it so only the bridge does
+const socketFd = socket => {
+  if (typeof socket === 'number') {
+    return socket
+  }
+  const handle = socket && socket._handle
+  if (!handle || typeof handle.fd !== 'number' || handle.fd < 0) {
+    throw new TypeError('"socket" must be a connected net.Socket or a file descriptor')
+  }
+  socket.pause()
+  handle.readStop()
+  return handle.fd
+}
+
+/**
+ * Connects a serial port to a socket in both directions on a native thread. On Linux the data is spliced through pipes and never copied into user space, fds that can't be spliced, and ports with a tap on them, fall back to a read/write loop. JavaScript only starts and stops the bridge, so neither stream nor the thread pool sees the data. Not available on Windows.
+ *
+ * Emits `'close'` once the bridge has stopped, with an error if the port went away or either side failed. The error's `side` is `'serial'` or `'socket'` when one of them failed, errors from the port also have `disconnect` set. Neither the port nor the socket is closed by the bridge.
+ */
+class Bridge extends EventEmitter {
+  /**
+   * @param {object} options
+   * @param {LinuxBinding} options.binding an open port
+   * @param {net.Socket|number} options.socket a connected TCP or Unix socket, or its fd
+   * @param {number} [options.bufferSize=65536] bytes to hold in each direction when the other side is slower
+   * @param {boolean} [options.splice=true] `false` to always copy through a buffer
+   * @param {Function} [options.onModemLines] called with `{ cts, dsr, dcd }` when any of them change, to pass them on over the socket's protocol
+   * @param {number} [options.modemPollMs=100] how often to check the modem lines for `onModemLines`
+   */
+  constructor({ binding, socket, bufferSize = 65536, splice = true, onModemLines, modemPollMs = 100 }, NativeBridge = BridgeBindings) {
+    super()
+    if (!NativeBridge) {
+      throw new Error('Bridges are not supported on this platform')
+    }
+    if (!binding || typeof binding.fd !== 'number') {
+      throw new TypeError('"binding" must be an open binding')
+    }
+    if (!Number.isInteger(bufferSize) || bufferSize < 4096) {
+      throw new TypeError('"bufferSize" must be an integer of at least 4096')
+    }
+    if (onModemLines !== undefined && typeof onModemLines !== 'function') {
+      throw new TypeError('"onModemLines" must be a function')
+    }
+    this.binding = binding
+    this.socket = socket
+    this.closed = false
+    this.modemLines = null
+    this.modemTimer = null
+    this.bridge = new NativeBridge(binding.fd, socketFd(socket), { bufferSize, splice: Boolean(splice) }, err => this.finish(err))
+    logger('bridging', binding.path)
+    if (onModemLines) {
+      this.watchModemLines(onModemLines, modemPollMs)
+    }
+  }
+
+  watchModemLines(onModemLines, modemPollMs) {
+    const check = async () => {
+      this.modemTimer = null
+      try {
+        const lines = await this.binding.get()
+        const changed = !this.modemLines || MODEM_LINES.some(line => lines[line] !== this.modemLines[line])
+        this.modemLines = lines
+        if (changed && !this.closed) {
+          onModemLines(lines)
+        }
+      } catch (err) {
+        logger('cannot read the modem lines', err)
+      }
+      if (!this.closed) {
+        this.modemTimer = setTimeout(check, modemPollMs)
+      }
+    }
+    check()
+  }
+
+  /**
+   * Passes modem lines from the socket side on to the port
+   * @param {object} flags `{ dtr, rts, brk, ... }` as for `binding.set()`
+   * @returns {Promise}
+   */
+  setModemLines(flags) {
+    return this.binding.set(flags)
+  }
+
+  /**
+   * @returns {object} `{ toSerial, toSocket }` each with the `bytes` moved so far and whether it's using `splice`
+   */
+  stats() {
+    return this.bridge.stats()
+  }
+
+  finish(err) {
+    if (this.closed) {
+      return
+    }
+    if (err && err.side === 'serial') {
+      // reading or writing the port failed, it's gone
+      err.disconnect = true
+    }
+    logger('bridge stopped', err || 'the socket closed')
+    this.closed = true
+    clearTimeout(this.modemTimer)
+    this.bridge.close()
+    this.emit('close', err || null)
+  }
+
+  /**
+   * Stops the bridge, data still in its buffers is dropped
+   */
+  close() {
+    this.finish(null)
+  }
+}
+
+module.exports = Bridge
@@ -0,0 +1,155 @@
+const net = require('net')
+const Bridge = require('./bridge')
+
+class MockBridgeBindings {
+  constructor(serialFd, socketFd, options, cb) {
+    this.serialFd = serialFd
+    this.socketFd = socketFd
+    this.options = options
+    this.cb = cb
+    this.closed = false
+  }
+  stats() {
+    return { toSerial: { bytes: 1, splice: true }, toSocket: { bytes: 2, splice: true } }
+  }
+  close() {
+    this.closed = true
+  }
+}
+
+const makeBinding = (lines = { cts: false, dsr: false, dcd: false }) => ({
+  fd: 7,
+  path: '/dev/ttyS0',
+  lines,
+  sets: [],
+  async get() {
+    return { ...this.lines }
+  },
+  async set(flags) {
+    this.sets.push(flags)
+  },
+})
+
+describe('Bridge', () => {
+  it('hands the fds to the native bridge', () => {
+    const bridge = new Bridge({ binding: makeBinding(), socket: 9, bufferSize: 8192, splice: false }, MockBridgeBindings)
+    assert.containSubset(bridge.bridge, { serialFd: 7, socketFd: 9, options: { bufferSize: 8192, splice: false } })
+    assert.deepEqual(bridge.stats().toSocket, { bytes: 2, splice: true })
+  })
+
+  it('validates its options', () => {
+    assert.throws(() => new Bridge({ binding: {}, socket: 9 }, MockBridgeBindings), TypeError)
+    assert.throws(() => new Bridge({ binding: makeBinding(), socket: {} }, MockBridgeBindings), TypeError)
+    assert.throws(() => new Bridge({ binding: makeBinding(), socket: 9, bufferSize: 10 }, MockBridgeBindings), TypeError)
+  })
+
+  it('emits close once when the native bridge stops', () => {
+    const bridge = new Bridge({ binding: makeBinding(), socket: 9 }, MockBridgeBindings)
+    const closes = []
+    bridge.on('close', err => closes.push(err))
+    const err = new Error('Error: EIO, bridge stopped')
+    err.code = 'EIO'
+    err.side = 'serial'
+    bridge.bridge.cb(err)
+    bridge.close()
+    assert.deepEqual(closes, [err])
+    assert.isTrue(err.disconnect)
+    assert.isTrue(bridge.bridge.closed)
+  })
+
+  it("doesn't treat the socket failing as the port going away", () => {
+    const bridge = new Bridge({ binding: makeBinding(), socket: 9 }, MockBridgeBindings)
+    const err = new Error('Error: Input/output error, bridge stopped')
+    err.code = 'EIO'
+    err.side = 'socket'
+    bridge.bridge.cb(err)
+    assert.isUndefined(err.disconnect)
+  })
+
+  it('reports modem line changes', async () => {
+    const binding = makeBinding()
+    const changes = []
+    const bridge = new Bridge({ binding, socket: 9, onModemLines: lines => changes.push(lines), modemPollMs: 1 }, MockBridgeBindings)
+    await new Promise(resolve => setTimeout(resolve, 10))
+    binding.lines = { cts: true, dsr: false, dcd: false }
+    await new Promise(resolve => setTimeout(resolve, 10))
+    bridge.close()
+    assert.deepEqual(changes, [
+      { cts: false, dsr: false, dcd: false },
+      { cts: true, dsr: false, dcd: false },
+    ])
+    await bridge.setModemLines({ dtr: true })
+    assert.deepEqual(binding.sets, [{ dtr: true }])
+  })
+
+  describe('between a pseudo terminal and a unix socket', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+    const LinuxBinding = require('./linux')
+    const { VirtualPort } = require('./virtual-port')
+
+    let device
+    let binding
+    let server
+    let client
+    beforeEach(async () => {
+      device = new VirtualPort({ echo: true })
+      binding = new LinuxBinding()
+      await binding.open(device.path, { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1 })
+      const accepted = new Promise(resolve => {
+        server = net.createServer(resolve)
+      })
+      const path = `\0serialport-bridge-test-${process.pid}`
+      await new Promise(resolve => server.listen(path, resolve))
+      client = net.connect(path)
+      const socket = await accepted
+      await binding.startBridge(socket)
+    })
+
+    afterEach(async () => {
+      client.destroy()
+      server.close()
+      if (binding.isOpen) {
+        await binding.close()
+      }
+      device.close()
+    })
+
+    it('passes data both ways', async () => {
+      const data = Buffer.alloc(100000).map((_, i) => i % 251)
+      const received = []
+      let length = 0
+      const done = new Promise(resolve =>
+        client.on('data', chunk => {
+          received.push(chunk)
+          length += chunk.length
+          if (length >= data.length) {
+            resolve()
+          }
+        })
+      )
+      client.write(data)
+      await done
+      assert.deepEqual(Buffer.concat(received), data)
+      const { toSerial, toSocket } = binding.bridge.stats()
+      assert.equal(toSerial.bytes, data.length)
+      assert.equal(toSocket.bytes, data.length)
+    })
+
+    it('closes when the socket does and gives reads back to the binding', async () => {
+      const closed = new Promise(resolve => binding.bridge.once('close', resolve))
+      client.end()
+      assert.isNull(await closed)
+      assert.isNull(binding.bridge)
+      await binding.write(Buffer.from('back'))
+      const buffer = Buffer.alloc(4)
+      let offset = 0
+      while (offset < 4) {
+        offset += (await binding.read(buffer, offset, 4 - offset)).bytesRead
+      }
+      assert.equal(buffer.toString(), 'back')
+    })
+  })
+})
@@ -0,0 +1,302 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/capture')
+const fs = require('fs')
+const binding = require('bindings')('bindings.node')
+
+// mirrors src/capture.h
+const MAGIC = 0x50435053
+const VERSION = 1
+const FILE_HEADER = 16
+const BLOCK_MAGIC = 0x4b425053
+const BLOCK_HEADER = 24
+const RECORD_HEADER = 16
+const INDEX_ENTRY = 24
+const INDEX_MAGIC = 0x58495053
+const TRAILER = 16
+const DIRECTIONS = ['rx', 'tx']
+
+const directionCode = direction => {
+  const code = DIRECTIONS.indexOf(direction)
+  if (code === -1) {
+    throw new TypeError(`"direction" must be one of ${DIRECTIONS.join(', ')}`)
+  }
+  return code
+}
+
+/**
+ * Appends timestamped traffic to a capture file. Records are copied into a block in memory, full blocks go to disk on a native thread so taping a port costs about a `memcpy` per read or write. Not available on Windows.
+ */
+class CaptureWriter {
+  /**
+   * @param {string} path the file to create, an existing one is truncated
+   * @param {object} [options]
+   * @param {number} [options.blockSize=1048576] bytes of records to collect before writing them out, records aren't on disk before their block is
+   */
+  constructor(path, { blockSize } = {}) {
+    if (!binding.CaptureWriter) {
+      throw new Error('Capture is not supported on this platform')
+    }
+    this.path = path
+    this.writer = new binding.CaptureWriter(path, { blockSize })
+    this.closed = false
+    logger('capturing to', path)
+  }
+
+  /**
+   * @param {string} direction `'rx'` or `'tx'`
+   * @param {number} portId tells the ports apart when several share a capture, 0 to 65535
+   * @param {Buffer} buffer
+   * @param {number} [offset=0]
+   * @param {number} [length=buffer.length - offset]
+   * @returns {number} the record's timestamp
+   */
+  record(direction, portId, buffer, offset, length) {
+    return this.writer.record(directionCode(direction), portId, buffer, offset, length)
+  }
+
+  /**
+   * ms since the capture started, the clock the record timestamps are on
+   */
+  now() {
+    return this.writer.now()
+  }
+
+  /**
+   * Starts writing out the current block even though it isn't full
+   */
+  flush() {
+    this.writer.flush()
+  }
+
+  /**
+   * Writes the remaining records and the index
+   * @returns {object} `{ records, bytes, blocks }` written over the life of the capture
+   */
+  close() {
+    if (this.closed) {
+      return null
+    }
+    this.closed = true
+    return this.writer.close()
+  }
+}
+
+const readIndex = (buffer, view) => {
+  if (buffer.length < FILE_HEADER + TRAILER) {
+    return null
+  }
+  const trailer = buffer.length - TRAILER
+  if (view.getUint32(trailer + 12, true) !== INDEX_MAGIC) {
+    return null
+  }
+  const offset = view.getFloat64(trailer, true)
+  const count = view.getUint32(trailer + 8, true)
+  if (!Number.isInteger(offset) || offset < FILE_HEADER || offset + count * INDEX_ENTRY !== trailer) {
+    return null
+  }
+  const blocks = []
+  // blocks follow each other in file order, each entry has to point at a whole block between the last one and the index
+  let end = FILE_HEADER
+  for (let i = 0; i < count; i++) {
+    const entry = offset + i * INDEX_ENTRY
+    const block = {
+      offset: view.getFloat64(entry, true),
+      firstTimestamp: view.getFloat64(entry + 8, true),
+      records: view.getUint32(entry + 16, true),
+      bytes: view.getUint32(entry + 20, true),
+    }
+    if (
+      !Number.isInteger(block.offset) ||
+      block.offset < end ||
+      block.offset + BLOCK_HEADER + block.bytes > offset ||
+      view.getUint32(block.offset, true) !== BLOCK_MAGIC
+    ) {
+      throw new Error(`Corrupt capture file, index entry ${i} does not point at a block`)
+    }
+    end = block.offset + BLOCK_HEADER + block.bytes
+    blocks.push(block)
+  }
+  return blocks
+}
+
+// a capture that was never closed has no index, its complete blocks are still good
+const scanBlocks = (buffer, view) => {
+  const blocks = []
+  let offset = FILE_HEADER
+  while (offset + BLOCK_HEADER <= buffer.length && view.getUint32(offset, true) === BLOCK_MAGIC) {
+    const bytes = view.getUint32(offset + 4, true)
+    if (offset + BLOCK_HEADER + bytes > buffer.length) {
+      break
+    }
+    blocks.push({
+      offset,
+      firstTimestamp: view.getFloat64(offset + 16, true),
+      records: view.getUint32(offset + 8, true),
+      bytes,
+    })
+    offset += BLOCK_HEADER + bytes
+  }
+  return blocks
+}
+
+/**
+ * Reads a capture file. Records are views into the file's buffer, nothing is copied.
+ */
+class CaptureReader {
+  /**
+   * Maps the file into memory instead of reading it, pages are only loaded as records are read. Falls back to reading the whole file on Windows.
+   * Don't truncate the file while the reader is in use, reading a record past its new end raises SIGBUS and kills the process.
+   * @param {string} path
+   * @returns {CaptureReader}
+   */
+  static open(path) {
+    const buffer = binding.mapFile ? binding.mapFile(path) : fs.readFileSync(path)
+    return new CaptureReader(buffer)
+  }
+
+  /**
+   * @param {Buffer} buffer the contents of a capture file
+   */
+  constructor(buffer) {
+    if (!Buffer.isBuffer(buffer)) {
+      throw new TypeError('"buffer" is not a Buffer')
+    }
+    const view = new DataView(buffer.buffer, buffer.byteOffset, buffer.length)
+    if (buffer.length < FILE_HEADER || view.getUint32(0, true) !== MAGIC) {
+      throw new Error('Not a capture file')
+    }
+    const version = view.getUint16(4, true)
+    if (version !== VERSION) {
+      throw new Error(`Unsupported capture version ${version}`)
+    }
+    this.buffer = buffer
+    this.view = view
+    /**
+     * Wall clock time the capture started at, in ms since the epoch
+     */
+    this.startTime = view.getFloat64(8, true)
+    const index = readIndex(buffer, view)
+    this.complete = index !== null
+    this.blocks = index || scanBlocks(buffer, view)
+  }
+
+  get recordCount() {
+    return this.blocks.reduce((total, block) => total + block.records, 0)
+  }
+
+  /**
+   * @param {object} [filter]
+   * @param {number} [filter.portId] only this port's records
+   * @param {string} [filter.direction] only `'rx'` or `'tx'` records
+   * @param {number} [filter.from=0] skip records before this timestamp, whole blocks are skipped through the index
+   * @param {number} [filter.to=Infinity] stop at this timestamp
+   * @returns {Iterator<object>} `{ direction, portId, timestamp, data }` in the order they were captured
+   */
+  *records({ portId, direction, from = 0, to = Infinity } = {}) {
+    const { buffer, view, blocks } = this
+    for (let i = 0; i < blocks.length; i++) {
+      const block = blocks[i]
+      if (block.firstTimestamp > to) {
+        return
+      }
+      if (i + 1 < blocks.length && blocks[i + 1].firstTimestamp < from) {
+        continue
+      }
+      let offset = block.offset + BLOCK_HEADER
+      const end = offset + block.bytes
+      while (offset + RECORD_HEADER <= end) {
+        const length = view.getUint32(offset + 4, true)
+        if (offset + RECORD_HEADER + length > end) {
+          throw new Error(`Corrupt capture file, the record at ${offset} runs past its block`)
+        }
+        const timestamp = view.getFloat64(offset + 8, true)
+        if (timestamp > to) {
+          return
+        }
+        const record = {
+          direction: DIRECTIONS[buffer[offset]],
+          portId: view.getUint16(offset + 2, true),
+          timestamp,
+          data: buffer.slice(offset + RECORD_HEADER, offset + RECORD_HEADER + length),
+        }
+        offset += RECORD_HEADER + length
+        if (timestamp < from || (portId !== undefined && record.portId !== portId) || (direction && record.direction !== direction)) {
+          continue
+        }
+        yield record
+      }
+    }
+  }
+
+  [Symbol.iterator]() {
+    return this.records()
+  }
+}
+
+/**
+ * Builds a capture file in memory, for tests and for converting traffic captured some other way
+ * @param {object[]} records `{ direction, portId, timestamp, data }` in timestamp order
+ * @param {object} [options]
+ * @param {number} [options.startTime=0] wall clock time the capture started at
+ * @param {number} [options.blockSize=1048576]
+ * @returns {Buffer} the complete file, index included
+ */
+const encode = (records, { startTime = 0, blockSize = 1 << 20 } = {}) => {
+  const header = Buffer.alloc(FILE_HEADER)
+  header.writeUInt32LE(MAGIC, 0)
+  header.writeUInt16LE(VERSION, 4)
+  header.writeDoubleLE(startTime, 8)
+  const parts = [header]
+  const index = []
+  let offset = FILE_HEADER
+  let block = null
+  const seal = () => {
+    const blockHeader = Buffer.alloc(BLOCK_HEADER)
+    blockHeader.writeUInt32LE(BLOCK_MAGIC, 0)
+    blockHeader.writeUInt32LE(block.bytes, 4)
+    blockHeader.writeUInt32LE(block.records.length, 8)
+    blockHeader.writeDoubleLE(block.firstTimestamp, 16)
+    parts.push(blockHeader, ...block.records)
+    index.push({ offset, firstTimestamp: block.firstTimestamp, records: block.records.length, bytes: block.bytes })
+    offset += BLOCK_HEADER + block.bytes
+    block = null
+  }
+  for (const { direction, portId = 0, timestamp, data } of records) {
+    const record = Buffer.alloc(RECORD_HEADER + data.length)
+    record.writeUInt8(directionCode(direction), 0)
+    record.writeUInt16LE(portId, 2)
+    record.writeUInt32LE(data.length, 4)
+    record.writeDoubleLE(timestamp, 8)
+    Buffer.from(data).copy(record, RECORD_HEADER)
+    if (block && BLOCK_HEADER + block.bytes + record.length > blockSize) {
+      seal()
+    }
+    if (!block) {
+      block = { records: [], bytes: 0, firstTimestamp: timestamp }
+    }
+    block.records.push(record)
+    block.bytes += record.length
+  }
+  if (block) {
+    seal()
+  }
+  const footer = Buffer.alloc(index.length * INDEX_ENTRY + TRAILER)
+  index.forEach((entry, i) => {
+    footer.writeDoubleLE(entry.offset, i * INDEX_ENTRY)
+    footer.writeDoubleLE(entry.firstTimestamp, i * INDEX_ENTRY + 8)
+    footer.writeUInt32LE(entry.records, i * INDEX_ENTRY + 16)
+    footer.writeUInt32LE(entry.bytes, i * INDEX_ENTRY + 20)
+  })
+  const trailer = index.length * INDEX_ENTRY
+  footer.writeDoubleLE(offset, trailer)
+  footer.writeUInt32LE(index.length, trailer + 8)
+  footer.writeUInt32LE(INDEX_MAGIC, trailer + 12)
+  parts.push(footer)
+  return Buffer.concat(parts)
+}
+
+module.exports = {
+  CaptureWriter,
+  CaptureReader,
+  encode,
+}
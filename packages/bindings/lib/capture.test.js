@@ -0,0 +1,138 @@
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+const { CaptureWriter, CaptureReader, encode } = require('./capture')
+
+const records = [
+  { direction: 'tx', portId: 0, timestamp: 0.5, data: Buffer.from('request') },
+  { direction: 'rx', portId: 0, timestamp: 2.25, data: Buffer.from('response') },
+  { direction: 'rx', portId: 3, timestamp: 4, data: Buffer.from('other port') },
+  { direction: 'rx', portId: 0, timestamp: 9, data: Buffer.alloc(0) },
+  { direction: 'tx', portId: 0, timestamp: 12, data: Buffer.from('again') },
+]
+
+// mirrors lib/capture.js
+const INDEX_ENTRY = 24
+const TRAILER = 16
+
+const plain = record => ({ ...record, data: record.data.toString() })
+
+describe('capture', () => {
+  describe('CaptureReader', () => {
+    it('rejects other files', () => {
+      assert.throws(() => new CaptureReader(Buffer.from('not a capture file')), 'Not a capture file')
+      const file = encode([])
+      file.writeUInt16LE(9, 4)
+      assert.throws(() => new CaptureReader(file), 'Unsupported capture version 9')
+    })
+
+    it('reads back the records', () => {
+      const reader = new CaptureReader(encode(records, { startTime: 1500000000000 }))
+      assert.equal(reader.startTime, 1500000000000)
+      assert.isTrue(reader.complete)
+      assert.equal(reader.recordCount, records.length)
+      assert.deepEqual([...reader].map(plain), records.map(plain))
+    })
+
+    it('reads a capture split over several blocks', () => {
+      const reader = new CaptureReader(encode(records, { blockSize: 64 }))
+      assert.isAbove(reader.blocks.length, 1)
+      assert.deepEqual([...reader].map(plain), records.map(plain))
+    })
+
+    it('reads the complete blocks of a capture without an index', () => {
+      const file = encode(records, { blockSize: 64 })
+      const reader = new CaptureReader(file)
+      const lastBlock = reader.blocks[reader.blocks.length - 1]
+      const truncated = file.slice(0, lastBlock.offset + 10)
+      const partial = new CaptureReader(truncated)
+      assert.isFalse(partial.complete)
+      assert.equal(partial.blocks.length, reader.blocks.length - 1)
+      assert.deepEqual([...partial].map(plain), records.slice(0, partial.recordCount).map(plain))
+    })
+
+    it('rejects an index that points outside the file', () => {
+      const file = encode(records, { blockSize: 64 })
+      const indexOffset = file.readDoubleLE(file.length - TRAILER)
+      file.writeDoubleLE(file.length, indexOffset + INDEX_ENTRY)
+      assert.throws(() => new CaptureReader(file), 'Corrupt capture file, index entry 1 does not point at a block')
+      file.writeDoubleLE(16.5, indexOffset)
+      assert.throws(() => new CaptureReader(file), 'Corrupt capture file, index entry 0 does not point at a block')
+    })
+
+    it('rejects a record that runs past its block', () => {
+      const file = encode(records)
+      // the first record's length, after the file and block headers
+      file.writeUInt32LE(1000, 16 + 24 + 4)
+      assert.throws(() => [...new CaptureReader(file)], 'runs past its block')
+    })
+
+    it('filters records', () => {
+      const reader = new CaptureReader(encode(records, { blockSize: 64 }))
+      const data = filter => [...reader.records(filter)].map(record => record.data.toString())
+      assert.deepEqual(data({ portId: 3 }), ['other port'])
+      assert.deepEqual(data({ direction: 'tx' }), ['request', 'again'])
+      assert.deepEqual(data({ from: 2, to: 9 }), ['response', 'other port', ''])
+    })
+
+    it('returns views into the file', () => {
+      const file = encode(records)
+      const [first] = new CaptureReader(file)
+      assert.strictEqual(first.data.buffer, file.buffer)
+    })
+  })
+
+  describe('encode', () => {
+    it('rejects unknown directions', () => {
+      assert.throws(() => encode([{ direction: 'up', timestamp: 0, data: Buffer.from('x') }]), TypeError)
+    })
+  })
+
+  describe('CaptureWriter', () => {
+    if (process.platform === 'win32') {
+      it('Cannot be tested on win32')
+      return
+    }
+
+    let dir
+    beforeEach(() => {
+      dir = fs.mkdtempSync(path.join(os.tmpdir(), 'capture-'))
+    })
+
+    afterEach(() => {
+      fs.readdirSync(dir).forEach(file => fs.unlinkSync(path.join(dir, file)))
+      fs.rmdirSync(dir)
+    })
+
+    it('writes a capture the reader maps back in', () => {
+      const file = path.join(dir, 'traffic.cap')
+      const writer = new CaptureWriter(file, { blockSize: 4096 })
+      const payload = Buffer.alloc(1000, 'x')
+      for (let i = 0; i < 20; i++) {
+        writer.record(i % 2 ? 'tx' : 'rx', i % 3, payload, 0, 100 + i)
+      }
+      const stats = writer.close()
+      assert.equal(stats.records, 20)
+      assert.isAbove(stats.blocks, 1)
+
+      const reader = CaptureReader.open(file)
+      assert.isTrue(reader.complete)
+      assert.closeTo(reader.startTime, Date.now(), 60000)
+      const read = [...reader]
+      assert.equal(read.length, 20)
+      read.forEach((record, i) => {
+        assert.containSubset(record, { direction: i % 2 ? 'tx' : 'rx', portId: i % 3 })
+        assert.equal(record.data.length, 100 + i)
+        if (i > 0) {
+          assert.isAtLeast(record.timestamp, read[i - 1].timestamp)
+        }
+      })
+    })
+
+    it('rejects records after close', () => {
+      const writer = new CaptureWriter(path.join(dir, 'closed.cap'))
+      writer.close()
+      assert.throws(() => writer.record('rx', 0, Buffer.from('late')), 'Capture is closed')
+    })
+  })
+})
@@ -3,6 +3,7 @@ const binding = require('bindings')('bindings.node')
 const AbstractBinding = require('@serialport/binding-abstract')
 const Poller = require('./poller')
 const unixRead = require('./unix-read')
+const unixReconfigure = require('./unix-reconfigure')
 const unixWrite = require('./unix-write')
 const { wrapWithHiddenComName } = require('./legacy')
 
@@ -18,6 +19,7 @@ const asyncUpdate = promisify(binding.update)
 const asyncSet = promisify(binding.set)
 const asyncGet = promisify(binding.get)
 const asyncGetBaudRate = promisify(binding.getBaudRate)
+const asyncGetQueueSizes = promisify(binding.getQueueSizes)
 const asyncDrain = promisify(binding.drain)
 const asyncFlush = promisify(binding.flush)
 
@@ -77,7 +79,17 @@ class DarwinBinding extends AbstractBinding {
 
   async update(options) {
     await super.update(options)
-    return asyncUpdate(this.fd, options)
+    await asyncUpdate(this.fd, options)
+    this.openOptions.baudRate = options.baudRate
+  }
+
+  /**
+   * Changes any of the port's termios settings, and optionally its modem lines, in one verified step, see `unixReconfigure`
+   * @param {object} options any of `baudRate`, `dataBits`, `parity`, `stopBits`, `rtscts`, `xon`, `xoff`, `xany`, `hupcl`, `vmin` and `vtime`, plus `set` and `flush`
+   * @returns {Promise} Resolves once the port is reconfigured. Rejects with `rolledBack` set if the old settings were restored.
+   */
+  async reconfigure(options) {
+    await unixReconfigure({ binding: this, options })
   }
 
   async set(options) {
@@ -95,6 +107,11 @@ class DarwinBinding extends AbstractBinding {
     return asyncGetBaudRate(this.fd)
   }
 
+  async getQueueSizes() {
+    await super.getQueueSizes()
+    return asyncGetQueueSizes(this.fd)
+  }
+
   async drain() {
     await super.drain()
     await this.writeOperation
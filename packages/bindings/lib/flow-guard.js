@@ -0,0 +1,89 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/flowGuard')
+const FlowGuardBindings = require('bindings')('bindings.node').FlowGuard
+
+// mirrors src/flow_guard.h
+const MODES = ['rts', 'xoff']
+
+/**
+ * Holds the sender back while received data piles up. A native thread adds up the kernel's input queue, a running ring reader and the bytes JavaScript reports with `setBuffered()`, and drops RTS or sends XOFF once that passes `highWater`. The sender is let go again at `lowWater`. The thread doesn't wait on the event loop, so a long GC pause or a busy handler still stops the sender before the kernel's buffer overflows. Not available on Windows.
+ *
+ * Use `'rts'` on ports opened without `rtscts`, with kernel hardware flow control the driver owns RTS and the two fight over it. `'xoff'` needs a sender that honors XON/XOFF and data that can't contain those bytes.
+ */
+class FlowGuard {
+  /**
+   * @param {number} fd the open port
+   * @param {object} options
+   * @param {number} options.highWater stop the sender at this many unconsumed bytes
+   * @param {number} [options.lowWater=highWater / 2] let it go again at this many
+   * @param {string} [options.mode='rts'] `'rts'` to drop RTS or `'xoff'` to send XOFF
+   * @param {number} [options.intervalUs=1000] how often to check, in microseconds
+   */
+  constructor(fd, { highWater, lowWater, mode = 'rts', intervalUs = 1000 }, NativeFlowGuard = FlowGuardBindings) {
+    if (!NativeFlowGuard) {
+      throw new Error('Flow guards are not supported on this platform')
+    }
+    if (!Number.isInteger(highWater) || highWater < 1) {
+      throw new TypeError('"highWater" must be a positive integer')
+    }
+    if (lowWater === undefined) {
+      lowWater = Math.floor(highWater / 2)
+    }
+    if (!Number.isInteger(lowWater) || lowWater < 0 || lowWater >= highWater) {
+      throw new TypeError('"lowWater" must be a positive integer below "highWater"')
+    }
+    if (!MODES.includes(mode)) {
+      throw new TypeError(`"mode" must be one of ${MODES.join(', ')}`)
+    }
+    if (!Number.isInteger(intervalUs) || intervalUs < 1) {
+      throw new TypeError('"intervalUs" must be a positive integer')
+    }
+    this.guard = new NativeFlowGuard(fd, { highWater, lowWater, mode: MODES.indexOf(mode), intervalUs })
+    this.closed = false
+    logger('guarding with', mode, 'between', lowWater, 'and', highWater, 'bytes')
+  }
+
+  /**
+   * Reports bytes read but not consumed yet, like a stream's buffer
+   * @param {number} bytes
+   */
+  setBuffered(bytes) {
+    if (!this.closed) {
+      this.guard.setBuffered(bytes)
+    }
+  }
+
+  /**
+   * Counts the unread bytes of a ring reader too, see `RingReader`
+   * @param {RingReader|null} ringReader the running reader, or `null` once it stops
+   */
+  setRingReader(ringReader) {
+    if (!this.closed) {
+      this.guard.setRing(ringReader ? new Uint8Array(ringReader.buffer) : null)
+    }
+  }
+
+  /**
+   * @returns {object} `{ active, activations, activeMs, level, maxLevel }`, whether the sender is held now, how often and how long it was held and the unconsumed bytes at the last check, `error` with the code once the guard gave up
+   */
+  stats() {
+    return this.guard.stats()
+  }
+
+  /**
+   * Stops the thread, a sender still being held is let go
+   * @returns {object} the final stats
+   */
+  close() {
+    if (this.closed) {
+      return null
+    }
+    this.closed = true
+    this.guard.close()
+    const stats = this.guard.stats()
+    logger('closed flow guard', stats)
+    return stats
+  }
+}
+
+module.exports = FlowGuard
@@ -0,0 +1,107 @@
+const FlowGuard = require('./flow-guard')
+
+class MockFlowGuardBindings {
+  constructor(fd, options) {
+    this.fd = fd
+    this.options = options
+    this.buffered = 0
+    this.ring = null
+    this.closed = false
+  }
+  setBuffered(bytes) {
+    this.buffered = bytes
+  }
+  setRing(shared) {
+    this.ring = shared
+  }
+  stats() {
+    return { active: false, activations: 0, activeMs: 0, level: this.buffered, maxLevel: this.buffered }
+  }
+  close() {
+    this.closed = true
+  }
+}
+
+const waitFor = async (condition, timeoutMs = 2000) => {
+  const deadline = Date.now() + timeoutMs
+  while (!condition()) {
+    if (Date.now() > deadline) {
+      throw new Error('Timed out')
+    }
+    await new Promise(resolve => setTimeout(resolve, 5))
+  }
+}
+
+describe('FlowGuard', () => {
+  it('passes its settings on', () => {
+    const guard = new FlowGuard(7, { highWater: 4096, mode: 'xoff' }, MockFlowGuardBindings)
+    assert.equal(guard.guard.fd, 7)
+    assert.deepEqual(guard.guard.options, { highWater: 4096, lowWater: 2048, mode: 1, intervalUs: 1000 })
+  })
+
+  it('validates its settings', () => {
+    assert.throws(() => new FlowGuard(7, {}, MockFlowGuardBindings), TypeError)
+    assert.throws(() => new FlowGuard(7, { highWater: 100, lowWater: 100 }, MockFlowGuardBindings), TypeError)
+    assert.throws(() => new FlowGuard(7, { highWater: 100, mode: 'dtr' }, MockFlowGuardBindings), TypeError)
+    assert.throws(() => new FlowGuard(7, { highWater: 100, intervalUs: 0 }, MockFlowGuardBindings), TypeError)
+  })
+
+  it('hands over the ring and buffered bytes until closed', () => {
+    const guard = new FlowGuard(7, { highWater: 100 }, MockFlowGuardBindings)
+    const buffer = new SharedArrayBuffer(128)
+    guard.setRingReader({ buffer })
+    guard.setBuffered(30)
+    assert.equal(guard.guard.ring.buffer, buffer)
+    assert.equal(guard.close().level, 30)
+    guard.setBuffered(50)
+    assert.isTrue(guard.guard.closed)
+    assert.equal(guard.guard.buffered, 30)
+    assert.isNull(guard.close())
+  })
+
+  describe('on a pseudo terminal', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+    const LinuxBinding = require('./linux')
+    const { VirtualPort } = require('./virtual-port')
+
+    let device
+    let binding
+    beforeEach(async () => {
+      device = new VirtualPort()
+      // a pty has no modem lines, XOFF goes to the device side like any other byte
+      binding = new LinuxBinding({ bindingOptions: { flowGuard: { highWater: 2000, lowWater: 500, mode: 'xoff' } } })
+      await binding.open(device.path, { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1 })
+    })
+
+    afterEach(async () => {
+      if (binding.isOpen) {
+        await binding.close()
+      }
+      device.close()
+    })
+
+    it('holds the sender while nobody reads and lets it go once caught up', async () => {
+      device.generate({ frames: 'flow', limit: 8000 })
+      await waitFor(() => binding.flowGuardStats().active)
+
+      const buffer = Buffer.alloc(8000)
+      let offset = 0
+      while (offset < buffer.length) {
+        offset += (await binding.read(buffer, offset, buffer.length - offset)).bytesRead
+      }
+      await waitFor(() => !binding.flowGuardStats().active)
+      const stats = binding.flowGuardStats()
+      assert.isAtLeast(stats.activations, 1)
+      assert.isAtLeast(stats.maxLevel, 2000)
+      assert.isUndefined(stats.error)
+    })
+
+    it('stops with the port', async () => {
+      await binding.close()
+      assert.isNull(binding.flowGuardStats())
+    })
+  })
+})
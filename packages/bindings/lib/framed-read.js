@@ -0,0 +1,48 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/framedRead')
+
+const readable = binding => {
+  return new Promise((resolve, reject) => {
+    binding.poller.once('readable', err => (err ? reject(err) : resolve()))
+  })
+}
+
+/**
+ * Like `unixRead()` but hands out one frame from `binding.framer` per read, the port is only read once the queued frames run out
+ */
+const framedRead = async ({ binding, buffer, offset, length }) => {
+  logger('Starting read')
+  if (!binding.isOpen) {
+    const err = new Error('Port is not open')
+    err.canceled = true
+    throw err
+  }
+
+  const { framer } = binding
+  try {
+    if (framer.hasFrames || framer.read(binding.fd)) {
+      const bytesRead = framer.copyFrame(buffer, offset, length)
+      logger('Finished read', bytesRead, 'bytes')
+      return { bytesRead, buffer }
+    }
+  } catch (err) {
+    logger('read error', err)
+    const disconnectError =
+      err.code === 'EBADF' || // Bad file number means we got closed
+      err.code === 'ENXIO' || // No such device or address probably usb disconnect
+      err.code === 'UNKNOWN' ||
+      err.errno === -1 // generic error
+
+    if (disconnectError) {
+      err.disconnect = true
+      logger('disconnecting', err)
+    }
+    throw err
+  }
+
+  logger('waiting for a complete frame')
+  await readable(binding)
+  return framedRead({ binding, buffer, offset, length })
+}
+
+module.exports = framedRead
@@ -0,0 +1,111 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/framer')
+const FramerBindings = require('bindings')('bindings.node').Framer
+
+const TYPES = ['delimiter', 'byteLength', 'lengthPrefixed', 'slip']
+
+const normalizeSpec = spec => {
+  if (!spec || TYPES.indexOf(spec.type) === -1) {
+    throw new TypeError(`"framing.type" must be one of ${TYPES.join(', ')}`)
+  }
+  const normalized = { ...spec }
+  if (spec.type === 'delimiter') {
+    if (spec.delimiter === undefined || spec.delimiter.length === 0) {
+      throw new TypeError('"framing.delimiter" has a 0 or undefined length')
+    }
+    normalized.delimiter = Buffer.from(spec.delimiter)
+  }
+  if (spec.type === 'lengthPrefixed' && normalized.lengthBytes === undefined) {
+    normalized.lengthBytes = 1
+  }
+  return normalized
+}
+
+/**
+ * Splits what is read from the port into frames in native code. Each wakeup reads everything available and returns all the frames it completed in one `Buffer`, reads through the binding then hand out one frame at a time.
+ */
+class Framer {
+  /**
+   * @param {object} spec the framing
+   * @param {string} spec.type `'delimiter'`, `'byteLength'`, `'lengthPrefixed'` or `'slip'`
+   * @param {string|Buffer|number[]} [spec.delimiter] for `'delimiter'`, the byte sequence ending a frame
+   * @param {boolean} [spec.includeDelimiter=false] for `'delimiter'`, keep the delimiter on the end of the frame
+   * @param {number} [spec.length] for `'byteLength'`, the size of each frame
+   * @param {number} [spec.lengthBytes=1] for `'lengthPrefixed'`, the size of the big endian length in front of the payload, 1, 2 or 4
+   * @param {boolean} [spec.littleEndian=false] for `'lengthPrefixed'`, the length is little endian
+   * @param {boolean} [spec.includeLength=false] for `'lengthPrefixed'`, keep the length in front of the payload
+   * @param {number} [spec.maxLength=65536] longer frames are thrown away, for `'lengthPrefixed'` a longer length means we lost sync and the framer skips ahead a byte
+   */
+  constructor(spec, Bindings = FramerBindings) {
+    if (!Bindings) {
+      throw new Error('Native framing is not supported on this platform')
+    }
+    logger('Creating framer', spec.type)
+    this.framer = new Bindings(normalizeSpec(spec))
+    this.frames = []
+    this.next = 0
+  }
+
+  get hasFrames() {
+    return this.next < this.frames.length
+  }
+
+  queue(batch) {
+    if (!batch) {
+      return false
+    }
+    const { buffer, ends } = batch
+    if (!this.hasFrames) {
+      this.frames = []
+      this.next = 0
+    }
+    let start = 0
+    for (let i = 0; i < ends.length; i++) {
+      this.frames.push(buffer.slice(start, ends[i]))
+      start = ends[i]
+    }
+    logger('Queued', ends.length, 'frames')
+    return true
+  }
+
+  /**
+   * Reads everything the port has, returns `true` if that completed any frames
+   */
+  read(fd) {
+    return this.queue(this.framer.read(fd))
+  }
+
+  /**
+   * Frames bytes that were read some other way
+   */
+  push(data) {
+    return this.queue(this.framer.push(data))
+  }
+
+  /**
+   * Copies the next frame into `buffer`, a frame longer than `length` is handed out over several calls
+   * @returns {number} the number of bytes copied
+   */
+  copyFrame(buffer, offset, length) {
+    const frame = this.frames[this.next]
+    const bytesCopied = frame.copy(buffer, offset, 0, length)
+    if (bytesCopied < frame.length) {
+      this.frames[this.next] = frame.slice(bytesCopied)
+    } else {
+      this.frames[this.next++] = null
+    }
+    return bytesCopied
+  }
+
+  /**
+   * Takes every queued frame, used when handing the port over
+   */
+  drain() {
+    const frames = this.frames.slice(this.next)
+    this.frames = []
+    this.next = 0
+    return frames.length > 0 ? Buffer.concat(frames) : null
+  }
+}
+
+module.exports = Framer
@@ -0,0 +1,144 @@
+const Framer = require('./framer')
+const framedRead = require('./framed-read')
+
+// Splits on the delimiter like the native framer, `incoming` stands in for the port
+class MockFramerBindings {
+  constructor(spec) {
+    this.spec = spec
+    this.partial = Buffer.alloc(0)
+    this.incoming = []
+    this.error = null
+  }
+  read() {
+    if (this.error) {
+      throw this.error
+    }
+    return this.push(Buffer.concat(this.incoming.splice(0)))
+  }
+  push(data) {
+    let pending = Buffer.concat([this.partial, data])
+    const frames = []
+    let position
+    while ((position = pending.indexOf(this.spec.delimiter)) !== -1) {
+      frames.push(pending.slice(0, position))
+      pending = pending.slice(position + this.spec.delimiter.length)
+    }
+    this.partial = pending
+    if (frames.length === 0) {
+      return null
+    }
+    const ends = []
+    frames.reduce((end, frame) => {
+      ends.push(end + frame.length)
+      return end + frame.length
+    }, 0)
+    return { buffer: Buffer.concat(frames), ends: Uint32Array.from(ends) }
+  }
+}
+
+const makeMockBinding = framer => {
+  return {
+    isOpen: true,
+    fd: 1,
+    framer,
+    poller: {
+      once(event, func) {
+        setImmediate(func)
+      },
+    },
+  }
+}
+
+describe('Framer', () => {
+  it('normalizes the delimiter to a Buffer', () => {
+    const framer = new Framer({ type: 'delimiter', delimiter: '\n' }, MockFramerBindings)
+    assert.deepEqual(framer.framer.spec.delimiter, Buffer.from('\n'))
+  })
+  it('defaults to a one byte length prefix', () => {
+    const framer = new Framer({ type: 'lengthPrefixed' }, MockFramerBindings)
+    assert.equal(framer.framer.spec.lengthBytes, 1)
+  })
+  it('throws on an unknown framing', () => {
+    assert.throws(() => new Framer({ type: 'cobs' }, MockFramerBindings), TypeError)
+    assert.throws(() => new Framer({ type: 'delimiter', delimiter: '' }, MockFramerBindings), TypeError)
+    assert.throws(() => new Framer({ type: 'slip' }, null))
+  })
+  it('queues every frame of a batch', () => {
+    const framer = new Framer({ type: 'delimiter', delimiter: '\n' }, MockFramerBindings)
+    assert.isFalse(framer.push(Buffer.from('ab')))
+    assert.isFalse(framer.hasFrames)
+    assert.isTrue(framer.push(Buffer.from('c\nde\nf')))
+    const buffer = Buffer.alloc(8)
+    assert.equal(framer.copyFrame(buffer, 0, 8), 3)
+    assert.equal(buffer.toString('utf8', 0, 3), 'abc')
+    assert.equal(framer.copyFrame(buffer, 0, 8), 2)
+    assert.equal(buffer.toString('utf8', 0, 2), 'de')
+    assert.isFalse(framer.hasFrames)
+  })
+  it('hands out a frame longer than the read over several reads', () => {
+    const framer = new Framer({ type: 'delimiter', delimiter: '\n' }, MockFramerBindings)
+    framer.push(Buffer.from('abcdef\n'))
+    const buffer = Buffer.alloc(4)
+    assert.equal(framer.copyFrame(buffer, 0, 4), 4)
+    assert.equal(framer.copyFrame(buffer, 0, 4), 2)
+    assert.equal(buffer.toString('utf8', 0, 2), 'ef')
+    assert.isFalse(framer.hasFrames)
+  })
+  it('drains the queued frames', () => {
+    const framer = new Framer({ type: 'delimiter', delimiter: '\n' }, MockFramerBindings)
+    framer.push(Buffer.from('ab\ncd\nef\n'))
+    framer.copyFrame(Buffer.alloc(8), 0, 8)
+    assert.deepEqual(framer.drain(), Buffer.from('cdef'))
+    assert.isNull(framer.drain())
+  })
+})
+
+describe('framedRead', () => {
+  let framer
+  let mock
+  beforeEach(() => {
+    framer = new Framer({ type: 'delimiter', delimiter: '\n' }, MockFramerBindings)
+    mock = makeMockBinding(framer)
+  })
+  it('rejects when not open', async () => {
+    mock.isOpen = false
+    const err = await shouldReject(framedRead({ binding: mock, buffer: Buffer.alloc(8), offset: 0, length: 8 }))
+    assert.isTrue(err.canceled)
+  })
+  it('returns one frame per read', async () => {
+    framer.framer.incoming.push(Buffer.from('one\ntwo\n'))
+    const buffer = Buffer.alloc(8)
+    const { bytesRead } = await framedRead({ binding: mock, buffer, offset: 2, length: 6 })
+    assert.equal(bytesRead, 3)
+    assert.equal(buffer.toString('utf8', 2, 5), 'one')
+    const second = await framedRead({ binding: mock, buffer, offset: 0, length: 8 })
+    assert.equal(second.bytesRead, 3)
+    assert.equal(buffer.toString('utf8', 0, 3), 'two')
+  })
+  it('waits for readable until a frame is complete', async () => {
+    let waits = 0
+    mock.poller.once = (event, func) => {
+      waits++
+      framer.framer.incoming.push(Buffer.from(waits === 1 ? 'par' : 'tial\n'))
+      setImmediate(func)
+    }
+    const buffer = Buffer.alloc(8)
+    const { bytesRead } = await framedRead({ binding: mock, buffer, offset: 0, length: 8 })
+    assert.equal(waits, 2)
+    assert.equal(buffer.toString('utf8', 0, bytesRead), 'partial')
+  })
+  it('marks disconnects', async () => {
+    const err = new Error('Error: ENXIO')
+    err.code = 'ENXIO'
+    framer.framer.error = err
+    const readErr = await shouldReject(framedRead({ binding: mock, buffer: Buffer.alloc(8), offset: 0, length: 8 }))
+    assert.isTrue(readErr.disconnect)
+  })
+  it('passes other errors through', async () => {
+    const err = new Error('Error: EPERM')
+    err.code = 'EPERM'
+    framer.framer.error = err
+    const readErr = await shouldReject(framedRead({ binding: mock, buffer: Buffer.alloc(8), offset: 0, length: 8 }))
+    assert.isUndefined(readErr.disconnect)
+  })
+})
@@ -2,14 +2,30 @@ const { promisify } = require('util')
 const binding = require('bindings')('bindings.node')
 const AbstractBinding = require('@serialport/binding-abstract')
 const linuxList = require('./linux-list')
+const Bridge = require('./bridge')
+const FlowGuard = require('./flow-guard')
+const Framer = require('./framer')
+const ModemWatcher = require('./modem-watcher')
+const framedRead = require('./framed-read')
 const Poller = require('./poller')
+const { RingReader } = require('./ring-reader')
+const Tap = require('./tap')
+const Uring = require('./uring')
+const openMany = require('./open-many')
+const transact = require('./transact')
+const TtyIndex = require('./tty-index')
 const unixRead = require('./unix-read')
-const unixWrite = require('./unix-write')
+const unixReconfigure = require('./unix-reconfigure')
+const WriteQueue = require('./write-queue')
+const FileWrite = require('./write-file')
 const { wrapWithHiddenComName } = require('./legacy')
 
 const defaultBindingOptions = Object.freeze({
   vmin: 1,
   vtime: 0,
+  ioBackend: 'poll',
+  maxQueueMs: 0,
+  writeLanes: ['high', 'normal'],
 })
 
 const asyncOpen = promisify(binding.open)
@@ -18,9 +34,27 @@ const asyncUpdate = promisify(binding.update)
 const asyncSet = promisify(binding.set)
 const asyncGet = promisify(binding.get)
 const asyncGetBaudRate = promisify(binding.getBaudRate)
+const asyncGetQueueSizes = promisify(binding.getQueueSizes)
 const asyncDrain = promisify(binding.drain)
 const asyncFlush = promisify(binding.flush)
 
+// drops functions like `binding` that can't be posted to another thread
+const cloneableOptions = options => {
+  const cloneable = {}
+  Object.keys(options).forEach(key => {
+    if (typeof options[key] !== 'function') {
+      cloneable[key] = options[key]
+    }
+  })
+  return cloneable
+}
+
+const detachedError = () => {
+  const err = new Error('Port was detached')
+  err.canceled = true
+  return err
+}
+
 /**
  * The linux binding layer
  */
@@ -29,11 +63,45 @@ class LinuxBinding extends AbstractBinding {
     return wrapWithHiddenComName(linuxList())
   }
 
+  /**
+   * Opens many ports at once, for gateways that open hundreds at startup. The opens run on native threads of their own rather than the libuv thread pool, ports with the same settings share one termios and each takes a single `tcsetattr` and flush.
+   * @param {Array<object>} ports `{ path, options, bindingOptions }` per port, `options` as for `open()` and `bindingOptions` as for the constructor
+   * @param {object} [options]
+   * @param {number} [options.concurrency=16] opens in progress at once, from 1 to 64
+   * @returns {Promise<Array<object>>} Resolves once every port is done with `{ path, binding }` for each open binding and `{ path, error }` for each port that didn't open, in the order given.
+   */
+  static openMany(ports, { concurrency } = {}) {
+    return openMany({ Binding: this, ports, concurrency })
+  }
+
+  /**
+   * Looks ports up by their USB attributes in an index of sysfs, without the udev query `list()` makes
+   * @param {object} query any of `serialNumber`, `locationId`, `vendorId` and `productId`
+   * @returns {Array<object>} the ports matching every attribute given, sorted by path
+   */
+  static resolve(query) {
+    return TtyIndex.shared().resolve(query)
+  }
+
   constructor(opt = {}) {
     super(opt)
     this.bindingOptions = { ...defaultBindingOptions, ...opt.bindingOptions }
     this.fd = null
     this.writeOperation = null
+    this.readOperation = null
+    this.ring = null
+    this.buffered = null
+    this.ringReader = null
+    this.bridge = null
+    this.framer = null
+    this.transaction = null
+    this.closing = false
+    this.writeQueue = null
+    this.fileWrite = null
+    this.capture = null
+    this.taps = null
+    this.flowGuard = null
+    this.modemWatchers = new Set()
   }
 
   get isOpen() {
@@ -42,42 +110,576 @@ class LinuxBinding extends AbstractBinding {
 
   async open(path, options) {
     await super.open(path, options)
-    this.openOptions = { ...this.bindingOptions, ...options }
-    const fd = await asyncOpen(path, this.openOptions)
-    this.fd = fd
-    this.poller = new Poller(fd)
+    const openOptions = { ...this.bindingOptions, ...options }
+    const fd = await asyncOpen(path, openOptions)
+    try {
+      await this.attach(fd, { path, openOptions })
+    } catch (err) {
+      await asyncClose(fd).catch(() => {})
+      throw err
+    }
   }
 
   async close() {
     await super.close()
-    const fd = this.fd
+    this.writeQueue.clear(new Error('Port is not open'))
+    this.closing = true
+    try {
+      if (this.fileWrite) {
+        // the native thread has to let go of the fd before it's closed
+        this.fileWrite.cancel()
+        await this.fileWrite.done.catch(() => {})
+      }
+      // so does a transaction on the thread pool, the ones that haven't started yet won't
+      while (this.transaction) {
+        transact.cancel(this.fd)
+        await this.transaction.catch(() => {})
+      }
+    } finally {
+      this.closing = false
+    }
+    const fd = this.releaseFd()
+    this.buffered = null
+    return asyncClose(fd)
+  }
+
+  /**
+   * Stops reading and writing and hands over the open port without closing it, so DTR isn't dropped (HUPCL) and the lock is kept. The kernel keeps the termios, modem line and lock state on the file descriptor, any bytes already read are returned in `buffered`. Pass the result to `attach()` on a binding in the same process (any worker thread) to resume.
+   * @returns {Promise} Resolves with `{ fd, path, openOptions, buffered }`, all of which can be sent with `postMessage()`.
+   */
+  async detach() {
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+    this.detaching = true
+    try {
+      // a transaction reads and writes the fd itself, whatever it reads past the response goes along in `buffered`
+      while (this.transaction) {
+        await this.transaction.catch(() => {})
+      }
+      await this.writeOperation
+      const fd = this.fd
+      this.stopPolling()
+      if (this.readOperation) {
+        // a read that was already in progress rejects as canceled, any bytes it got end up in `buffered`
+        await this.readOperation.catch(() => {})
+      }
+      // frames already read go along as plain bytes, a partial frame still in the native framer is lost
+      const queued = [this.buffered, this.framer && this.framer.drain()].filter(Boolean)
+      const state = {
+        fd,
+        path: this.path,
+        openOptions: cloneableOptions(this.openOptions),
+        buffered: queued.length > 0 ? Buffer.concat(queued) : null,
+      }
+      this.releaseFd()
+      this.buffered = null
+      return state
+    } finally {
+      this.detaching = false
+    }
+  }
+
+  /**
+   * Takes over a port handed over by `detach()`, bytes in `state.buffered` are returned by the next reads.
+   * @param {number} fd the open file descriptor
+   * @param {object} state the result of `detach()`
+   * @returns {Promise} Resolves once the port is ready for reading and writing.
+   */
+  async attach(fd, state = {}) {
+    if (typeof fd !== 'number') {
+      throw new TypeError('"fd" is not a number')
+    }
+    if (this.isOpen) {
+      throw new Error('Already open')
+    }
+    this.path = state.path
+    this.openOptions = { ...this.bindingOptions, ...state.openOptions }
+    this.buffered = state.buffered && state.buffered.length > 0 ? Buffer.from(state.buffered) : null
+    this.fd = fd
+    try {
+      this.poller = new Poller(fd)
+      if (this.openOptions.ioBackend === 'io_uring') {
+        this.ring = Uring.shared()
+      }
+      if (this.openOptions.framing) {
+        this.framer = new Framer(this.openOptions.framing)
+      }
+      if (this.openOptions.flowGuard) {
+        this.flowGuard = new FlowGuard(fd, this.openOptions.flowGuard)
+      }
+      this.writeQueue = new WriteQueue({
+        binding: this,
+        maxQueueMs: this.openOptions.maxQueueMs,
+        settings: this.openOptions,
+        lanes: this.openOptions.writeLanes,
+        getQueueSizes: () => asyncGetQueueSizes(this.fd),
+        fsWriteAsync: this.ring ? this.ring.write.bind(this.ring) : undefined,
+      })
+    } catch (err) {
+      // the native threads started so far let go of the fd, it stays with the caller
+      this.releaseFd()
+      this.buffered = null
+      throw err
+    }
+  }
+
+  /**
+   * The lanes `write()` accepts, from highest to lowest priority
+   */
+  get writeLanes() {
+    return this.bindingOptions.writeLanes
+  }
+
+  /**
+   * @returns {object} bytes queued and written per write lane, and how long writes waited in each, see `WriteQueue`
+   */
+  writeStats() {
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+    return this.writeQueue.stats()
+  }
+
+  /**
+   * Writes `request` and reads until the response is complete, all in native code on a thread pool thread. Reads through the binding wait until it's done, bytes that arrive after the response go to them. Transactions run one at a time, each occupies a thread pool thread until it resolves.
+   * @param {Buffer} request what to send
+   * @param {object} options
+   * @param {object} options.until `{ delimiter }` to read up to and including a byte sequence, `{ length }` for a fixed size or `{ lengthField: { offset, size, littleEndian, adjust } }` for a response that carries its length. The response is then `offset + size + length + adjust` bytes long.
+   * @param {number} [options.timeoutMs=1000] deadline for writing the request and reading the complete response
+   * @param {number} [options.maxLength=4096] give up if the response hasn't completed by this many bytes
+   * @param {boolean} [options.discardInput=false] throw away unread input before writing the request
+   * @returns {Promise<Buffer>} Resolves with the response. Rejects with `code` `'ETIMEDOUT'` and the partial `response` if the deadline passes.
+   */
+  async transact(request, options) {
+    if (!Buffer.isBuffer(request)) {
+      throw new TypeError('"request" is not a Buffer')
+    }
+    transact.normalizeOptions(options)
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+    if (this.ringReader) {
+      throw new Error('Cannot transact while the ring reader is running')
+    }
+    // writes queued after this wait for us, so only wait for the ones that came first
+    const previous = this.transaction
+    const pendingWrite = this.writeOperation
+    const transaction = (async () => {
+      await Promise.all([previous, pendingWrite].map(operation => operation && operation.catch(() => {})))
+      await this.interruptRead()
+      if (!this.isOpen || this.closing) {
+        const err = new Error('Port is not open')
+        err.canceled = true
+        throw err
+      }
+      this.captureData('tx', request)
+      const { response, rest } = await transact({ fd: this.fd, request, options })
+      this.captureData('rx', response)
+      if (rest.length > 0) {
+        if (this.framer) {
+          this.framer.push(rest)
+        } else {
+          this.buffered = this.buffered ? Buffer.concat([this.buffered, rest]) : rest
+        }
+      }
+      return response
+    })()
+    this.transaction = transaction
+    try {
+      return await transaction
+    } finally {
+      if (this.transaction === transaction) {
+        this.transaction = null
+      }
+    }
+  }
+
+  /**
+   * Records everything read from and written to the port in a capture file, reads through the ring reader aren't seen by the binding and aren't captured
+   * @param {CaptureWriter} writer from `@serialport/bindings/lib/capture`, several ports can share one
+   * @param {object} [options]
+   * @param {number} [options.portId=0] tells this port's records apart from the others in the capture
+   */
+  startCapture(writer, { portId = 0 } = {}) {
+    if (!writer || typeof writer.record !== 'function') {
+      throw new TypeError('"writer" is not a CaptureWriter')
+    }
+    this.capture = { writer, portId }
+  }
+
+  /**
+   * Stops recording, closing the writer is up to whoever created it
+   */
+  stopCapture() {
+    this.capture = null
+  }
+
+  captureData(direction, buffer, offset = 0, length = buffer.length - offset) {
+    if (this.capture && length > 0) {
+      this.capture.writer.record(direction, this.capture.portId, buffer, offset, length)
+    }
+  }
+
+  /**
+   * Appends the port's raw traffic to files, see `Tap`. Bytes read and written in native code go to the files without passing through JavaScript, the rest is copied in once per read or write. The taps close with the port.
+   * @param {object} options `rotateBytes`, `fsync`, `batchSize`, `flushMs` and `maxBuffered` apply to both files, see `Tap`
+   * @param {string} options.path file for the received bytes
+   * @param {string} [options.sentPath] file for the sent bytes, they aren't tapped without one
+   */
+  tap({ path, sentPath, ...options }) {
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+    if (this.taps) {
+      throw new Error('Port is already tapped')
+    }
+    const taps = { rx: new Tap(this.fd, { ...options, path, direction: 'rx' }) }
+    if (sentPath !== undefined) {
+      try {
+        taps.tx = new Tap(this.fd, { ...options, path: sentPath, direction: 'tx' })
+      } catch (err) {
+        taps.rx.close()
+        throw err
+      }
+    }
+    this.taps = taps
+  }
+
+  /**
+   * Stops tapping, the files are complete when this returns
+   * @returns {object} `{ rx, tx }` with each tap's final stats, see `Tap.close()`
+   */
+  untap() {
+    const taps = this.taps
+    this.taps = null
+    if (!taps) {
+      return null
+    }
+    return { rx: taps.rx.close(), tx: taps.tx ? taps.tx.close() : null }
+  }
+
+  tapData(direction, buffer, offset = 0, length = buffer.length - offset) {
+    const tap = this.taps && this.taps[direction]
+    if (tap && length > 0) {
+      tap.record(buffer, offset, length)
+    }
+  }
+
+  // A read in progress gives up as canceled, the stream then reads again and waits for whatever needed the port
+  async interruptRead() {
+    if (!this.readOperation) {
+      return
+    }
+    if (this.ring) {
+      this.ring.cancel(this.fd)
+    }
     this.poller.stop()
-    this.poller.destroy()
-    this.poller = null
+    await this.readOperation.catch(() => {})
+  }
+
+  /**
+   * @returns {object} what the flow guard from `bindingOptions.flowGuard` has done so far, see `FlowGuard.stats()`, `null` without one
+   */
+  flowGuardStats() {
+    return this.flowGuard ? this.flowGuard.stats() : null
+  }
+
+  /**
+   * Tells the flow guard how many bytes the reader holds but hasn't consumed, the stream calls this as it reads
+   * @param {number} bytes
+   */
+  setReadBuffered(bytes) {
+    if (this.flowGuard) {
+      this.flowGuard.setBuffered(bytes)
+    }
+  }
+
+  /**
+   * Starts a native thread that reads the port into a ring in a `SharedArrayBuffer` instead of going through `read()`. Post `ringReader.buffer` to the workers doing the processing and read it with a `RingConsumer`. Reads through the binding wait until the ring reader is stopped.
+   * @param {object} [options] `capacity` and `overflow`, see `RingReader`
+   * @returns {Promise<RingReader>} Resolves with the running reader.
+   */
+  async startRingReader(options) {
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+    if (this.ringReader) {
+      throw new Error('Ring reader is already running')
+    }
+    await this.interruptRead()
+    const ringReader = new RingReader(this.fd, options)
+    this.ringReader = ringReader
+    if (this.flowGuard) {
+      this.flowGuard.setRingReader(ringReader)
+    }
+    ringReader.once('close', () => {
+      this.ringReader = null
+      if (this.flowGuard) {
+        this.flowGuard.setRingReader(null)
+      }
+    })
+    return ringReader
+  }
+
+  /**
+   * Stops the ring reader, reads through the binding pick up where it left off
+   */
+  async stopRingReader() {
+    if (this.ringReader) {
+      this.ringReader.close()
+    }
+  }
+
+  /**
+   * Connects the port to a socket on a native thread, see `Bridge`. Reads through the binding wait until the bridge closes, writes go out between the bridge's.
+   * @param {net.Socket|number} socket a connected TCP or Unix socket, or its fd
+   * @param {object} [options] `bufferSize`, `splice`, `onModemLines` and `modemPollMs`, see `Bridge`
+   * @returns {Promise<Bridge>} Resolves with the running bridge.
+   */
+  async startBridge(socket, options) {
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+    if (this.bridge || this.ringReader) {
+      throw new Error('The port is already being read by a bridge or ring reader')
+    }
+    await this.interruptRead()
+    this.bridge = new Bridge({ ...options, binding: this, socket })
+    this.bridge.once('close', () => {
+      this.bridge = null
+    })
+    return this.bridge
+  }
+
+  /**
+   * Stops the bridge, reads through the binding pick up where it left off
+   */
+  async stopBridge() {
+    if (this.bridge) {
+      this.bridge.close()
+    }
+  }
+
+  /**
+   * Watches the modem input lines on a native thread instead of polling `get()`, see `ModemWatcher`. The watcher stops when the port closes.
+   * @param {object} [options] `lines`, `intervalUs` and `pollMs`, see `ModemWatcher`
+   * @returns {ModemWatcher} the running watcher, listen for `'change'`
+   */
+  watchModemLines(options) {
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+    const watcher = new ModemWatcher({ ...options, binding: this })
+    this.modemWatchers.add(watcher)
+    watcher.once('close', () => this.modemWatchers.delete(watcher))
+    return watcher
+  }
+
+  stopPolling() {
+    this.modemWatchers.forEach(watcher => watcher.close())
+    if (this.bridge) {
+      this.bridge.close()
+    }
+    if (this.ringReader) {
+      this.ringReader.close()
+    }
+    if (this.flowGuard) {
+      // nobody reads the port until it's attached again, the sender is let go
+      this.flowGuard.close()
+      this.flowGuard = null
+    }
+    if (this.ring) {
+      this.ring.cancel(this.fd)
+      this.ring = null
+    }
+    if (this.poller) {
+      this.poller.stop()
+      this.poller.destroy()
+      this.poller = null
+    }
+  }
+
+  releaseFd() {
+    const fd = this.fd
+    this.stopPolling()
+    // the fd number can go to another port once it's closed
+    this.untap()
     this.openOptions = null
+    this.path = null
+    this.framer = null
+    this.writeQueue = null
     this.fd = null
-    return asyncClose(fd)
+    return fd
   }
 
   async read(buffer, offset, length) {
     await super.read(buffer, offset, length)
-    return unixRead({ binding: this, buffer, offset, length })
+    // no other awaits from here on, a transaction starting meanwhile has to see this read to interrupt it
+    while (this.transaction) {
+      await this.transaction.catch(() => {})
+    }
+    if (this.buffered) {
+      const bytesRead = this.buffered.copy(buffer, offset, 0, length)
+      this.buffered = bytesRead < this.buffered.length ? this.buffered.slice(bytesRead) : null
+      this.captureData('rx', buffer, offset, bytesRead)
+      return { bytesRead, buffer }
+    }
+    const reader = this.ringReader || this.bridge
+    if (reader) {
+      const err = await new Promise(resolve => reader.once('close', resolve))
+      // a socket going wrong under a bridge is no reason to fail the port
+      if (err && err.disconnect) {
+        throw err
+      }
+      return this.read(buffer, offset, length)
+    }
+    const fsReadAsync = this.ring ? this.ring.read.bind(this.ring) : undefined
+    const operation = this.framer
+      ? framedRead({ binding: this, buffer, offset, length })
+      : unixRead({ binding: this, buffer, offset, length, fsReadAsync })
+    this.readOperation = operation.then(
+      result => {
+        this.readOperation = null
+        if (this.detaching) {
+          // keep the bytes for whoever attaches next
+          this.buffered = Buffer.from(buffer.slice(offset, offset + result.bytesRead))
+          throw detachedError()
+        }
+        this.captureData('rx', buffer, offset, result.bytesRead)
+        if (!this.framer) {
+          // the framer taps in native code
+          this.tapData('rx', buffer, offset, result.bytesRead)
+        }
+        return result
+      },
+      err => {
+        this.readOperation = null
+        throw err
+      }
+    )
+    return this.readOperation
   }
 
-  async write(buffer) {
-    this.writeOperation = super.write(buffer).then(async () => {
+  /**
+   * Writes may overlap, they go out in the order of their lane and then in the order they were made.
+   * @param {Buffer} buffer the data to write
+   * @param {object} [options]
+   * @param {string} [options.lane='normal'] one of `bindingOptions.writeLanes`, a write in a higher lane goes ahead of queued writes in the lower ones
+   * @param {number[]} [options.boundaries] end offsets of the frames in `buffer`, where a write from a higher lane may cut in
+   * @returns {Promise} Resolves once all of `buffer` is in the OS output queue.
+   */
+  async write(buffer, options) {
+    const fileWrite = this.fileWrite
+    // transactions started after this wait for it, so only wait for the one that came first
+    const transaction = this.transaction
+    const operation = super.write(buffer).then(async () => {
+      if (fileWrite) {
+        await fileWrite.done.catch(() => {})
+      }
+      if (transaction) {
+        await transaction.catch(() => {})
+      }
+      if (this.detaching) {
+        throw detachedError()
+      }
+      if (!this.isOpen) {
+        throw new Error('Port is not open')
+      }
       if (buffer.length === 0) {
         return
       }
-      await unixWrite({ binding: this, buffer })
-      this.writeOperation = null
+      await this.writeQueue.push(buffer, options)
+      this.captureData('tx', buffer)
+      this.tapData('tx', buffer)
+    })
+    this.trackWrite(operation)
+    return operation
+  }
+
+  /**
+   * Sends a file, or part of one, in native code without reading it into JavaScript, see `FileWrite`. It goes out after the writes made before it and ahead of the ones made after, transactions and `drain()` wait for it like for any write. One file at a time. Don't truncate the file until it's done, see `FileWrite`.
+   * @param {string} path the file to send
+   * @param {object} [options] `offset`, `length`, `chunkSize`, `progressBytes` and `onProgress`, see `FileWrite`
+   * @returns {Promise} Resolves with `{ bytesWritten }` once all of it is in the OS output queue. Rejects with `canceled` set after `cancelWriteFile()`.
+   */
+  async writeFile(path, options = {}) {
+    if (!this.isOpen) {
+      throw new Error('Port is not open')
+    }
+    if (this.fileWrite) {
+      throw new Error('A file is already being written')
+    }
+    const previous = [this.writeOperation, this.transaction]
+    const fileWrite = { writer: null, canceled: false }
+    fileWrite.cancel = () => {
+      fileWrite.canceled = true
+      if (fileWrite.writer) {
+        fileWrite.writer.cancel()
+      }
+    }
+    fileWrite.done = (async () => {
+      await Promise.all(previous.map(operation => operation && operation.catch(() => {})))
+      if (fileWrite.canceled) {
+        const err = new Error('File write was canceled')
+        err.canceled = true
+        throw err
+      }
+      if (this.detaching) {
+        throw detachedError()
+      }
+      if (!this.isOpen) {
+        throw new Error('Port is not open')
+      }
+      fileWrite.writer = new FileWrite({ ...options, fd: this.fd, path })
+      return fileWrite.writer.done
+    })()
+    this.fileWrite = fileWrite
+    this.trackWrite(fileWrite.done)
+    try {
+      return await fileWrite.done
+    } finally {
+      this.fileWrite = null
+    }
+  }
+
+  /**
+   * Stops the file being written after the chunk in progress
+   */
+  cancelWriteFile() {
+    if (this.fileWrite) {
+      this.fileWrite.cancel()
+    }
+  }
+
+  // `writeOperation` settles once `operation` and every earlier write are done
+  trackWrite(operation) {
+    const previous = this.writeOperation
+    const settled = operation.catch(() => {})
+    const writeOperation = previous ? Promise.all([previous, settled]).then(() => {}) : settled
+    this.writeOperation = writeOperation
+    writeOperation.then(() => {
+      if (this.writeOperation === writeOperation) {
+        this.writeOperation = null
+      }
     })
-    return this.writeOperation
   }
 
   async update(options) {
     await super.update(options)
-    return asyncUpdate(this.fd, options)
+    await asyncUpdate(this.fd, options)
+    this.openOptions.baudRate = options.baudRate
+    this.writeQueue.setSpeed(this.openOptions)
+  }
+
+  /**
+   * Changes any of the port's termios settings, and optionally its modem lines, in one verified step, see `unixReconfigure`
+   * @param {object} options any of `baudRate`, `dataBits`, `parity`, `stopBits`, `rtscts`, `xon`, `xoff`, `xany`, `hupcl`, `vmin` and `vtime`, plus `set` and `flush`
+   * @returns {Promise} Resolves once the port is reconfigured. Rejects with `rolledBack` set if the old settings were restored.
+   */
+  async reconfigure(options) {
+    await unixReconfigure({ binding: this, options })
+    this.writeQueue.setSpeed(this.openOptions)
   }
 
   async set(options) {
@@ -95,6 +697,11 @@ class LinuxBinding extends AbstractBinding {
     return asyncGetBaudRate(this.fd)
   }
 
+  async getQueueSizes() {
+    await super.getQueueSizes()
+    return asyncGetQueueSizes(this.fd)
+  }
+
   async drain() {
     await super.drain()
     await this.writeOperation
@@ -103,6 +710,7 @@ class LinuxBinding extends AbstractBinding {
 
   async flush() {
     await super.flush()
+    this.writeQueue.clear()
     return asyncFlush(this.fd)
   }
 }
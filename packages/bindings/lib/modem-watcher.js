@@ -0,0 +1,132 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/modemWatcher')
+const EventEmitter = require('events')
+const ModemWatcherBindings = require('bindings')('bindings.node').ModemWatcher
+
+const LINES = ['cts', 'dsr', 'dcd', 'ri']
+
+const hrtimeMs = () => {
+  const [seconds, nanoseconds] = process.hrtime()
+  return seconds * 1e3 + nanoseconds / 1e6
+}
+
+/**
+ * Reports changes of the modem input lines without polling `get()`. A native thread sleeps in `TIOCMIWAIT` until one of the lines changes, drivers that can't wait for changes are checked every `intervalUs`. Each change carries the driver's transition counters (`TIOCGICOUNT`), so a pulse shorter than the time to deliver it still counts. Changes that come in while the event loop is busy arrive as one `'change'`.
+ *
+ * Emits `'change'` with `{ lines, transitions, changes, timestamp }`: the `lines` now, the `transitions` of each watched line since the last event, how many changes the event stands for and when the last one was seen in milliseconds on the `process.hrtime()` clock. Drivers without counters report a line that changed as one transition and miss pulses. Emits `'close'` once it stops, with an error if the port went away.
+ *
+ * With `pollMs`, or where there's no native watcher, `binding.get()` is polled from JavaScript instead. That works with any binding and sees only the lines at each poll.
+ */
+class ModemWatcher extends EventEmitter {
+  /**
+   * @param {object} options
+   * @param {object} options.binding an open port
+   * @param {string[]} [options.lines=['cts', 'dsr', 'dcd']] any of `'cts'`, `'dsr'`, `'dcd'` and `'ri'`
+   * @param {number} [options.intervalUs=10000] how often the native thread checks a driver that can't wait for changes
+   * @param {number} [options.pollMs] poll `binding.get()` this often instead of using the native thread
+   */
+  constructor({ binding, lines = ['cts', 'dsr', 'dcd'], intervalUs = 10000, pollMs }, NativeModemWatcher = ModemWatcherBindings) {
+    super()
+    if (!binding || !binding.isOpen) {
+      throw new TypeError('"binding" must be an open binding')
+    }
+    if (!Array.isArray(lines) || lines.length === 0 || lines.some(line => !LINES.includes(line))) {
+      throw new TypeError(`"lines" must list some of ${LINES.join(', ')}`)
+    }
+    if (!Number.isInteger(intervalUs) || intervalUs < 1) {
+      throw new TypeError('"intervalUs" must be a positive integer')
+    }
+    if (!NativeModemWatcher && pollMs === undefined) {
+      pollMs = 100
+    }
+    if (pollMs !== undefined && !(pollMs > 0)) {
+      throw new TypeError('"pollMs" must be a positive number')
+    }
+    this.binding = binding
+    this.lines = lines
+    this.closed = false
+    this.watcher = null
+    this.pollTimer = null
+    this.polled = null
+    this.changes = 0
+    if (pollMs !== undefined) {
+      logger('polling', lines, 'every', pollMs, 'ms')
+      this.poll(pollMs)
+      return
+    }
+    const watched = {}
+    lines.forEach(line => (watched[line] = true))
+    this.watcher = new NativeModemWatcher(binding.fd, { lines: watched, intervalUs }, (err, event) => (err ? this.finish(err) : this.change(event)))
+    logger('watching', lines)
+  }
+
+  change({ lines, transitions, changes, timestamp }) {
+    if (this.closed) {
+      return
+    }
+    const watched = {}
+    this.lines.forEach(line => (watched[line] = transitions[line]))
+    this.emit('change', { lines, transitions: watched, changes, timestamp })
+  }
+
+  poll(pollMs) {
+    const check = async () => {
+      this.pollTimer = null
+      let lines
+      try {
+        lines = await this.binding.get()
+      } catch (err) {
+        return this.finish(err)
+      }
+      if (this.closed) {
+        return
+      }
+      const previous = this.polled
+      this.polled = lines
+      const transitions = {}
+      this.lines.forEach(line => (transitions[line] = previous && Boolean(lines[line]) !== Boolean(previous[line]) ? 1 : 0))
+      if (previous && this.lines.some(line => transitions[line])) {
+        this.changes++
+        this.emit('change', { lines, transitions, changes: 1, timestamp: hrtimeMs() })
+      }
+      this.pollTimer = setTimeout(check, pollMs)
+    }
+    check()
+  }
+
+  /**
+   * @returns {object} `{ lines, changes, waiting }`, the lines at the last change, the changes seen so far and whether the native thread waits in `TIOCMIWAIT` rather than checking every interval. The native thread adds the driver's `counts` when it keeps them and `error` once it gave up.
+   */
+  stats() {
+    if (this.watcher) {
+      return this.watcher.stats()
+    }
+    return { lines: this.polled, changes: this.changes, waiting: false }
+  }
+
+  finish(err) {
+    if (this.closed) {
+      return
+    }
+    if (err && (err.code === 'EIO' || err.code === 'ENXIO')) {
+      // the port is gone
+      err.disconnect = true
+    }
+    logger('stopped watching', err || '')
+    this.closed = true
+    clearTimeout(this.pollTimer)
+    if (this.watcher) {
+      this.watcher.close()
+    }
+    this.emit('close', err || null)
+  }
+
+  /**
+   * Stops watching, the port stays open
+   */
+  close() {
+    this.finish(null)
+  }
+}
+
+module.exports = ModemWatcher
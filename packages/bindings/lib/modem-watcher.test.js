@@ -0,0 +1,118 @@
+const ModemWatcher = require('./modem-watcher')
+
+class MockModemWatcherBindings {
+  constructor(fd, options, callback) {
+    this.fd = fd
+    this.options = options
+    this.callback = callback
+    this.closed = false
+  }
+  stats() {
+    return { lines: { cts: true, dsr: false, dcd: false, ri: false }, changes: 0, waiting: true }
+  }
+  close() {
+    this.closed = true
+  }
+}
+
+const binding = { fd: 7, isOpen: true }
+const lines = (cts, dcd) => ({ cts, dsr: false, dcd, ri: false })
+const nextEvent = (emitter, event) => new Promise(resolve => emitter.once(event, resolve))
+
+describe('ModemWatcher', () => {
+  it('passes the lines to watch on', () => {
+    const watcher = new ModemWatcher({ binding, lines: ['cts', 'ri'], intervalUs: 500 }, MockModemWatcherBindings)
+    assert.equal(watcher.watcher.fd, 7)
+    assert.deepEqual(watcher.watcher.options, { lines: { cts: true, ri: true }, intervalUs: 500 })
+    assert.isTrue(watcher.stats().waiting)
+  })
+
+  it('validates its settings', () => {
+    assert.throws(() => new ModemWatcher({ binding: { isOpen: false } }, MockModemWatcherBindings), TypeError)
+    assert.throws(() => new ModemWatcher({ binding, lines: [] }, MockModemWatcherBindings), TypeError)
+    assert.throws(() => new ModemWatcher({ binding, lines: ['rts'] }, MockModemWatcherBindings), TypeError)
+    assert.throws(() => new ModemWatcher({ binding, intervalUs: 0 }, MockModemWatcherBindings), TypeError)
+    assert.throws(() => new ModemWatcher({ binding, pollMs: -1 }, MockModemWatcherBindings), TypeError)
+  })
+
+  it('reports the transitions of the watched lines', () => {
+    const watcher = new ModemWatcher({ binding, lines: ['cts'] }, MockModemWatcherBindings)
+    const events = []
+    watcher.on('change', event => events.push(event))
+    const transitions = { cts: 2, dsr: 1, dcd: 0, ri: 0 }
+    watcher.watcher.callback(null, { lines: lines(true, false), transitions, changes: 2, timestamp: 1234.5 })
+    assert.deepEqual(events, [{ lines: lines(true, false), transitions: { cts: 2 }, changes: 2, timestamp: 1234.5 }])
+  })
+
+  it('closes on an error and marks a port that went away', async () => {
+    const watcher = new ModemWatcher({ binding }, MockModemWatcherBindings)
+    const closed = nextEvent(watcher, 'close')
+    const err = new Error('Error: Input/output error, cannot watch the modem lines')
+    err.code = 'EIO'
+    watcher.watcher.callback(err)
+    assert.isTrue((await closed).disconnect)
+    assert.isTrue(watcher.watcher.closed)
+    watcher.watcher.callback(null, { lines: lines(true, true), transitions: {}, changes: 1, timestamp: 1 })
+  })
+
+  describe('polling get()', () => {
+    it('reports lines that changed between polls', async () => {
+      const states = [lines(false, false), lines(false, false), lines(true, false)]
+      const polled = { ...binding, get: async () => states.shift() || lines(true, false) }
+      const watcher = new ModemWatcher({ binding: polled, lines: ['cts', 'dcd'], pollMs: 1 }, MockModemWatcherBindings)
+      assert.isNull(watcher.watcher)
+      const event = await nextEvent(watcher, 'change')
+      assert.deepEqual(event.transitions, { cts: 1, dcd: 0 })
+      assert.isTrue(event.lines.cts)
+      assert.isNumber(event.timestamp)
+      watcher.close()
+      assert.equal(watcher.stats().changes, 1)
+    })
+
+    it('is used where there is no native watcher', async () => {
+      const err = new Error('EIO')
+      err.code = 'EIO'
+      const failing = { ...binding, get: async () => Promise.reject(err) }
+      const watcher = new ModemWatcher({ binding: failing }, null)
+      assert.equal(await nextEvent(watcher, 'close'), err)
+    })
+  })
+
+  describe('on a pseudo terminal', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+    const LinuxBinding = require('./linux')
+    const { VirtualPort } = require('./virtual-port')
+
+    let device
+    let port
+    beforeEach(async () => {
+      device = new VirtualPort()
+      port = new LinuxBinding()
+      await port.open(device.path, { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1 })
+    })
+
+    afterEach(async () => {
+      if (port.isOpen) {
+        await port.close()
+      }
+      device.close()
+    })
+
+    it('reports a port without modem lines', async () => {
+      const err = await nextEvent(port.watchModemLines(), 'close')
+      assert.equal(err.code, 'ENOTTY')
+      assert.equal(port.modemWatchers.size, 0)
+    })
+
+    it('stops with the port', async () => {
+      port.get = async () => lines(false, false)
+      const watcher = port.watchModemLines({ pollMs: 1000 })
+      const closed = nextEvent(watcher, 'close')
+      await port.close()
+      assert.isNull(await closed)
+    })
+  })
+})
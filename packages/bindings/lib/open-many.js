@@ -0,0 +1,67 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/openMany')
+const AbstractBinding = require('@serialport/binding-abstract')
+const { promisify } = require('util')
+const nativeBinding = require('bindings')('bindings.node')
+
+const nativeOpenMany = nativeBinding.openMany
+const asyncClose = nativeBinding.close && promisify(nativeBinding.close)
+
+// mirrors OPEN_MANY_MAX_CONCURRENCY in src/serialport.h
+const MAX_CONCURRENCY = 64
+
+/**
+ * Opens a batch of ports on native threads of its own, then attaches each fd to a new binding
+ * @returns {Promise<Array<object>>} Resolves with `{ path, binding }` or `{ path, error }` per port, in order.
+ */
+const openMany = async ({ Binding, ports, concurrency = 16, openManyNative = nativeOpenMany, closeAsync = asyncClose }) => {
+  if (!Array.isArray(ports)) {
+    throw new TypeError('"ports" is not an array')
+  }
+  if (!Number.isInteger(concurrency) || concurrency < 1 || concurrency > MAX_CONCURRENCY) {
+    throw new TypeError(`"concurrency" must be an integer from 1 to ${MAX_CONCURRENCY}`)
+  }
+  const requests = ports.map(({ path, options, bindingOptions }) => {
+    const binding = new Binding({ bindingOptions })
+    return { path, binding, options: { ...binding.bindingOptions, ...options } }
+  })
+  // the same checks as open(), a port that fails them isn't sent to native code
+  await Promise.all(
+    requests.map(request =>
+      AbstractBinding.prototype.open.call(request.binding, request.path, request.options).catch(err => {
+        request.error = err
+      })
+    )
+  )
+  const valid = requests.filter(request => !request.error)
+  logger('opening', valid.length, 'ports', concurrency, 'at a time')
+  const results = await new Promise((resolve, reject) => {
+    if (valid.length === 0) {
+      return resolve([])
+    }
+    openManyNative(valid.map(({ path, options }) => ({ path, options })), concurrency, (err, results) => (err ? reject(err) : resolve(results)))
+  })
+  valid.forEach((request, i) => {
+    request.fd = results[i].fd
+    request.error = results[i].error
+  })
+  return Promise.all(
+    requests.map(async ({ path, binding, options, fd, error }) => {
+      if (error) {
+        logger('failed to open', path, error.message)
+        return { path, error }
+      }
+      try {
+        await binding.attach(fd, { path, openOptions: options })
+      } catch (err) {
+        // nobody else has the fd, it's closed here rather than leaked
+        logger('failed to attach', path, err.message)
+        await (binding.isOpen ? binding.close() : closeAsync(fd)).catch(() => {})
+        return { path, error: err }
+      }
+      return { path, binding }
+    })
+  )
+}
+
+module.exports = openMany
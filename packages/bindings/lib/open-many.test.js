@@ -0,0 +1,79 @@
+const AbstractBinding = require('@serialport/binding-abstract')
+const openMany = require('./open-many')
+
+class MockBinding extends AbstractBinding {
+  constructor(opt = {}) {
+    super(opt)
+    this.bindingOptions = { vmin: 1, vtime: 0, ...opt.bindingOptions }
+    this.fd = null
+  }
+  get isOpen() {
+    return this.fd !== null
+  }
+  async attach(fd, state) {
+    if (state.openOptions.attachError) {
+      throw state.openOptions.attachError
+    }
+    this.fd = fd
+    this.path = state.path
+    this.openOptions = state.openOptions
+  }
+}
+
+const makeNative = results => (ports, concurrency, cb) => {
+  makeNative.calls.push({ ports, concurrency })
+  setImmediate(() => cb(null, results))
+}
+
+const options = { baudRate: 9600, dataBits: 8, parity: 'none', stopBits: 1 }
+
+describe('openMany', () => {
+  beforeEach(() => {
+    makeNative.calls = []
+  })
+
+  it('attaches every port that opened and reports the rest, in order', async () => {
+    const err = new Error('Error: No such file or directory, cannot open /dev/ttyUSB1')
+    const openManyNative = makeNative([{ fd: 10 }, { error: err }, { fd: 12 }])
+    const ports = [
+      { path: '/dev/ttyUSB0', options },
+      { path: '/dev/ttyUSB1', options },
+      { path: '/dev/ttyUSB2', options: { ...options, baudRate: 115200 }, bindingOptions: { vmin: 0 } },
+    ]
+    const results = await openMany({ Binding: MockBinding, ports, concurrency: 4, openManyNative })
+    assert.equal(makeNative.calls[0].concurrency, 4)
+    assert.deepEqual(makeNative.calls[0].ports[2], { path: '/dev/ttyUSB2', options: { ...options, baudRate: 115200, vmin: 0, vtime: 0 } })
+    assert.equal(results[0].binding.fd, 10)
+    assert.equal(results[0].binding.path, '/dev/ttyUSB0')
+    assert.deepEqual(results[1], { path: '/dev/ttyUSB1', error: err })
+    assert.equal(results[2].binding.openOptions.vmin, 0)
+  })
+
+  it("doesn't send ports that fail the open() checks", async () => {
+    const openManyNative = makeNative([{ fd: 11 }])
+    const results = await openMany({ Binding: MockBinding, ports: [{ path: '', options }, { path: '/dev/ttyUSB1', options }], openManyNative })
+    assert.equal(makeNative.calls[0].ports.length, 1)
+    assert.instanceOf(results[0].error, TypeError)
+    assert.equal(results[1].binding.fd, 11)
+  })
+
+  it('closes the fd of a port that fails to attach and reports it with the rest', async () => {
+    const err = new Error('framing is not supported')
+    const openManyNative = makeNative([{ fd: 10 }, { fd: 11 }])
+    const closed = []
+    const closeAsync = async fd => closed.push(fd)
+    const ports = [{ path: '/dev/ttyUSB0', options: { ...options, attachError: err } }, { path: '/dev/ttyUSB1', options }]
+    const results = await openMany({ Binding: MockBinding, ports, openManyNative, closeAsync })
+    assert.deepEqual(closed, [10])
+    assert.deepEqual(results[0], { path: '/dev/ttyUSB0', error: err })
+    assert.equal(results[1].binding.fd, 11)
+  })
+
+  it('validates its arguments', async () => {
+    const openManyNative = makeNative([])
+    await shouldReject(openMany({ Binding: MockBinding, ports: 'ports', openManyNative }), TypeError)
+    await shouldReject(openMany({ Binding: MockBinding, ports: [], concurrency: 65, openManyNative }), TypeError)
+    assert.deepEqual(await openMany({ Binding: MockBinding, ports: [], openManyNative }), [])
+    assert.equal(makeNative.calls.length, 0)
+  })
+})
@@ -0,0 +1,198 @@
+/* eslint-disable node/no-unsupported-features/es-builtins */
+const debug = require('debug')
+const logger = debug('serialport/bindings/ring-reader')
+const EventEmitter = require('events')
+const os = require('os')
+const RingReaderBindings = require('bindings')('bindings.node').RingReader
+
+// mirrors src/ring_reader.h
+const HEADER_SIZE = 64
+const WRITE = 0
+const READ = 1
+const SEQ = 2
+const DROPPED = 3
+const STATE = 4
+const ERRNO = 5
+const STATES = ['running', 'closed', 'error']
+const RECORD_HEADER = 16
+const RECORD_WRAP = 0xffffffff
+
+const align = size => (size + 7) & ~7
+
+const errnoNames = {}
+Object.keys(os.constants.errno).forEach(name => {
+  errnoNames[os.constants.errno[name]] = name
+})
+
+const ringError = errno => {
+  const code = errnoNames[errno] || 'UNKNOWN'
+  const err = new Error(`Error: ${code}, cannot read`)
+  err.code = code
+  err.errno = errno
+  // the reader thread only stops on its own when the port goes away
+  err.disconnect = true
+  return err
+}
+
+/**
+ * Reads a ring filled by a `RingReader`. Needs nothing but the `SharedArrayBuffer`, so it works the same on any thread the buffer is posted to. Only one consumer may read a ring at a time.
+ */
+class RingConsumer {
+  constructor(buffer) {
+    if (!(buffer instanceof SharedArrayBuffer)) {
+      throw new TypeError('"buffer" is not a SharedArrayBuffer')
+    }
+    this.buffer = buffer
+    this.capacity = buffer.byteLength - HEADER_SIZE
+    this.header = new Int32Array(buffer, 0, HEADER_SIZE / 4)
+    this.bytes = new Uint8Array(buffer, HEADER_SIZE)
+    this.words = new Uint32Array(buffer, HEADER_SIZE)
+    this.doubles = new Float64Array(buffer, HEADER_SIZE)
+  }
+
+  /**
+   * `'running'`, `'closed'` or `'error'`, records published before the reader stopped can still be consumed
+   */
+  get state() {
+    return STATES[Atomics.load(this.header, STATE)]
+  }
+
+  /**
+   * The error that stopped the reader thread, if any
+   */
+  get error() {
+    return this.state === 'error' ? ringError(Atomics.load(this.header, ERRNO)) : null
+  }
+
+  /**
+   * Bytes thrown away because the ring was full, only with `overflow: 'drop'`
+   */
+  get dropped() {
+    return Atomics.load(this.header, DROPPED) >>> 0
+  }
+
+  /**
+   * Bytes waiting to be consumed
+   */
+  get pending() {
+    return (Atomics.load(this.header, WRITE) - Atomics.load(this.header, READ)) >>> 0
+  }
+
+  /**
+   * Hands every published record to `onRecord(data, timestamp)` and releases their space. `data` is a view into the ring that is only valid during the call, copy it to keep it. `timestamp` is the monotonic time in milliseconds the bytes were read at, on the same clock as `process.hrtime()`.
+   * @param {Function} onRecord called for each record in order
+   * @param {number} [maxRecords=Infinity] stop after this many records
+   * @returns {number} the number of records consumed
+   */
+  consume(onRecord, maxRecords = Infinity) {
+    const mask = this.capacity - 1
+    const write = Atomics.load(this.header, WRITE) >>> 0
+    let read = Atomics.load(this.header, READ) >>> 0
+    let count = 0
+    while (read !== write && count < maxRecords) {
+      const offset = read & mask
+      const length = this.words[offset / 4]
+      if (length === RECORD_WRAP) {
+        read = (read + this.capacity - offset) >>> 0
+      } else {
+        const start = offset + RECORD_HEADER
+        onRecord(this.bytes.subarray(start, start + length), this.doubles[(offset + 8) / 8])
+        read = (read + align(RECORD_HEADER + length)) >>> 0
+        count++
+      }
+      // release as we go so the reader thread can refill while we're busy
+      Atomics.store(this.header, READ, read | 0)
+    }
+    return count
+  }
+
+  /**
+   * Blocks the thread until there are records to consume or the reader stops. Don't call it on a thread with an event loop to keep running.
+   * @param {number} [timeout=Infinity] milliseconds
+   * @returns {boolean} `false` if it timed out
+   */
+  wait(timeout = Infinity) {
+    const seq = Atomics.load(this.header, SEQ)
+    if (this.pending > 0 || this.state !== 'running') {
+      return true
+    }
+    return Atomics.wait(this.header, SEQ, seq, timeout) !== 'timed-out'
+  }
+
+  /**
+   * Resolves when there are records to consume or the reader stops
+   * @param {number} [timeout=Infinity] milliseconds
+   * @returns {Promise<boolean>} `false` if it timed out
+   */
+  async waitAsync(timeout = Infinity) {
+    const seq = Atomics.load(this.header, SEQ)
+    if (this.pending > 0 || this.state !== 'running') {
+      return true
+    }
+    if (typeof Atomics.waitAsync === 'function') {
+      const { value } = Atomics.waitAsync(this.header, SEQ, seq, timeout)
+      return (await value) !== 'timed-out'
+    }
+    // no Atomics.waitAsync on older versions of node, poll the sequence instead
+    const started = Date.now()
+    while (Atomics.load(this.header, SEQ) === seq) {
+      if (Date.now() - started >= timeout) {
+        return false
+      }
+      await new Promise(resolve => setTimeout(resolve, 1))
+    }
+    return true
+  }
+}
+
+/**
+ * Runs a native thread that reads the port straight into a ring in a `SharedArrayBuffer`, records carry the read timestamp. Post `buffer` to any worker and read it with a `RingConsumer`, the owning thread only wakes waiting consumers. Emits `close` with an error if the port went away.
+ */
+class RingReader extends EventEmitter {
+  /**
+   * @param {number} fd an open port
+   * @param {object} [options]
+   * @param {number} [options.capacity=1048576] size of the ring in bytes, a power of two
+   * @param {string} [options.overflow='wait'] `'wait'` leaves bytes in the kernel queue while the ring is full, `'drop'` discards them and counts them in `dropped`
+   */
+  constructor(fd, { capacity = 1 << 20, overflow = 'wait' } = {}, ReaderBindings = RingReaderBindings) {
+    super()
+    if (!ReaderBindings) {
+      throw new Error('Ring readers are not supported on this platform')
+    }
+    if (typeof capacity !== 'number' || capacity < 4096 || capacity > 1 << 30 || (capacity & (capacity - 1)) !== 0) {
+      throw new TypeError('"capacity" must be a power of two between 4096 and 1073741824')
+    }
+    if (overflow !== 'wait' && overflow !== 'drop') {
+      throw new TypeError('"overflow" must be "wait" or "drop"')
+    }
+    logger('Creating ring reader with', capacity, 'bytes')
+    this.buffer = new SharedArrayBuffer(HEADER_SIZE + capacity)
+    this.consumer = new RingConsumer(this.buffer)
+    this.closed = false
+    this.reader = new ReaderBindings(fd, new Uint8Array(this.buffer), { dropWhenFull: overflow === 'drop' }, () => this.wake())
+  }
+
+  wake() {
+    Atomics.notify(this.consumer.header, SEQ)
+    if (!this.closed && this.consumer.state === 'error') {
+      logger('reader thread stopped', this.consumer.error)
+      this.close()
+    }
+  }
+
+  /**
+   * Stops the reader thread, records already in the ring can still be consumed
+   */
+  close() {
+    if (this.closed) {
+      return
+    }
+    this.closed = true
+    this.reader.close()
+    Atomics.notify(this.consumer.header, SEQ)
+    this.emit('close', this.consumer.error)
+  }
+}
+
+module.exports = { RingReader, RingConsumer }
@@ -0,0 +1,145 @@
+/* eslint-disable node/no-unsupported-features/es-builtins */
+const { RingReader, RingConsumer } = require('./ring-reader')
+
+// Plays the part of the native reader thread, same layout as src/ring_reader.cpp
+class MockReaderBindings {
+  constructor(fd, shared, options, wake) {
+    this.fd = fd
+    this.options = options
+    this.wake = wake
+    this.closed = false
+    this.header = new Int32Array(shared.buffer, 0, 16)
+    this.bytes = new Uint8Array(shared.buffer, 64)
+    this.words = new Uint32Array(shared.buffer, 64)
+    this.doubles = new Float64Array(shared.buffer, 64)
+    this.capacity = this.bytes.length
+  }
+  publish(data, timestamp = 1) {
+    let write = Atomics.load(this.header, 0) >>> 0
+    let offset = write & (this.capacity - 1)
+    if (this.capacity - offset < 16 + data.length) {
+      this.words[offset / 4] = 0xffffffff
+      write += this.capacity - offset
+      offset = 0
+    }
+    this.words[offset / 4] = data.length
+    this.doubles[(offset + 8) / 8] = timestamp
+    this.bytes.set(data, offset + 16)
+    Atomics.store(this.header, 0, (write + ((16 + data.length + 7) & ~7)) | 0)
+    Atomics.add(this.header, 2, 1)
+    this.wake()
+  }
+  fail(errno) {
+    Atomics.store(this.header, 5, errno)
+    Atomics.store(this.header, 4, 2)
+    Atomics.add(this.header, 2, 1)
+    this.wake()
+  }
+  close() {
+    this.closed = true
+  }
+}
+
+const collect = consumer => {
+  const records = []
+  consumer.consume((data, timestamp) => records.push({ data: Buffer.from(data), timestamp }))
+  return records
+}
+
+describe('RingReader', () => {
+  it('allocates a shared ring and starts the reader', () => {
+    const reader = new RingReader(5, { capacity: 4096 }, MockReaderBindings)
+    assert.instanceOf(reader.buffer, SharedArrayBuffer)
+    assert.equal(reader.buffer.byteLength, 64 + 4096)
+    assert.equal(reader.reader.fd, 5)
+    assert.isFalse(reader.reader.options.dropWhenFull)
+  })
+  it('passes the overflow policy', () => {
+    const reader = new RingReader(5, { capacity: 4096, overflow: 'drop' }, MockReaderBindings)
+    assert.isTrue(reader.reader.options.dropWhenFull)
+  })
+  it('validates options', () => {
+    assert.throws(() => new RingReader(5, { capacity: 5000 }, MockReaderBindings), TypeError)
+    assert.throws(() => new RingReader(5, { capacity: 1024 }, MockReaderBindings), TypeError)
+    assert.throws(() => new RingReader(5, { overflow: 'block' }, MockReaderBindings), TypeError)
+    assert.throws(() => new RingReader(5, {}, null))
+  })
+  it('emits close without an error when closed', () => {
+    const reader = new RingReader(5, { capacity: 4096 }, MockReaderBindings)
+    let closeError
+    reader.on('close', err => (closeError = err))
+    reader.close()
+    reader.close()
+    assert.isTrue(reader.reader.closed)
+    assert.isNull(closeError)
+  })
+  it('closes with a disconnect error when the reader thread fails', () => {
+    const reader = new RingReader(5, { capacity: 4096 }, MockReaderBindings)
+    let closeError
+    reader.on('close', err => (closeError = err))
+    reader.reader.fail(5)
+    assert.isTrue(reader.closed)
+    assert.equal(closeError.code, 'EIO')
+    assert.isTrue(closeError.disconnect)
+    assert.equal(reader.consumer.state, 'error')
+  })
+})
+
+describe('RingConsumer', () => {
+  it('requires a SharedArrayBuffer', () => {
+    assert.throws(() => new RingConsumer(new ArrayBuffer(128)), TypeError)
+  })
+  it('consumes records in order with their timestamps', () => {
+    const reader = new RingReader(5, { capacity: 4096 }, MockReaderBindings)
+    reader.reader.publish(Buffer.from('abc'), 10)
+    reader.reader.publish(Buffer.from('defgh'), 11.5)
+    const consumer = new RingConsumer(reader.buffer)
+    assert.equal(consumer.pending, 48)
+    assert.deepEqual(collect(consumer), [
+      { data: Buffer.from('abc'), timestamp: 10 },
+      { data: Buffer.from('defgh'), timestamp: 11.5 },
+    ])
+    assert.equal(consumer.pending, 0)
+    assert.deepEqual(collect(consumer), [])
+  })
+  it('stops after maxRecords', () => {
+    const reader = new RingReader(5, { capacity: 4096 }, MockReaderBindings)
+    reader.reader.publish(Buffer.from('a'))
+    reader.reader.publish(Buffer.from('b'))
+    const consumer = new RingConsumer(reader.buffer)
+    assert.equal(consumer.consume(() => {}, 1), 1)
+    assert.deepEqual(collect(consumer).map(record => record.data.toString()), ['b'])
+  })
+  it('follows records around the end of the ring', () => {
+    const reader = new RingReader(5, { capacity: 4096 }, MockReaderBindings)
+    const consumer = new RingConsumer(reader.buffer)
+    const chunk = Buffer.alloc(1000, 1)
+    const received = []
+    for (let i = 0; i < 20; i++) {
+      chunk[0] = i
+      reader.reader.publish(chunk)
+      consumer.consume(data => received.push(data[0]))
+    }
+    assert.deepEqual(received, [...Array(20).keys()])
+  })
+  it('reports the reader state and dropped bytes', () => {
+    const reader = new RingReader(5, { capacity: 4096 }, MockReaderBindings)
+    const consumer = new RingConsumer(reader.buffer)
+    assert.equal(consumer.state, 'running')
+    assert.isNull(consumer.error)
+    Atomics.store(reader.reader.header, 3, 42)
+    assert.equal(consumer.dropped, 42)
+    reader.reader.fail(6)
+    assert.equal(consumer.state, 'error')
+    assert.equal(consumer.error.code, 'ENXIO')
+  })
+  it('waits until records are published', async () => {
+    const reader = new RingReader(5, { capacity: 4096 }, MockReaderBindings)
+    const consumer = new RingConsumer(reader.buffer)
+    assert.isFalse(consumer.wait(1))
+    const waiting = consumer.waitAsync(1000)
+    setTimeout(() => reader.reader.publish(Buffer.from('a')), 5)
+    assert.isTrue(await waiting)
+    assert.isTrue(consumer.wait(0))
+  })
+})
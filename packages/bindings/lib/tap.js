@@ -0,0 +1,98 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/tap')
+const TapBindings = require('bindings')('bindings.node').Tap
+
+// mirrors src/tap.h
+const DIRECTIONS = ['rx', 'tx']
+const FSYNC_POLICIES = ['none', 'rotate', 'always']
+
+/**
+ * Appends one direction of a port's raw traffic to a file. The ring reader, framer, transactions and bridges copy what they read and write straight into the tap in native code, reads and writes through `fs` go through `record()`. Either way the bytes land in a batch that a native thread writes out, the file gets no framing or timestamps. Not available on Windows.
+ */
+class Tap {
+  /**
+   * @param {number} fd the open port
+   * @param {object} options
+   * @param {string} options.path the live file, appended to if it exists
+   * @param {string} [options.direction='rx'] `'rx'` for received bytes or `'tx'` for sent ones, a port takes one tap in each direction
+   * @param {number} [options.rotateBytes=0] once the live file has this many bytes it's renamed to `path.<ms since the epoch>` and a new one started, `0` to never rotate
+   * @param {string} [options.fsync='rotate'] `'none'` to leave it to the OS, `'rotate'` to sync a file before rotating or closing it, `'always'` to sync after every batch
+   * @param {number} [options.batchSize=262144] bytes to collect before writing, fewer go out after `flushMs`
+   * @param {number} [options.flushMs=1000] longest time bytes wait in memory
+   * @param {number} [options.maxBuffered=4 * batchSize] bytes to hold while the disk is slow, more than that are dropped and counted
+   */
+  constructor(fd, { path, direction = 'rx', rotateBytes = 0, fsync = 'rotate', batchSize, flushMs, maxBuffered }, NativeTap = TapBindings) {
+    if (!NativeTap) {
+      throw new Error('Taps are not supported on this platform')
+    }
+    if (typeof path !== 'string') {
+      throw new TypeError('"path" must be a string')
+    }
+    if (!DIRECTIONS.includes(direction)) {
+      throw new TypeError(`"direction" must be one of ${DIRECTIONS.join(', ')}`)
+    }
+    if (!FSYNC_POLICIES.includes(fsync)) {
+      throw new TypeError(`"fsync" must be one of ${FSYNC_POLICIES.join(', ')}`)
+    }
+    if (!Number.isInteger(rotateBytes) || rotateBytes < 0) {
+      throw new TypeError('"rotateBytes" must be a positive integer')
+    }
+    this.path = path
+    this.direction = direction
+    this.tap = new NativeTap(fd, {
+      path,
+      direction: DIRECTIONS.indexOf(direction),
+      rotateBytes,
+      fsync: FSYNC_POLICIES.indexOf(fsync),
+      batchSize,
+      flushMs,
+      maxBuffered,
+    })
+    this.closed = false
+    logger('tapping', direction, 'to', path)
+  }
+
+  /**
+   * Copies bytes that didn't go through native code, the buffer can be reused right away
+   * @param {Buffer} buffer
+   * @param {number} [offset=0]
+   * @param {number} [length=buffer.length - offset]
+   */
+  record(buffer, offset, length) {
+    if (!this.closed) {
+      this.tap.record(buffer, offset, length)
+    }
+  }
+
+  /**
+   * @returns {object} `{ bytes, written, dropped, rotations }` so far, `error` with the code once writing has failed
+   */
+  stats() {
+    return this.tap.stats()
+  }
+
+  /**
+   * Starts writing the current batch out even though it isn't full
+   */
+  flush() {
+    if (!this.closed) {
+      this.tap.flush()
+    }
+  }
+
+  /**
+   * Writes the remaining bytes and closes the file
+   * @returns {object} the final stats, check `error` to be sure everything made it to disk
+   */
+  close() {
+    if (this.closed) {
+      return null
+    }
+    this.closed = true
+    const stats = this.tap.close()
+    logger('closed tap on', this.path, stats)
+    return stats
+  }
+}
+
+module.exports = Tap
@@ -0,0 +1,108 @@
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+const Tap = require('./tap')
+
+class MockTapBindings {
+  constructor(fd, options) {
+    this.fd = fd
+    this.options = options
+    this.recorded = []
+    this.closed = false
+  }
+  record(buffer, offset, length) {
+    this.recorded.push(Buffer.from(buffer.slice(offset, offset + length)))
+  }
+  stats() {
+    return { bytes: Buffer.concat(this.recorded).length, written: 0, dropped: 0, rotations: 0 }
+  }
+  flush() {}
+  close() {
+    this.closed = true
+    return this.stats()
+  }
+}
+
+describe('Tap', () => {
+  it('passes its settings on', () => {
+    const tap = new Tap(7, { path: '/tmp/port.log', direction: 'tx', rotateBytes: 1000, fsync: 'always' }, MockTapBindings)
+    assert.equal(tap.tap.fd, 7)
+    assert.containSubset(tap.tap.options, { path: '/tmp/port.log', direction: 1, rotateBytes: 1000, fsync: 2 })
+  })
+
+  it('validates its settings', () => {
+    assert.throws(() => new Tap(7, {}, MockTapBindings), TypeError)
+    assert.throws(() => new Tap(7, { path: 'a', direction: 'both' }, MockTapBindings), TypeError)
+    assert.throws(() => new Tap(7, { path: 'a', fsync: 'sometimes' }, MockTapBindings), TypeError)
+    assert.throws(() => new Tap(7, { path: 'a', rotateBytes: -1 }, MockTapBindings), TypeError)
+  })
+
+  it('stops recording once closed', () => {
+    const tap = new Tap(7, { path: 'a' }, MockTapBindings)
+    tap.record(Buffer.from('abcdef'), 1, 3)
+    assert.deepEqual(tap.close(), { bytes: 3, written: 0, dropped: 0, rotations: 0 })
+    tap.record(Buffer.from('gh'))
+    assert.isNull(tap.close())
+    assert.deepEqual(tap.tap.recorded, [Buffer.from('bcd')])
+  })
+
+  describe('on a pseudo terminal', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+    const LinuxBinding = require('./linux')
+    const { VirtualPort } = require('./virtual-port')
+
+    let device
+    let binding
+    let dir
+    beforeEach(async () => {
+      dir = fs.mkdtempSync(path.join(os.tmpdir(), 'tap-'))
+      device = new VirtualPort({ echo: true })
+      binding = new LinuxBinding()
+      await binding.open(device.path, { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1 })
+    })
+
+    afterEach(async () => {
+      if (binding.isOpen) {
+        await binding.close()
+      }
+      device.close()
+      fs.readdirSync(dir).forEach(file => fs.unlinkSync(path.join(dir, file)))
+      fs.rmdirSync(dir)
+    })
+
+    it('writes what was sent and received to the files', async () => {
+      const received = path.join(dir, 'rx.log')
+      const sent = path.join(dir, 'tx.log')
+      binding.tap({ path: received, sentPath: sent })
+      await binding.write(Buffer.from('hello'))
+      const buffer = Buffer.alloc(5)
+      let offset = 0
+      while (offset < 5) {
+        offset += (await binding.read(buffer, offset, 5 - offset)).bytesRead
+      }
+      const { rx, tx } = binding.untap()
+      assert.containSubset(rx, { bytes: 5, written: 5, dropped: 0 })
+      assert.containSubset(tx, { bytes: 5, written: 5, dropped: 0 })
+      assert.equal(fs.readFileSync(received, 'utf8'), 'hello')
+      assert.equal(fs.readFileSync(sent, 'utf8'), 'hello')
+    })
+
+    it('taps the ring reader and rotates the file', async () => {
+      const received = path.join(dir, 'rx.log')
+      binding.tap({ path: received, rotateBytes: 1000, batchSize: 4096, flushMs: 10 })
+      await binding.startRingReader()
+      device.generate({ frames: 'x', limit: 5000 })
+      await new Promise(resolve => setTimeout(resolve, 200))
+      await binding.stopRingReader()
+      const { rx } = binding.untap()
+      assert.containSubset(rx, { bytes: 5000, written: 5000, dropped: 0 })
+      assert.isAtLeast(rx.rotations, 4)
+      const files = fs.readdirSync(dir)
+      const total = files.reduce((sum, file) => sum + fs.statSync(path.join(dir, file)).size, 0)
+      assert.equal(total, 5000)
+    })
+  })
+})
@@ -0,0 +1,82 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/transact')
+const { transact: nativeTransact, cancelTransact: nativeCancelTransact } = require('bindings')('bindings.node')
+
+const normalizeOptions = ({ until, timeoutMs = 1000, maxLength = 4096, discardInput = false } = {}) => {
+  const options = {
+    until: null,
+    delimiter: null,
+    length: 0,
+    fieldOffset: 0,
+    fieldSize: 1,
+    fieldLittleEndian: false,
+    fieldAdjust: 0,
+    timeoutMs,
+    maxLength,
+    discardInput: !!discardInput,
+  }
+  if (!until) {
+    throw new TypeError('"until" is required')
+  }
+  if (until.delimiter !== undefined) {
+    if (until.delimiter.length === 0) {
+      throw new TypeError('"until.delimiter" has a 0 or undefined length')
+    }
+    options.until = 'delimiter'
+    options.delimiter = Buffer.from(until.delimiter)
+  } else if (until.length !== undefined) {
+    if (!Number.isInteger(until.length) || until.length < 1) {
+      throw new TypeError('"until.length" must be a positive integer')
+    }
+    options.until = 'length'
+    options.length = until.length
+  } else if (until.lengthField) {
+    const { offset = 0, size = 1, littleEndian = false, adjust = 0 } = until.lengthField
+    if (size !== 1 && size !== 2 && size !== 4) {
+      throw new TypeError('"until.lengthField.size" must be 1, 2 or 4')
+    }
+    options.until = 'lengthField'
+    options.fieldOffset = offset
+    options.fieldSize = size
+    options.fieldLittleEndian = !!littleEndian
+    options.fieldAdjust = adjust
+  } else {
+    throw new TypeError('"until" needs a "delimiter", "length" or "lengthField"')
+  }
+  if (!Number.isInteger(timeoutMs) || timeoutMs < 0) {
+    throw new TypeError('"timeoutMs" must be a positive integer')
+  }
+  if (!Number.isInteger(maxLength) || maxLength < 1) {
+    throw new TypeError('"maxLength" must be a positive integer')
+  }
+  return options
+}
+
+/**
+ * Writes the request and reads until the response is complete or the deadline passes, in a single thread pool job
+ * @returns {Promise} Resolves with `{ response, rest }`, `rest` holds anything read after the response.
+ */
+const transact = ({ fd, request, options, transactNative = nativeTransact }) => {
+  const transactOptions = normalizeOptions(options)
+  logger('Starting transaction', transactOptions.until)
+  return new Promise((resolve, reject) => {
+    transactNative(fd, request, transactOptions, (err, response, rest) => {
+      if (err) {
+        logger('transaction error', err)
+        return reject(err)
+      }
+      logger('Finished transaction', response.length, 'bytes')
+      resolve({ response, rest })
+    })
+  })
+}
+
+/**
+ * Wakes up the transactions queued or running on the fd, they reject with `canceled` set. Whatever came in so far is in the error's `response`.
+ * @returns {number} how many there were
+ */
+transact.cancel = (fd, cancelNative = nativeCancelTransact) => cancelNative(fd)
+
+transact.normalizeOptions = normalizeOptions
+
+module.exports = transact
@@ -0,0 +1,95 @@
+const transact = require('./transact')
+
+const makeNative = (err, response, rest) => (fd, request, options, cb) => {
+  makeNative.calls.push({ fd, request, options })
+  setImmediate(() => cb(err, response, rest))
+}
+
+describe('transact', () => {
+  beforeEach(() => {
+    makeNative.calls = []
+  })
+  it('resolves with the response and what came after it', async () => {
+    const transactNative = makeNative(null, Buffer.from('OK\r\n'), Buffer.from('+RING'))
+    const { response, rest } = await transact({ fd: 3, request: Buffer.from('AT\r'), options: { until: { delimiter: '\r\n' } }, transactNative })
+    assert.deepEqual(response, Buffer.from('OK\r\n'))
+    assert.deepEqual(rest, Buffer.from('+RING'))
+    assert.equal(makeNative.calls[0].fd, 3)
+    assert.deepEqual(makeNative.calls[0].options.delimiter, Buffer.from('\r\n'))
+  })
+  it('rejects with the native error', async () => {
+    const err = new Error('Error: timed out')
+    err.code = 'ETIMEDOUT'
+    const transactNative = makeNative(err)
+    const transactErr = await shouldReject(transact({ fd: 3, request: Buffer.from('AT\r'), options: { until: { length: 4 } }, transactNative }))
+    assert.equal(transactErr.code, 'ETIMEDOUT')
+  })
+
+  describe('on a pseudo terminal', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+    const LinuxBinding = require('./linux')
+    const { VirtualPort } = require('./virtual-port')
+
+    let device
+    let binding
+    beforeEach(async () => {
+      device = new VirtualPort({ echo: true })
+      binding = new LinuxBinding()
+      await binding.open(device.path, { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1 })
+    })
+
+    afterEach(async () => {
+      if (binding.isOpen) {
+        await binding.close()
+      }
+      device.close()
+    })
+
+    it('runs a transaction made right after a write once the write is out', async () => {
+      const write = binding.write(Buffer.from('hello'))
+      const response = binding.transact(Buffer.from('ping\n'), { until: { delimiter: '\n' } })
+      await write
+      assert.deepEqual(await response, Buffer.from('helloping\n'))
+    })
+
+    it('cancels a transaction still waiting for its response when the port closes', async () => {
+      const response = binding.transact(Buffer.from('ping'), { until: { length: 100 }, timeoutMs: 10000 })
+      const started = Date.now()
+      await binding.close()
+      const err = await shouldReject(response)
+      assert.isTrue(err.canceled)
+      assert.isBelow(Date.now() - started, 5000)
+    })
+
+    it('runs a write made right after a transaction once the transaction is done', async () => {
+      const response = binding.transact(Buffer.from('ping\n'), { until: { delimiter: '\n' } })
+      const write = binding.write(Buffer.from('after'))
+      assert.deepEqual(await response, Buffer.from('ping\n'))
+      await write
+    })
+  })
+
+  describe('.normalizeOptions', () => {
+    it('fills in the defaults', () => {
+      const options = transact.normalizeOptions({ until: { length: 8 } })
+      assert.include(options, { until: 'length', length: 8, timeoutMs: 1000, maxLength: 4096, discardInput: false })
+    })
+    it('flattens a length field', () => {
+      const options = transact.normalizeOptions({ until: { lengthField: { offset: 2, adjust: 2 } } })
+      assert.include(options, { until: 'lengthField', fieldOffset: 2, fieldSize: 1, fieldLittleEndian: false, fieldAdjust: 2 })
+    })
+    it('throws on a bad until', () => {
+      assert.throws(() => transact.normalizeOptions({}), TypeError)
+      assert.throws(() => transact.normalizeOptions({ until: {} }), TypeError)
+      assert.throws(() => transact.normalizeOptions({ until: { delimiter: '' } }), TypeError)
+      assert.throws(() => transact.normalizeOptions({ until: { length: 0 } }), TypeError)
+      assert.throws(() => transact.normalizeOptions({ until: { lengthField: { size: 3 } } }), TypeError)
+    })
+    it('throws on a bad timeout', () => {
+      assert.throws(() => transact.normalizeOptions({ until: { length: 1 }, timeoutMs: -1 }), TypeError)
+    })
+  })
+})
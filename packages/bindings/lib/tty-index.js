@@ -0,0 +1,85 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/ttyIndex')
+const TtyIndexBindings = require('bindings')('bindings.node').TtyIndex
+
+const QUERY_KEYS = ['serialNumber', 'locationId', 'vendorId', 'productId']
+
+let sharedIndex
+
+// list() reports USB ids without a 0x prefix, accept either and any case
+const normalizeId = id => id.replace(/^0x/i, '').toLowerCase()
+
+/**
+ * An index of the ttys in sysfs by USB serial number, location, vendor and product id. Resolving a port re-reads the attributes of ttys that appeared or were re-created since the last lookup and nothing else, so it's cheap enough for every reconnect. Only on Linux.
+ *
+ * The `locationId` is the name sysfs gives the USB device, the bus and the hub ports it's plugged into (eg `1-1.4`). It stays the same when the device is plugged back into the same socket. `list()` doesn't report it on Linux.
+ */
+class TtyIndex {
+  /**
+   * @param {object} [options]
+   * @param {string} [options.classDir='/sys/class/tty'] where to find the ttys
+   * @param {string} [options.devDir='/dev'] where their device nodes are
+   */
+  constructor({ classDir, devDir } = {}, NativeTtyIndex = TtyIndexBindings) {
+    if (!NativeTtyIndex) {
+      throw new Error('The tty index is not supported on this platform')
+    }
+    this.index = new NativeTtyIndex(classDir, devDir)
+  }
+
+  /**
+   * Returns the index of the system's ttys, shared by every binding on the thread
+   * @returns {TtyIndex} the shared index
+   */
+  static shared(NativeTtyIndex = TtyIndexBindings) {
+    if (!sharedIndex) {
+      sharedIndex = new TtyIndex({}, NativeTtyIndex)
+    }
+    return sharedIndex
+  }
+
+  /**
+   * Catches up with ttys that came and went since the last call
+   * @returns {object} `{ added, removed, ports }`
+   */
+  refresh() {
+    const changes = this.index.refresh()
+    if (changes.added || changes.removed) {
+      logger('refreshed', changes)
+    }
+    return changes
+  }
+
+  /**
+   * Finds the ports with every attribute given
+   * @param {object} query
+   * @param {string} [query.serialNumber]
+   * @param {string} [query.locationId]
+   * @param {string} [query.vendorId]
+   * @param {string} [query.productId]
+   * @returns {Array<object>} the matching ports sorted by path, with the fields `list()` reports
+   */
+  resolve(query) {
+    if (typeof query !== 'object' || query === null) {
+      throw new TypeError('"query" is not an object')
+    }
+    const wanted = {}
+    QUERY_KEYS.forEach(key => {
+      const value = query[key]
+      if (value === undefined) {
+        return
+      }
+      if (typeof value !== 'string' || value === '') {
+        throw new TypeError(`"${key}" must be a non-empty string`)
+      }
+      wanted[key] = key === 'vendorId' || key === 'productId' ? normalizeId(value) : value
+    })
+    if (Object.keys(wanted).length === 0) {
+      throw new TypeError(`"query" needs at least one of ${QUERY_KEYS.join(', ')}`)
+    }
+    this.refresh()
+    return this.index.find(wanted).sort((a, b) => (a.path < b.path ? -1 : a.path > b.path ? 1 : 0))
+  }
+}
+
+module.exports = TtyIndex
@@ -0,0 +1,114 @@
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+const TtyIndex = require('./tty-index')
+
+class MockTtyIndexBindings {
+  constructor(classDir, devDir) {
+    this.classDir = classDir
+    this.devDir = devDir
+    this.refreshes = 0
+    this.ports = [
+      { path: '/dev/ttyUSB1', serialNumber: 'A123', vendorId: '0403', productId: '6001', locationId: '1-1.4' },
+      { path: '/dev/ttyUSB0', serialNumber: 'A123', vendorId: '0403', productId: '6001', locationId: '1-1.2' },
+    ]
+  }
+  refresh() {
+    this.refreshes++
+    return { added: 0, removed: 0, ports: this.ports.length }
+  }
+  find(query) {
+    this.query = query
+    return this.ports.filter(port => Object.keys(query).every(key => port[key] === query[key]))
+  }
+}
+
+describe('TtyIndex', () => {
+  it('refreshes before every lookup and sorts by path', () => {
+    const index = new TtyIndex({ classDir: '/tmp/class' }, MockTtyIndexBindings)
+    assert.equal(index.index.classDir, '/tmp/class')
+    assert.deepEqual(index.resolve({ serialNumber: 'A123' }).map(port => port.path), ['/dev/ttyUSB0', '/dev/ttyUSB1'])
+    assert.deepEqual(index.resolve({ locationId: '1-1.4' }).map(port => port.path), ['/dev/ttyUSB1'])
+    assert.equal(index.index.refreshes, 2)
+  })
+
+  it('matches USB ids written like list() or with 0x', () => {
+    const index = new TtyIndex({}, MockTtyIndexBindings)
+    assert.lengthOf(index.resolve({ vendorId: '0x0403', productId: '6001' }), 2)
+    assert.deepEqual(index.index.query, { vendorId: '0403', productId: '6001' })
+  })
+
+  it('validates the query', () => {
+    const index = new TtyIndex({}, MockTtyIndexBindings)
+    assert.throws(() => index.resolve(), TypeError)
+    assert.throws(() => index.resolve({}), TypeError)
+    assert.throws(() => index.resolve({ path: '/dev/ttyUSB0' }), TypeError)
+    assert.throws(() => index.resolve({ serialNumber: 123 }), TypeError)
+    assert.equal(index.index.refreshes, 0)
+  })
+
+  describe('on a sysfs tree', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+
+    // the layout of a usb-serial adapter: class link -> tty -> port -> interface -> USB device
+    let root
+    const mkdirs = dir => {
+      if (!fs.existsSync(dir)) {
+        mkdirs(path.dirname(dir))
+        fs.mkdirSync(dir)
+      }
+    }
+    const removeTree = file => {
+      if (fs.lstatSync(file).isDirectory()) {
+        fs.readdirSync(file).forEach(name => removeTree(path.join(file, name)))
+        fs.rmdirSync(file)
+      } else {
+        fs.unlinkSync(file)
+      }
+    }
+    const addUsbTty = (name, location, attributes) => {
+      const device = path.join(root, 'devices', location)
+      const tty = path.join(device, `${location}:1.0`, name, 'tty', name)
+      mkdirs(tty)
+      fs.symlinkSync('../..', path.join(tty, 'device'))
+      Object.keys(attributes).forEach(key => fs.writeFileSync(path.join(device, key), `${attributes[key]}\n`))
+      fs.symlinkSync(tty, path.join(root, 'class', name))
+    }
+    const removeTty = name => fs.unlinkSync(path.join(root, 'class', name))
+
+    beforeEach(() => {
+      root = fs.mkdtempSync(path.join(os.tmpdir(), 'tty-index-'))
+      fs.mkdirSync(path.join(root, 'class'))
+      mkdirs(path.join(root, 'devices', 'virtual', 'tty0'))
+      fs.symlinkSync(path.join(root, 'devices', 'virtual', 'tty0'), path.join(root, 'class', 'tty0'))
+    })
+
+    afterEach(() => {
+      removeTree(root)
+    })
+
+    it('reads the USB attributes of each tty', () => {
+      addUsbTty('ttyUSB0', '1-1.4', { idVendor: '0403', idProduct: '6001', serial: 'A123', manufacturer: 'FTDI' })
+      const index = new TtyIndex({ classDir: path.join(root, 'class') })
+      assert.deepEqual(index.resolve({ serialNumber: 'A123' }), [
+        { path: '/dev/ttyUSB0', manufacturer: 'FTDI', serialNumber: 'A123', locationId: '1-1.4', vendorId: '0403', productId: '6001' },
+      ])
+      assert.deepEqual(index.refresh(), { added: 0, removed: 0, ports: 2 })
+    })
+
+    it('follows a device that comes back under another name', () => {
+      addUsbTty('ttyUSB0', '1-1.4', { idVendor: '0403', idProduct: '6001', serial: 'A123' })
+      const index = new TtyIndex({ classDir: path.join(root, 'class') })
+      assert.lengthOf(index.resolve({ locationId: '1-1.4' }), 1)
+
+      removeTty('ttyUSB0')
+      addUsbTty('ttyUSB1', '1-1.3', { idVendor: '0403', idProduct: '6001', serial: 'A123' })
+      assert.deepEqual(index.refresh(), { added: 1, removed: 1, ports: 2 })
+      assert.deepEqual(index.resolve({ serialNumber: 'A123' }).map(port => port.path), ['/dev/ttyUSB1'])
+      assert.lengthOf(index.resolve({ locationId: '1-1.4' }), 0)
+    })
+  })
+})
@@ -0,0 +1,27 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/unixReconfigure')
+const { promisify } = require('util')
+const nativeBinding = require('bindings')('bindings.node')
+
+const asyncReconfigure = nativeBinding.reconfigure && promisify(nativeBinding.reconfigure)
+
+/**
+ * Changes any of the port's termios settings, and optionally its modem lines, in one call on the thread pool. What the driver took is read back and checked, if it didn't take everything the port is put back the way it was. Shared by the Linux and Darwin bindings.
+ * @param {object} options
+ * @param {object} options.binding an open binding, its `openOptions` are updated once the change is through
+ * @param {object} options.options any of `baudRate`, `dataBits`, `parity`, `stopBits`, `rtscts`, `xon`, `xoff`, `xany`, `hupcl`, `vmin` and `vtime`, the others keep their current values. `set` takes `{ rts, dtr, brk }` to set the modem lines as part of the change, `rts` and `dtr` default to `true`. `flush` set to `false` keeps unread and unsent data, otherwise it is thrown away once before the change.
+ * @returns {Promise<object>} Resolves with the new settings once the port is reconfigured. Rejects with `rolledBack` set if the old settings were restored.
+ */
+const unixReconfigure = async ({ binding, options: { set, flush, ...options }, reconfigureAsync = asyncReconfigure }) => {
+  if (!binding.isOpen) {
+    throw new Error('Port is not open')
+  }
+  const settings = { ...binding.openOptions, ...options }
+  const modem = set && { rts: set.rts !== false, dtr: set.dtr !== false, brk: !!set.brk }
+  logger('reconfiguring', options, modem)
+  await reconfigureAsync(binding.fd, { ...settings, flush, modem })
+  binding.openOptions = settings
+  return settings
+}
+
+module.exports = unixReconfigure
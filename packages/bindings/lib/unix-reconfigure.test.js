@@ -0,0 +1,68 @@
+const { execFileSync } = require('child_process')
+const unixReconfigure = require('./unix-reconfigure')
+
+const makeBinding = () => ({ isOpen: true, fd: 7, openOptions: { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1, vmin: 1 } })
+
+describe('unixReconfigure', () => {
+  it('merges the changes into the open settings and fills in the modem lines', async () => {
+    const binding = makeBinding()
+    const calls = []
+    const reconfigureAsync = async (fd, options) => calls.push({ fd, options })
+    await unixReconfigure({ binding, options: { dataBits: 7, set: { rts: false }, flush: false }, reconfigureAsync })
+    assert.deepEqual(calls[0], {
+      fd: 7,
+      options: { baudRate: 115200, dataBits: 7, parity: 'none', stopBits: 1, vmin: 1, flush: false, modem: { rts: false, dtr: true, brk: false } },
+    })
+    assert.equal(binding.openOptions.dataBits, 7)
+    assert.isUndefined(binding.openOptions.set)
+  })
+
+  it('keeps the settings when the change is rolled back', async () => {
+    const binding = makeBinding()
+    const err = new Error('Error: Invalid argument, cannot set all of the settings')
+    err.rolledBack = true
+    const reconfigureAsync = async () => Promise.reject(err)
+    await shouldReject(unixReconfigure({ binding, options: { baudRate: 9600 }, reconfigureAsync }), Error)
+    assert.equal(binding.openOptions.baudRate, 115200)
+  })
+
+  it('rejects when the port is closed', async () => {
+    const binding = { ...makeBinding(), isOpen: false }
+    await shouldReject(unixReconfigure({ binding, options: {}, reconfigureAsync: async () => {} }), Error)
+  })
+
+  describe('on a pseudo terminal', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+    const LinuxBinding = require('./linux')
+    const { VirtualPort } = require('./virtual-port')
+    // the pty keeps the termios flags it's given, stty reads them back
+    const hupcl = path => !/(^|\s)-hupcl(\s|$)/.test(execFileSync('stty', ['-F', path, '-a']).toString())
+
+    let device
+    let binding
+    beforeEach(async () => {
+      device = new VirtualPort()
+      binding = new LinuxBinding()
+      await binding.open(device.path, { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1, hupcl: true })
+    })
+
+    afterEach(async () => {
+      if (binding.isOpen) {
+        await binding.close()
+      }
+      device.close()
+    })
+
+    it('clears and sets hupcl', async () => {
+      assert.isTrue(hupcl(device.path))
+      await binding.reconfigure({ hupcl: false })
+      assert.isFalse(hupcl(device.path))
+      assert.isFalse(binding.openOptions.hupcl)
+      await binding.reconfigure({ hupcl: true })
+      assert.isTrue(hupcl(device.path))
+    })
+  })
+})
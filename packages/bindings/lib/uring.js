@@ -0,0 +1,78 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/uring')
+const { promisify } = require('util')
+const UringBindings = require('bindings')('bindings.node').Uring
+
+let sharedRing
+
+/**
+ * An io_uring submission queue shared by every port on the thread. Reads and writes are submitted as a poll linked to the transfer, submissions are batched per event loop tick and completions are reaped together.
+ */
+class Uring {
+  constructor(entries = 256, RingBindings = UringBindings) {
+    if (!RingBindings) {
+      throw new Error('io_uring is not supported on this platform')
+    }
+    logger('Creating ring with', entries, 'entries')
+    this.ring = new RingBindings(entries)
+    this.readAsync = promisify(this.ring.read.bind(this.ring))
+    this.writeAsync = promisify(this.ring.write.bind(this.ring))
+  }
+
+  /**
+   * Returns the ring for this thread or `null` if io_uring is unavailable
+   * @returns {?Uring} the shared ring
+   */
+  static shared(RingBindings = UringBindings) {
+    if (sharedRing === undefined) {
+      try {
+        sharedRing = new Uring(256, RingBindings)
+      } catch (err) {
+        logger('io_uring is unavailable, falling back to poll', err.message)
+        sharedRing = null
+      }
+    }
+    return sharedRing
+  }
+
+  /**
+   * Same signature and resolution as a promisified `fs.read`
+   */
+  async read(fd, buffer, offset, length) {
+    try {
+      const bytesRead = await this.readAsync(fd, buffer, offset, length)
+      return { bytesRead, buffer }
+    } catch (err) {
+      throw markCanceled(err)
+    }
+  }
+
+  /**
+   * Same signature and resolution as a promisified `fs.write`
+   */
+  async write(fd, buffer, offset, length) {
+    try {
+      const bytesWritten = await this.writeAsync(fd, buffer, offset, length)
+      return { bytesWritten, buffer }
+    } catch (err) {
+      throw markCanceled(err)
+    }
+  }
+
+  /**
+   * Cancel every read and write in flight for the file descriptor, they reject with an error that has `canceled` set to `true`
+   */
+  cancel(fd) {
+    logger('Canceling operations for fd', fd)
+    this.ring.cancel(fd)
+  }
+}
+
+function markCanceled(err) {
+  if (err.code === 'ECANCELED') {
+    err.canceled = true
+  }
+  return err
+}
+
+module.exports = Uring
@@ -0,0 +1,84 @@
+const Uring = require('./uring')
+const unixRead = require('./unix-read')
+
+class MockRingBindings {
+  constructor(entries) {
+    this.entries = entries
+    this.canceled = []
+    this.error = null
+  }
+  read(fd, buffer, offset, length, cb) {
+    buffer.fill(1, offset, offset + length)
+    setImmediate(() => (this.error ? cb(this.error) : cb(null, length)))
+  }
+  write(fd, buffer, offset, length, cb) {
+    setImmediate(() => (this.error ? cb(this.error) : cb(null, length)))
+  }
+  cancel(fd) {
+    this.canceled.push(fd)
+  }
+}
+
+class UnsupportedRingBindings {
+  constructor() {
+    throw new Error('function not implemented')
+  }
+}
+
+const makeError = code => {
+  const err = new Error(`Error: ${code}`)
+  err.code = code
+  return err
+}
+
+describe('Uring', () => {
+  it('constructs', () => {
+    const ring = new Uring(8, MockRingBindings)
+    assert.equal(ring.ring.entries, 8)
+  })
+  it('throws when the platform has no ring bindings', () => {
+    assert.throws(() => new Uring(8, null))
+  })
+  it('resolves reads like fs.read', async () => {
+    const ring = new Uring(8, MockRingBindings)
+    const buffer = Buffer.alloc(8)
+    const { bytesRead, buffer: readBuffer } = await ring.read(1, buffer, 2, 4)
+    assert.equal(bytesRead, 4)
+    assert.strictEqual(readBuffer, buffer)
+    assert.deepEqual(buffer, Buffer.from([0, 0, 1, 1, 1, 1, 0, 0]))
+  })
+  it('resolves writes like fs.write', async () => {
+    const ring = new Uring(8, MockRingBindings)
+    const { bytesWritten } = await ring.write(1, Buffer.alloc(8), 0, 8)
+    assert.equal(bytesWritten, 8)
+  })
+  it('marks canceled operations', async () => {
+    const ring = new Uring(8, MockRingBindings)
+    ring.ring.error = makeError('ECANCELED')
+    const err = await shouldReject(ring.read(1, Buffer.alloc(8), 0, 8))
+    assert.isTrue(err.canceled)
+  })
+  it('passes other errors through', async () => {
+    const ring = new Uring(8, MockRingBindings)
+    ring.ring.error = makeError('EIO')
+    const err = await shouldReject(ring.write(1, Buffer.alloc(8), 0, 8))
+    assert.isUndefined(err.canceled)
+  })
+  it('forwards cancel to the bindings', () => {
+    const ring = new Uring(8, MockRingBindings)
+    ring.cancel(5)
+    assert.deepEqual(ring.ring.canceled, [5])
+  })
+  it('can stand in for fs.read in unixRead', async () => {
+    const ring = new Uring(8, MockRingBindings)
+    const binding = { isOpen: true, fd: 1 }
+    const { bytesRead } = await unixRead({ binding, buffer: Buffer.alloc(4), offset: 0, length: 4, fsReadAsync: ring.read.bind(ring) })
+    assert.equal(bytesRead, 4)
+  })
+  describe('.shared', () => {
+    it('caches null when io_uring is unavailable', () => {
+      assert.isNull(Uring.shared(UnsupportedRingBindings))
+      assert.isNull(Uring.shared(MockRingBindings))
+    })
+  })
+})
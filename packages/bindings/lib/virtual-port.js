@@ -0,0 +1,88 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/virtual-port')
+const VirtualPortBindings = require('bindings')('bindings.node').VirtualPort
+
+/**
+ * A pseudo terminal standing in for a device. `path` is a tty that `LinuxBinding` (or anything else) opens like a real port, a native thread on the other end generates traffic into it and reads whatever is written to it. Not available on Windows.
+ */
+class VirtualPort {
+  /**
+   * @param {object} [options]
+   * @param {boolean} [options.echo=false] send everything written to the port straight back, ahead of generated traffic
+   */
+  constructor({ echo = false } = {}, PortBindings = VirtualPortBindings) {
+    if (!PortBindings) {
+      throw new Error('Virtual ports are not supported on this platform')
+    }
+    this.port = new PortBindings({ echo: Boolean(echo) })
+    this.closed = false
+    logger('created virtual port', this.path)
+  }
+
+  /**
+   * The tty to open
+   */
+  get path() {
+    return this.port.path
+  }
+
+  /**
+   * Starts sending `frames` over and over, replacing whatever was being sent before
+   * @param {object} options
+   * @param {Buffer|string|Array<Buffer|string>} options.frames sent in order and then from the start again
+   * @param {number} [options.rate=0] bytes per second, `0` for as fast as the port is read
+   * @param {number} [options.chunkSize=256] bytes per write, from 1 to 65536. Chunks don't have to line up with frames.
+   * @param {number} [options.limit=0] stop after this many bytes, `0` to keep going until `stop()`
+   */
+  generate({ frames, rate = 0, chunkSize = 256, limit = 0 }) {
+    if (this.closed) {
+      throw new Error('Virtual port is closed')
+    }
+    const pattern = Buffer.concat([].concat(frames).map(frame => Buffer.from(frame)))
+    if (pattern.length === 0) {
+      throw new TypeError('"frames" must have at least one byte')
+    }
+    if (typeof rate !== 'number' || !(rate >= 0)) {
+      throw new TypeError('"rate" must be a number of bytes per second')
+    }
+    if (!Number.isInteger(chunkSize) || chunkSize < 1 || chunkSize > 65536) {
+      throw new TypeError('"chunkSize" must be an integer from 1 to 65536')
+    }
+    if (!Number.isInteger(limit) || limit < 0) {
+      throw new TypeError('"limit" must be a positive integer')
+    }
+    logger('generating', pattern.length, 'byte pattern at', rate || 'full speed', 'in chunks of', chunkSize)
+    this.port.start({ pattern, rate, chunkSize, limit })
+  }
+
+  /**
+   * Stops generating traffic, reading and echoing go on
+   */
+  stop() {
+    if (!this.closed) {
+      this.port.stop()
+    }
+  }
+
+  /**
+   * @returns {object} `{ generating, bytesSent, bytesReceived, writes }` so far, `error` with the code if the thread stopped on one
+   */
+  stats() {
+    return this.port.stats()
+  }
+
+  /**
+   * Hangs up, a binding with the port open sees the device disappear
+   */
+  close() {
+    if (this.closed) {
+      return
+    }
+    this.closed = true
+    this.port.close()
+  }
+}
+
+const createVirtualPort = options => new VirtualPort(options)
+
+module.exports = { VirtualPort, createVirtualPort }
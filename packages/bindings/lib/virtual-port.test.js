@@ -0,0 +1,109 @@
+const { VirtualPort } = require('./virtual-port')
+
+class MockPortBindings {
+  constructor(options) {
+    this.options = options
+    this.path = '/dev/pts/99'
+    this.started = null
+    this.closed = false
+  }
+  start(options) {
+    this.started = options
+  }
+  stop() {
+    this.started = null
+  }
+  stats() {
+    return { generating: Boolean(this.started), bytesSent: 0, bytesReceived: 0, writes: 0 }
+  }
+  close() {
+    this.closed = true
+  }
+}
+
+const readBytes = async (binding, length) => {
+  const buffer = Buffer.alloc(length)
+  let offset = 0
+  while (offset < length) {
+    const { bytesRead } = await binding.read(buffer, offset, length - offset)
+    offset += bytesRead
+  }
+  return buffer
+}
+
+describe('VirtualPort', () => {
+  it('passes the generator settings on', () => {
+    const port = new VirtualPort({ echo: true }, MockPortBindings)
+    assert.equal(port.path, '/dev/pts/99')
+    assert.deepEqual(port.port.options, { echo: true })
+    port.generate({ frames: ['ab', Buffer.from('c')], rate: 1000 })
+    assert.deepEqual(port.port.started, { pattern: Buffer.from('abc'), rate: 1000, chunkSize: 256, limit: 0 })
+    assert.isTrue(port.stats().generating)
+    port.stop()
+    assert.isFalse(port.stats().generating)
+  })
+
+  it('validates the generator settings', () => {
+    const port = new VirtualPort({}, MockPortBindings)
+    assert.throws(() => port.generate({ frames: [] }), TypeError)
+    assert.throws(() => port.generate({ frames: 'a', rate: -1 }), TypeError)
+    assert.throws(() => port.generate({ frames: 'a', chunkSize: 0 }), TypeError)
+    assert.throws(() => port.generate({ frames: 'a', chunkSize: 65537 }), TypeError)
+    assert.throws(() => port.generate({ frames: 'a', limit: 1.5 }), TypeError)
+  })
+
+  it('closes once', () => {
+    const port = new VirtualPort({}, MockPortBindings)
+    port.close()
+    port.close()
+    assert.isTrue(port.port.closed)
+    assert.throws(() => port.generate({ frames: 'a' }), 'Virtual port is closed')
+  })
+
+  describe('pseudo terminal', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+    const LinuxBinding = require('./linux')
+
+    let port
+    let binding
+    beforeEach(async () => {
+      port = new VirtualPort({ echo: true })
+      binding = new LinuxBinding()
+      await binding.open(port.path, { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1 })
+    })
+
+    afterEach(async () => {
+      if (binding.isOpen) {
+        await binding.close()
+      }
+      port.close()
+    })
+
+    it('generates the frames in order', async () => {
+      const frames = [Buffer.from('frame one\n'), Buffer.from('second frame\n')]
+      port.generate({ frames, chunkSize: 7, limit: 2300 })
+      const data = await readBytes(binding, 2300)
+      const pattern = Buffer.concat(frames)
+      for (let i = 0; i < data.length; i++) {
+        assert.equal(data[i], pattern[i % pattern.length])
+      }
+      assert.containSubset(port.stats(), { generating: false, bytesSent: 2300 })
+    })
+
+    it('sends at the given rate', async () => {
+      const start = Date.now()
+      port.generate({ frames: 'x', rate: 10000, chunkSize: 100, limit: 2000 })
+      await readBytes(binding, 2000)
+      assert.isAtLeast(Date.now() - start, 150)
+    })
+
+    it('echoes writes', async () => {
+      await binding.write(Buffer.from('hello'))
+      assert.equal((await readBytes(binding, 5)).toString(), 'hello')
+      assert.equal(port.stats().bytesReceived, 5)
+    })
+  })
+})
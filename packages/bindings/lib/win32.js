@@ -12,6 +12,7 @@ const asyncUpdate = promisify(binding.update)
 const asyncSet = promisify(binding.set)
 const asyncGet = promisify(binding.get)
 const asyncGetBaudRate = promisify(binding.getBaudRate)
+const asyncGetQueueSizes = promisify(binding.getQueueSizes)
 const asyncDrain = promisify(binding.drain)
 const asyncFlush = promisify(binding.flush)
 const { wrapWithHiddenComName } = require('./legacy')
@@ -108,6 +109,11 @@ class WindowsBinding extends AbstractBinding {
     return asyncGetBaudRate(this.fd)
   }
 
+  async getQueueSizes() {
+    await super.getQueueSizes()
+    return asyncGetQueueSizes(this.fd)
+  }
+
   async drain() {
     await super.drain()
     await this.writeOperation
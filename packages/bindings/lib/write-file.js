@@ -0,0 +1,71 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/writeFile')
+const FileWriterBindings = require('bindings')('bindings.node').FileWriter
+
+/**
+ * Sends part or all of a file to a port on a native thread, for firmware uploads and the like. The file is mapped and written straight to the tty so none of it passes through JavaScript, and the thread waits for room in the OS output queue so flow control holds it back like any other write. Not available on Windows.
+ *
+ * The file must not be truncated while it's being sent. Reading a mapped page past the file's new end raises SIGBUS, which kills the process instead of failing the write. Replace a file that may be sent by writing a new one and renaming it over the old, the mapping keeps the old contents.
+ */
+class FileWrite {
+  /**
+   * @param {object} options
+   * @param {number} options.fd the open port
+   * @param {string} options.path the file to send
+   * @param {number} [options.offset=0] where in the file to start
+   * @param {number} [options.length] how many bytes to send, the rest of the file by default
+   * @param {number} [options.chunkSize=4096] bytes per write, from 1 to 1048576
+   * @param {number} [options.progressBytes=65536] call `onProgress` about every this many bytes, `0` for only at the end
+   * @param {Function} [options.onProgress] called with `(bytesWritten, length)`
+   */
+  constructor({ fd, path, offset = 0, length, chunkSize = 4096, progressBytes = 65536, onProgress }, NativeFileWriter = FileWriterBindings) {
+    if (!NativeFileWriter) {
+      throw new Error('Writing files is not supported on this platform')
+    }
+    if (typeof path !== 'string') {
+      throw new TypeError('"path" must be a string')
+    }
+    if (!Number.isInteger(offset) || offset < 0) {
+      throw new TypeError('"offset" must be a positive integer')
+    }
+    if (length !== undefined && (!Number.isInteger(length) || length < 0)) {
+      throw new TypeError('"length" must be a positive integer')
+    }
+    if (!Number.isInteger(chunkSize) || chunkSize < 1 || chunkSize > 1048576) {
+      throw new TypeError('"chunkSize" must be an integer from 1 to 1048576')
+    }
+    if (!Number.isInteger(progressBytes) || progressBytes < 0) {
+      throw new TypeError('"progressBytes" must be a positive integer')
+    }
+    if (onProgress !== undefined && typeof onProgress !== 'function') {
+      throw new TypeError('"onProgress" must be a function')
+    }
+    logger('writing', path, 'from', offset, 'in chunks of', chunkSize)
+    let settle
+    this.done = new Promise((resolve, reject) => {
+      settle = { resolve, reject }
+    })
+    this.writer = new NativeFileWriter(fd, path, { offset, length, chunkSize, progressBytes }, onProgress, (err, bytesWritten) => {
+      logger('wrote', bytesWritten, 'bytes of', path, err || '')
+      if (!err) {
+        settle.resolve({ bytesWritten })
+        return
+      }
+      if (err.code === 'ECANCELED') {
+        err.canceled = true
+      } else if (err.code === 'EIO' || err.code === 'ENXIO' || err.code === 'EBADF') {
+        err.disconnect = true
+      }
+      settle.reject(err)
+    })
+  }
+
+  /**
+   * Stops after the chunk being written, `done` rejects with `canceled` set and the `bytesWritten` so far
+   */
+  cancel() {
+    this.writer.cancel()
+  }
+}
+
+module.exports = FileWrite
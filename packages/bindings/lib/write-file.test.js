@@ -0,0 +1,106 @@
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+const FileWrite = require('./write-file')
+
+class MockFileWriterBindings {
+  constructor(fd, path, options, onProgress, cb) {
+    this.fd = fd
+    this.path = path
+    this.options = options
+    this.onProgress = onProgress
+    this.cb = cb
+    this.canceled = false
+  }
+  cancel() {
+    this.canceled = true
+    const err = new Error('Error: Operation canceled, cannot write')
+    err.code = 'ECANCELED'
+    err.bytesWritten = 10
+    this.cb(err, 10)
+  }
+}
+
+describe('FileWrite', () => {
+  it('passes its options on', async () => {
+    const fileWrite = new FileWrite({ fd: 5, path: 'firmware.bin', offset: 16, length: 100, chunkSize: 64 }, MockFileWriterBindings)
+    assert.containSubset(fileWrite.writer, { fd: 5, path: 'firmware.bin', options: { offset: 16, length: 100, chunkSize: 64, progressBytes: 65536 } })
+    fileWrite.writer.cb(null, 100)
+    assert.deepEqual(await fileWrite.done, { bytesWritten: 100 })
+  })
+
+  it('validates its options', () => {
+    assert.throws(() => new FileWrite({ fd: 5 }, MockFileWriterBindings), TypeError)
+    assert.throws(() => new FileWrite({ fd: 5, path: 'a', offset: -1 }, MockFileWriterBindings), TypeError)
+    assert.throws(() => new FileWrite({ fd: 5, path: 'a', chunkSize: 0 }, MockFileWriterBindings), TypeError)
+    assert.throws(() => new FileWrite({ fd: 5, path: 'a', progressBytes: 0.5 }, MockFileWriterBindings), TypeError)
+    assert.throws(() => new FileWrite({ fd: 5, path: 'a', onProgress: 1 }, MockFileWriterBindings), TypeError)
+  })
+
+  it('rejects as canceled', async () => {
+    const fileWrite = new FileWrite({ fd: 5, path: 'a' }, MockFileWriterBindings)
+    fileWrite.cancel()
+    const err = await fileWrite.done.catch(err => err)
+    assert.isTrue(err.canceled)
+    assert.equal(err.bytesWritten, 10)
+  })
+
+  describe('to a pseudo terminal', () => {
+    if (process.platform !== 'linux') {
+      it(`Cannot be tested on ${process.platform}`)
+      return
+    }
+    const LinuxBinding = require('./linux')
+    const { VirtualPort } = require('./virtual-port')
+
+    let device
+    let binding
+    let dir
+    let file
+    const data = Buffer.alloc(200000).map((_, i) => (i * 7) % 256)
+    beforeEach(async () => {
+      dir = fs.mkdtempSync(path.join(os.tmpdir(), 'write-file-'))
+      file = path.join(dir, 'firmware.bin')
+      fs.writeFileSync(file, data)
+      device = new VirtualPort({ echo: true })
+      binding = new LinuxBinding()
+      await binding.open(device.path, { baudRate: 115200, dataBits: 8, parity: 'none', stopBits: 1 })
+    })
+
+    afterEach(async () => {
+      if (binding.isOpen) {
+        await binding.close()
+      }
+      device.close()
+      fs.unlinkSync(file)
+      fs.rmdirSync(dir)
+    })
+
+    const readBytes = async length => {
+      const buffer = Buffer.alloc(length)
+      let offset = 0
+      while (offset < length) {
+        offset += (await binding.read(buffer, offset, length - offset)).bytesRead
+      }
+      return buffer
+    }
+
+    it('sends the file after the writes before it', async () => {
+      const progress = []
+      binding.write(Buffer.from('header'))
+      const written = binding.writeFile(file, { offset: 1000, length: 50000, progressBytes: 10000, onProgress: bytes => progress.push(bytes) })
+      const received = readBytes(6 + 50000)
+      assert.deepEqual(await written, { bytesWritten: 50000 })
+      assert.deepEqual(await received, Buffer.concat([Buffer.from('header'), data.slice(1000, 51000)]))
+      assert.equal(progress[progress.length - 1], 50000)
+    })
+
+    it('can be canceled', async () => {
+      const written = binding.writeFile(file, { chunkSize: 16 })
+      binding.cancelWriteFile()
+      const err = await written.catch(err => err)
+      assert.isTrue(err.canceled)
+      await binding.write(Buffer.from('after'))
+    })
+  })
+})
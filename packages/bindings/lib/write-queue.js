@@ -0,0 +1,230 @@
+const debug = require('debug')
+const logger = debug('serialport/bindings/writeQueue')
+const unixWrite = require('./unix-write')
+
+const delay = ms => new Promise(resolve => setTimeout(resolve, ms))
+
+const MAX_LANES = 8
+
+// bits on the wire per character, start bit included
+const charBits = ({ dataBits = 8, parity = 'none', stopBits = 1 }) => 1 + dataBits + (parity === 'none' ? 0 : 1) + stopBits
+
+const makeLane = name => ({
+  name,
+  entries: [],
+  bytes: 0,
+  stats: { writes: 0, bytesWritten: 0, delay: { count: 0, totalMs: 0, maxMs: 0, lastMs: 0 } },
+})
+
+/**
+ * Serializes writes to the kernel from a set of lanes, a write in a higher lane goes ahead of everything queued in the lower ones as soon as the write in progress reaches a frame boundary. With `maxQueueMs` it also feeds the kernel no faster than the port transmits, so the OS output queue never holds more than `maxQueueMs` of data. Everything else waits here where `clear()` can still drop it, which keeps the latency of a write that comes after a large one bounded.
+ *
+ * Without `maxQueueMs` lanes still take turns at frame boundaries, but each frame goes to the kernel as fast as it takes it. A higher lane then only gets ahead of what hasn't reached the OS output queue yet, not of what is already waiting there.
+ */
+class WriteQueue {
+  /**
+   * @param {object} options
+   * @param {LinuxBinding} options.binding the open binding to write to
+   * @param {number} [options.maxQueueMs=0] how much data, in transmit time, to let into the OS output queue. `0` writes as fast as the kernel takes it.
+   * @param {object} [options.settings] `baudRate`, `dataBits`, `parity` and `stopBits` of the port, needed with `maxQueueMs`
+   * @param {string[]} [options.lanes=['high', 'normal']] lane names from highest to lowest priority, at most 8
+   * @param {Function} [options.getQueueSizes] resolves with the OS `{ input, output }` queue sizes, needed with `maxQueueMs`
+   * @param {Function} [options.fsWriteAsync] passed on to `unixWrite`
+   */
+  constructor({ binding, maxQueueMs = 0, settings, lanes = ['high', 'normal'], getQueueSizes, fsWriteAsync }) {
+    if (!Array.isArray(lanes) || lanes.length < 1 || lanes.length > MAX_LANES) {
+      throw new TypeError(`"lanes" must be an array of 1 to ${MAX_LANES} names`)
+    }
+    this.binding = binding
+    this.maxQueueMs = maxQueueMs
+    this.getQueueSizes = getQueueSizes
+    this.fsWriteAsync = fsWriteAsync
+    this.lanes = lanes.map(makeLane)
+    this.defaultLane = lanes.indexOf('normal') !== -1 ? 'normal' : lanes[lanes.length - 1]
+    // an entry that stopped in the middle of a frame, it has to finish before another lane gets a turn
+    this.current = null
+    this.running = false
+    this.budget = Infinity
+    this.setSpeed(settings)
+  }
+
+  get laneNames() {
+    return this.lanes.map(lane => lane.name)
+  }
+
+  setSpeed(settings) {
+    if (!(this.maxQueueMs > 0)) {
+      return
+    }
+    this.bytesPerMs = settings.baudRate / (charBits(settings) * 1000)
+    this.budget = Math.max(1, Math.floor(this.maxQueueMs * this.bytesPerMs))
+    logger('pacing to', this.budget, 'bytes in the output queue')
+  }
+
+  /**
+   * Bytes waiting to go to the kernel
+   */
+  get length() {
+    return this.lanes.reduce((total, lane) => total + lane.bytes, 0)
+  }
+
+  /**
+   * @param {Buffer} buffer the data to write
+   * @param {object} [options]
+   * @param {string} [options.lane] which lane to queue in, `'normal'` or the lowest lane by default
+   * @param {number[]} [options.boundaries] end offsets of the frames in `buffer`, a higher lane can only cut in at one of these. `buffer` is one frame without them.
+   * @returns {Promise} Resolves once all of `buffer` is in the OS output queue.
+   */
+  push(buffer, { lane = this.defaultLane, boundaries } = {}) {
+    const target = this.lanes.find(({ name }) => name === lane)
+    if (!target) {
+      return Promise.reject(new TypeError(`"${lane}" is not a write lane, use one of ${this.laneNames.join(', ')}`))
+    }
+    return new Promise((resolve, reject) => {
+      target.entries.push({ buffer, offset: 0, boundaries, queuedAt: Date.now(), lane: target, resolve, reject })
+      target.bytes += buffer.length
+      if (!this.running) {
+        this.run()
+      }
+    })
+  }
+
+  /**
+   * Drops everything that hasn't reached the kernel. With an error the pending writes reject with it, otherwise they resolve as if the data had been written and then flushed.
+   * @param {Error=} err
+   */
+  clear(err) {
+    const entries = []
+    this.lanes.forEach(lane => {
+      entries.push(...lane.entries.splice(0))
+      lane.bytes = 0
+    })
+    this.current = null
+    if (entries.length > 0) {
+      logger('dropping', entries.length, 'queued writes')
+    }
+    entries.forEach(entry => (err ? entry.reject(err) : entry.resolve()))
+  }
+
+  /**
+   * @returns {object} per lane `queuedBytes`, completed `writes`, `bytesWritten` and the queueing `delay` (`lastMs`, `maxMs`, `meanMs`) from `push()` until the first byte reaches the kernel
+   */
+  stats() {
+    const lanes = {}
+    this.lanes.forEach(({ name, bytes, stats }) => {
+      const { delay } = stats
+      lanes[name] = {
+        queuedBytes: bytes,
+        writes: stats.writes,
+        bytesWritten: stats.bytesWritten,
+        delay: { lastMs: delay.lastMs, maxMs: delay.maxMs, meanMs: delay.count ? delay.totalMs / delay.count : 0 },
+      }
+    })
+    return { budget: this.budget, lanes }
+  }
+
+  next() {
+    if (this.current) {
+      return this.current
+    }
+    const lane = this.lanes.find(({ entries }) => entries.length > 0)
+    return lane ? lane.entries[0] : null
+  }
+
+  async run() {
+    this.running = true
+    try {
+      while (this.length > 0) {
+        await this.writeNext()
+      }
+    } finally {
+      this.running = false
+    }
+  }
+
+  async writeNext() {
+    if (!this.binding.isOpen) {
+      return this.clear(new Error('Port is not open'))
+    }
+    let room = this.budget
+    if (room !== Infinity) {
+      let sizes
+      try {
+        sizes = await this.getQueueSizes()
+      } catch (err) {
+        return this.fail(err, this.next())
+      }
+      const { output } = sizes
+      room = Math.floor(this.budget - output)
+      if (room <= 0) {
+        // wait for the queue to get down to half the budget so writes don't get tiny
+        await delay(Math.max(1, (output - this.budget / 2) / this.bytesPerMs))
+        return
+      }
+    }
+    const entry = this.next()
+    if (!entry) {
+      return
+    }
+    if (entry.offset === 0) {
+      const delayMs = Date.now() - entry.queuedAt
+      const laneDelay = entry.lane.stats.delay
+      laneDelay.count++
+      laneDelay.totalMs += delayMs
+      laneDelay.maxMs = Math.max(laneDelay.maxMs, delayMs)
+      laneDelay.lastMs = delayMs
+    }
+    let end = entry.offset + room
+    if (entry.boundaries) {
+      // chunks stop at the end of a frame so another lane can get in there
+      const boundary = entry.boundaries.find(offset => offset > entry.offset)
+      if (boundary !== undefined) {
+        end = Math.min(end, boundary)
+      }
+    }
+    const chunk = entry.buffer.slice(entry.offset, end)
+    this.current = entry
+    try {
+      await unixWrite({ binding: this.binding, buffer: chunk, fsWriteAsync: this.fsWriteAsync })
+    } catch (err) {
+      return this.fail(err, entry)
+    }
+    // a clear() while the chunk was in flight already settled the entry
+    if (this.current !== entry) {
+      return
+    }
+    const lane = entry.lane
+    entry.offset += chunk.length
+    lane.bytes -= chunk.length
+    lane.stats.bytesWritten += chunk.length
+    if (entry.offset >= entry.buffer.length) {
+      lane.entries.shift()
+      lane.stats.writes++
+      this.current = null
+      entry.resolve()
+    } else if (entry.boundaries && entry.boundaries.indexOf(entry.offset) !== -1) {
+      this.current = null
+    }
+  }
+
+  // the write in progress gets the error, the ones after it may still go through
+  fail(err, entry) {
+    logger('write errored', err)
+    if (this.current === entry) {
+      this.current = null
+    }
+    if (entry && entry.lane.entries[0] === entry) {
+      entry.lane.entries.shift()
+      entry.lane.bytes -= entry.buffer.length - entry.offset
+      entry.reject(err)
+    }
+    if (err.disconnect) {
+      this.clear(err)
+    }
+  }
+}
+
+WriteQueue.charBits = charBits
+WriteQueue.MAX_LANES = MAX_LANES
+
+module.exports = WriteQueue
@@ -0,0 +1,188 @@
+const WriteQueue = require('./write-queue')
+
+// An output queue that transmits `bytesPerMs` and records what was written to it
+const makeMockPort = ({ bytesPerMs }) => {
+  const port = {
+    binding: { isOpen: true, fd: 1, poller: { once() {} } },
+    writes: [],
+    output: 0,
+    maxOutput: 0,
+    drainedAt: Date.now(),
+    getQueueSizes: async () => {
+      const now = Date.now()
+      port.output = Math.max(0, port.output - (now - port.drainedAt) * bytesPerMs)
+      port.drainedAt = now
+      return { input: 0, output: port.output }
+    },
+    fsWriteAsync: async (fd, buffer, offset, length) => {
+      await port.getQueueSizes()
+      port.writes.push(Buffer.from(buffer.slice(offset, offset + length)))
+      port.output += length
+      port.maxOutput = Math.max(port.maxOutput, port.output)
+      return { bytesWritten: length }
+    },
+  }
+  return port
+}
+
+const makeQueue = (port, maxQueueMs, baudRate = 115200, lanes) =>
+  new WriteQueue({
+    binding: port.binding,
+    maxQueueMs,
+    lanes,
+    settings: { baudRate, dataBits: 8, parity: 'none', stopBits: 1 },
+    getQueueSizes: port.getQueueSizes,
+    fsWriteAsync: port.fsWriteAsync,
+  })
+
+describe('WriteQueue', () => {
+  it('computes the bits per character', () => {
+    assert.equal(WriteQueue.charBits({ dataBits: 8, parity: 'none', stopBits: 1 }), 10)
+    assert.equal(WriteQueue.charBits({ dataBits: 7, parity: 'even', stopBits: 2 }), 11)
+  })
+
+  it('derives the queue budget from the port settings', () => {
+    const port = makeMockPort({ bytesPerMs: 11.52 })
+    const queue = makeQueue(port, 10)
+    assert.equal(queue.budget, 115)
+    queue.setSpeed({ baudRate: 9600, dataBits: 8, parity: 'even', stopBits: 1 })
+    assert.equal(queue.budget, 8)
+  })
+
+  it('never lets more than the budget into the output queue', async () => {
+    const port = makeMockPort({ bytesPerMs: 11.52 })
+    const queue = makeQueue(port, 5)
+    const data = Buffer.alloc(300, 'a')
+    await queue.push(data)
+    assert.isAtMost(port.maxOutput, queue.budget)
+    assert.isAbove(port.writes.length, 1)
+    assert.deepEqual(Buffer.concat(port.writes), data)
+    assert.equal(queue.length, 0)
+  })
+
+  it('writes in order', async () => {
+    const port = makeMockPort({ bytesPerMs: 100 })
+    const queue = makeQueue(port, 1, 1000000)
+    await Promise.all([queue.push(Buffer.from('one')), queue.push(Buffer.from('two'))])
+    assert.deepEqual(Buffer.concat(port.writes), Buffer.from('onetwo'))
+  })
+
+  it('resolves dropped writes on clear()', async () => {
+    const port = makeMockPort({ bytesPerMs: 1 })
+    const queue = makeQueue(port, 5, 9600)
+    const first = queue.push(Buffer.alloc(100))
+    const second = queue.push(Buffer.alloc(100))
+    await new Promise(resolve => setTimeout(resolve, 5))
+    assert.isAbove(queue.length, 100)
+    queue.clear()
+    await Promise.all([first, second])
+    assert.equal(queue.length, 0)
+    assert.isBelow(Buffer.concat(port.writes).length, 200)
+  })
+
+  it('rejects dropped writes with the given error', async () => {
+    const port = makeMockPort({ bytesPerMs: 1 })
+    const queue = makeQueue(port, 5, 9600)
+    const write = queue.push(Buffer.alloc(100))
+    queue.clear(new Error('Port is not open'))
+    const err = await shouldReject(write)
+    assert.equal(err.message, 'Port is not open')
+  })
+
+  it('rejects when the port closes', async () => {
+    const port = makeMockPort({ bytesPerMs: 1 })
+    port.binding.isOpen = false
+    const queue = makeQueue(port, 5)
+    await shouldReject(queue.push(Buffer.from('data')))
+  })
+
+  it('rejects the failed write and continues with the next', async () => {
+    const port = makeMockPort({ bytesPerMs: 100 })
+    const fsWriteAsync = port.fsWriteAsync
+    let calls = 0
+    port.fsWriteAsync = async (...args) => {
+      if (calls++ === 0) {
+        const err = new Error('EIO')
+        err.code = 'EIO'
+        throw err
+      }
+      return fsWriteAsync(...args)
+    }
+    const queue = makeQueue(port, 10, 1000000)
+    const first = queue.push(Buffer.from('one'))
+    const second = queue.push(Buffer.from('two'))
+    const err = await shouldReject(first)
+    assert.equal(err.code, 'EIO')
+    await second
+    assert.deepEqual(Buffer.concat(port.writes), Buffer.from('two'))
+  })
+
+  it('writes everything at once without pacing', async () => {
+    const port = makeMockPort({ bytesPerMs: 1 })
+    const queue = makeQueue(port, 0)
+    assert.equal(queue.budget, Infinity)
+    await queue.push(Buffer.alloc(300))
+    assert.equal(port.writes.length, 1)
+  })
+
+  describe('lanes', () => {
+    it('limits the number of lanes', () => {
+      const port = makeMockPort({ bytesPerMs: 1 })
+      assert.throws(() => makeQueue(port, 0, 9600, []), TypeError)
+      assert.throws(() => makeQueue(port, 0, 9600, ['0', '1', '2', '3', '4', '5', '6', '7', '8']), TypeError)
+    })
+
+    it('rejects unknown lanes', async () => {
+      const queue = makeQueue(makeMockPort({ bytesPerMs: 1 }), 0)
+      await shouldReject(queue.push(Buffer.from('stop'), { lane: 'urgent' }), TypeError)
+    })
+
+    it('defaults to the normal lane, or the lowest one', () => {
+      const port = makeMockPort({ bytesPerMs: 1 })
+      assert.equal(makeQueue(port, 0).defaultLane, 'normal')
+      assert.equal(makeQueue(port, 0, 9600, ['urgent', 'bulk']).defaultLane, 'bulk')
+    })
+
+    it('puts higher lanes ahead of queued writes', async () => {
+      const port = makeMockPort({ bytesPerMs: 11.52 })
+      const queue = makeQueue(port, 2)
+      const bulk = [queue.push(Buffer.alloc(40, 'a')), queue.push(Buffer.alloc(40, 'b'))]
+      await queue.push(Buffer.from('stop'), { lane: 'high' })
+      await Promise.all(bulk)
+      assert.equal(Buffer.concat(port.writes).toString(), `stop${'a'.repeat(40)}${'b'.repeat(40)}`)
+    })
+
+    it('only cuts in at frame boundaries', async () => {
+      const port = makeMockPort({ bytesPerMs: 11.52 })
+      const queue = makeQueue(port, 2)
+      // two frames of 30 bytes, chunks of at most 23 bytes
+      const bulk = queue.push(Buffer.concat([Buffer.alloc(30, 'a'), Buffer.alloc(30, 'b')]), { boundaries: [30, 60] })
+      await new Promise(resolve => setTimeout(resolve, 1))
+      await queue.push(Buffer.from('stop'), { lane: 'high' })
+      await bulk
+      assert.equal(Buffer.concat(port.writes).toString(), `${'a'.repeat(30)}stop${'b'.repeat(30)}`)
+    })
+
+    it('cuts in at frame boundaries without pacing too', async () => {
+      const port = makeMockPort({ bytesPerMs: 11.52 })
+      const queue = makeQueue(port, 0)
+      const bulk = queue.push(Buffer.concat([Buffer.alloc(30, 'a'), Buffer.alloc(30, 'b')]), { boundaries: [30, 60] })
+      await queue.push(Buffer.from('stop'), { lane: 'high' })
+      await bulk
+      assert.equal(Buffer.concat(port.writes).toString(), `${'a'.repeat(30)}stop${'b'.repeat(30)}`)
+    })
+
+    it('keeps stats per lane', async () => {
+      const port = makeMockPort({ bytesPerMs: 100 })
+      const queue = makeQueue(port, 0)
+      await Promise.all([queue.push(Buffer.alloc(10)), queue.push(Buffer.alloc(4), { lane: 'high' })])
+      const { lanes } = queue.stats()
+      assert.containSubset(lanes, {
+        high: { queuedBytes: 0, writes: 1, bytesWritten: 4 },
+        normal: { queuedBytes: 0, writes: 1, bytesWritten: 10 },
+      })
+      assert.isAtLeast(lanes.normal.delay.maxMs, 0)
+      assert.isAtLeast(lanes.high.delay.meanMs, 0)
+    })
+  })
+})
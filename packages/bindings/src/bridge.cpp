@@ -0,0 +1,375 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include "./serialport.h"
+#include "./bridge.h"
+#include "./tap.h"
+
+#define BRIDGE_TO_SERIAL 0
+#define BRIDGE_TO_SOCKET 1
+
+Bridge::Bridge(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Bridge>(info), env(info.Env()) {
+  if (!info[0].IsNumber() || !info[1].IsNumber()) {
+    Napi::TypeError::New(env, "serialFd and socketFd must be ints").ThrowAsJavaScriptException();
+    return;
+  }
+  int serialFd = info[0].As<Napi::Number>().Int32Value();
+  int socketFd = info[1].As<Napi::Number>().Int32Value();
+
+  if (!info[2].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[2].As<Napi::Object>();
+  Napi::Value size = options.Get("bufferSize");
+  if (size.IsNumber()) {
+    bufferSize = size.As<Napi::Number>().Uint32Value();
+  }
+  if (bufferSize < BRIDGE_MIN_BUFFER_SIZE) {
+    bufferSize = BRIDGE_MIN_BUFFER_SIZE;
+  }
+  bool useSplice = options.Get("splice").ToBoolean();
+
+  if (!info[3].IsFunction()) {
+    Napi::TypeError::New(env, "cb must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+
+  directions[BRIDGE_TO_SERIAL].in = socketFd;
+  directions[BRIDGE_TO_SERIAL].out = serialFd;
+  directions[BRIDGE_TO_SOCKET].in = serialFd;
+  directions[BRIDGE_TO_SOCKET].out = socketFd;
+  directions[BRIDGE_TO_SERIAL].tapFd = serialFd;
+  directions[BRIDGE_TO_SERIAL].tapDirection = TAP_TX;
+  directions[BRIDGE_TO_SOCKET].tapFd = serialFd;
+  directions[BRIDGE_TO_SOCKET].tapDirection = TAP_RX;
+#ifdef __linux__
+  for (BridgeDirection& direction : directions) {
+    if (!useSplice || 0 != pipe2(direction.pipe, O_NONBLOCK | O_CLOEXEC)) {
+      continue;
+    }
+    direction.splice = true;
+    // a bigger pipe is just a hint, the bridge works the same with the default size
+    fcntl(direction.pipe[1], F_SETPIPE_SZ, static_cast<int>(bufferSize));
+  }
+#endif
+
+  if (0 != pipe(wake_fds)) {
+    closePipes();
+    Napi::Error::New(env, uv_strerror(uv_translate_sys_error(errno))).ThrowAsJavaScriptException();
+    return;
+  }
+  fcntl(wake_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_fds[1], F_SETFD, FD_CLOEXEC);
+
+  this->callback.Reset(info[3].As<Napi::Function>(), 1);
+  this->async = new uv_async_t();
+  async->data = this;
+  uv_async_init(getLoop(env), async, Bridge::onDone);
+
+  if (0 != uv_thread_create(&thread, Bridge::run, this)) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), Bridge::onClose);
+    async = nullptr;
+    closePipes();
+    Napi::Error::New(env, "Error: cannot start the bridge thread").ThrowAsJavaScriptException();
+    return;
+  }
+  running = true;
+}
+
+Bridge::~Bridge() {
+  stop();
+  if (async) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), Bridge::onClose);
+    async = nullptr;
+  }
+  closePipes();
+}
+
+void Bridge::onClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+Napi::Object Bridge::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "Bridge", {
+    InstanceMethod("stats", &Bridge::stats),
+    InstanceMethod("close", &Bridge::close),
+  });
+
+  exports.Set("Bridge", func);
+  return exports;
+}
+
+void Bridge::run(void* arg) {
+  static_cast<Bridge*>(arg)->loop();
+}
+
+// Switches a direction from splice to read()/write(), whatever is in the pipe moves to the buffer
+static int stopSplicing(BridgeDirection& direction, size_t bufferSize) {
+  __atomic_store_n(&direction.splice, false, __ATOMIC_RELAXED);
+  direction.buffer.resize(bufferSize);
+  while (direction.piped > 0) {
+    ssize_t bytesRead = ::read(direction.pipe[0], direction.buffer.data() + direction.end, direction.piped);
+    if (bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesRead <= 0) {
+      return bytesRead == 0 ? EIO : errno;
+    }
+    direction.end += bytesRead;
+    direction.piped -= bytesRead;
+  }
+  return 0;
+}
+
+// Reads as much as there's room for, returns an errno or 0
+int Bridge::fill(BridgeDirection& direction) {
+  size_t room = bufferSize - direction.pending();
+  if (room == 0 || direction.eof) {
+    return 0;
+  }
+#ifdef __linux__
+  if (direction.splice && isTapped(direction.tapFd, direction.tapDirection)) {
+    int err = stopSplicing(direction, bufferSize);
+    if (err) {
+      return err;
+    }
+  }
+  if (direction.splice) {
+    ssize_t moved =
+      ::splice(direction.in, nullptr, direction.pipe[1], nullptr, room, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (moved > 0) {
+      direction.piped += moved;
+      return 0;
+    }
+    if (moved == 0) {
+      direction.eof = true;
+      return 0;
+    }
+    if (errno == EAGAIN || errno == EINTR) {
+      return 0;
+    }
+    if (errno != EINVAL) {
+      errorFd = direction.in;
+      return errno;
+    }
+    int err = stopSplicing(direction, bufferSize);
+    if (err) {
+      return err;
+    }
+  }
+#endif
+  if (direction.buffer.empty()) {
+    direction.buffer.resize(bufferSize);
+  }
+  if (direction.start > 0) {
+    memmove(direction.buffer.data(), direction.buffer.data() + direction.start, direction.end - direction.start);
+    direction.end -= direction.start;
+    direction.start = 0;
+  }
+  ssize_t bytesRead = ::read(direction.in, direction.buffer.data() + direction.end, bufferSize - direction.end);
+  if (bytesRead > 0) {
+    if (direction.tapDirection == TAP_RX) {
+      tapData(direction.tapFd, TAP_RX, direction.buffer.data() + direction.end, bytesRead);
+    }
+    direction.end += bytesRead;
+    return 0;
+  }
+  if (bytesRead == 0) {
+    direction.eof = true;
+    return 0;
+  }
+  if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+    return 0;
+  }
+  errorFd = direction.in;
+  return errno;
+}
+
+// Writes as much as the other side takes, returns an errno or 0
+int Bridge::flush(BridgeDirection& direction) {
+#ifdef __linux__
+  if (direction.splice && direction.piped > 0) {
+    ssize_t moved =
+      ::splice(direction.pipe[0], nullptr, direction.out, nullptr, direction.piped, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (moved > 0) {
+      direction.piped -= moved;
+      __atomic_fetch_add(&direction.bytes, static_cast<uint64_t>(moved), __ATOMIC_RELAXED);
+      return 0;
+    }
+    if (moved < 0 && (errno == EAGAIN || errno == EINTR)) {
+      return 0;
+    }
+    if (moved == 0 || errno != EINVAL) {
+      errorFd = direction.out;
+      return moved == 0 ? EIO : errno;
+    }
+    int err = stopSplicing(direction, bufferSize);
+    if (err) {
+      return err;
+    }
+  }
+#endif
+  if (direction.end == direction.start) {
+    return 0;
+  }
+  ssize_t written = ::write(direction.out, direction.buffer.data() + direction.start, direction.end - direction.start);
+  if (written < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return 0;
+    }
+    errorFd = direction.out;
+    return errno;
+  }
+  if (direction.tapDirection == TAP_TX) {
+    tapData(direction.tapFd, TAP_TX, direction.buffer.data() + direction.start, written);
+  }
+  direction.start += written;
+  if (direction.start == direction.end) {
+    direction.start = direction.end = 0;
+  }
+  __atomic_fetch_add(&direction.bytes, static_cast<uint64_t>(written), __ATOMIC_RELAXED);
+  return 0;
+}
+
+void Bridge::loop() {
+  BridgeDirection& toSerial = directions[BRIDGE_TO_SERIAL];
+  BridgeDirection& toSocket = directions[BRIDGE_TO_SOCKET];
+  int err = 0;
+
+  for (;;) {
+    if (toSocket.eof) {
+      // the port went away
+      errorFd = toSocket.in;
+      err = EIO;
+      break;
+    }
+    if (toSerial.eof && toSerial.pending() == 0) {
+      // the socket closed and everything it sent made it to the port
+      break;
+    }
+    bool serialRoom = toSocket.pending() < bufferSize;
+    bool socketRoom = toSerial.pending() < bufferSize && !toSerial.eof;
+    struct pollfd fds[3];
+    fds[0] = { wake_fds[0], POLLIN, 0 };
+    fds[1] = { toSocket.in, static_cast<short>((serialRoom ? POLLIN : 0) | (toSerial.pending() ? POLLOUT : 0)), 0 };
+    fds[2] = { toSerial.in, static_cast<short>((socketRoom ? POLLIN : 0) | (toSocket.pending() ? POLLOUT : 0)), 0 };
+    int ready = poll(fds, 3, -1);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready < 0) {
+      err = errno;
+      break;
+    }
+    if (fds[0].revents) {
+      // stopped from JS, nothing to report
+      return;
+    }
+    if ((fds[1].revents | fds[2].revents) & POLLNVAL) {
+      errorFd = (fds[1].revents & POLLNVAL) ? fds[1].fd : fds[2].fd;
+      err = EBADF;
+      break;
+    }
+    // a hang up or error shows up as the read coming back empty or failing
+    if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+      if (!serialRoom) {
+        errorFd = toSocket.in;
+        err = EIO;
+        break;
+      }
+      if ((err = fill(toSocket))) {
+        break;
+      }
+    }
+    if (fds[2].revents & (POLLIN | POLLHUP | POLLERR)) {
+      if (!socketRoom) {
+        toSerial.eof = true;
+      } else if ((err = fill(toSerial))) {
+        break;
+      }
+    }
+    // try both even if poll didn't say so, data that just came in can often go straight out
+    if ((err = flush(toSerial)) || (err = flush(toSocket))) {
+      break;
+    }
+  }
+
+  __atomic_store_n(&error, err, __ATOMIC_RELAXED);
+  uv_async_send(async);
+}
+
+void Bridge::onDone(uv_async_t* handle) {
+  Bridge* obj = static_cast<Bridge*>(handle->data);
+  Napi::HandleScope scope(obj->env);
+  int err = __atomic_load_n(&obj->error, __ATOMIC_RELAXED);
+  if (!err) {
+    obj->callback.Call({ obj->env.Null() });
+    return;
+  }
+  Napi::Error error = errnoError(obj->env, err, "bridge stopped");
+  // errors from the pipes splice goes through, or from poll() itself, belong to neither side
+  if (obj->errorFd == obj->directions[BRIDGE_TO_SOCKET].in) {
+    error.Value().Set("side", Napi::String::New(obj->env, "serial"));
+  } else if (obj->errorFd == obj->directions[BRIDGE_TO_SERIAL].in) {
+    error.Value().Set("side", Napi::String::New(obj->env, "socket"));
+  }
+  obj->callback.Call({ error.Value() });
+}
+
+void Bridge::stop() {
+  if (!running) {
+    return;
+  }
+  running = false;
+  char byte = 0;
+  ssize_t written;
+  do {
+    written = ::write(wake_fds[1], &byte, 1);
+  } while (written < 0 && errno == EINTR);
+  uv_thread_join(&thread);
+}
+
+void Bridge::closePipes() {
+  for (BridgeDirection& direction : directions) {
+    for (int& fd : direction.pipe) {
+      if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+  }
+  for (int& fd : wake_fds) {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+}
+
+Napi::Value Bridge::stats(const Napi::CallbackInfo& info) {
+  Napi::Object stats = Napi::Object::New(env);
+  const char* names[] = { "toSerial", "toSocket" };
+  for (int i = 0; i < 2; i++) {
+    Napi::Object direction = Napi::Object::New(env);
+    direction.Set("bytes",
+      Napi::Number::New(env, static_cast<double>(__atomic_load_n(&directions[i].bytes, __ATOMIC_RELAXED))));
+    direction.Set("splice", Napi::Boolean::New(env, __atomic_load_n(&directions[i].splice, __ATOMIC_RELAXED)));
+    stats.Set(names[i], direction);
+  }
+  return stats;
+}
+
+// Stops moving data, both fds stay open
+void Bridge::close(const Napi::CallbackInfo& info) {
+  stop();
+  if (async) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), Bridge::onClose);
+    async = nullptr;
+  }
+  closePipes();
+}
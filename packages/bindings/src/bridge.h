@@ -0,0 +1,68 @@
+#ifndef PACKAGES_SERIALPORT_SRC_BRIDGE_H_
+#define PACKAGES_SERIALPORT_SRC_BRIDGE_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <vector>
+
+#define BRIDGE_DEFAULT_BUFFER_SIZE 65536
+#define BRIDGE_MIN_BUFFER_SIZE 4096
+
+// Bytes on their way from one fd to the other. With splice they wait in a pipe and never come into user space,
+// fds that can't be spliced (EINVAL) fall back to a buffer and read()/write().
+struct BridgeDirection {
+  int in = -1;
+  int out = -1;
+  int pipe[2] = { -1, -1 };
+  bool splice = false;
+  size_t piped = 0;
+  std::vector<uint8_t> buffer;
+  size_t start = 0;
+  size_t end = 0;
+  bool eof = false;
+  uint64_t bytes = 0;
+  // the serial fd and which of its directions this is, for a tap. Tapped data has to come through the buffer.
+  int tapFd = -1;
+  int tapDirection = 0;
+
+  size_t pending() const { return piped + end - start; }
+};
+
+// Moves data between a serial port and a socket in both directions on a thread of its own
+class Bridge : public Napi::ObjectWrap<Bridge> {
+ public:
+  Bridge(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void run(void* arg);
+  static void onDone(uv_async_t* handle);
+  static void onClose(uv_handle_t* handle);
+  ~Bridge();
+
+ private:
+  Napi::Env env;
+  Napi::FunctionReference callback;
+  size_t bufferSize = BRIDGE_DEFAULT_BUFFER_SIZE;
+  // 0 to serial, 1 to socket
+  BridgeDirection directions[2];
+
+  int wake_fds[2] = { -1, -1 };
+  uv_thread_t thread;
+  bool running = false;
+  uv_async_t* async = nullptr;
+  // why the thread stopped on its own, 0 when the socket closed
+  int error = 0;
+  // the fd that failed, -1 when it wasn't the port or the socket
+  int errorFd = -1;
+
+  void loop();
+  int fill(BridgeDirection& direction);
+  int flush(BridgeDirection& direction);
+  void stop();
+  void closePipes();
+
+  Napi::Value stats(const Napi::CallbackInfo& info);
+  void close(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_BRIDGE_H_
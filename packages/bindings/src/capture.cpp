@@ -0,0 +1,309 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include "./serialport.h"
+#include "./capture.h"
+
+#define CAPTURE_DEFAULT_BLOCK_SIZE (1 << 20)
+#define CAPTURE_MIN_BLOCK_SIZE 4096
+
+// the format is little endian, as are the hosts this runs on
+template <typename T>
+static inline void put(uint8_t* target, T value) {
+  memcpy(target, &value, sizeof(value));
+}
+
+CaptureWriter::CaptureWriter(const Napi::CallbackInfo& info) : Napi::ObjectWrap<CaptureWriter>(info) {
+  Napi::Env env = info.Env();
+
+  if (!info[0].IsString()) {
+    Napi::TypeError::New(env, "path must be a string").ThrowAsJavaScriptException();
+    return;
+  }
+  std::string path = info[0].As<Napi::String>().Utf8Value();
+
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Value blockSize = info[1].As<Napi::Object>().Get("blockSize");
+  this->blockSize = blockSize.IsNumber() ? blockSize.As<Napi::Number>().Uint32Value() : CAPTURE_DEFAULT_BLOCK_SIZE;
+  if (this->blockSize < CAPTURE_MIN_BLOCK_SIZE) {
+    this->blockSize = CAPTURE_MIN_BLOCK_SIZE;
+  }
+
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throwErrno(env, errno, "open the capture file");
+    return;
+  }
+
+  struct timespec wallClock;
+  clock_gettime(CLOCK_REALTIME, &wallClock);
+  uint8_t header[CAPTURE_FILE_HEADER];
+  put<uint32_t>(header, CAPTURE_MAGIC);
+  put<uint16_t>(header + 4, CAPTURE_VERSION);
+  put<uint16_t>(header + 6, 0);
+  put<double>(header + 8, wallClock.tv_sec * 1e3 + wallClock.tv_nsec / 1e6);
+  int err = writeAll(fd, header, sizeof(header));
+  if (err) {
+    ::close(fd);
+    fd = -1;
+    throwErrno(env, err, "write the capture file");
+    return;
+  }
+  startedAt = uv_hrtime();
+
+  uv_mutex_init(&mutex);
+  uv_cond_init(&cond);
+  if (0 != uv_thread_create(&thread, CaptureWriter::run, this)) {
+    ::close(fd);
+    fd = -1;
+    uv_cond_destroy(&cond);
+    uv_mutex_destroy(&mutex);
+    Napi::Error::New(env, "Error: cannot start the capture writer thread").ThrowAsJavaScriptException();
+    return;
+  }
+  running = true;
+}
+
+CaptureWriter::~CaptureWriter() {
+  if (running) {
+    finish();
+  }
+}
+
+Napi::Object CaptureWriter::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "CaptureWriter", {
+    InstanceMethod("record", &CaptureWriter::record),
+    InstanceMethod("now", &CaptureWriter::now),
+    InstanceMethod("flush", &CaptureWriter::flush),
+    InstanceMethod("close", &CaptureWriter::close),
+  });
+
+  exports.Set("CaptureWriter", func);
+  exports.Set("mapFile", Napi::Function::New(env, MapFile));
+  return exports;
+}
+
+void CaptureWriter::run(void* arg) {
+  static_cast<CaptureWriter*>(arg)->loop();
+}
+
+// The only user of fd and fileOffset while running
+void CaptureWriter::loop() {
+  uv_mutex_lock(&mutex);
+  for (;;) {
+    while (pending.empty() && !stopping) {
+      uv_cond_wait(&cond, &mutex);
+    }
+    if (pending.empty()) {
+      break;
+    }
+    CaptureBlock* block = pending.front();
+    pending.pop_front();
+    uv_mutex_unlock(&mutex);
+
+    uint32_t bytes = static_cast<uint32_t>(block->data.size() - CAPTURE_BLOCK_HEADER);
+    put<uint32_t>(block->data.data(), CAPTURE_BLOCK_MAGIC);
+    put<uint32_t>(block->data.data() + 4, bytes);
+    put<uint32_t>(block->data.data() + 8, block->records);
+    put<uint32_t>(block->data.data() + 12, 0);
+    put<double>(block->data.data() + 16, block->firstTimestamp);
+    int err = error ? 0 : writeAll(fd, block->data.data(), block->data.size());
+
+    uv_mutex_lock(&mutex);
+    if (err) {
+      error = err;
+    } else if (!error) {
+      index.push_back({ fileOffset, block->firstTimestamp, block->records, bytes });
+      fileOffset += block->data.size();
+    }
+    delete block;
+  }
+  uv_mutex_unlock(&mutex);
+}
+
+// Hands the current block to the writer thread
+void CaptureWriter::seal() {
+  if (current.records == 0) {
+    return;
+  }
+  CaptureBlock* block = new CaptureBlock();
+  block->data.swap(current.data);
+  block->records = current.records;
+  block->firstTimestamp = current.firstTimestamp;
+  current.records = 0;
+  uv_mutex_lock(&mutex);
+  pending.push_back(block);
+  uv_cond_signal(&cond);
+  uv_mutex_unlock(&mutex);
+}
+
+// Writes the last block, the index and the trailer, returns an errno or 0
+int CaptureWriter::finish() {
+  seal();
+  uv_mutex_lock(&mutex);
+  stopping = true;
+  uv_cond_signal(&cond);
+  uv_mutex_unlock(&mutex);
+  uv_thread_join(&thread);
+  running = false;
+  uv_cond_destroy(&cond);
+  uv_mutex_destroy(&mutex);
+
+  int err = error;
+  if (!err) {
+    std::vector<uint8_t> footer(index.size() * CAPTURE_INDEX_ENTRY + CAPTURE_TRAILER);
+    uint8_t* entry = footer.data();
+    for (const CaptureIndexEntry& block : index) {
+      put<double>(entry, block.offset);
+      put<double>(entry + 8, block.firstTimestamp);
+      put<uint32_t>(entry + 16, block.records);
+      put<uint32_t>(entry + 20, block.bytes);
+      entry += CAPTURE_INDEX_ENTRY;
+    }
+    put<double>(entry, fileOffset);
+    put<uint32_t>(entry + 8, static_cast<uint32_t>(index.size()));
+    put<uint32_t>(entry + 12, CAPTURE_INDEX_MAGIC);
+    err = writeAll(fd, footer.data(), footer.size());
+  }
+  if (::close(fd) != 0 && !err) {
+    err = errno;
+  }
+  fd = -1;
+  return err;
+}
+
+// record(direction, portId, buffer[, offset, length]), copies the bytes so the buffer can be reused right away
+Napi::Value CaptureWriter::record(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!running) {
+    Napi::Error::New(env, "Capture is closed").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!info[0].IsNumber() || !info[1].IsNumber()) {
+    Napi::TypeError::New(env, "direction and portId must be ints").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!info[2].IsTypedArray() || info[2].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+    Napi::TypeError::New(env, "buffer must be a Uint8Array").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Uint8Array buffer = info[2].As<Napi::Uint8Array>();
+  size_t offset = info[3].IsNumber() ? info[3].As<Napi::Number>().Uint32Value() : 0;
+  size_t length = info[4].IsNumber() ? info[4].As<Napi::Number>().Uint32Value() : buffer.ByteLength() - offset;
+  if (offset > buffer.ByteLength() || length > buffer.ByteLength() - offset) {
+    Napi::RangeError::New(env, "offset and length must be within the buffer").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  uv_mutex_lock(&mutex);
+  int err = error;
+  uv_mutex_unlock(&mutex);
+  if (err) {
+    throwErrno(env, err, "write the capture file");
+    return env.Undefined();
+  }
+
+  double timestamp = static_cast<double>(uv_hrtime() - startedAt) / 1e6;
+  if (current.records > 0 && current.data.size() + CAPTURE_RECORD_HEADER + length > blockSize) {
+    seal();
+  }
+  if (current.records == 0) {
+    current.data.reserve(blockSize);
+    current.data.resize(CAPTURE_BLOCK_HEADER);
+    current.firstTimestamp = timestamp;
+  }
+  size_t at = current.data.size();
+  current.data.resize(at + CAPTURE_RECORD_HEADER + length);
+  uint8_t* header = current.data.data() + at;
+  header[0] = static_cast<uint8_t>(info[0].As<Napi::Number>().Uint32Value());
+  header[1] = 0;
+  put<uint16_t>(header + 2, static_cast<uint16_t>(info[1].As<Napi::Number>().Uint32Value()));
+  put<uint32_t>(header + 4, static_cast<uint32_t>(length));
+  put<double>(header + 8, timestamp);
+  memcpy(header + CAPTURE_RECORD_HEADER, buffer.Data() + offset, length);
+  current.records++;
+  recordCount++;
+  byteCount += length;
+  return Napi::Number::New(env, timestamp);
+}
+
+// ms since the capture started, on the same clock as the record timestamps
+Napi::Value CaptureWriter::now(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), static_cast<double>(uv_hrtime() - startedAt) / 1e6);
+}
+
+void CaptureWriter::flush(const Napi::CallbackInfo& info) {
+  if (running) {
+    seal();
+  }
+}
+
+Napi::Value CaptureWriter::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!running) {
+    return env.Undefined();
+  }
+  int err = finish();
+  if (err) {
+    throwErrno(env, err, "write the capture file");
+    return env.Undefined();
+  }
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("records", Napi::Number::New(env, static_cast<double>(recordCount)));
+  stats.Set("bytes", Napi::Number::New(env, static_cast<double>(byteCount)));
+  stats.Set("blocks", Napi::Number::New(env, static_cast<double>(index.size())));
+  return stats;
+}
+
+static void unmap(Napi::Env env, uint8_t* data, size_t* length) {
+  munmap(data, *length);
+  delete length;
+}
+
+// mapFile(path), a Buffer backed by the file's pages instead of a copy. The mapping is copy on write, writing to the
+// Buffer changes this process's copy of a page and never the file.
+Napi::Value MapFile(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsString()) {
+    Napi::TypeError::New(env, "path must be a string").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  std::string path = info[0].As<Napi::String>().Utf8Value();
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throwErrno(env, errno, "open the file");
+    return env.Undefined();
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    ::close(fd);
+    throwErrno(env, err, "stat the file");
+    return env.Undefined();
+  }
+  if (st.st_size == 0) {
+    ::close(fd);
+    return Napi::Buffer<uint8_t>::New(env, 0);
+  }
+  size_t* length = new size_t(static_cast<size_t>(st.st_size));
+  void* data = mmap(nullptr, *length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  int err = errno;
+  // the mapping keeps the file open
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    delete length;
+    throwErrno(env, err, "map the file");
+    return env.Undefined();
+  }
+  return Napi::Buffer<uint8_t>::New(env, static_cast<uint8_t*>(data), *length, unmap, length);
+}
@@ -0,0 +1,82 @@
+#ifndef PACKAGES_SERIALPORT_SRC_CAPTURE_H_
+#define PACKAGES_SERIALPORT_SRC_CAPTURE_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+// Layout of a capture file, lib/capture.js mirrors these values. All fields are little endian.
+// [file header][block]...[block][index entry]...[trailer]
+// The index and trailer are missing if the writer never closed.
+#define CAPTURE_MAGIC 0x50435053        // "SPCP"
+#define CAPTURE_VERSION 1
+// uint32 magic, uint16 version, uint16 flags, float64 wall clock ms at the start
+#define CAPTURE_FILE_HEADER 16
+#define CAPTURE_BLOCK_MAGIC 0x4b425053  // "SPBK"
+// uint32 magic, uint32 record bytes, uint32 record count, uint32 reserved, float64 first timestamp
+#define CAPTURE_BLOCK_HEADER 24
+// uint8 direction, uint8 flags, uint16 port id, uint32 length, float64 ms since the start
+#define CAPTURE_RECORD_HEADER 16
+// float64 block file offset, float64 first timestamp, uint32 record count, uint32 record bytes
+#define CAPTURE_INDEX_ENTRY 24
+#define CAPTURE_INDEX_MAGIC 0x58495053  // "SPIX"
+#define CAPTURE_TRAILER 16              // float64 index file offset, uint32 block count, uint32 magic
+
+#define CAPTURE_DIRECTION_RX 0
+#define CAPTURE_DIRECTION_TX 1
+
+struct CaptureBlock {
+  std::vector<uint8_t> data;
+  uint32_t records = 0;
+  double firstTimestamp = 0;
+};
+
+struct CaptureIndexEntry {
+  double offset;
+  double firstTimestamp;
+  uint32_t records;
+  uint32_t bytes;
+};
+
+// Appends records to an in-memory block, full blocks are written to the file on a thread of their own
+class CaptureWriter : public Napi::ObjectWrap<CaptureWriter> {
+ public:
+  CaptureWriter(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void run(void* arg);
+  ~CaptureWriter();
+
+ private:
+  int fd = -1;
+  size_t blockSize = 0;
+  uint64_t startedAt = 0;
+  CaptureBlock current;
+  uint64_t recordCount = 0;
+  uint64_t byteCount = 0;
+
+  // shared with the writer thread
+  uv_mutex_t mutex;
+  uv_cond_t cond;
+  uv_thread_t thread;
+  std::deque<CaptureBlock*> pending;
+  std::vector<CaptureIndexEntry> index;
+  double fileOffset = CAPTURE_FILE_HEADER;
+  int error = 0;
+  bool stopping = false;
+  bool running = false;
+
+  void loop();
+  void seal();
+  int finish();
+
+  Napi::Value record(const Napi::CallbackInfo& info);
+  Napi::Value now(const Napi::CallbackInfo& info);
+  void flush(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+};
+
+Napi::Value MapFile(const Napi::CallbackInfo& info);
+
+#endif  // PACKAGES_SERIALPORT_SRC_CAPTURE_H_
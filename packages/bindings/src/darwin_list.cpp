@@ -1,3 +1,4 @@
+#include "./serialport.h"
 #include "./darwin_list.h"
 
 #include <IOKit/IOKitLib.h>
@@ -14,7 +15,12 @@
 #include <list>
 
 uv_mutex_t list_mutex;
-Boolean lockInitialised = FALSE;
+uv_once_t list_mutex_once = UV_ONCE_INIT;
+
+// Lists can run concurrently from several environments (worker threads)
+static void initListMutex() {
+  uv_mutex_init(&list_mutex);
+}
 
 Napi::Value List(const Napi::CallbackInfo& info) {
   auto env = info.Env();
@@ -31,7 +37,7 @@ Napi::Value List(const Napi::CallbackInfo& info) {
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
-  uv_queue_work(uv_default_loop(), req, EIO_List, (uv_after_work_cb)EIO_AfterList);
+  uv_queue_work(getLoop(env), req, EIO_List, (uv_after_work_cb)EIO_AfterList);
   return env.Undefined();
 }
 
@@ -282,10 +288,7 @@ static stDeviceListItem* GetSerialDevices() {
 void EIO_List(uv_work_t* req) {
   ListBaton* data = static_cast<ListBaton*>(req->data);
 
-  if (!lockInitialised) {
-    uv_mutex_init(&list_mutex);
-    lockInitialised = TRUE;
-  }
+  uv_once(&list_mutex_once, initListMutex);
 
   stDeviceListItem* devices = GetSerialDevices();
   if (devices != NULL && *(devices->length) > 0) {
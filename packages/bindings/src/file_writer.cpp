@@ -0,0 +1,278 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include "./serialport.h"
+#include "./file_writer.h"
+#include "./tap.h"
+
+// FileWriter(fd, path, { offset, length, chunkSize, progressBytes }, onProgress, cb)
+FileWriter::FileWriter(const Napi::CallbackInfo& info) : Napi::ObjectWrap<FileWriter>(info), env(info.Env()) {
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  fd = info[0].As<Napi::Number>().Int32Value();
+
+  if (!info[1].IsString()) {
+    Napi::TypeError::New(env, "path must be a string").ThrowAsJavaScriptException();
+    return;
+  }
+  std::string path = info[1].As<Napi::String>().Utf8Value();
+
+  if (!info[2].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[2].As<Napi::Object>();
+  Napi::Value offsetValue = options.Get("offset");
+  offset = offsetValue.IsNumber() ? static_cast<uint64_t>(offsetValue.As<Napi::Number>().DoubleValue()) : 0;
+  Napi::Value lengthValue = options.Get("length");
+  Napi::Value chunkValue = options.Get("chunkSize");
+  if (chunkValue.IsNumber()) {
+    chunkSize = chunkValue.As<Napi::Number>().Uint32Value();
+  }
+  if (chunkSize < 1 || chunkSize > FILE_WRITER_MAX_CHUNK) {
+    Napi::RangeError::New(env, "chunkSize must be from 1 to 1048576").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Value progressValue = options.Get("progressBytes");
+  if (progressValue.IsNumber()) {
+    progressBytes = static_cast<uint64_t>(progressValue.As<Napi::Number>().DoubleValue());
+  }
+
+  if (!info[3].IsFunction() && !info[3].IsUndefined() && !info[3].IsNull()) {
+    Napi::TypeError::New(env, "onProgress must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+  if (!info[4].IsFunction()) {
+    Napi::TypeError::New(env, "cb must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+
+  int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0) {
+    throwErrno(env, errno, "open the file");
+    return;
+  }
+  struct stat st;
+  if (fstat(file, &st) != 0) {
+    int err = errno;
+    ::close(file);
+    throwErrno(env, err, "stat the file");
+    return;
+  }
+  uint64_t size = static_cast<uint64_t>(st.st_size);
+  if (offset > size) {
+    ::close(file);
+    Napi::RangeError::New(env, "offset is past the end of the file").ThrowAsJavaScriptException();
+    return;
+  }
+  length = size - offset;
+  if (lengthValue.IsNumber()) {
+    uint64_t requested = static_cast<uint64_t>(lengthValue.As<Napi::Number>().DoubleValue());
+    if (requested < length) {
+      length = requested;
+    }
+  }
+  if (length > 0) {
+    uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t start = offset - offset % pageSize;
+    mappedLength = static_cast<size_t>(offset - start + length);
+    // truncating the file while it's being written makes the rest of the mapping fault (SIGBUS), the JS docs say so.
+    // A private mapping faults the same way, only reading it up front would avoid it.
+    void* data = mmap(nullptr, mappedLength, PROT_READ, MAP_SHARED, file, static_cast<off_t>(start));
+    if (data == MAP_FAILED) {
+      int err = errno;
+      ::close(file);
+      mappedLength = 0;
+      throwErrno(env, err, "map the file");
+      return;
+    }
+    mapped = static_cast<uint8_t*>(data);
+    madvise(mapped, mappedLength, MADV_SEQUENTIAL);
+  }
+  // the mapping keeps the file open
+  ::close(file);
+
+  if (0 != pipe(wake_fds)) {
+    int err = errno;
+    release();
+    throwErrno(env, err, "create a pipe");
+    return;
+  }
+  fcntl(wake_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_fds[1], F_SETFD, FD_CLOEXEC);
+
+  if (info[3].IsFunction()) {
+    progressCallback.Reset(info[3].As<Napi::Function>(), 1);
+  }
+  callback.Reset(info[4].As<Napi::Function>(), 1);
+  async = new uv_async_t();
+  async->data = this;
+  uv_async_init(getLoop(env), async, FileWriter::onWake);
+
+  running = true;
+  if (0 != uv_thread_create(&thread, FileWriter::run, this)) {
+    running = false;
+    release();
+    Napi::Error::New(env, "Error: cannot start the file writer thread").ThrowAsJavaScriptException();
+    return;
+  }
+}
+
+FileWriter::~FileWriter() {
+  if (running) {
+    __atomic_store_n(&canceled, true, __ATOMIC_RELEASE);
+    char byte = 0;
+    ssize_t ignored = ::write(wake_fds[1], &byte, 1);
+    (void)ignored;
+    uv_thread_join(&thread);
+    running = false;
+  }
+  release();
+}
+
+void FileWriter::onClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+Napi::Object FileWriter::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "FileWriter", {
+    InstanceMethod("cancel", &FileWriter::cancel),
+  });
+
+  exports.Set("FileWriter", func);
+  return exports;
+}
+
+void FileWriter::run(void* arg) {
+  static_cast<FileWriter*>(arg)->loop();
+}
+
+void FileWriter::loop() {
+  const uint8_t* data = mapped + (mappedLength - length);
+  uint64_t sent = 0;
+  uint64_t signaled = 0;
+  int err = 0;
+
+  while (sent < length) {
+    if (__atomic_load_n(&canceled, __ATOMIC_ACQUIRE)) {
+      err = ECANCELED;
+      break;
+    }
+    size_t size = length - sent < chunkSize ? static_cast<size_t>(length - sent) : chunkSize;
+    ssize_t count = ::write(fd, data + sent, size);
+    if (count > 0) {
+      tapData(fd, TAP_TX, data + sent, count);
+      sent += count;
+      __atomic_store_n(&bytesWritten, sent, __ATOMIC_RELAXED);
+      if (progressBytes > 0 && sent - signaled >= progressBytes) {
+        signaled = sent;
+        uv_async_send(async);
+      }
+      continue;
+    }
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      err = errno;
+      break;
+    }
+    // the output queue is full or flow control has stopped the port, wait for room like a write through the poller
+    struct pollfd fds[2] = { { fd, POLLOUT, 0 }, { wake_fds[0], POLLIN, 0 } };
+    int ready = poll(fds, 2, -1);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready < 0) {
+      err = errno;
+      break;
+    }
+    if (fds[1].revents) {
+      err = ECANCELED;
+      break;
+    }
+    if (fds[0].revents & POLLNVAL) {
+      err = EBADF;
+      break;
+    }
+    if ((fds[0].revents & (POLLHUP | POLLERR)) && !(fds[0].revents & POLLOUT)) {
+      err = EIO;
+      break;
+    }
+  }
+
+  __atomic_store_n(&error, err, __ATOMIC_RELAXED);
+  __atomic_store_n(&finished, true, __ATOMIC_RELEASE);
+  uv_async_send(async);
+}
+
+// Progress and the end of the write both come through here, wakeups coalesce so progress can skip a step
+void FileWriter::onWake(uv_async_t* handle) {
+  FileWriter* obj = static_cast<FileWriter*>(handle->data);
+  Napi::HandleScope scope(obj->env);
+  bool finished = __atomic_load_n(&obj->finished, __ATOMIC_ACQUIRE);
+  uint64_t bytes = __atomic_load_n(&obj->bytesWritten, __ATOMIC_RELAXED);
+  if (!obj->progressCallback.IsEmpty() && bytes != obj->reported) {
+    obj->reported = bytes;
+    obj->progressCallback.Call({
+      Napi::Number::New(obj->env, static_cast<double>(bytes)),
+      Napi::Number::New(obj->env, static_cast<double>(obj->length))
+    });
+  }
+  if (finished) {
+    obj->done();
+  }
+}
+
+void FileWriter::done() {
+  uv_thread_join(&thread);
+  running = false;
+  release();
+  Napi::Value bytes = Napi::Number::New(env, static_cast<double>(bytesWritten));
+  if (!error) {
+    callback.Call({ env.Null(), bytes });
+    return;
+  }
+  Napi::Error err = errnoError(env, error, "cannot write");
+  err.Value().Set("bytesWritten", bytes);
+  callback.Call({ err.Value(), bytes });
+}
+
+void FileWriter::release() {
+  if (mapped) {
+    munmap(mapped, mappedLength);
+    mapped = nullptr;
+  }
+  for (int& wake_fd : wake_fds) {
+    if (wake_fd >= 0) {
+      ::close(wake_fd);
+      wake_fd = -1;
+    }
+  }
+  if (async) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), FileWriter::onClose);
+    async = nullptr;
+  }
+}
+
+// Stops after the chunk being written, the callback gets ECANCELED
+void FileWriter::cancel(const Napi::CallbackInfo& info) {
+  if (!running) {
+    return;
+  }
+  __atomic_store_n(&canceled, true, __ATOMIC_RELEASE);
+  char byte = 0;
+  ssize_t written;
+  do {
+    written = ::write(wake_fds[1], &byte, 1);
+  } while (written < 0 && errno == EINTR);
+}
@@ -0,0 +1,55 @@
+#ifndef PACKAGES_SERIALPORT_SRC_FILE_WRITER_H_
+#define PACKAGES_SERIALPORT_SRC_FILE_WRITER_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+
+#define FILE_WRITER_DEFAULT_CHUNK 4096
+#define FILE_WRITER_MAX_CHUNK (1 << 20)
+#define FILE_WRITER_DEFAULT_PROGRESS 65536
+
+// Writes part of a file to a port on a thread of its own. The file is mapped, so the data goes from the page cache
+// to the tty without a copy in JS, and the port's flow control holds the thread back like any other write.
+class FileWriter : public Napi::ObjectWrap<FileWriter> {
+ public:
+  FileWriter(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void run(void* arg);
+  static void onWake(uv_async_t* handle);
+  static void onClose(uv_handle_t* handle);
+  ~FileWriter();
+
+ private:
+  int fd = -1;
+  Napi::Env env;
+  Napi::FunctionReference progressCallback;
+  Napi::FunctionReference callback;
+  uint64_t offset = 0;
+  uint64_t length = 0;
+  size_t chunkSize = FILE_WRITER_DEFAULT_CHUNK;
+  uint64_t progressBytes = FILE_WRITER_DEFAULT_PROGRESS;
+  // the mapping starts at the page offset falls in
+  uint8_t* mapped = nullptr;
+  size_t mappedLength = 0;
+
+  int wake_fds[2] = { -1, -1 };
+  uv_thread_t thread;
+  bool running = false;
+  uv_async_t* async = nullptr;
+
+  // shared with the thread
+  uint64_t bytesWritten = 0;
+  uint64_t reported = 0;
+  bool canceled = false;
+  bool finished = false;
+  int error = 0;
+
+  void loop();
+  void done();
+  void release();
+
+  void cancel(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_FILE_WRITER_H_
@@ -0,0 +1,252 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "./serialport.h"
+#include "./ring_reader.h"
+#include "./port_state.h"
+#include "./flow_guard.h"
+
+// FlowGuard(fd, { mode, highWater, lowWater, intervalUs })
+FlowGuard::FlowGuard(const Napi::CallbackInfo& info) : Napi::ObjectWrap<FlowGuard>(info) {
+  Napi::Env env = info.Env();
+
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  fd = info[0].As<Napi::Number>().Int32Value();
+
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].As<Napi::Object>();
+  mode = options.Get("mode").ToNumber().Int32Value() == FLOW_GUARD_XOFF ? FLOW_GUARD_XOFF : FLOW_GUARD_RTS;
+  Napi::Value high = options.Get("highWater");
+  Napi::Value low = options.Get("lowWater");
+  if (!high.IsNumber() || !low.IsNumber()) {
+    Napi::TypeError::New(env, "highWater and lowWater must be numbers").ThrowAsJavaScriptException();
+    return;
+  }
+  highWater = static_cast<uint64_t>(high.As<Napi::Number>().DoubleValue());
+  lowWater = static_cast<uint64_t>(low.As<Napi::Number>().DoubleValue());
+  if (lowWater >= highWater) {
+    Napi::RangeError::New(env, "lowWater must be below highWater").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Value interval = options.Get("intervalUs");
+  if (interval.IsNumber() && interval.As<Napi::Number>().Uint32Value() > 0) {
+    intervalUs = interval.As<Napi::Number>().Uint32Value();
+  }
+
+  if (0 != pipe(wake_fds)) {
+    throwErrno(env, errno, "create a pipe");
+    return;
+  }
+  fcntl(wake_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_fds[1], F_SETFD, FD_CLOEXEC);
+
+  uv_mutex_init(&mutex);
+  running = true;
+  if (0 != uv_thread_create(&thread, FlowGuard::run, this)) {
+    running = false;
+    uv_mutex_destroy(&mutex);
+    for (int& wake_fd : wake_fds) {
+      ::close(wake_fd);
+      wake_fd = -1;
+    }
+    Napi::Error::New(env, "Error: cannot start the flow guard thread").ThrowAsJavaScriptException();
+    return;
+  }
+}
+
+// The binding closes the guard before it lets go of the fd, this only matters if that was skipped
+FlowGuard::~FlowGuard() {
+  if (running) {
+    stopThread();
+    if (active) {
+      release();
+    }
+  }
+}
+
+Napi::Object FlowGuard::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "FlowGuard", {
+    InstanceMethod("setBuffered", &FlowGuard::setBuffered),
+    InstanceMethod("setRing", &FlowGuard::setRing),
+    InstanceMethod("stats", &FlowGuard::stats),
+    InstanceMethod("close", &FlowGuard::close),
+  });
+
+  exports.Set("FlowGuard", func);
+  return exports;
+}
+
+void FlowGuard::run(void* arg) {
+  static_cast<FlowGuard*>(arg)->loop();
+}
+
+// Tells the peer to stop, returns an errno or 0
+int FlowGuard::stop() {
+  if (mode == FLOW_GUARD_XOFF) {
+    return tcflow(fd, TCIOFF) == 0 ? 0 : errno;
+  }
+  int bits = TIOCM_RTS;
+  forgetModemState(fd);
+  return ioctl(fd, TIOCMBIC, &bits) == 0 ? 0 : errno;
+}
+
+// Lets the peer go on, returns an errno or 0
+int FlowGuard::release() {
+  if (mode == FLOW_GUARD_XOFF) {
+    return tcflow(fd, TCION) == 0 ? 0 : errno;
+  }
+  int bits = TIOCM_RTS;
+  forgetModemState(fd);
+  return ioctl(fd, TIOCMBIS, &bits) == 0 ? 0 : errno;
+}
+
+void FlowGuard::loop() {
+  int timeoutMs = static_cast<int>((intervalUs + 999) / 1000);
+  struct pollfd stopped = { wake_fds[0], POLLIN, 0 };
+
+  for (;;) {
+    int inQueue = 0;
+    if (ioctl(fd, FIONREAD, &inQueue) != 0) {
+      __atomic_store_n(&error, errno, __ATOMIC_RELAXED);
+      break;
+    }
+    uint64_t current = static_cast<uint64_t>(inQueue) + __atomic_load_n(&buffered, __ATOMIC_RELAXED);
+    uv_mutex_lock(&mutex);
+    if (ringHeader) {
+      uint32_t written = static_cast<uint32_t>(__atomic_load_n(&ringHeader[RING_WRITE], __ATOMIC_ACQUIRE));
+      uint32_t read = static_cast<uint32_t>(__atomic_load_n(&ringHeader[RING_READ], __ATOMIC_ACQUIRE));
+      current += written - read;
+    }
+    uv_mutex_unlock(&mutex);
+    __atomic_store_n(&level, current, __ATOMIC_RELAXED);
+    if (current > __atomic_load_n(&maxLevel, __ATOMIC_RELAXED)) {
+      __atomic_store_n(&maxLevel, current, __ATOMIC_RELAXED);
+    }
+
+    bool isActive = __atomic_load_n(&active, __ATOMIC_RELAXED);
+    if (!isActive && current >= highWater) {
+      int err = stop();
+      if (err) {
+        __atomic_store_n(&error, err, __ATOMIC_RELAXED);
+        break;
+      }
+      __atomic_store_n(&activeSince, uv_hrtime(), __ATOMIC_RELAXED);
+      __atomic_fetch_add(&activations, 1, __ATOMIC_RELAXED);
+      __atomic_store_n(&active, true, __ATOMIC_RELEASE);
+    } else if (isActive && current <= lowWater) {
+      int err = release();
+      if (err) {
+        __atomic_store_n(&error, err, __ATOMIC_RELAXED);
+        break;
+      }
+      __atomic_store_n(&active, false, __ATOMIC_RELEASE);
+      __atomic_fetch_add(&activeNs, uv_hrtime() - __atomic_load_n(&activeSince, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    }
+
+    int ready = poll(&stopped, 1, timeoutMs);
+    if (ready > 0) {
+      break;
+    }
+  }
+}
+
+void FlowGuard::stopThread() {
+  if (!running) {
+    return;
+  }
+  running = false;
+  char byte = 0;
+  ssize_t written;
+  do {
+    written = ::write(wake_fds[1], &byte, 1);
+  } while (written < 0 && errno == EINTR);
+  uv_thread_join(&thread);
+  for (int& wake_fd : wake_fds) {
+    ::close(wake_fd);
+    wake_fd = -1;
+  }
+  uv_mutex_destroy(&mutex);
+}
+
+// setBuffered(bytes), what JS holds that hasn't been consumed yet
+void FlowGuard::setBuffered(const Napi::CallbackInfo& info) {
+  if (info[0].IsNumber()) {
+    uint64_t bytes = static_cast<uint64_t>(info[0].As<Napi::Number>().DoubleValue());
+    __atomic_store_n(&buffered, bytes, __ATOMIC_RELAXED);
+  }
+}
+
+// setRing(shared), the Uint8Array a RingReader fills, or null once it stops
+void FlowGuard::setRing(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!running) {
+    return;
+  }
+  int32_t* header = nullptr;
+  if (info[0].IsTypedArray() && info[0].As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array) {
+    Napi::Uint8Array shared = info[0].As<Napi::Uint8Array>();
+    if (shared.ByteLength() <= RING_HEADER_SIZE) {
+      Napi::RangeError::New(env, "shared must be a ring").ThrowAsJavaScriptException();
+      return;
+    }
+    header = reinterpret_cast<int32_t*>(shared.Data());
+  } else if (!info[0].IsNull() && !info[0].IsUndefined()) {
+    Napi::TypeError::New(env, "shared must be a Uint8Array or null").ThrowAsJavaScriptException();
+    return;
+  }
+  uv_mutex_lock(&mutex);
+  ringHeader = header;
+  uv_mutex_unlock(&mutex);
+  if (header) {
+    ringArray.Reset(info[0].As<Napi::Object>(), 1);
+  } else {
+    ringArray.Reset();
+  }
+}
+
+Napi::Value FlowGuard::stats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  bool isActive = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+  uint64_t totalNs = __atomic_load_n(&activeNs, __ATOMIC_RELAXED);
+  if (isActive) {
+    totalNs += uv_hrtime() - __atomic_load_n(&activeSince, __ATOMIC_RELAXED);
+  }
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("active", Napi::Boolean::New(env, isActive));
+  uint64_t count = __atomic_load_n(&activations, __ATOMIC_RELAXED);
+  stats.Set("activations", Napi::Number::New(env, static_cast<double>(count)));
+  stats.Set("activeMs", Napi::Number::New(env, static_cast<double>(totalNs) / 1e6));
+  stats.Set("level", Napi::Number::New(env, static_cast<double>(__atomic_load_n(&level, __ATOMIC_RELAXED))));
+  stats.Set("maxLevel", Napi::Number::New(env, static_cast<double>(__atomic_load_n(&maxLevel, __ATOMIC_RELAXED))));
+  int err = __atomic_load_n(&error, __ATOMIC_RELAXED);
+  if (err) {
+    stats.Set("error", uv_err_name(uv_translate_sys_error(err)));
+  }
+  return stats;
+}
+
+// Stops watching, a stopped peer is let go first
+void FlowGuard::close(const Napi::CallbackInfo& info) {
+  if (!running) {
+    return;
+  }
+  stopThread();
+  ringArray.Reset();
+  if (__atomic_load_n(&active, __ATOMIC_ACQUIRE)) {
+    release();
+    __atomic_fetch_add(&activeNs, uv_hrtime() - activeSince, __ATOMIC_RELAXED);
+    active = false;
+  }
+}
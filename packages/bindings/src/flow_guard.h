@@ -0,0 +1,60 @@
+#ifndef PACKAGES_SERIALPORT_SRC_FLOW_GUARD_H_
+#define PACKAGES_SERIALPORT_SRC_FLOW_GUARD_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+
+#define FLOW_GUARD_RTS 0
+#define FLOW_GUARD_XOFF 1
+
+#define FLOW_GUARD_DEFAULT_INTERVAL_US 1000
+
+// Stops the peer while received data piles up on our side. A thread of its own adds up the kernel's input queue,
+// the native ring and what JS reports as buffered, drops RTS (or sends XOFF) above the high watermark and raises
+// it again (or sends XON) below the low one. It doesn't need the event loop, so GC pauses don't hold it up.
+class FlowGuard : public Napi::ObjectWrap<FlowGuard> {
+ public:
+  FlowGuard(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void run(void* arg);
+  ~FlowGuard();
+
+ private:
+  int fd = -1;
+  int mode = FLOW_GUARD_RTS;
+  uint64_t highWater = 0;
+  uint64_t lowWater = 0;
+  unsigned intervalUs = FLOW_GUARD_DEFAULT_INTERVAL_US;
+
+  int wake_fds[2] = { -1, -1 };
+  uv_thread_t thread;
+  bool running = false;
+
+  // the ring of a running RingReader, its typed array keeps the memory alive
+  uv_mutex_t mutex;
+  Napi::ObjectReference ringArray;
+  int32_t* ringHeader = nullptr;
+
+  // shared with the thread
+  uint64_t buffered = 0;
+  bool active = false;
+  uint64_t activeSince = 0;
+  uint64_t activeNs = 0;
+  uint64_t activations = 0;
+  uint64_t level = 0;
+  uint64_t maxLevel = 0;
+  int error = 0;
+
+  void loop();
+  int stop();
+  int release();
+  void stopThread();
+
+  void setBuffered(const Napi::CallbackInfo& info);
+  void setRing(const Napi::CallbackInfo& info);
+  Napi::Value stats(const Napi::CallbackInfo& info);
+  void close(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_FLOW_GUARD_H_
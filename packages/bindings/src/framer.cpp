@@ -0,0 +1,134 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include "./serialport.h"
+#include "./framer.h"
+#include "./tap.h"
+
+#define FRAMER_CHUNK_SIZE 65536
+// Bounds the time spent in one read() call on a port that never runs dry
+#define FRAMER_MAX_CHUNKS 16
+
+Framer::Framer(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Framer>(info) {
+  auto env = info.Env();
+
+  if (!info[0].IsObject()) {
+    Napi::TypeError::New(env, "spec must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[0].As<Napi::Object>();
+
+  FramingSpec spec;
+  std::string type = options.Get("type").ToString();
+  if (type == "delimiter") {
+    Napi::Value delimiter = options.Get("delimiter");
+    if (!delimiter.IsBuffer() || delimiter.As<Napi::Buffer<uint8_t>>().Length() == 0) {
+      Napi::TypeError::New(env, "delimiter must be a non empty Buffer").ThrowAsJavaScriptException();
+      return;
+    }
+    Napi::Buffer<uint8_t> bytes = delimiter.As<Napi::Buffer<uint8_t>>();
+    spec.type = FRAMING_DELIMITER;
+    spec.delimiter.assign(bytes.Data(), bytes.Data() + bytes.Length());
+    spec.includeDelimiter = options.Get("includeDelimiter").ToBoolean();
+  } else if (type == "byteLength") {
+    spec.type = FRAMING_BYTE_LENGTH;
+    spec.length = options.Get("length").ToNumber().Uint32Value();
+    if (spec.length == 0) {
+      Napi::TypeError::New(env, "length must be a positive int").ThrowAsJavaScriptException();
+      return;
+    }
+  } else if (type == "lengthPrefixed") {
+    spec.type = FRAMING_LENGTH_PREFIXED;
+    spec.lengthBytes = options.Get("lengthBytes").ToNumber().Uint32Value();
+    if (spec.lengthBytes != 1 && spec.lengthBytes != 2 && spec.lengthBytes != 4) {
+      Napi::TypeError::New(env, "lengthBytes must be 1, 2 or 4").ThrowAsJavaScriptException();
+      return;
+    }
+    spec.littleEndian = options.Get("littleEndian").ToBoolean();
+    spec.includeLength = options.Get("includeLength").ToBoolean();
+  } else if (type == "slip") {
+    spec.type = FRAMING_SLIP;
+  } else {
+    Napi::TypeError::New(env, "type must be delimiter, byteLength, lengthPrefixed or slip").ThrowAsJavaScriptException();
+    return;
+  }
+  if (options.Has("maxLength")) {
+    spec.maxLength = options.Get("maxLength").ToNumber().Uint32Value();
+  }
+
+  this->framing.reset(new Framing(spec));
+  this->chunk.resize(FRAMER_CHUNK_SIZE);
+}
+
+Napi::Object Framer::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "Framer", {
+    InstanceMethod("read", &Framer::read),
+    InstanceMethod("push", &Framer::push),
+  });
+
+  exports.Set("Framer", func);
+  return exports;
+}
+
+// Hands every frame completed so far to JS in one go, a single Buffer and the end offset of each frame in it
+Napi::Value Framer::batch(Napi::Env env) {
+  if (ends.empty()) {
+    return env.Null();
+  }
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("buffer", Napi::Buffer<uint8_t>::Copy(env, frames.data(), frames.size()));
+  Napi::Uint32Array offsets = Napi::Uint32Array::New(env, ends.size());
+  memcpy(offsets.Data(), ends.data(), ends.size() * sizeof(uint32_t));
+  result.Set("ends", offsets);
+  frames.clear();
+  ends.clear();
+  return result;
+}
+
+// Drains the non blocking fd and frames what it got. Returns null when there is no complete frame yet.
+Napi::Value Framer::read(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  int fd = info[0].As<Napi::Number>().Int32Value();
+
+  for (int i = 0; i < FRAMER_MAX_CHUNKS; i++) {
+    ssize_t bytesRead = ::read(fd, chunk.data(), chunk.size());
+    if (bytesRead > 0) {
+      tapData(fd, TAP_RX, chunk.data(), bytesRead);
+      framing->push(chunk.data(), bytesRead, &frames, &ends);
+      if (static_cast<size_t>(bytesRead) < chunk.size()) {
+        break;
+      }
+      continue;
+    }
+    if (bytesRead == 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      break;
+    }
+    if (!ends.empty()) {
+      // deliver what we have, the next read runs into the error again
+      break;
+    }
+    throwErrno(env, errno, "read");
+    return env.Undefined();
+  }
+  return batch(env);
+}
+
+// Frames bytes that were read elsewhere
+Napi::Value Framer::push(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  if (!info[0].IsBuffer()) {
+    Napi::TypeError::New(env, "data must be a Buffer").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Buffer<uint8_t> data = info[0].As<Napi::Buffer<uint8_t>>();
+  framing->push(data.Data(), data.Length(), &frames, &ends);
+  return batch(env);
+}
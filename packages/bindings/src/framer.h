@@ -0,0 +1,26 @@
+#ifndef PACKAGES_SERIALPORT_SRC_FRAMER_H_
+#define PACKAGES_SERIALPORT_SRC_FRAMER_H_
+
+#include <napi.h>
+#include <memory>
+#include <vector>
+#include "./framing.h"
+
+class Framer : public Napi::ObjectWrap<Framer> {
+ public:
+  Framer(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+ private:
+  std::unique_ptr<Framing> framing;
+  std::vector<uint8_t> chunk;
+  std::vector<uint8_t> frames;
+  std::vector<uint32_t> ends;
+
+  Napi::Value batch(Napi::Env env);
+
+  Napi::Value read(const Napi::CallbackInfo& info);
+  Napi::Value push(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_FRAMER_H_
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include "./framing.h"
+
+#define SLIP_END 0xC0
+#define SLIP_ESC 0xDB
+#define SLIP_ESC_END 0xDC
+#define SLIP_ESC_ESC 0xDD
+
+static void emit(const uint8_t* data, size_t length, std::vector<uint8_t>* frames, std::vector<uint32_t>* ends) {
+  // an empty frame wouldn't make it through a read anyway
+  if (length == 0) {
+    return;
+  }
+  frames->insert(frames->end(), data, data + length);
+  ends->push_back(static_cast<uint32_t>(frames->size()));
+}
+
+Framing::Framing(const FramingSpec& spec) : spec(spec) {}
+
+void Framing::push(const uint8_t* data, size_t length, std::vector<uint8_t>* frames, std::vector<uint32_t>* ends) {
+  if (spec.type == FRAMING_SLIP) {
+    // decodes in place, there's nothing to gain from buffering the raw bytes
+    pushSlip(data, length, frames, ends);
+    return;
+  }
+  partial.insert(partial.end(), data, data + length);
+  switch (spec.type) {
+    case FRAMING_DELIMITER:
+      pushDelimiter(frames, ends);
+      break;
+    case FRAMING_BYTE_LENGTH:
+      pushByteLength(frames, ends);
+      break;
+    case FRAMING_LENGTH_PREFIXED:
+      pushLengthPrefixed(frames, ends);
+      break;
+    default:
+      break;
+  }
+}
+
+void Framing::pushDelimiter(std::vector<uint8_t>* frames, std::vector<uint32_t>* ends) {
+  const std::vector<uint8_t>& delimiter = spec.delimiter;
+  size_t consumed = 0;
+  size_t from = scanned;
+  for (;;) {
+    auto found = std::search(partial.begin() + from, partial.end(), delimiter.begin(), delimiter.end());
+    if (found == partial.end()) {
+      break;
+    }
+    size_t position = found - partial.begin();
+    size_t frameLength = position - consumed;
+    // the start of an oversized frame was already thrown away
+    if (!overflowed && frameLength <= spec.maxLength) {
+      emit(partial.data() + consumed, frameLength + (spec.includeDelimiter ? delimiter.size() : 0), frames, ends);
+    }
+    overflowed = false;
+    consumed = position + delimiter.size();
+    from = consumed;
+  }
+  partial.erase(partial.begin(), partial.begin() + consumed);
+
+  if (partial.size() > spec.maxLength) {
+    // keep what could be the start of a delimiter split across reads
+    partial.erase(partial.begin(), partial.end() - (delimiter.size() - 1));
+    overflowed = true;
+  }
+  // only the tail that could hold the start of a delimiter needs searching again
+  scanned = partial.size() >= delimiter.size() ? partial.size() - delimiter.size() + 1 : 0;
+}
+
+void Framing::pushByteLength(std::vector<uint8_t>* frames, std::vector<uint32_t>* ends) {
+  size_t consumed = 0;
+  while (partial.size() - consumed >= spec.length) {
+    emit(partial.data() + consumed, spec.length, frames, ends);
+    consumed += spec.length;
+  }
+  partial.erase(partial.begin(), partial.begin() + consumed);
+}
+
+void Framing::pushLengthPrefixed(std::vector<uint8_t>* frames, std::vector<uint32_t>* ends) {
+  size_t consumed = 0;
+  while (partial.size() - consumed >= spec.lengthBytes) {
+    const uint8_t* prefix = partial.data() + consumed;
+    size_t payload = 0;
+    for (unsigned i = 0; i < spec.lengthBytes; i++) {
+      payload = (payload << 8) | prefix[spec.littleEndian ? spec.lengthBytes - 1 - i : i];
+    }
+    if (payload > spec.maxLength) {
+      // not a length we'd accept, we're out of sync so slide forward until we find one
+      consumed++;
+      continue;
+    }
+    if (partial.size() - consumed < spec.lengthBytes + payload) {
+      break;
+    }
+    if (spec.includeLength) {
+      emit(prefix, spec.lengthBytes + payload, frames, ends);
+    } else {
+      emit(prefix + spec.lengthBytes, payload, frames, ends);
+    }
+    consumed += spec.lengthBytes + payload;
+  }
+  partial.erase(partial.begin(), partial.begin() + consumed);
+}
+
+void Framing::pushSlip(const uint8_t* data, size_t length, std::vector<uint8_t>* frames, std::vector<uint32_t>* ends) {
+  for (size_t i = 0; i < length; i++) {
+    uint8_t byte = data[i];
+    if (byte == SLIP_END) {
+      if (!overflowed) {
+        emit(partial.data(), partial.size(), frames, ends);
+      }
+      partial.clear();
+      escaped = false;
+      overflowed = false;
+      continue;
+    }
+    if (escaped) {
+      escaped = false;
+      if (byte == SLIP_ESC_END) {
+        byte = SLIP_END;
+      } else if (byte == SLIP_ESC_ESC) {
+        byte = SLIP_ESC;
+      }
+    } else if (byte == SLIP_ESC) {
+      escaped = true;
+      continue;
+    }
+    if (overflowed) {
+      continue;
+    }
+    partial.push_back(byte);
+    if (partial.size() > spec.maxLength) {
+      partial.clear();
+      overflowed = true;
+    }
+  }
+}
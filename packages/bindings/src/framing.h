@@ -0,0 +1,46 @@
+#ifndef PACKAGES_SERIALPORT_SRC_FRAMING_H_
+#define PACKAGES_SERIALPORT_SRC_FRAMING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum FramingType {
+  FRAMING_DELIMITER,
+  FRAMING_BYTE_LENGTH,
+  FRAMING_LENGTH_PREFIXED,
+  FRAMING_SLIP
+};
+
+struct FramingSpec {
+  FramingType type = FRAMING_DELIMITER;
+  std::vector<uint8_t> delimiter;
+  bool includeDelimiter = false;
+  size_t length = 0;
+  unsigned lengthBytes = 1;
+  bool littleEndian = false;
+  bool includeLength = false;
+  size_t maxLength = 65536;
+};
+
+// Splits a byte stream into frames, everything it completes from a chunk is appended to one output buffer
+class Framing {
+ public:
+  explicit Framing(const FramingSpec& spec);
+  // Each completed frame is appended to frames and its end offset to ends
+  void push(const uint8_t* data, size_t length, std::vector<uint8_t>* frames, std::vector<uint32_t>* ends);
+
+ private:
+  FramingSpec spec;
+  std::vector<uint8_t> partial;
+  size_t scanned = 0;
+  bool escaped = false;
+  bool overflowed = false;
+
+  void pushDelimiter(std::vector<uint8_t>* frames, std::vector<uint32_t>* ends);
+  void pushByteLength(std::vector<uint8_t>* frames, std::vector<uint32_t>* ends);
+  void pushLengthPrefixed(std::vector<uint8_t>* frames, std::vector<uint32_t>* ends);
+  void pushSlip(const uint8_t* data, size_t length, std::vector<uint8_t>* frames, std::vector<uint32_t>* ends);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_FRAMING_H_
@@ -0,0 +1,363 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include "./serialport.h"
+#include "./modem_watcher.h"
+
+#ifdef __linux__
+  #include <linux/serial.h>
+#endif
+
+#if defined(__linux__) && defined(TIOCMIWAIT)
+  #define MODEM_WATCHER_WAIT
+  // an otherwise unused signal, it only gets a thread out of TIOCMIWAIT
+  #define MODEM_WATCHER_WAKE_SIGNAL (SIGRTMIN + 3)
+#endif
+
+#ifdef MODEM_WATCHER_WAIT
+static uv_once_t wakeSignalOnce = UV_ONCE_INIT;
+
+static void onWakeSignal(int signal) {}
+
+static void installWakeSignal() {
+  struct sigaction action;
+  if (0 != sigaction(MODEM_WATCHER_WAKE_SIGNAL, nullptr, &action) ||
+      (action.sa_handler != SIG_DFL && action.sa_handler != SIG_IGN)) {
+    return;
+  }
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = onWakeSignal;
+  sigemptyset(&action.sa_mask);
+  // no SA_RESTART, the ioctl has to come back with EINTR
+  sigaction(MODEM_WATCHER_WAKE_SIGNAL, &action, nullptr);
+}
+#endif
+
+// ModemWatcher(fd, { mask, intervalUs, poll }, cb)
+ModemWatcher::ModemWatcher(const Napi::CallbackInfo& info) : Napi::ObjectWrap<ModemWatcher>(info), env(info.Env()) {
+  uv_mutex_init(&mutex);
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  fd = info[0].As<Napi::Number>().Int32Value();
+
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].As<Napi::Object>();
+  Napi::Object lines = options.Get("lines").IsObject() ? options.Get("lines").As<Napi::Object>() : Napi::Object::New(env);
+  if (lines.Get("cts").ToBoolean()) {
+    mask |= TIOCM_CTS;
+  }
+  if (lines.Get("dsr").ToBoolean()) {
+    mask |= TIOCM_DSR;
+  }
+  if (lines.Get("dcd").ToBoolean()) {
+    mask |= TIOCM_CD;
+  }
+  if (lines.Get("ri").ToBoolean()) {
+    mask |= TIOCM_RI;
+  }
+  if (0 == mask) {
+    Napi::TypeError::New(env, "lines must name at least one of cts, dsr, dcd and ri").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Value interval = options.Get("intervalUs");
+  if (interval.IsNumber() && interval.As<Napi::Number>().Uint32Value() > 0) {
+    intervalUs = interval.As<Napi::Number>().Uint32Value();
+  }
+  poll = options.Get("poll").ToBoolean();
+
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "cb must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+
+  if (0 != pipe(wake_fds)) {
+    throwErrno(env, errno, "create a pipe");
+    return;
+  }
+  fcntl(wake_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_fds[1], F_SETFD, FD_CLOEXEC);
+#ifdef MODEM_WATCHER_WAIT
+  uv_once(&wakeSignalOnce, installWakeSignal);
+#endif
+
+  this->callback.Reset(info[2].As<Napi::Function>(), 1);
+  this->async = new uv_async_t();
+  async->data = this;
+  uv_async_init(getLoop(env), async, ModemWatcher::onChange);
+
+  if (0 != uv_thread_create(&thread, ModemWatcher::run, this)) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), ModemWatcher::onClose);
+    async = nullptr;
+    for (int& wake_fd : wake_fds) {
+      ::close(wake_fd);
+      wake_fd = -1;
+    }
+    Napi::Error::New(env, "Error: cannot start the modem watcher thread").ThrowAsJavaScriptException();
+    return;
+  }
+  running = true;
+}
+
+ModemWatcher::~ModemWatcher() {
+  stop();
+  if (async) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), ModemWatcher::onClose);
+    async = nullptr;
+  }
+  uv_mutex_destroy(&mutex);
+}
+
+void ModemWatcher::onClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+Napi::Object ModemWatcher::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "ModemWatcher", {
+    InstanceMethod("stats", &ModemWatcher::stats),
+    InstanceMethod("close", &ModemWatcher::close),
+  });
+
+  exports.Set("ModemWatcher", func);
+  return exports;
+}
+
+void ModemWatcher::run(void* arg) {
+  static_cast<ModemWatcher*>(arg)->loop();
+}
+
+// Reads the lines and, where the driver keeps them, their transition counters. Returns an errno or 0.
+int ModemWatcher::read(int* lineBits, ModemCounts* lineCounts, bool* lineCounted) {
+  if (0 != ioctl(fd, TIOCMGET, lineBits)) {
+    return errno;
+  }
+  *lineCounted = false;
+#ifdef __linux__
+  struct serial_icounter_struct icount;
+  if (0 == ioctl(fd, TIOCGICOUNT, &icount)) {
+    lineCounts->cts = icount.cts;
+    lineCounts->dsr = icount.dsr;
+    lineCounts->dcd = icount.dcd;
+    lineCounts->ri = icount.rng;
+    *lineCounted = true;
+  }
+#endif
+  return 0;
+}
+
+void ModemWatcher::record(int lineBits, const ModemCounts& lineCounts, bool lineCounted) {
+  uv_mutex_lock(&mutex);
+  bits = lineBits;
+  counts = lineCounts;
+  counted = lineCounted;
+  changedAt = uv_hrtime();
+  changes++;
+  uv_mutex_unlock(&mutex);
+  uv_async_send(async);
+}
+
+static bool countsDiffer(const ModemCounts& a, const ModemCounts& b, int mask) {
+  return ((mask & TIOCM_CTS) && a.cts != b.cts) || ((mask & TIOCM_DSR) && a.dsr != b.dsr) ||
+    ((mask & TIOCM_CD) && a.dcd != b.dcd) || ((mask & TIOCM_RI) && a.ri != b.ri);
+}
+
+void ModemWatcher::loop() {
+  int lineBits = 0;
+  ModemCounts lineCounts;
+  bool lineCounted = false;
+  int err = read(&lineBits, &lineCounts, &lineCounted);
+  if (!err) {
+    uv_mutex_lock(&mutex);
+    bits = deliveredBits = lineBits;
+    counts = deliveredCounts = lineCounts;
+    counted = lineCounted;
+    uv_mutex_unlock(&mutex);
+  }
+
+  bool wait = false;
+#ifdef MODEM_WATCHER_WAIT
+  wait = !poll;
+#endif
+  int timeoutMs = static_cast<int>((intervalUs + 999) / 1000);
+  struct pollfd stopped = { wake_fds[0], POLLIN, 0 };
+
+  while (!err && !__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+#ifdef MODEM_WATCHER_WAIT
+    if (wait) {
+      __atomic_store_n(&waiting, true, __ATOMIC_RELAXED);
+      if (0 != ioctl(fd, TIOCMIWAIT, mask)) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno != EINVAL && errno != ENOTTY && errno != ENOSYS) {
+          err = errno;
+          break;
+        }
+        // the driver can't wait for changes, look every interval instead
+        wait = false;
+        __atomic_store_n(&waiting, false, __ATOMIC_RELAXED);
+        continue;
+      }
+    }
+#endif
+    if (!wait && ::poll(&stopped, 1, timeoutMs) > 0) {
+      break;
+    }
+
+    int newBits = 0;
+    ModemCounts newCounts;
+    bool newCounted = false;
+    if ((err = read(&newBits, &newCounts, &newCounted))) {
+      break;
+    }
+    // a wake up from TIOCMIWAIT is a change even if the driver keeps no counters and the line is back already
+    if (wait || ((newBits ^ lineBits) & mask) || (newCounted && countsDiffer(newCounts, lineCounts, mask))) {
+      record(newBits, newCounts, newCounted);
+      lineBits = newBits;
+      lineCounts = newCounts;
+    }
+  }
+
+  if (err) {
+    uv_mutex_lock(&mutex);
+    error = err;
+    uv_mutex_unlock(&mutex);
+  }
+  __atomic_store_n(&exited, true, __ATOMIC_RELEASE);
+  if (err) {
+    uv_async_send(async);
+  }
+}
+
+static Napi::Object linesObject(Napi::Env env, int bits) {
+  Napi::Object lines = Napi::Object::New(env);
+  lines.Set("cts", Napi::Boolean::New(env, bits & TIOCM_CTS));
+  lines.Set("dsr", Napi::Boolean::New(env, bits & TIOCM_DSR));
+  lines.Set("dcd", Napi::Boolean::New(env, bits & TIOCM_CD));
+  lines.Set("ri", Napi::Boolean::New(env, bits & TIOCM_RI));
+  return lines;
+}
+
+static Napi::Object countsObject(Napi::Env env, const ModemCounts& counts) {
+  Napi::Object object = Napi::Object::New(env);
+  object.Set("cts", Napi::Number::New(env, counts.cts));
+  object.Set("dsr", Napi::Number::New(env, counts.dsr));
+  object.Set("dcd", Napi::Number::New(env, counts.dcd));
+  object.Set("ri", Napi::Number::New(env, counts.ri));
+  return object;
+}
+
+// Without the driver's counters a line that changed counts once and a pulse not at all
+static ModemCounts transitionsSince(int bits, const ModemCounts& counts, bool counted, int lastBits,
+    const ModemCounts& lastCounts) {
+  ModemCounts transitions;
+  if (counted) {
+    transitions.cts = counts.cts - lastCounts.cts;
+    transitions.dsr = counts.dsr - lastCounts.dsr;
+    transitions.dcd = counts.dcd - lastCounts.dcd;
+    transitions.ri = counts.ri - lastCounts.ri;
+  } else {
+    int changed = bits ^ lastBits;
+    transitions.cts = (changed & TIOCM_CTS) ? 1 : 0;
+    transitions.dsr = (changed & TIOCM_DSR) ? 1 : 0;
+    transitions.dcd = (changed & TIOCM_CD) ? 1 : 0;
+    transitions.ri = (changed & TIOCM_RI) ? 1 : 0;
+  }
+  return transitions;
+}
+
+// cb(null, { lines, transitions, changes, timestamp }) for the changes since the last call, or cb(err) once the
+// thread stopped on an error
+void ModemWatcher::onChange(uv_async_t* handle) {
+  ModemWatcher* obj = static_cast<ModemWatcher*>(handle->data);
+  Napi::HandleScope scope(obj->env);
+
+  uv_mutex_lock(&obj->mutex);
+  int lineBits = obj->bits;
+  uint64_t changedAt = obj->changedAt;
+  uint64_t changes = obj->changes - obj->delivered;
+  ModemCounts transitions = transitionsSince(obj->bits, obj->counts, obj->counted, obj->deliveredBits,
+    obj->deliveredCounts);
+  obj->delivered = obj->changes;
+  obj->deliveredBits = obj->bits;
+  obj->deliveredCounts = obj->counts;
+  int err = obj->error;
+  uv_mutex_unlock(&obj->mutex);
+
+  if (changes > 0) {
+    Napi::Object event = Napi::Object::New(obj->env);
+    event.Set("lines", linesObject(obj->env, lineBits));
+    event.Set("transitions", countsObject(obj->env, transitions));
+    event.Set("changes", Napi::Number::New(obj->env, static_cast<double>(changes)));
+    event.Set("timestamp", Napi::Number::New(obj->env, static_cast<double>(changedAt) / 1e6));
+    obj->callback.Call({ obj->env.Null(), event });
+  }
+
+  // the callback may have closed the watcher
+  if (err && !obj->errorReported && obj->async) {
+    obj->errorReported = true;
+    obj->callback.Call({ errnoError(obj->env, err, "cannot watch the modem lines").Value() });
+  }
+}
+
+void ModemWatcher::stop() {
+  if (!running) {
+    return;
+  }
+  running = false;
+  __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+  char byte = 0;
+  ssize_t written;
+  do {
+    written = ::write(wake_fds[1], &byte, 1);
+  } while (written < 0 && errno == EINTR);
+#ifdef MODEM_WATCHER_WAIT
+  // TIOCMIWAIT only comes back for a change or a signal, keep at it in case the signal came just before the ioctl
+  while (!__atomic_load_n(&exited, __ATOMIC_ACQUIRE)) {
+    pthread_kill(thread, MODEM_WATCHER_WAKE_SIGNAL);
+    usleep(1000);
+  }
+#endif
+  uv_thread_join(&thread);
+  for (int& wake_fd : wake_fds) {
+    ::close(wake_fd);
+    wake_fd = -1;
+  }
+}
+
+Napi::Value ModemWatcher::stats(const Napi::CallbackInfo& info) {
+  Napi::Object stats = Napi::Object::New(env);
+  uv_mutex_lock(&mutex);
+  stats.Set("lines", linesObject(env, bits));
+  if (counted) {
+    stats.Set("counts", countsObject(env, counts));
+  }
+  stats.Set("changes", Napi::Number::New(env, static_cast<double>(changes)));
+  int err = error;
+  uv_mutex_unlock(&mutex);
+  stats.Set("waiting", Napi::Boolean::New(env, __atomic_load_n(&waiting, __ATOMIC_RELAXED)));
+  if (err) {
+    stats.Set("error", Napi::String::New(env, strerror(err)));
+  }
+  return stats;
+}
+
+// Stops watching, the port stays open
+void ModemWatcher::close(const Napi::CallbackInfo& info) {
+  stop();
+  if (async) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), ModemWatcher::onClose);
+    async = nullptr;
+  }
+}
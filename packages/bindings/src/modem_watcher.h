@@ -0,0 +1,70 @@
+#ifndef PACKAGES_SERIALPORT_SRC_MODEM_WATCHER_H_
+#define PACKAGES_SERIALPORT_SRC_MODEM_WATCHER_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+
+#define MODEM_WATCHER_DEFAULT_INTERVAL_US 10000
+
+// transitions of each input line as the driver counts them, see TIOCGICOUNT
+struct ModemCounts {
+  uint32_t cts = 0;
+  uint32_t dsr = 0;
+  uint32_t dcd = 0;
+  uint32_t ri = 0;
+};
+
+// Reports changes of the modem input lines from a thread of its own. Where the driver supports it the thread sleeps
+// in TIOCMIWAIT until a line in the mask changes, otherwise it checks TIOCMGET every interval. The driver's transition
+// counters go with every change, so a pulse shorter than the time to deliver it still shows up. Changes that come in
+// while the event loop is busy are delivered together.
+class ModemWatcher : public Napi::ObjectWrap<ModemWatcher> {
+ public:
+  ModemWatcher(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void run(void* arg);
+  static void onChange(uv_async_t* handle);
+  static void onClose(uv_handle_t* handle);
+  ~ModemWatcher();
+
+ private:
+  Napi::Env env;
+  Napi::FunctionReference callback;
+  int fd = -1;
+  int mask = 0;
+  unsigned intervalUs = MODEM_WATCHER_DEFAULT_INTERVAL_US;
+  bool poll = false;
+
+  int wake_fds[2] = { -1, -1 };
+  uv_thread_t thread;
+  bool running = false;
+  bool stopping = false;
+  bool exited = false;
+  uv_async_t* async = nullptr;
+
+  // the latest state, shared with the thread
+  uv_mutex_t mutex;
+  int bits = 0;
+  bool counted = false;
+  ModemCounts counts;
+  uint64_t changedAt = 0;
+  uint64_t changes = 0;
+  // what the last event reported, for the transitions since
+  uint64_t delivered = 0;
+  int deliveredBits = 0;
+  ModemCounts deliveredCounts;
+  bool waiting = false;
+  int error = 0;
+  bool errorReported = false;
+
+  void loop();
+  int read(int* lineBits, ModemCounts* lineCounts, bool* lineCounted);
+  void record(int lineBits, const ModemCounts& lineCounts, bool lineCounted);
+  void stop();
+
+  Napi::Value stats(const Napi::CallbackInfo& info);
+  void close(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_MODEM_WATCHER_H_
@@ -1,5 +1,6 @@
 #include <napi.h>
 #include <uv.h>
+#include "./serialport.h"
 #include "./poller.h"
 
 Poller::Poller(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Poller>(info), env(info.Env()) {
@@ -20,7 +21,7 @@ Poller::Poller(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Poller>(info),
   this->poll_handle = new uv_poll_t();
   memset(this->poll_handle, 0, sizeof(uv_poll_t));
   poll_handle->data = this;
-  int status = uv_poll_init(uv_default_loop(), poll_handle, fd);
+  int status = uv_poll_init(getLoop(env), poll_handle, fd);
   if (0 != status) {
     Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
     return;
@@ -0,0 +1,85 @@
+#include <uv.h>
+#include <unordered_map>
+#include "./port_state.h"
+
+struct PortState {
+  bool termiosValid = false;
+  struct termios termios;
+  int baudRate = PORT_STATE_UNKNOWN_BAUD_RATE;
+  bool modemValid = false;
+  int modemBits = 0;
+  bool brk = false;
+};
+
+static uv_once_t statesOnce = UV_ONCE_INIT;
+static uv_mutex_t statesLock;
+static std::unordered_map<int, PortState> states;
+
+static void initStates() {
+  uv_mutex_init(&statesLock);
+}
+
+bool getTermiosState(int fd, struct termios* termios, int* baudRate) {
+  uv_once(&statesOnce, initStates);
+  bool found = false;
+  uv_mutex_lock(&statesLock);
+  auto it = states.find(fd);
+  if (it != states.end() && it->second.termiosValid) {
+    *termios = it->second.termios;
+    *baudRate = it->second.baudRate;
+    found = true;
+  }
+  uv_mutex_unlock(&statesLock);
+  return found;
+}
+
+void setTermiosState(int fd, const struct termios& termios, int baudRate) {
+  uv_once(&statesOnce, initStates);
+  uv_mutex_lock(&statesLock);
+  PortState& state = states[fd];
+  state.termiosValid = true;
+  state.termios = termios;
+  state.baudRate = baudRate;
+  uv_mutex_unlock(&statesLock);
+}
+
+bool getModemState(int fd, int* bits, bool* brk) {
+  uv_once(&statesOnce, initStates);
+  bool found = false;
+  uv_mutex_lock(&statesLock);
+  auto it = states.find(fd);
+  if (it != states.end() && it->second.modemValid) {
+    *bits = it->second.modemBits;
+    *brk = it->second.brk;
+    found = true;
+  }
+  uv_mutex_unlock(&statesLock);
+  return found;
+}
+
+void setModemState(int fd, int bits, bool brk) {
+  uv_once(&statesOnce, initStates);
+  uv_mutex_lock(&statesLock);
+  PortState& state = states[fd];
+  state.modemValid = true;
+  state.modemBits = bits;
+  state.brk = brk;
+  uv_mutex_unlock(&statesLock);
+}
+
+void forgetModemState(int fd) {
+  uv_once(&statesOnce, initStates);
+  uv_mutex_lock(&statesLock);
+  auto it = states.find(fd);
+  if (it != states.end()) {
+    it->second.modemValid = false;
+  }
+  uv_mutex_unlock(&statesLock);
+}
+
+void forgetPortState(int fd) {
+  uv_once(&statesOnce, initStates);
+  uv_mutex_lock(&statesLock);
+  states.erase(fd);
+  uv_mutex_unlock(&statesLock);
+}
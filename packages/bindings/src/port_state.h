@@ -0,0 +1,25 @@
+#ifndef PACKAGES_SERIALPORT_SRC_PORT_STATE_H_
+#define PACKAGES_SERIALPORT_SRC_PORT_STATE_H_
+
+#include <termios.h>
+
+#define PORT_STATE_UNKNOWN_BAUD_RATE -1
+
+// What the binding last put on each open port, so update() and set() only issue the calls for what changed instead
+// of reading the state back first. Kept per fd from open to close and safe on any thread. Changes made behind the
+// binding's back (stty, another process) aren't seen, native code here that moves the modem lines itself calls
+// forgetModemState() so the next set() starts from the kernel again.
+
+// Copies the termios and baud rate last set on fd, false if they aren't known
+bool getTermiosState(int fd, struct termios* termios, int* baudRate);
+void setTermiosState(int fd, const struct termios& termios, int baudRate);
+
+// Copies the TIOCM_* output bits and break state last set on fd, false if they aren't known
+bool getModemState(int fd, int* bits, bool* brk);
+void setModemState(int fd, int bits, bool brk);
+void forgetModemState(int fd);
+
+// The fd was closed or is being set up from scratch
+void forgetPortState(int fd);
+
+#endif  // PACKAGES_SERIALPORT_SRC_PORT_STATE_H_
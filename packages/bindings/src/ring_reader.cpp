@@ -0,0 +1,254 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include "./serialport.h"
+#include "./ring_reader.h"
+#include "./tap.h"
+
+// Don't bother reading into the tail of the ring when there is less than this left before the wrap
+#define RING_MIN_READ 64
+#define RING_MAX_READ 65536
+#define RING_FULL_BACKOFF_MS 1
+
+static inline uint32_t ringAlign(uint32_t size) {
+  return (size + 7) & ~7u;
+}
+
+RingReader::RingReader(const Napi::CallbackInfo& info) : Napi::ObjectWrap<RingReader>(info), env(info.Env()) {
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  this->fd = info[0].As<Napi::Number>().Int32Value();
+
+  if (!info[1].IsTypedArray() || info[1].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+    Napi::TypeError::New(env, "shared must be a Uint8Array").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Uint8Array shared = info[1].As<Napi::Uint8Array>();
+  size_t size = shared.ByteLength();
+  uint32_t capacity = static_cast<uint32_t>(size - RING_HEADER_SIZE);
+  if (size <= RING_HEADER_SIZE || size - RING_HEADER_SIZE > (1u << 30) || (capacity & (capacity - 1)) != 0 ||
+      (reinterpret_cast<uintptr_t>(shared.Data()) & 7) != 0) {
+    Napi::RangeError::New(env, "shared must be an aligned header plus a power of two ring").ThrowAsJavaScriptException();
+    return;
+  }
+
+  if (!info[2].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[2].As<Napi::Object>();
+  this->dropWhenFull = options.Get("dropWhenFull").ToBoolean();
+
+  if (!info[3].IsFunction()) {
+    Napi::TypeError::New(env, "cb must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+
+  if (0 != pipe(wake_fds)) {
+    Napi::Error::New(env, uv_strerror(uv_translate_sys_error(errno))).ThrowAsJavaScriptException();
+    return;
+  }
+  fcntl(wake_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_fds[1], F_SETFD, FD_CLOEXEC);
+
+  // the typed array keeps the SharedArrayBuffer alive for as long as the thread may write into it
+  this->shared = Napi::Persistent(info[1].As<Napi::Object>());
+  this->header = reinterpret_cast<int32_t*>(shared.Data());
+  this->records = shared.Data() + RING_HEADER_SIZE;
+  this->capacity = capacity;
+  this->callback.Reset(info[3].As<Napi::Function>(), 1);
+
+  this->async = new uv_async_t();
+  async->data = this;
+  uv_async_init(getLoop(env), async, RingReader::onWake);
+
+  if (0 != uv_thread_create(&thread, RingReader::run, this)) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), RingReader::onClose);
+    async = nullptr;
+    Napi::Error::New(env, "Error: cannot start the ring reader thread").ThrowAsJavaScriptException();
+    return;
+  }
+  running = true;
+}
+
+RingReader::~RingReader() {
+  stop();
+  if (async) {
+    uv_close(reinterpret_cast<uv_handle_t*>(async), RingReader::onClose);
+    async = nullptr;
+  }
+  if (wake_fds[0] >= 0) {
+    ::close(wake_fds[0]);
+    ::close(wake_fds[1]);
+  }
+}
+
+void RingReader::onClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+Napi::Object RingReader::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "RingReader", {
+    InstanceMethod("close", &RingReader::close),
+  });
+
+  exports.Set("RingReader", func);
+  return exports;
+}
+
+void RingReader::run(void* arg) {
+  static_cast<RingReader*>(arg)->loop();
+}
+
+// Blocks until the port is readable, returns false when stopped
+bool RingReader::waitReadable() {
+  struct pollfd fds[2];
+  fds[0].fd = wake_fds[0];
+  fds[0].events = POLLIN;
+  fds[1].fd = fd;
+  fds[1].events = POLLIN;
+  for (;;) {
+    fds[0].revents = fds[1].revents = 0;
+    int ready = poll(fds, 2, -1);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready < 0) {
+      finish(RING_STATE_ERROR, errno);
+      return false;
+    }
+    if (fds[0].revents) {
+      return false;
+    }
+    if (fds[1].revents & POLLNVAL) {
+      finish(RING_STATE_ERROR, EBADF);
+      return false;
+    }
+    // a hang up is confirmed by the read coming back empty
+    hungUp = (fds[1].revents & (POLLHUP | POLLERR)) != 0;
+    return true;
+  }
+}
+
+// Publishes the final state, consumers see it on their next wakeup
+void RingReader::finish(int state, int err) {
+  __atomic_store_n(&header[RING_ERRNO], err, __ATOMIC_RELAXED);
+  __atomic_store_n(&header[RING_STATE], state, __ATOMIC_RELEASE);
+  __atomic_fetch_add(&header[RING_SEQ], 1, __ATOMIC_SEQ_CST);
+  uv_async_send(async);
+}
+
+// The only writer of RING_WRITE. The consumer only moves RING_READ, so the free space seen here can only grow
+// while the payload is read straight into the ring without an intermediate copy.
+void RingReader::loop() {
+  uint8_t scratch[RING_MIN_READ * 16];
+  const uint32_t mask = capacity - 1;
+
+  while (waitReadable()) {
+    uint32_t write = static_cast<uint32_t>(__atomic_load_n(&header[RING_WRITE], __ATOMIC_RELAXED));
+    uint32_t read = static_cast<uint32_t>(__atomic_load_n(&header[RING_READ], __ATOMIC_ACQUIRE));
+    uint32_t available = capacity - (write - read);
+    uint32_t offset = write & mask;
+    uint32_t contiguous = capacity - offset;
+
+    if (contiguous < RING_RECORD_HEADER + RING_MIN_READ && available >= contiguous) {
+      *reinterpret_cast<uint32_t*>(records + offset) = RING_RECORD_WRAP;
+      __atomic_store_n(&header[RING_WRITE], static_cast<int32_t>(write + contiguous), __ATOMIC_RELEASE);
+      continue;
+    }
+
+    uint32_t space = available < contiguous ? available : contiguous;
+    if (space < RING_RECORD_HEADER + RING_MIN_READ) {
+      if (!dropWhenFull) {
+        // let the consumer catch up, the bytes wait in the kernel queue meanwhile
+        struct pollfd stopped = { wake_fds[0], POLLIN, 0 };
+        if (poll(&stopped, 1, RING_FULL_BACKOFF_MS) > 0) {
+          break;
+        }
+        continue;
+      }
+      ssize_t dropped = ::read(fd, scratch, sizeof(scratch));
+      if (dropped > 0) {
+        // dropped from the ring but still received, a tap keeps them
+        tapData(fd, TAP_RX, scratch, dropped);
+        __atomic_fetch_add(&header[RING_DROPPED], static_cast<int32_t>(dropped), __ATOMIC_RELAXED);
+        continue;
+      }
+      if (dropped < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        continue;
+      }
+      if (dropped == 0 && !hungUp) {
+        continue;
+      }
+      finish(RING_STATE_ERROR, dropped == 0 ? EIO : errno);
+      return;
+    }
+
+    uint32_t length = space - RING_RECORD_HEADER;
+    if (length > RING_MAX_READ) {
+      length = RING_MAX_READ;
+    }
+    uint8_t* record = records + offset;
+    ssize_t bytesRead = ::read(fd, record + RING_RECORD_HEADER, length);
+    if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      continue;
+    }
+    if (bytesRead == 0 && !hungUp) {
+      continue;
+    }
+    if (bytesRead <= 0) {
+      finish(RING_STATE_ERROR, bytesRead == 0 ? EIO : errno);
+      return;
+    }
+
+    tapData(fd, TAP_RX, record + RING_RECORD_HEADER, bytesRead);
+    double timestamp = static_cast<double>(uv_hrtime()) / 1e6;
+    reinterpret_cast<uint32_t*>(record)[0] = static_cast<uint32_t>(bytesRead);
+    reinterpret_cast<uint32_t*>(record)[1] = 0;
+    memcpy(record + 8, &timestamp, sizeof(timestamp));
+    write += ringAlign(RING_RECORD_HEADER + static_cast<uint32_t>(bytesRead));
+    __atomic_store_n(&header[RING_WRITE], static_cast<int32_t>(write), __ATOMIC_RELEASE);
+    __atomic_fetch_add(&header[RING_SEQ], 1, __ATOMIC_SEQ_CST);
+    // wakeups coalesce, one Atomics.notify() covers every record published since the last one
+    uv_async_send(async);
+  }
+}
+
+void RingReader::stop() {
+  if (!running) {
+    return;
+  }
+  running = false;
+  char byte = 0;
+  ssize_t written;
+  do {
+    written = ::write(wake_fds[1], &byte, 1);
+  } while (written < 0 && errno == EINTR);
+  uv_thread_join(&thread);
+}
+
+void RingReader::onWake(uv_async_t* handle) {
+  RingReader* obj = static_cast<RingReader*>(handle->data);
+  Napi::HandleScope scope(obj->env);
+  obj->callback.Call({});
+}
+
+// Stops the thread, the port itself stays open
+void RingReader::close(const Napi::CallbackInfo& info) {
+  if (!running) {
+    return;
+  }
+  stop();
+  if (__atomic_load_n(&header[RING_STATE], __ATOMIC_ACQUIRE) == RING_STATE_RUNNING) {
+    __atomic_store_n(&header[RING_STATE], RING_STATE_CLOSED, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&header[RING_SEQ], 1, __ATOMIC_SEQ_CST);
+  }
+  uv_close(reinterpret_cast<uv_handle_t*>(async), RingReader::onClose);
+  async = nullptr;
+}
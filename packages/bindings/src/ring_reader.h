@@ -0,0 +1,60 @@
+#ifndef PACKAGES_SERIALPORT_SRC_RING_READER_H_
+#define PACKAGES_SERIALPORT_SRC_RING_READER_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+
+// Layout of the shared ring, lib/ring-reader.js mirrors these values
+// The header is an Int32Array of cursors and counters followed by the record area
+#define RING_HEADER_SIZE 64
+#define RING_WRITE 0    // bytes published by the reader thread (wraps at 2^32)
+#define RING_READ 1     // bytes released by the consumer (wraps at 2^32)
+#define RING_SEQ 2      // bumped on every publish, consumers Atomics.wait() on it
+#define RING_DROPPED 3  // bytes dropped while the ring was full
+#define RING_STATE 4    // RING_STATE_*
+#define RING_ERRNO 5    // errno when RING_STATE is RING_STATE_ERROR
+
+#define RING_STATE_RUNNING 0
+#define RING_STATE_CLOSED 1
+#define RING_STATE_ERROR 2
+
+// Every record is an 8 byte aligned [uint32 length][uint32 flags][float64 monotonic ms] header and the payload.
+// A length of RING_RECORD_WRAP means skip to the start of the ring.
+#define RING_RECORD_HEADER 16
+#define RING_RECORD_WRAP 0xFFFFFFFF
+
+class RingReader : public Napi::ObjectWrap<RingReader> {
+ public:
+  RingReader(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void run(void* arg);
+  static void onWake(uv_async_t* handle);
+  static void onClose(uv_handle_t* handle);
+  ~RingReader();
+
+ private:
+  int fd;
+  Napi::Env env;
+  Napi::ObjectReference shared;
+  Napi::FunctionReference callback;
+  int32_t* header = nullptr;
+  uint8_t* records = nullptr;
+  uint32_t capacity = 0;
+  bool dropWhenFull = false;
+
+  int wake_fds[2] = { -1, -1 };
+  uv_thread_t thread;
+  bool running = false;
+  bool hungUp = false;
+  uv_async_t* async = nullptr;
+
+  void loop();
+  bool waitReadable();
+  void finish(int state, int err);
+  void stop();
+
+  void close(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_RING_READER_H_
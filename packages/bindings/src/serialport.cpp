@@ -9,7 +9,62 @@
   #define strncasecmp strnicmp
   #include "./serialport_win.h"
 #else
+  #include <errno.h>
+  #include <unistd.h>
   #include "./poller.h"
+  #include "./ring_reader.h"
+  #include "./framer.h"
+  #include "./capture.h"
+  #include "./virtual_port.h"
+  #include "./bridge.h"
+  #include "./tap.h"
+  #include "./file_writer.h"
+  #include "./flow_guard.h"
+  #include "./modem_watcher.h"
+#endif
+
+#ifdef __linux__
+  #include "./uring.h"
+  #include "./tty_index.h"
+#endif
+
+uv_loop_t* getLoop(const Napi::Env& env) {
+  uv_loop_t* loop = nullptr;
+  napi_get_uv_event_loop(env, &loop);
+  return loop;
+}
+
+Napi::Error errnoError(const Napi::Env& env, int err, const char* context) {
+  char errorString[ERROR_STRING_SIZE];
+  snprintf(errorString, sizeof(errorString), "Error: %s, %s", strerror(err), context);
+  Napi::Error error = Napi::Error::New(env, errorString);
+  int uvErr = uv_translate_sys_error(err);
+  error.Value().Set("code", Napi::String::New(env, uv_err_name(uvErr)));
+  error.Value().Set("errno", Napi::Number::New(env, uvErr));
+  return error;
+}
+
+void throwErrno(const Napi::Env& env, int err, const char* action) {
+  char context[ERROR_STRING_SIZE];
+  snprintf(context, sizeof(context), "cannot %s", action);
+  errnoError(env, err, context).ThrowAsJavaScriptException();
+}
+
+#ifndef WIN32
+int writeAll(int fd, const uint8_t* data, size_t length) {
+  while (length > 0) {
+    ssize_t written = ::write(fd, data, length);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written < 0) {
+      return errno;
+    }
+    data += written;
+    length -= written;
+  }
+  return 0;
+}
 #endif
 
 Napi::Value getValueFromObject(Napi::Object options, std::string key) {
@@ -33,6 +88,30 @@ double getDoubleFromObject(Napi::Object options, std::string key) {
   return getValueFromObject(options, key).As<Napi::Number>().DoubleValue();
 }
 
+// The settings open() takes, shared with openMany()
+static OpenBaton* newOpenBaton(Napi::Env env, const std::string& path, Napi::Object options) {
+  OpenBaton* baton = new OpenBaton {
+    .env = env,
+    .baudRate = getIntFromObject(options, "baudRate"),
+    .dataBits = getIntFromObject(options, "dataBits"),
+    .parity = ToParityEnum(env, getStringFromObj(options, "parity")),
+    .stopBits = ToStopBitEnum(getDoubleFromObject(options, "stopBits")),
+    .rtscts = getBoolFromObject(options, "rtscts"),
+    .xon = getBoolFromObject(options, "xon"),
+    .xoff = getBoolFromObject(options, "xoff"),
+    .xany = getBoolFromObject(options, "xany"),
+    .hupcl = getBoolFromObject(options, "hupcl"),
+    .lock = getBoolFromObject(options, "lock"),
+  };
+  snprintf(baton->path, sizeof(baton->path), "%s", path.c_str());
+
+  #ifndef WIN32
+    baton->vmin = getIntFromObject(options, "vmin");
+    baton->vtime = getIntFromObject(options, "vtime");
+  #endif
+  return baton;
+}
+
 Napi::Value Open(const Napi::CallbackInfo& info) {
   auto env = info.Env();
 
@@ -56,31 +135,13 @@ Napi::Value Open(const Napi::CallbackInfo& info) {
     return env.Null();
   }
 
-  OpenBaton* baton = new OpenBaton {
-    .env = env,
-    .baudRate = getIntFromObject(options, "baudRate"),
-    .dataBits = getIntFromObject(options, "dataBits"),
-    .parity = ToParityEnum(env, getStringFromObj(options, "parity")),
-    .stopBits = ToStopBitEnum(getDoubleFromObject(options, "stopBits")),
-    .rtscts = getBoolFromObject(options, "rtscts"),
-    .xon = getBoolFromObject(options, "xon"),
-    .xoff = getBoolFromObject(options, "xoff"),
-    .xany = getBoolFromObject(options, "xany"),
-    .hupcl = getBoolFromObject(options, "hupcl"),
-    .lock = getBoolFromObject(options, "lock"),
-  };
-  snprintf(baton->path, sizeof(baton->path), "%s", path.c_str());
+  OpenBaton* baton = newOpenBaton(env, path, options);
   baton->callback.Reset(info[2].As<Napi::Function>());
 
-  #ifndef WIN32
-    baton->vmin = getIntFromObject(options, "vmin");
-    baton->vtime = getIntFromObject(options, "vtime");
-  #endif
-
   uv_work_t* req = new uv_work_t();
   req->data = baton;
 
-  uv_queue_work(uv_default_loop(), req, EIO_Open, (uv_after_work_cb)EIO_AfterOpen);
+  uv_queue_work(getLoop(env), req, EIO_Open, (uv_after_work_cb)EIO_AfterOpen);
   return env.Undefined();
 }
 
@@ -131,12 +192,16 @@ Napi::Value Update(const Napi::CallbackInfo& info) {
   ConnectionOptionsBaton* baton = new ConnectionOptionsBaton(env);
   baton->baudRate = getIntFromObject(options, "baudRate");
   baton->fd = fd;
+  Napi::Value flush = options.Get("flush");
+  if (flush.IsBoolean()) {
+    baton->flush = flush.As<Napi::Boolean>().Value();
+  }
   baton->callback.Reset(info[2].As<Napi::Function>());
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
 
-  uv_queue_work(uv_default_loop(), req, EIO_Update, (uv_after_work_cb)EIO_AfterUpdate);
+  uv_queue_work(getLoop(env), req, EIO_Update, (uv_after_work_cb)EIO_AfterUpdate);
   return env.Undefined();
 }
 
@@ -177,7 +242,7 @@ Napi::Value Close(const Napi::CallbackInfo& info) {
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
-  uv_queue_work(uv_default_loop(), req, EIO_Close, (uv_after_work_cb)EIO_AfterClose);
+  uv_queue_work(getLoop(env), req, EIO_Close, (uv_after_work_cb)EIO_AfterClose);
   return env.Undefined();
 }
 
@@ -219,7 +284,7 @@ Napi::Value Flush(const Napi::CallbackInfo& info) {
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
-  uv_queue_work(uv_default_loop(), req, EIO_Flush, (uv_after_work_cb)EIO_AfterFlush);
+  uv_queue_work(getLoop(env), req, EIO_Flush, (uv_after_work_cb)EIO_AfterFlush);
   return env.Undefined();
 }
 
@@ -273,7 +338,7 @@ Napi::Value Set(const Napi::CallbackInfo& info) {
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
-  uv_queue_work(uv_default_loop(), req, EIO_Set, (uv_after_work_cb)EIO_AfterSet);
+  uv_queue_work(getLoop(env), req, EIO_Set, (uv_after_work_cb)EIO_AfterSet);
   return env.Undefined();
 }
 
@@ -317,7 +382,7 @@ Napi::Value Get(const Napi::CallbackInfo& info) {
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
-  uv_queue_work(uv_default_loop(), req, EIO_Get, (uv_after_work_cb)EIO_AfterGet);
+  uv_queue_work(getLoop(env), req, EIO_Get, (uv_after_work_cb)EIO_AfterGet);
   return env.Undefined();
 }
 
@@ -368,7 +433,7 @@ Napi::Value GetBaudRate(const Napi::CallbackInfo& info) {
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
-  uv_queue_work(uv_default_loop(), req, EIO_GetBaudRate, (uv_after_work_cb)EIO_AfterGetBaudRate);
+  uv_queue_work(getLoop(env), req, EIO_GetBaudRate, (uv_after_work_cb)EIO_AfterGetBaudRate);
   return env.Undefined();
 }
 
@@ -392,6 +457,57 @@ void EIO_AfterGetBaudRate(uv_work_t* req) {
   delete req;
 }
 
+Napi::Value GetQueueSizes(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int fd = info[0].As<Napi::Number>().Int32Value();
+
+  // callback
+  if (!info[1].IsFunction()) {
+    Napi::TypeError::New(env, "Second argument must be a function").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  GetQueueSizesBaton* baton = new GetQueueSizesBaton {
+    .env = env,
+    .fd = fd,
+    .input = 0,
+    .output = 0
+  };
+  baton->callback.Reset(info[1].As<Napi::Function>());
+
+  uv_work_t* req = new uv_work_t();
+  req->data = baton;
+  uv_queue_work(getLoop(env), req, EIO_GetQueueSizes, (uv_after_work_cb)EIO_AfterGetQueueSizes);
+  return env.Undefined();
+}
+
+void EIO_AfterGetQueueSizes(uv_work_t* req) {
+  GetQueueSizesBaton* data = static_cast<GetQueueSizesBaton*>(req->data);
+  auto env = data->env;
+
+  if (data->errorString[0]) {
+    data->callback.Call({
+      Napi::Error::New(env, data->errorString).Value(),
+      env.Undefined()
+    });
+  } else {
+    Napi::Object results = Napi::Object::New(env);
+    (results).Set(Napi::String::New(env, "input"), Napi::Number::New(env, data->input));
+    (results).Set(Napi::String::New(env, "output"), Napi::Number::New(env, data->output));
+
+    data->callback.Call({ env.Null(), results });
+  }
+
+  delete data;
+  delete req;
+}
+
 Napi::Value Drain(const Napi::CallbackInfo& info) {
   auto env = info.Env();
 
@@ -416,7 +532,7 @@ Napi::Value Drain(const Napi::CallbackInfo& info) {
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
-  uv_queue_work(uv_default_loop(), req, EIO_Drain, (uv_after_work_cb)EIO_AfterDrain);
+  uv_queue_work(getLoop(env), req, EIO_Drain, (uv_after_work_cb)EIO_AfterDrain);
   return env.Undefined();
 }
 
@@ -434,6 +550,288 @@ void EIO_AfterDrain(uv_work_t* req) {
   delete req;
 }
 
+#ifndef WIN32
+Napi::Value Transact(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int fd = info[0].As<Napi::Number>().Int32Value();
+
+  // request
+  if (!info[1].IsBuffer()) {
+    Napi::TypeError::New(env, "Second argument must be a buffer").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Buffer<uint8_t> request = info[1].As<Napi::Buffer<uint8_t>>();
+
+  // options
+  if (!info[2].IsObject()) {
+    Napi::TypeError::New(env, "Third argument must be an object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Object options = info[2].As<Napi::Object>();
+
+  // callback
+  if (!info[3].IsFunction()) {
+    Napi::TypeError::New(env, "Fourth argument must be a function").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  TransactBaton* baton = new TransactBaton {
+    .fd = fd,
+    .env = env,
+  };
+  baton->request.assign(request.Data(), request.Data() + request.Length());
+  std::string until = getStringFromObj(options, "until");
+  if (until == "delimiter") {
+    Napi::Buffer<uint8_t> delimiter = getValueFromObject(options, "delimiter").As<Napi::Buffer<uint8_t>>();
+    baton->until = TRANSACT_UNTIL_DELIMITER;
+    baton->delimiter.assign(delimiter.Data(), delimiter.Data() + delimiter.Length());
+  } else if (until == "lengthField") {
+    baton->until = TRANSACT_UNTIL_LENGTH_FIELD;
+    baton->fieldOffset = getIntFromObject(options, "fieldOffset");
+    baton->fieldSize = getIntFromObject(options, "fieldSize");
+    baton->fieldLittleEndian = getBoolFromObject(options, "fieldLittleEndian");
+    baton->fieldAdjust = getIntFromObject(options, "fieldAdjust");
+  } else {
+    baton->until = TRANSACT_UNTIL_LENGTH;
+    baton->length = getIntFromObject(options, "length");
+  }
+  baton->maxLength = getIntFromObject(options, "maxLength");
+  baton->timeoutMs = getIntFromObject(options, "timeoutMs");
+  baton->discardInput = getBoolFromObject(options, "discardInput");
+  int err = addTransaction(baton);
+  if (err) {
+    delete baton;
+    throwErrno(env, err, "create a pipe");
+    return env.Null();
+  }
+  baton->callback.Reset(info[3].As<Napi::Function>());
+
+  uv_work_t* req = new uv_work_t();
+  req->data = baton;
+  uv_queue_work(getLoop(env), req, EIO_Transact, (uv_after_work_cb)EIO_AfterTransact);
+  return env.Undefined();
+}
+
+// cancelTransact(fd), wakes up the transactions on fd so the port can be closed, returns how many there were
+Napi::Value CancelTransact(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  return Napi::Number::New(env, cancelTransactions(info[0].As<Napi::Number>().Int32Value()));
+}
+
+void EIO_AfterTransact(uv_work_t* req) {
+  TransactBaton* data = static_cast<TransactBaton*>(req->data);
+  auto env = data->env;
+
+  size_t responseLength = data->responseLength;
+  if (data->errorString[0]) {
+    // hand over whatever did arrive, it helps telling a slow device from a dead one
+    responseLength = data->received.size();
+  }
+  Napi::Buffer<uint8_t> response = Napi::Buffer<uint8_t>::Copy(env, data->received.data(), responseLength);
+  Napi::Buffer<uint8_t> rest = Napi::Buffer<uint8_t>::Copy(env,
+    data->received.data() + responseLength, data->received.size() - responseLength);
+
+  if (data->errorString[0]) {
+    Napi::Object err = Napi::Error::New(env, data->errorString).Value();
+    if (data->timedOut) {
+      err.Set("code", Napi::String::New(env, "ETIMEDOUT"));
+    }
+    if (data->canceled) {
+      err.Set("canceled", Napi::Boolean::New(env, true));
+    }
+    err.Set("response", response);
+    data->callback.Call({ err, env.Undefined(), env.Undefined() });
+  } else {
+    data->callback.Call({ env.Null(), response, rest });
+  }
+
+  delete data;
+  delete req;
+}
+
+Napi::Value Reconfigure(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  // file descriptor
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "First argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  int fd = info[0].As<Napi::Number>().Int32Value();
+
+  // options
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "Second argument must be an object").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Object options = info[1].As<Napi::Object>();
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  ReconfigureBaton* baton = new ReconfigureBaton {
+    .fd = fd,
+    .env = env,
+  };
+  baton->baudRate = getIntFromObject(options, "baudRate");
+  baton->settings.dataBits = getIntFromObject(options, "dataBits");
+  baton->settings.parity = ToParityEnum(env, getStringFromObj(options, "parity"));
+  baton->settings.stopBits = ToStopBitEnum(getDoubleFromObject(options, "stopBits"));
+  baton->settings.rtscts = getBoolFromObject(options, "rtscts");
+  baton->settings.xon = getBoolFromObject(options, "xon");
+  baton->settings.xoff = getBoolFromObject(options, "xoff");
+  baton->settings.xany = getBoolFromObject(options, "xany");
+  baton->settings.hupcl = getBoolFromObject(options, "hupcl");
+  baton->settings.vmin = getIntFromObject(options, "vmin");
+  baton->settings.vtime = getIntFromObject(options, "vtime");
+  Napi::Value flush = options.Get("flush");
+  if (flush.IsBoolean()) {
+    baton->flush = flush.As<Napi::Boolean>().Value();
+  }
+  Napi::Value modem = options.Get("modem");
+  if (modem.IsObject()) {
+    baton->setModem = true;
+    baton->rts = getBoolFromObject(modem.As<Napi::Object>(), "rts");
+    baton->dtr = getBoolFromObject(modem.As<Napi::Object>(), "dtr");
+    baton->brk = getBoolFromObject(modem.As<Napi::Object>(), "brk");
+  }
+  baton->callback.Reset(info[2].As<Napi::Function>());
+
+  uv_work_t* req = new uv_work_t();
+  req->data = baton;
+  uv_queue_work(getLoop(env), req, EIO_Reconfigure, (uv_after_work_cb)EIO_AfterReconfigure);
+  return env.Undefined();
+}
+
+void EIO_AfterReconfigure(uv_work_t* req) {
+  ReconfigureBaton* data = static_cast<ReconfigureBaton*>(req->data);
+  auto env = data->env;
+
+  if (data->errorString[0]) {
+    Napi::Object err = Napi::Error::New(env, data->errorString).Value();
+    err.Set("rolledBack", Napi::Boolean::New(env, data->rolledBack));
+    data->callback.Call({ err });
+  } else {
+    data->callback.Call({ env.Null() });
+  }
+
+  delete data;
+  delete req;
+}
+
+// openMany([{ path, options }], concurrency, callback)
+Napi::Value OpenMany(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  // ports
+  if (!info[0].IsArray()) {
+    Napi::TypeError::New(env, "First argument must be an array").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Array ports = info[0].As<Napi::Array>();
+
+  // concurrency
+  if (!info[1].IsNumber()) {
+    Napi::TypeError::New(env, "Second argument must be an int").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  uint32_t concurrency = info[1].As<Napi::Number>().Uint32Value();
+  if (concurrency < 1 || concurrency > OPEN_MANY_MAX_CONCURRENCY) {
+    concurrency = OPEN_MANY_DEFAULT_CONCURRENCY;
+  }
+
+  // callback
+  if (!info[2].IsFunction()) {
+    Napi::TypeError::New(env, "Third argument must be a function").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  OpenManyBaton* batch = new OpenManyBaton { .env = env };
+  for (uint32_t i = 0; i < ports.Length(); i++) {
+    Napi::Value port = ports.Get(i);
+    if (!port.IsObject() || !port.As<Napi::Object>().Get("path").IsString() ||
+        !port.As<Napi::Object>().Get("options").IsObject()) {
+      for (OpenBaton* data : batch->ports) {
+        delete data;
+      }
+      delete batch;
+      Napi::TypeError::New(env, "Every port must have a path and options").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    Napi::Object request = port.As<Napi::Object>();
+    std::string path = request.Get("path").As<Napi::String>();
+    batch->ports.push_back(newOpenBaton(env, path, request.Get("options").As<Napi::Object>()));
+  }
+  batch->callback.Reset(info[2].As<Napi::Function>());
+  uv_mutex_init(&batch->templatesLock);
+  batch->async = new uv_async_t();
+  batch->async->data = batch;
+  uv_async_init(getLoop(env), batch->async, EIO_AfterOpenMany);
+
+  if (batch->ports.empty()) {
+    uv_async_send(batch->async);
+    return env.Undefined();
+  }
+  size_t threads = std::min(static_cast<size_t>(concurrency), batch->ports.size());
+  batch->threads.resize(threads);
+  for (size_t i = 0; i < threads; i++) {
+    if (0 != uv_thread_create(&batch->threads[i], EIO_OpenMany, batch)) {
+      // the threads already running open the rest
+      batch->threads.resize(i);
+      break;
+    }
+  }
+  if (batch->threads.empty()) {
+    EIO_OpenMany(batch);
+  }
+  return env.Undefined();
+}
+
+static void onOpenManyClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+void EIO_AfterOpenMany(uv_async_t* handle) {
+  OpenManyBaton* batch = static_cast<OpenManyBaton*>(handle->data);
+  auto env = batch->env;
+  Napi::HandleScope scope(env);
+
+  for (uv_thread_t& thread : batch->threads) {
+    uv_thread_join(&thread);
+  }
+  uv_close(reinterpret_cast<uv_handle_t*>(batch->async), onOpenManyClose);
+  uv_mutex_destroy(&batch->templatesLock);
+
+  Napi::Array results = Napi::Array::New(env, batch->ports.size());
+  for (size_t i = 0; i < batch->ports.size(); i++) {
+    OpenBaton* data = batch->ports[i];
+    Napi::Object result = Napi::Object::New(env);
+    if (data->errorString[0]) {
+      result.Set("error", Napi::Error::New(env, data->errorString).Value());
+    } else {
+      result.Set("fd", Napi::Number::New(env, data->result));
+    }
+    results.Set(i, result);
+    delete data;
+  }
+  batch->callback.Call({ env.Null(), results });
+  delete batch;
+}
+#endif
+
 SerialPortParity inline(ToParityEnum(const Napi::Env& env, const Napi::String& v8str)) {
   auto str = std::string(v8str);
   size_t count = str.size();
@@ -466,11 +864,18 @@ Napi::Object init(Napi::Env env, Napi::Object exports) {
   exports.Set(Napi::String::New(env, "set"), Napi::Function::New(env, Set));
   exports.Set(Napi::String::New(env, "get"), Napi::Function::New(env, Get));
   exports.Set(Napi::String::New(env, "getBaudRate"), Napi::Function::New(env, GetBaudRate));
+  exports.Set(Napi::String::New(env, "getQueueSizes"), Napi::Function::New(env, GetQueueSizes));
   exports.Set(Napi::String::New(env, "open"), Napi::Function::New(env, Open));
   exports.Set(Napi::String::New(env, "update"), Napi::Function::New(env, Update));
   exports.Set(Napi::String::New(env, "close"), Napi::Function::New(env, Close));
   exports.Set(Napi::String::New(env, "flush"), Napi::Function::New(env, Flush));
   exports.Set(Napi::String::New(env, "drain"), Napi::Function::New(env, Drain));
+  #ifndef WIN32
+  exports.Set(Napi::String::New(env, "transact"), Napi::Function::New(env, Transact));
+  exports.Set(Napi::String::New(env, "cancelTransact"), Napi::Function::New(env, CancelTransact));
+  exports.Set(Napi::String::New(env, "reconfigure"), Napi::Function::New(env, Reconfigure));
+  exports.Set(Napi::String::New(env, "openMany"), Napi::Function::New(env, OpenMany));
+  #endif
 
   #ifdef __APPLE__
   exports.Set(Napi::String::New(env, "list"), Napi::Function::New(env, List));
@@ -482,6 +887,20 @@ Napi::Object init(Napi::Env env, Napi::Object exports) {
   exports.Set(Napi::String::New(env, "list"), Napi::Function::New(env, List));
   #else
   Poller::Init(env, exports);
+  RingReader::Init(env, exports);
+  Framer::Init(env, exports);
+  CaptureWriter::Init(env, exports);
+  VirtualPort::Init(env, exports);
+  Bridge::Init(env, exports);
+  Tap::Init(env, exports);
+  FileWriter::Init(env, exports);
+  FlowGuard::Init(env, exports);
+  ModemWatcher::Init(env, exports);
+  #endif
+
+  #ifdef __linux__
+  Uring::Init(env, exports);
+  TtyIndex::Init(env, exports);
   #endif
   return exports;
 }
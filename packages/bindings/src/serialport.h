@@ -6,9 +6,27 @@
 #include <napi.h>
 #include <uv.h>
 #include <string>
+#include <vector>
+#ifndef WIN32
+#include <termios.h>
+#endif
 
 #define ERROR_STRING_SIZE 1024
 
+// An Error for a failed system call, "Error: <strerror>, <context>" with `code` and `errno` from libuv, the same way
+// fs reports them
+Napi::Error errnoError(const Napi::Env& env, int err, const char* context);
+// Throws errnoError() for "cannot <action>"
+void throwErrno(const Napi::Env& env, int err, const char* action);
+
+#ifndef WIN32
+// Writes all of it, going again after EINTR and short writes. Returns 0 or the errno.
+int writeAll(int fd, const uint8_t* data, size_t length);
+#endif
+
+// The event loop of the environment (main thread or worker) the call was made from
+uv_loop_t* getLoop(const Napi::Env& env);
+
 Napi::Value Open(const Napi::CallbackInfo& info);
 void EIO_Open(uv_work_t* req);
 void EIO_AfterOpen(uv_work_t* req);
@@ -37,10 +55,34 @@ Napi::Value GetBaudRate(const Napi::CallbackInfo& info);
 void EIO_GetBaudRate(uv_work_t* req);
 void EIO_AfterGetBaudRate(uv_work_t* req);
 
+Napi::Value GetQueueSizes(const Napi::CallbackInfo& info);
+void EIO_GetQueueSizes(uv_work_t* req);
+void EIO_AfterGetQueueSizes(uv_work_t* req);
+
 Napi::Value Drain(const Napi::CallbackInfo& info);
 void EIO_Drain(uv_work_t* req);
 void EIO_AfterDrain(uv_work_t* req);
 
+#ifndef WIN32
+struct TransactBaton;
+Napi::Value Transact(const Napi::CallbackInfo& info);
+void EIO_Transact(uv_work_t* req);
+void EIO_AfterTransact(uv_work_t* req);
+// Makes a transaction cancelable before it's queued, returns an errno or 0
+int addTransaction(TransactBaton* data);
+// Wakes up the transactions queued or running on fd, they fail with `canceled` set. Returns how many there were.
+int cancelTransactions(int fd);
+Napi::Value CancelTransact(const Napi::CallbackInfo& info);
+
+Napi::Value Reconfigure(const Napi::CallbackInfo& info);
+void EIO_Reconfigure(uv_work_t* req);
+void EIO_AfterReconfigure(uv_work_t* req);
+
+Napi::Value OpenMany(const Napi::CallbackInfo& info);
+void EIO_OpenMany(void* arg);
+void EIO_AfterOpenMany(uv_async_t* handle);
+#endif
+
 enum SerialPortParity {
   SERIALPORT_PARITY_NONE  = 1,
   SERIALPORT_PARITY_MARK  = 2,
@@ -86,6 +128,17 @@ struct ConnectionOptions {
   char errorString[ERROR_STRING_SIZE];
   int fd = 0;
   int baudRate = 0;
+  // throw away unread and unsent data when the baud rate changes
+  bool flush = true;
+};
+
+struct GetQueueSizesBaton {
+  int fd = 0;
+  Napi::Env env;
+  Napi::FunctionReference callback;
+  char errorString[ERROR_STRING_SIZE];
+  int input = 0;
+  int output = 0;
 };
 
 struct ConnectionOptionsBaton : ConnectionOptions {
@@ -132,6 +185,88 @@ struct VoidBaton {
   char errorString[ERROR_STRING_SIZE];
 };
 
+enum TransactUntil {
+  TRANSACT_UNTIL_DELIMITER,
+  TRANSACT_UNTIL_LENGTH,
+  TRANSACT_UNTIL_LENGTH_FIELD
+};
+
+struct TransactBaton {
+  int fd = 0;
+  Napi::Env env;
+  Napi::FunctionReference callback;
+  char errorString[ERROR_STRING_SIZE];
+  std::vector<uint8_t> request;
+  TransactUntil until = TRANSACT_UNTIL_LENGTH;
+  std::vector<uint8_t> delimiter;
+  size_t length = 0;
+  size_t fieldOffset = 0;
+  unsigned fieldSize = 1;
+  bool fieldLittleEndian = false;
+  int fieldAdjust = 0;
+  size_t maxLength = 0;
+  unsigned timeoutMs = 0;
+  bool discardInput = false;
+  bool timedOut = false;
+  // cancelTransactions() writes to the pipe and sets canceled, the thread pool job polls the read end with the port
+  int wake_fds[2] = { -1, -1 };
+  bool canceled = false;
+  // everything read, the response is the first responseLength bytes and anything after it arrived unasked
+  std::vector<uint8_t> received;
+  size_t responseLength = 0;
+};
+
+#ifndef WIN32
+// The termios part of a port's settings, open and reconfigure build the termios from it the same way
+struct TermiosSettings {
+  int dataBits = 8;
+  bool rtscts = false;
+  bool xon = false;
+  bool xoff = false;
+  bool xany = false;
+  bool hupcl = false;
+  SerialPortParity parity = SERIALPORT_PARITY_NONE;
+  SerialPortStopBits stopBits = SERIALPORT_STOPBITS_ONE;
+  uint8_t vmin = 1;
+  uint8_t vtime = 0;
+};
+
+struct ReconfigureBaton {
+  int fd = 0;
+  Napi::Env env;
+  Napi::FunctionReference callback;
+  char errorString[ERROR_STRING_SIZE];
+  int baudRate = 0;
+  TermiosSettings settings;
+  bool flush = true;
+  // the modem lines are only touched when setModem is
+  bool setModem = false;
+  bool rts = false;
+  bool dtr = false;
+  bool brk = false;
+  // the port went back to how it was before the error
+  bool rolledBack = false;
+};
+
+#define OPEN_MANY_DEFAULT_CONCURRENCY 16
+#define OPEN_MANY_MAX_CONCURRENCY 64
+
+// A batch of opens shared by threads of its own, so a gateway opening hundreds of ports doesn't tie up the libuv
+// thread pool. Ports with the same settings share one termios built for the first of them.
+struct OpenManyBaton {
+  Napi::Env env;
+  Napi::FunctionReference callback;
+  std::vector<OpenBaton*> ports;
+  std::vector<uv_thread_t> threads;
+  uv_async_t* async = nullptr;
+  // the next port to open and the number finished, taken and bumped by the threads
+  size_t next = 0;
+  size_t finished = 0;
+  uv_mutex_t templatesLock;
+  std::vector<std::pair<OpenBaton*, struct termios>> templates;
+};
+#endif
+
 int setup(int fd, OpenBaton *data);
 int setBaudRate(ConnectionOptions *data);
 #endif  // PACKAGES_SERIALPORT_SRC_SERIALPORT_H_
@@ -1,11 +1,15 @@
 #include "serialport_unix.h"
 #include "serialport.h"
+#include "tap.h"
+#include "port_state.h"
 
 #include <sys/file.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <termios.h>
+#include <poll.h>
+#include <algorithm>
 
 #ifdef __APPLE__
 #include <AvailabilityMacros.h>
@@ -100,9 +104,14 @@ int setBaudRate(ConnectionOptions *data) {
   int baudRate = ToBaudConstant(data->baudRate);
   int fd = data->fd;
 
-  // get port options
+  // get port options, from what we last set when we know it
   struct termios options;
-  if (-1 == tcgetattr(fd, &options)) {
+  int currentBaudRate;
+  if (getTermiosState(fd, &options, &currentBaudRate)) {
+    if (currentBaudRate == data->baudRate) {
+      return 1;
+    }
+  } else if (-1 == tcgetattr(fd, &options)) {
     snprintf(data->errorString, sizeof(data->errorString),
              "Error: %s setting custom baud rate of %d", strerror(errno), data->baudRate);
     return -1;
@@ -112,6 +121,9 @@ int setBaudRate(ConnectionOptions *data) {
   #if defined(__linux__) && defined(ASYNC_SPD_CUST)
     if (baudRate == -1) {
       int err = linuxSetCustomBaudRate(fd, data->baudRate);
+      if (err < 0) {
+        forgetPortState(fd);
+      }
 
       if (err == -1) {
         snprintf(data->errorString, sizeof(data->errorString),
@@ -123,6 +135,10 @@ int setBaudRate(ConnectionOptions *data) {
         return -1;
       }
 
+      // termios2 changed the speed fields behind termios, read them back once
+      if (0 == tcgetattr(fd, &options)) {
+        setTermiosState(fd, options, data->baudRate);
+      }
       return 1;
     }
   #endif
@@ -136,7 +152,10 @@ int setBaudRate(ConnectionOptions *data) {
                  "Error: %s calling ioctl(.., IOSSIOSPEED, %ld )", strerror(errno), speed);
         return -1;
       } else {
-        tcflush(fd, TCIOFLUSH);
+        if (data->flush) {
+          tcflush(fd, TCIOFLUSH);
+        }
+        setTermiosState(fd, options, data->baudRate);
         return 1;
       }
     }
@@ -152,9 +171,15 @@ int setBaudRate(ConnectionOptions *data) {
   cfsetospeed(&options, baudRate);
   cfsetispeed(&options, baudRate);
   // throw away all the buffered data
-  tcflush(fd, TCIOFLUSH);
+  if (data->flush) {
+    tcflush(fd, TCIOFLUSH);
+  }
   // make the changes now
-  tcsetattr(fd, TCSANOW, &options);
+  if (-1 == tcsetattr(fd, TCSANOW, &options)) {
+    forgetPortState(fd);
+  } else {
+    setTermiosState(fd, options, data->baudRate);
+  }
   return 1;
 }
 
@@ -163,109 +188,133 @@ void EIO_Update(uv_work_t* req) {
   setBaudRate(data);
 }
 
-int setup(int fd, OpenBaton *data) {
-  int dataBits = ToDataBitsConstant(data->dataBits);
+// Applies settings to options, the rest of options is left as it was. Fails on settings a tty can't have.
+static int buildTermios(struct termios* options, const TermiosSettings& settings, char* errorString) {
+  int dataBits = ToDataBitsConstant(settings.dataBits);
   if (-1 == dataBits) {
-    snprintf(data->errorString, sizeof(data->errorString),
-             "Invalid data bits setting %d", data->dataBits);
+    snprintf(errorString, ERROR_STRING_SIZE, "Invalid data bits setting %d", settings.dataBits);
     return -1;
   }
 
-  // Snow Leopard doesn't have O_CLOEXEC
-  if (-1 == fcntl(fd, F_SETFD, FD_CLOEXEC)) {
-    snprintf(data->errorString, sizeof(data->errorString), "Error %s Cannot open %s", strerror(errno), data->path);
-    return -1;
-  }
-
-  // Get port configuration for modification
-  struct termios options;
-  tcgetattr(fd, &options);
-
   // IGNPAR: ignore bytes with parity errors
-  options.c_iflag = IGNPAR;
+  options->c_iflag = IGNPAR;
 
   // ICRNL: map CR to NL (otherwise a CR input on the other computer will not terminate input)
   // Future potential option
-  // options.c_iflag = ICRNL;
+  // options->c_iflag = ICRNL;
   // otherwise make device raw (no other input processing)
 
   // Specify data bits
-  options.c_cflag &= ~CSIZE;
-  options.c_cflag |= dataBits;
+  options->c_cflag &= ~CSIZE;
+  options->c_cflag |= dataBits;
 
-  options.c_cflag &= ~(CRTSCTS);
+  options->c_cflag &= ~(CRTSCTS);
 
-  if (data->rtscts) {
-    options.c_cflag |= CRTSCTS;
+  if (settings.rtscts) {
+    options->c_cflag |= CRTSCTS;
     // evaluate specific flow control options
   }
 
-  options.c_iflag &= ~(IXON | IXOFF | IXANY);
+  options->c_iflag &= ~(IXON | IXOFF | IXANY);
 
-  if (data->xon) {
-    options.c_iflag |= IXON;
+  if (settings.xon) {
+    options->c_iflag |= IXON;
   }
 
-  if (data->xoff) {
-    options.c_iflag |= IXOFF;
+  if (settings.xoff) {
+    options->c_iflag |= IXOFF;
   }
 
-  if (data->xany) {
-    options.c_iflag |= IXANY;
+  if (settings.xany) {
+    options->c_iflag |= IXANY;
   }
 
-  switch (data->parity) {
+  switch (settings.parity) {
   case SERIALPORT_PARITY_NONE:
-    options.c_cflag &= ~PARENB;
-    // options.c_cflag &= ~CSTOPB;
-    // options.c_cflag &= ~CSIZE;
-    // options.c_cflag |= CS8;
+    options->c_cflag &= ~PARENB;
+    // options->c_cflag &= ~CSTOPB;
+    // options->c_cflag &= ~CSIZE;
+    // options->c_cflag |= CS8;
     break;
   case SERIALPORT_PARITY_ODD:
-    options.c_cflag |= PARENB;
-    options.c_cflag |= PARODD;
-    // options.c_cflag &= ~CSTOPB;
-    // options.c_cflag &= ~CSIZE;
-    // options.c_cflag |= CS7;
+    options->c_cflag |= PARENB;
+    options->c_cflag |= PARODD;
+    // options->c_cflag &= ~CSTOPB;
+    // options->c_cflag &= ~CSIZE;
+    // options->c_cflag |= CS7;
     break;
   case SERIALPORT_PARITY_EVEN:
-    options.c_cflag |= PARENB;
-    options.c_cflag &= ~PARODD;
-    // options.c_cflag &= ~CSTOPB;
-    // options.c_cflag &= ~CSIZE;
-    // options.c_cflag |= CS7;
+    options->c_cflag |= PARENB;
+    options->c_cflag &= ~PARODD;
+    // options->c_cflag &= ~CSTOPB;
+    // options->c_cflag &= ~CSIZE;
+    // options->c_cflag |= CS7;
     break;
   default:
-    snprintf(data->errorString, sizeof(data->errorString), "Invalid parity setting %d", data->parity);
+    snprintf(errorString, ERROR_STRING_SIZE, "Invalid parity setting %d", settings.parity);
     return -1;
   }
 
-  switch (data->stopBits) {
+  switch (settings.stopBits) {
   case SERIALPORT_STOPBITS_ONE:
-    options.c_cflag &= ~CSTOPB;
+    options->c_cflag &= ~CSTOPB;
     break;
   case SERIALPORT_STOPBITS_TWO:
-    options.c_cflag |= CSTOPB;
+    options->c_cflag |= CSTOPB;
     break;
   default:
-    snprintf(data->errorString, sizeof(data->errorString), "Invalid stop bits setting %d", data->stopBits);
+    snprintf(errorString, ERROR_STRING_SIZE, "Invalid stop bits setting %d", settings.stopBits);
     return -1;
   }
 
-  options.c_cflag |= CLOCAL;  // ignore status lines
-  options.c_cflag |= CREAD;   // enable receiver
-  if (data->hupcl) {
-    options.c_cflag |= HUPCL;  // drop DTR (i.e. hangup) on close
+  options->c_cflag |= CLOCAL;  // ignore status lines
+  options->c_cflag |= CREAD;   // enable receiver
+  if (settings.hupcl) {
+    options->c_cflag |= HUPCL;  // drop DTR (i.e. hangup) on close
+  } else {
+    options->c_cflag &= ~HUPCL;  // keep DTR up on close, so the device isn't reset
   }
 
   // Raw output
-  options.c_oflag = 0;
+  options->c_oflag = 0;
 
   // ICANON makes partial lines not readable. It should be optional.
   // It works with ICRNL.
-  options.c_lflag = 0;  // ICANON;
-  options.c_cc[VMIN]= data->vmin;
-  options.c_cc[VTIME]= data->vtime;
+  options->c_lflag = 0;  // ICANON;
+  options->c_cc[VMIN] = settings.vmin;
+  options->c_cc[VTIME] = settings.vtime;
+  return 1;
+}
+
+static TermiosSettings termiosSettingsOf(const OpenBaton* data) {
+  TermiosSettings settings;
+  settings.dataBits = data->dataBits;
+  settings.rtscts = data->rtscts;
+  settings.xon = data->xon;
+  settings.xoff = data->xoff;
+  settings.xany = data->xany;
+  settings.hupcl = data->hupcl;
+  settings.parity = data->parity;
+  settings.stopBits = data->stopBits;
+  settings.vmin = data->vmin;
+  settings.vtime = data->vtime;
+  return settings;
+}
+
+int setup(int fd, OpenBaton *data) {
+  // Snow Leopard doesn't have O_CLOEXEC
+  if (-1 == fcntl(fd, F_SETFD, FD_CLOEXEC)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error %s Cannot open %s", strerror(errno), data->path);
+    return -1;
+  }
+
+  // Get port configuration for modification
+  struct termios options;
+  tcgetattr(fd, &options);
+
+  if (-1 == buildTermios(&options, termiosSettingsOf(data), data->errorString)) {
+    return -1;
+  }
 
   // Note that tcsetattr() returns success if any of the requested changes could be successfully carried out.
   // Therefore, when making multiple changes it may be necessary to follow this call with a further call to
@@ -273,6 +322,12 @@ int setup(int fd, OpenBaton *data) {
   // This also fails on OSX
   tcsetattr(fd, TCSANOW, &options);
 
+  // the fd may have belonged to a port closed elsewhere, start over with what the kernel actually took
+  forgetPortState(fd);
+  if (0 == tcgetattr(fd, &options)) {
+    setTermiosState(fd, options, PORT_STATE_UNKNOWN_BAUD_RATE);
+  }
+
   if (data->lock) {
     if (-1 == flock(fd, LOCK_EX | LOCK_NB)) {
       snprintf(data->errorString, sizeof(data->errorString), "Error %s Cannot lock port", strerror(errno));
@@ -302,52 +357,303 @@ int setup(int fd, OpenBaton *data) {
 void EIO_Close(uv_work_t* req) {
   VoidBaton* data = static_cast<VoidBaton*>(req->data);
 
+  forgetPortState(data->fd);
   if (-1 == close(data->fd)) {
     snprintf(data->errorString, sizeof(data->errorString),
              "Error: %s, unable to close fd %d", strerror(errno), data->fd);
   }
 }
 
+// Sets the modem output lines and break. With the lines we set last time only what changed goes to the driver, RTS
+// always goes when the driver may be moving it for rtscts.
+// Returns -1 with errno set on failure.
+static int setModemLines(int fd, int wanted, bool brk) {
+  const int lines = TIOCM_RTS | TIOCM_CTS | TIOCM_DTR | TIOCM_DSR;
+  int current = 0;
+  bool currentBrk = false;
+  bool known = getModemState(fd, &current, &currentBrk);
+
+  int result = 0;
+  if (!known || currentBrk != brk) {
+    if (brk) {
+      result = ioctl(fd, TIOCSBRK, NULL);
+    } else {
+      result = ioctl(fd, TIOCCBRK, NULL);
+    }
+  }
+
+  if (-1 != result && known) {
+    int raise = wanted & ~current;
+    int lower = current & ~wanted;
+    // with rtscts the driver moves RTS itself, so what we set last says nothing about it now
+    struct termios termios;
+    int baudRate;
+    if (!getTermiosState(fd, &termios, &baudRate) || (termios.c_cflag & CRTSCTS)) {
+      raise |= wanted & TIOCM_RTS;
+      lower |= ~wanted & TIOCM_RTS;
+    }
+    if (raise) {
+      result = ioctl(fd, TIOCMBIS, &raise);
+    }
+    if (lower && -1 != result) {
+      result = ioctl(fd, TIOCMBIC, &lower);
+    }
+  } else if (-1 != result) {
+    int bits;
+    ioctl(fd, TIOCMGET, &bits);
+    bits = (bits & ~lines) | wanted;
+    result = ioctl(fd, TIOCMSET, &bits);
+  }
+
+  if (-1 == result) {
+    int err = errno;
+    forgetModemState(fd);
+    errno = err;
+    return -1;
+  }
+  setModemState(fd, wanted, brk);
+  return 0;
+}
+
 void EIO_Set(uv_work_t* req) {
   SetBaton* data = static_cast<SetBaton*>(req->data);
 
-  int bits;
-  ioctl(data->fd, TIOCMGET, &bits);
-
-  bits &= ~(TIOCM_RTS | TIOCM_CTS | TIOCM_DTR | TIOCM_DSR);
+  int wanted = 0;
 
   if (data->rts) {
-    bits |= TIOCM_RTS;
+    wanted |= TIOCM_RTS;
   }
 
   if (data->cts) {
-    bits |= TIOCM_CTS;
+    wanted |= TIOCM_CTS;
   }
 
   if (data->dtr) {
-    bits |= TIOCM_DTR;
+    wanted |= TIOCM_DTR;
   }
 
   if (data->dsr) {
-    bits |= TIOCM_DSR;
+    wanted |= TIOCM_DSR;
   }
 
-  int result = 0;
-  if (data->brk) {
-    result = ioctl(data->fd, TIOCSBRK, NULL);
+  if (-1 == setModemLines(data->fd, wanted, data->brk)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot set", strerror(errno));
+    return;
+  }
+}
+
+// The setting the driver didn't take, or nullptr when it took them all
+static const char* termiosMismatch(const struct termios& wanted, const struct termios& actual, bool checkSpeed) {
+  if ((wanted.c_cflag & CSIZE) != (actual.c_cflag & CSIZE)) {
+    return "data bits";
+  }
+  if ((wanted.c_cflag & (PARENB | PARODD)) != (actual.c_cflag & (PARENB | PARODD))) {
+    return "parity";
+  }
+  if ((wanted.c_cflag & CSTOPB) != (actual.c_cflag & CSTOPB)) {
+    return "stop bits";
+  }
+  if ((wanted.c_cflag & CRTSCTS) != (actual.c_cflag & CRTSCTS)) {
+    return "rtscts";
+  }
+  if ((wanted.c_iflag & (IXON | IXOFF | IXANY)) != (actual.c_iflag & (IXON | IXOFF | IXANY))) {
+    return "xon/xoff";
+  }
+  if ((wanted.c_cflag & HUPCL) != (actual.c_cflag & HUPCL)) {
+    return "hupcl";
+  }
+  if (wanted.c_cc[VMIN] != actual.c_cc[VMIN] || wanted.c_cc[VTIME] != actual.c_cc[VTIME]) {
+    return "vmin/vtime";
+  }
+  if (checkSpeed && (cfgetospeed(&wanted) != cfgetospeed(&actual) || cfgetispeed(&wanted) != cfgetispeed(&actual))) {
+    return "baud rate";
+  }
+  return nullptr;
+}
+
+// Sets a baud rate that has no B* constant, returns -1 with errno set on failure
+static int setCustomBaudRate(int fd, int baudRate) {
+#if defined(__linux__) && defined(ASYNC_SPD_CUST)
+  return linuxSetCustomBaudRate(fd, baudRate) < 0 ? -1 : 0;
+#elif defined(MAC_OS_X_VERSION_10_4) && (MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_4)
+  speed_t speed = baudRate;
+  return ioctl(fd, IOSSIOSPEED, &speed);
+#else
+  errno = EINVAL;
+  return -1;
+#endif
+}
+
+void EIO_Reconfigure(uv_work_t* req) {
+  ReconfigureBaton* data = static_cast<ReconfigureBaton*>(req->data);
+  int fd = data->fd;
+
+  // what to go back to
+  struct termios previous;
+  if (-1 == tcgetattr(fd, &previous)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot reconfigure", strerror(errno));
+    return;
+  }
+  struct termios shadow;
+  int previousBaudRate = PORT_STATE_UNKNOWN_BAUD_RATE;
+  getTermiosState(fd, &shadow, &previousBaudRate);
+  int previousBits = 0;
+  if (data->setModem && -1 == ioctl(fd, TIOCMGET, &previousBits)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot reconfigure", strerror(errno));
+    return;
+  }
+
+  struct termios options = previous;
+  if (-1 == buildTermios(&options, data->settings, data->errorString)) {
+    return;
+  }
+  int baudRate = ToBaudConstant(data->baudRate);
+  bool customBaudRate = -1 == baudRate;
+  if (!customBaudRate) {
+    cfsetospeed(&options, baudRate);
+    cfsetispeed(&options, baudRate);
+  }
+
+  // one flush for the whole switch
+  if (data->flush) {
+    tcflush(fd, TCIOFLUSH);
+  }
+
+  int err = 0;
+  const char* rejected = nullptr;
+  struct termios actual;
+  if (-1 == tcsetattr(fd, TCSANOW, &options)) {
+    err = errno;
+  } else if (customBaudRate && -1 == setCustomBaudRate(fd, data->baudRate)) {
+    err = errno;
+  } else if (-1 == tcgetattr(fd, &actual)) {
+    err = errno;
   } else {
-    result = ioctl(data->fd, TIOCCBRK, NULL);
+    // tcsetattr() succeeds when any of the changes could be made, check them all
+    rejected = termiosMismatch(options, actual, !customBaudRate);
   }
 
-  if (-1 == result) {
-    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot set", strerror(errno));
+  int wanted = (data->rts ? TIOCM_RTS : 0) | (data->dtr ? TIOCM_DTR : 0);
+  if (!err && !rejected && data->setModem && -1 == setModemLines(fd, wanted, data->brk)) {
+    err = errno;
+  }
+
+  if (!err && !rejected) {
+    setTermiosState(fd, actual, data->baudRate);
     return;
   }
 
-  if (-1 == ioctl(data->fd, TIOCMSET, &bits)) {
-    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot set", strerror(errno));
+  if (err) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot reconfigure", strerror(err));
+  } else {
+    snprintf(data->errorString, sizeof(data->errorString),
+             "Error: the driver didn't take the %s setting, cannot reconfigure", rejected);
+  }
+
+  // put everything back the way it was
+  forgetPortState(fd);
+  bool restored = 0 == tcsetattr(fd, TCSANOW, &previous);
+  if (restored && previousBaudRate != PORT_STATE_UNKNOWN_BAUD_RATE && -1 == ToBaudConstant(previousBaudRate)) {
+    restored = 0 == setCustomBaudRate(fd, previousBaudRate);
+  }
+  if (data->setModem) {
+    int bits = previousBits;
+    restored = 0 == ioctl(fd, TIOCMSET, &bits) && restored;
+  }
+  if (restored && 0 == tcgetattr(fd, &actual)) {
+    setTermiosState(fd, actual, previousBaudRate);
+  }
+  data->rolledBack = restored;
+}
+
+// Ports that can share a termios, the lock is applied separately
+static bool sameTermiosSettings(const OpenBaton* a, const OpenBaton* b) {
+  return a->baudRate == b->baudRate && a->dataBits == b->dataBits && a->parity == b->parity &&
+         a->stopBits == b->stopBits && a->rtscts == b->rtscts && a->xon == b->xon && a->xoff == b->xoff &&
+         a->xany == b->xany && a->hupcl == b->hupcl && a->vmin == b->vmin && a->vtime == b->vtime;
+}
+
+// The termios for a port's settings, built from the first port of the batch that has them. The parts of the
+// termios the settings don't cover are the same for every tty once it's raw.
+static int termiosTemplate(OpenManyBaton* batch, OpenBaton* data, int fd, struct termios* options) {
+  uv_mutex_lock(&batch->templatesLock);
+  for (const auto& entry : batch->templates) {
+    if (sameTermiosSettings(entry.first, data)) {
+      *options = entry.second;
+      uv_mutex_unlock(&batch->templatesLock);
+      return 1;
+    }
+  }
+  uv_mutex_unlock(&batch->templatesLock);
+
+  if (-1 == tcgetattr(fd, options)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot open %s", strerror(errno), data->path);
+    return -1;
+  }
+  if (-1 == buildTermios(options, termiosSettingsOf(data), data->errorString)) {
+    return -1;
+  }
+  int baudRate = ToBaudConstant(data->baudRate);
+  if (-1 != baudRate) {
+    cfsetospeed(options, baudRate);
+    cfsetispeed(options, baudRate);
+  }
+
+  uv_mutex_lock(&batch->templatesLock);
+  batch->templates.push_back({ data, *options });
+  uv_mutex_unlock(&batch->templatesLock);
+  return 1;
+}
+
+// Opens one port of a batch: one tcsetattr with the baud rate included and one flush, where open() takes two of
+// each and reads the termios back in between
+static void openFromTemplate(OpenManyBaton* batch, OpenBaton* data) {
+  int fd = open(data->path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC | O_SYNC);
+  if (-1 == fd) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot open %s", strerror(errno), data->path);
+    return;
+  }
+
+  // before anything is flushed or changed, a port another process holds is left alone
+  if (data->lock && -1 == flock(fd, LOCK_EX | LOCK_NB)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error %s Cannot lock port", strerror(errno));
+    close(fd);
+    return;
+  }
+
+  struct termios options;
+  if (-1 == termiosTemplate(batch, data, fd, &options)) {
+    close(fd);
     return;
   }
+
+  // throw away whatever arrived or was left with other settings
+  tcflush(fd, TCIOFLUSH);
+  tcsetattr(fd, TCSANOW, &options);
+  if (-1 == ToBaudConstant(data->baudRate) && -1 == setCustomBaudRate(fd, data->baudRate)) {
+    snprintf(data->errorString, sizeof(data->errorString),
+             "Error: %s || while setting custom baud rate of %d", strerror(errno), data->baudRate);
+    close(fd);
+    return;
+  }
+
+  forgetPortState(fd);
+  setTermiosState(fd, options, data->baudRate);
+  data->result = fd;
+}
+
+void EIO_OpenMany(void* arg) {
+  OpenManyBaton* batch = static_cast<OpenManyBaton*>(arg);
+  for (;;) {
+    size_t index = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED);
+    if (index >= batch->ports.size()) {
+      break;
+    }
+    openFromTemplate(batch, batch->ports[index]);
+    if (__atomic_add_fetch(&batch->finished, 1, __ATOMIC_ACQ_REL) == batch->ports.size()) {
+      uv_async_send(batch->async);
+    }
+  }
 }
 
 void EIO_Get(uv_work_t* req) {
@@ -381,6 +687,24 @@ void EIO_GetBaudRate(uv_work_t* req) {
   data->baudRate = outbaud;
 }
 
+void EIO_GetQueueSizes(uv_work_t* req) {
+  GetQueueSizesBaton* data = static_cast<GetQueueSizesBaton*>(req->data);
+
+  if (-1 == ioctl(data->fd, FIONREAD, &data->input)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot get input queue size", strerror(errno));
+    return;
+  }
+
+  #ifdef TIOCOUTQ
+  if (-1 == ioctl(data->fd, TIOCOUTQ, &data->output)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot get output queue size", strerror(errno));
+    return;
+  }
+  #else
+  snprintf(data->errorString, sizeof(data->errorString), "Error: Output queue size not implemented on this platform");
+  #endif
+}
+
 void EIO_Flush(uv_work_t* req) {
   VoidBaton* data = static_cast<VoidBaton*>(req->data);
 
@@ -398,3 +722,210 @@ void EIO_Drain(uv_work_t* req) {
     return;
   }
 }
+
+// The transactions on the thread pool, so closing a port can wake up the ones still using its fd
+static uv_once_t transactionsOnce = UV_ONCE_INIT;
+static uv_mutex_t transactionsLock;
+static std::vector<TransactBaton*> transactions;
+
+static void initTransactions() {
+  uv_mutex_init(&transactionsLock);
+}
+
+int addTransaction(TransactBaton* data) {
+  if (0 != pipe(data->wake_fds)) {
+    return errno;
+  }
+  fcntl(data->wake_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(data->wake_fds[1], F_SETFD, FD_CLOEXEC);
+  uv_once(&transactionsOnce, initTransactions);
+  uv_mutex_lock(&transactionsLock);
+  transactions.push_back(data);
+  uv_mutex_unlock(&transactionsLock);
+  return 0;
+}
+
+int cancelTransactions(int fd) {
+  uv_once(&transactionsOnce, initTransactions);
+  int canceled = 0;
+  uv_mutex_lock(&transactionsLock);
+  for (TransactBaton* data : transactions) {
+    if (data->fd != fd) {
+      continue;
+    }
+    __atomic_store_n(&data->canceled, true, __ATOMIC_RELEASE);
+    char byte = 0;
+    ssize_t written;
+    do {
+      written = write(data->wake_fds[1], &byte, 1);
+    } while (written < 0 && errno == EINTR);
+    canceled++;
+  }
+  uv_mutex_unlock(&transactionsLock);
+  return canceled;
+}
+
+// Waits for the fd until the deadline, returns the poll events, 0 on timeout or -1 with errno set. Being canceled
+// is -1 with ECANCELED.
+static int transactWait(TransactBaton* data, int events, uint64_t deadline) {
+  for (;;) {
+    uint64_t now = uv_hrtime();
+    if (now >= deadline) {
+      return 0;
+    }
+    struct pollfd fds[2] = {
+      { data->fd, static_cast<short>(events), 0 },
+      { data->wake_fds[0], POLLIN, 0 },
+    };
+    // round up so we never wake just short of the deadline and spin
+    int timeout = static_cast<int>((deadline - now + 999999) / 1000000);
+    int ready = poll(fds, 2, timeout);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready <= 0) {
+      return ready;
+    }
+    if (fds[1].revents) {
+      errno = ECANCELED;
+      return -1;
+    }
+    return fds[0].revents;
+  }
+}
+
+// The length of the complete response at the start of received, 0 while it's incomplete
+static size_t transactMatch(TransactBaton* data, size_t searchFrom) {
+  const std::vector<uint8_t>& received = data->received;
+  switch (data->until) {
+    case TRANSACT_UNTIL_DELIMITER: {
+      const std::vector<uint8_t>& delimiter = data->delimiter;
+      // the delimiter may have been split across reads
+      size_t from = searchFrom >= delimiter.size() ? searchFrom - delimiter.size() + 1 : 0;
+      auto found = std::search(received.begin() + from, received.end(), delimiter.begin(), delimiter.end());
+      return found == received.end() ? 0 : (found - received.begin()) + delimiter.size();
+    }
+    case TRANSACT_UNTIL_LENGTH_FIELD: {
+      if (received.size() < data->fieldOffset + data->fieldSize) {
+        return 0;
+      }
+      const uint8_t* field = received.data() + data->fieldOffset;
+      int64_t value = 0;
+      for (unsigned i = 0; i < data->fieldSize; i++) {
+        value = (value << 8) | field[data->fieldLittleEndian ? data->fieldSize - 1 - i : i];
+      }
+      int64_t total = static_cast<int64_t>(data->fieldOffset + data->fieldSize) + value + data->fieldAdjust;
+      if (total <= 0) {
+        return data->fieldOffset + data->fieldSize;
+      }
+      return received.size() >= static_cast<uint64_t>(total) ? static_cast<size_t>(total) : 0;
+    }
+    default:
+      return received.size() >= data->length ? data->length : 0;
+  }
+}
+
+static void transact(TransactBaton* data) {
+  uint64_t deadline = uv_hrtime() + static_cast<uint64_t>(data->timeoutMs) * 1000000;
+
+  if (data->discardInput && -1 == tcflush(data->fd, TCIFLUSH)) {
+    snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot flush", strerror(errno));
+    return;
+  }
+
+  size_t written = 0;
+  while (written < data->request.size()) {
+    ssize_t count = write(data->fd, data->request.data() + written, data->request.size() - written);
+    if (count >= 0) {
+      tapData(data->fd, TAP_TX, data->request.data() + written, count);
+      written += count;
+      continue;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot write", strerror(errno));
+      return;
+    }
+    int events = transactWait(data, POLLOUT, deadline);
+    if (events == 0) {
+      data->timedOut = true;
+      snprintf(data->errorString, sizeof(data->errorString),
+               "Error: timed out after %u ms writing the request", data->timeoutMs);
+      return;
+    }
+    if (events < 0) {
+      snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot write", strerror(errno));
+      return;
+    }
+  }
+
+  uint8_t chunk[1024];
+  size_t searchFrom = 0;
+  for (;;) {
+    size_t complete = transactMatch(data, searchFrom);
+    if (complete) {
+      data->responseLength = complete;
+      return;
+    }
+    if (data->received.size() >= data->maxLength) {
+      snprintf(data->errorString, sizeof(data->errorString),
+               "Error: no complete response in the first %u bytes", static_cast<unsigned>(data->maxLength));
+      return;
+    }
+    searchFrom = data->received.size();
+
+    ssize_t count = read(data->fd, chunk, sizeof(chunk));
+    if (count > 0) {
+      tapData(data->fd, TAP_RX, chunk, count);
+      data->received.insert(data->received.end(), chunk, chunk + count);
+      continue;
+    }
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot read", strerror(errno));
+      return;
+    }
+    int events = transactWait(data, POLLIN, deadline);
+    if (events == 0) {
+      data->timedOut = true;
+      snprintf(data->errorString, sizeof(data->errorString),
+               "Error: timed out after %u ms waiting for the response", data->timeoutMs);
+      return;
+    }
+    if (events < 0) {
+      snprintf(data->errorString, sizeof(data->errorString), "Error: %s, cannot read", strerror(errno));
+      return;
+    }
+    if ((events & (POLLHUP | POLLERR | POLLNVAL)) && !(events & POLLIN)) {
+      snprintf(data->errorString, sizeof(data->errorString), "Error: port disconnected, cannot read");
+      return;
+    }
+  }
+}
+
+void EIO_Transact(uv_work_t* req) {
+  TransactBaton* data = static_cast<TransactBaton*>(req->data);
+  // canceled while it waited for a thread
+  if (!__atomic_load_n(&data->canceled, __ATOMIC_ACQUIRE)) {
+    transact(data);
+  }
+
+  uv_mutex_lock(&transactionsLock);
+  transactions.erase(std::find(transactions.begin(), transactions.end(), data));
+  uv_mutex_unlock(&transactionsLock);
+  for (int& wake_fd : data->wake_fds) {
+    close(wake_fd);
+    wake_fd = -1;
+  }
+  // a response that was already complete is kept
+  if (__atomic_load_n(&data->canceled, __ATOMIC_ACQUIRE) && (data->errorString[0] || !data->responseLength)) {
+    data->timedOut = false;
+    snprintf(data->errorString, sizeof(data->errorString), "Error: canceled, the port is closing");
+  } else {
+    data->canceled = false;
+  }
+}
@@ -284,6 +284,20 @@ void EIO_GetBaudRate(uv_work_t* req) {
   data->baudRate = static_cast<int>(dcb.BaudRate);
 }
 
+void EIO_GetQueueSizes(uv_work_t* req) {
+  GetQueueSizesBaton* data = static_cast<GetQueueSizesBaton*>(req->data);
+
+  DWORD errors = 0;
+  COMSTAT status = { 0 };
+  if (!ClearCommError(int2handle(data->fd), &errors, &status)) {
+    ErrorCodeToString("Getting queue sizes (ClearCommError)", GetLastError(), data->errorString);
+    return;
+  }
+
+  data->input = static_cast<int>(status.cbInQue);
+  data->output = static_cast<int>(status.cbOutQue);
+}
+
 bool IsClosingHandle(int fd) {
   for (std::list<int>::iterator it = g_closingHandles.begin(); it != g_closingHandles.end(); ++it) {
     if (fd == *it) {
@@ -327,7 +341,7 @@ Napi::Value Write(const Napi::CallbackInfo& info) {
   baton->complete = false;
 
   uv_async_t* async = new uv_async_t;
-  uv_async_init(uv_default_loop(), async, EIO_AfterWrite);
+  uv_async_init(getLoop(env), async, EIO_AfterWrite);
   async->data = baton;
   // WriteFileEx requires a thread that can block. Create a new thread to
   // run the write operation, saving the handle so it can be deallocated later.
@@ -449,7 +463,7 @@ Napi::Value Read(const Napi::CallbackInfo& info) {
   baton->complete = false;
 
   uv_async_t* async = new uv_async_t;
-  uv_async_init(uv_default_loop(), async, EIO_AfterRead);
+  uv_async_init(getLoop(env), async, EIO_AfterRead);
   async->data = baton;
   // ReadFileEx requires a thread that can block. Create a new thread to
   // run the read operation, saving the handle so it can be deallocated later.
@@ -623,7 +637,7 @@ Napi::Value List(const Napi::CallbackInfo& info) {
 
   uv_work_t* req = new uv_work_t();
   req->data = baton;
-  uv_queue_work(uv_default_loop(), req, EIO_List, (uv_after_work_cb)EIO_AfterList);
+  uv_queue_work(getLoop(env), req, EIO_List, (uv_after_work_cb)EIO_AfterList);
 }
 
 // It's possible that the s/n is a construct and not the s/n of the parent USB
@@ -0,0 +1,397 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "./serialport.h"
+#include "./tap.h"
+
+#define TAP_DEFAULT_BATCH_SIZE (256 * 1024)
+#define TAP_MIN_BATCH_SIZE 4096
+#define TAP_DEFAULT_FLUSH_MS 1000
+
+struct TapEntry {
+  int fd;
+  int direction;
+  Tap* tap;
+};
+
+// Every running tap, the read and write paths look themselves up here. Readers hold the lock while they append so
+// a tap can't finish under them.
+static uv_once_t registryOnce = UV_ONCE_INIT;
+static uv_rwlock_t registryLock;
+static std::vector<TapEntry> registry;
+static int tapCount = 0;
+
+static void initRegistry() {
+  uv_rwlock_init(&registryLock);
+}
+
+void tapData(int fd, int direction, const uint8_t* data, size_t length) {
+  if (length == 0 || __atomic_load_n(&tapCount, __ATOMIC_ACQUIRE) == 0) {
+    return;
+  }
+  uv_rwlock_rdlock(&registryLock);
+  for (const TapEntry& entry : registry) {
+    if (entry.fd == fd && entry.direction == direction) {
+      entry.tap->append(data, length);
+      break;
+    }
+  }
+  uv_rwlock_rdunlock(&registryLock);
+}
+
+bool isTapped(int fd, int direction) {
+  if (__atomic_load_n(&tapCount, __ATOMIC_ACQUIRE) == 0) {
+    return false;
+  }
+  bool found = false;
+  uv_rwlock_rdlock(&registryLock);
+  for (const TapEntry& entry : registry) {
+    if (entry.fd == fd && entry.direction == direction) {
+      found = true;
+      break;
+    }
+  }
+  uv_rwlock_rdunlock(&registryLock);
+  return found;
+}
+
+static bool registerTap(int fd, int direction, Tap* tap) {
+  uv_once(&registryOnce, initRegistry);
+  uv_rwlock_wrlock(&registryLock);
+  for (const TapEntry& entry : registry) {
+    if (entry.fd == fd && entry.direction == direction) {
+      uv_rwlock_wrunlock(&registryLock);
+      return false;
+    }
+  }
+  registry.push_back({ fd, direction, tap });
+  __atomic_store_n(&tapCount, static_cast<int>(registry.size()), __ATOMIC_RELEASE);
+  uv_rwlock_wrunlock(&registryLock);
+  return true;
+}
+
+static void unregisterTap(Tap* tap) {
+  uv_rwlock_wrlock(&registryLock);
+  for (auto entry = registry.begin(); entry != registry.end(); ++entry) {
+    if (entry->tap == tap) {
+      registry.erase(entry);
+      break;
+    }
+  }
+  __atomic_store_n(&tapCount, static_cast<int>(registry.size()), __ATOMIC_RELEASE);
+  uv_rwlock_wrunlock(&registryLock);
+}
+
+static uint32_t uintOption(Napi::Object options, const char* key, uint32_t fallback) {
+  Napi::Value value = options.Get(key);
+  return value.IsNumber() ? value.As<Napi::Number>().Uint32Value() : fallback;
+}
+
+Tap::Tap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Tap>(info) {
+  Napi::Env env = info.Env();
+
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  fd = info[0].As<Napi::Number>().Int32Value();
+
+  if (!info[1].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object options = info[1].As<Napi::Object>();
+  Napi::Value pathValue = options.Get("path");
+  if (!pathValue.IsString()) {
+    Napi::TypeError::New(env, "path must be a string").ThrowAsJavaScriptException();
+    return;
+  }
+  path = pathValue.As<Napi::String>().Utf8Value();
+  direction = uintOption(options, "direction", TAP_RX) == TAP_TX ? TAP_TX : TAP_RX;
+  fsyncPolicy = static_cast<int>(uintOption(options, "fsync", TAP_FSYNC_ROTATE));
+  Napi::Value rotate = options.Get("rotateBytes");
+  rotateBytes = rotate.IsNumber() ? static_cast<uint64_t>(rotate.As<Napi::Number>().DoubleValue()) : 0;
+  batchSize = uintOption(options, "batchSize", TAP_DEFAULT_BATCH_SIZE);
+  if (batchSize < TAP_MIN_BATCH_SIZE) {
+    batchSize = TAP_MIN_BATCH_SIZE;
+  }
+  maxBuffered = uintOption(options, "maxBuffered", 0);
+  if (maxBuffered < batchSize * 4) {
+    maxBuffered = batchSize * 4;
+  }
+  flushMs = uintOption(options, "flushMs", TAP_DEFAULT_FLUSH_MS);
+  if (flushMs == 0) {
+    flushMs = 1;
+  }
+
+  int err = openFile();
+  if (err) {
+    throwErrno(env, err, "open the tap file");
+    return;
+  }
+  batch.reserve(batchSize);
+
+  // the read and write paths append as soon as the tap is registered, so it has to be ready for them first
+  uv_mutex_init(&mutex);
+  uv_cond_init(&cond);
+  running = true;
+  if (!registerTap(fd, direction, this)) {
+    running = false;
+    uv_cond_destroy(&cond);
+    uv_mutex_destroy(&mutex);
+    ::close(file);
+    file = -1;
+    Napi::Error::New(env, "Error: the port is already tapped in this direction").ThrowAsJavaScriptException();
+    return;
+  }
+  if (0 != uv_thread_create(&thread, Tap::run, this)) {
+    unregisterTap(this);
+    running = false;
+    uv_cond_destroy(&cond);
+    uv_mutex_destroy(&mutex);
+    ::close(file);
+    file = -1;
+    Napi::Error::New(env, "Error: cannot start the tap thread").ThrowAsJavaScriptException();
+    return;
+  }
+}
+
+Tap::~Tap() {
+  finish();
+}
+
+Napi::Object Tap::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "Tap", {
+    InstanceMethod("record", &Tap::record),
+    InstanceMethod("stats", &Tap::stats),
+    InstanceMethod("flush", &Tap::flush),
+    InstanceMethod("close", &Tap::close),
+  });
+
+  exports.Set("Tap", func);
+  return exports;
+}
+
+void Tap::run(void* arg) {
+  static_cast<Tap*>(arg)->loop();
+}
+
+// Opens the live file for appending, whatever an earlier run left in it stays
+int Tap::openFile() {
+  file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (file < 0) {
+    return errno;
+  }
+  struct stat st;
+  if (fstat(file, &st) != 0) {
+    int err = errno;
+    ::close(file);
+    file = -1;
+    return err;
+  }
+  fileBytes = static_cast<uint64_t>(st.st_size);
+  return 0;
+}
+
+// Moves the live file to path.<ms since the epoch> and starts a new one. link() refuses to replace an existing
+// file, so rotating never overwrites earlier traffic.
+int Tap::rotate() {
+  if (fsyncPolicy != TAP_FSYNC_NONE && fdatasync(file) != 0) {
+    return errno;
+  }
+  int closed = ::close(file);
+  file = -1;
+  if (closed != 0) {
+    return errno;
+  }
+  struct timespec wallClock;
+  clock_gettime(CLOCK_REALTIME, &wallClock);
+  uint64_t stamp = static_cast<uint64_t>(wallClock.tv_sec) * 1000 + wallClock.tv_nsec / 1000000;
+  for (;;) {
+    std::string rotated = path + "." + std::to_string(stamp);
+    if (link(path.c_str(), rotated.c_str()) == 0) {
+      break;
+    }
+    if (errno != EEXIST) {
+      return errno;
+    }
+    stamp++;
+  }
+  if (unlink(path.c_str()) != 0) {
+    return errno;
+  }
+  __atomic_fetch_add(&rotations, 1, __ATOMIC_RELAXED);
+  return openFile();
+}
+
+// Writes a batch, rotating whenever the live file reaches rotateBytes
+int Tap::writeOut(const uint8_t* data, size_t length) {
+  while (length > 0) {
+    if (rotateBytes > 0 && fileBytes >= rotateBytes) {
+      int err = rotate();
+      if (err) {
+        return err;
+      }
+    }
+    size_t chunk = length;
+    if (rotateBytes > 0 && chunk > rotateBytes - fileBytes) {
+      chunk = static_cast<size_t>(rotateBytes - fileBytes);
+    }
+    int err = writeAll(file, data, chunk);
+    if (err) {
+      return err;
+    }
+    fileBytes += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+  if (fsyncPolicy == TAP_FSYNC_ALWAYS && fdatasync(file) != 0) {
+    return errno;
+  }
+  return 0;
+}
+
+// The only user of file and fileBytes while running
+void Tap::loop() {
+  std::vector<uint8_t> writing;
+  writing.reserve(batchSize);
+  uv_mutex_lock(&mutex);
+  for (;;) {
+    if (batch.size() < batchSize && !flushing && !stopping) {
+      // a partial batch goes out after flushMs, so a quiet port doesn't keep its last bytes in memory
+      uv_cond_timedwait(&cond, &mutex, static_cast<uint64_t>(flushMs) * 1000000);
+    }
+    flushing = false;
+    if (batch.empty()) {
+      if (stopping) {
+        break;
+      }
+      continue;
+    }
+    writing.swap(batch);
+    int failed = error;
+    uv_mutex_unlock(&mutex);
+
+    int err = failed ? 0 : writeOut(writing.data(), writing.size());
+
+    uv_mutex_lock(&mutex);
+    if (failed || err) {
+      dropped += writing.size();
+      error = failed ? failed : err;
+    } else {
+      written += writing.size();
+    }
+    writing.clear();
+  }
+  uv_mutex_unlock(&mutex);
+}
+
+// Called from whichever thread read or wrote the bytes, drops them when the file can't keep up
+void Tap::append(const uint8_t* data, size_t length) {
+  uv_mutex_lock(&mutex);
+  bytes += length;
+  if (error || batch.size() + length > maxBuffered) {
+    dropped += length;
+  } else {
+    batch.insert(batch.end(), data, data + length);
+    if (batch.size() >= batchSize) {
+      uv_cond_signal(&cond);
+    }
+  }
+  uv_mutex_unlock(&mutex);
+}
+
+// Stops taking data, writes what's left and closes the file
+void Tap::finish() {
+  if (!running) {
+    return;
+  }
+  unregisterTap(this);
+  uv_mutex_lock(&mutex);
+  stopping = true;
+  uv_cond_signal(&cond);
+  uv_mutex_unlock(&mutex);
+  uv_thread_join(&thread);
+  running = false;
+
+  int err = error;
+  if (!err && file >= 0 && fsyncPolicy != TAP_FSYNC_NONE && fdatasync(file) != 0) {
+    err = errno;
+  }
+  if (file >= 0 && ::close(file) != 0 && !err) {
+    err = errno;
+  }
+  file = -1;
+  error = err;
+  uv_cond_destroy(&cond);
+  uv_mutex_destroy(&mutex);
+}
+
+Napi::Object Tap::statsObject(Napi::Env env) {
+  if (running) {
+    uv_mutex_lock(&mutex);
+  }
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("bytes", Napi::Number::New(env, static_cast<double>(bytes)));
+  stats.Set("written", Napi::Number::New(env, static_cast<double>(written)));
+  stats.Set("dropped", Napi::Number::New(env, static_cast<double>(dropped)));
+  stats.Set("rotations", Napi::Number::New(env, __atomic_load_n(&rotations, __ATOMIC_RELAXED)));
+  if (error) {
+    stats.Set("error", uv_err_name(uv_translate_sys_error(error)));
+  }
+  if (running) {
+    uv_mutex_unlock(&mutex);
+  }
+  return stats;
+}
+
+// record(buffer[, offset, length]) for bytes that went through fs.read() or fs.write() instead of native code
+void Tap::record(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsTypedArray() || info[0].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+    Napi::TypeError::New(env, "buffer must be a Uint8Array").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Uint8Array buffer = info[0].As<Napi::Uint8Array>();
+  size_t offset = info[1].IsNumber() ? info[1].As<Napi::Number>().Uint32Value() : 0;
+  size_t length = info[2].IsNumber() ? info[2].As<Napi::Number>().Uint32Value() : buffer.ByteLength() - offset;
+  if (offset > buffer.ByteLength() || length > buffer.ByteLength() - offset) {
+    Napi::RangeError::New(env, "offset and length must be within the buffer").ThrowAsJavaScriptException();
+    return;
+  }
+  if (running && length > 0) {
+    append(buffer.Data() + offset, length);
+  }
+}
+
+Napi::Value Tap::stats(const Napi::CallbackInfo& info) {
+  return statsObject(info.Env());
+}
+
+// Writes the current batch out now instead of when it fills up or flushMs passes
+void Tap::flush(const Napi::CallbackInfo& info) {
+  if (!running) {
+    return;
+  }
+  uv_mutex_lock(&mutex);
+  flushing = true;
+  uv_cond_signal(&cond);
+  uv_mutex_unlock(&mutex);
+}
+
+// Writes what's left and closes the file, the stats have the error if anything failed to make it to disk
+Napi::Value Tap::close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!running) {
+    return env.Undefined();
+  }
+  finish();
+  return statsObject(env);
+}
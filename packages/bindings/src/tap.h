@@ -0,0 +1,74 @@
+#ifndef PACKAGES_SERIALPORT_SRC_TAP_H_
+#define PACKAGES_SERIALPORT_SRC_TAP_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define TAP_RX 0
+#define TAP_TX 1
+
+#define TAP_FSYNC_NONE 0
+#define TAP_FSYNC_ROTATE 1
+#define TAP_FSYNC_ALWAYS 2
+
+// Copies bytes read from (TAP_RX) or written to (TAP_TX) fd into its tap, if there is one. Safe on any thread, costs
+// an atomic load when nothing is tapped.
+void tapData(int fd, int direction, const uint8_t* data, size_t length);
+bool isTapped(int fd, int direction);
+
+// Appends one direction of a port's raw traffic to a file. The native read and write paths copy into a batch,
+// a thread of its own writes full batches out and rotates the file.
+class Tap : public Napi::ObjectWrap<Tap> {
+ public:
+  Tap(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void run(void* arg);
+  ~Tap();
+
+  void append(const uint8_t* data, size_t length);
+
+ private:
+  int fd = -1;
+  int direction = TAP_RX;
+  std::string path;
+  uint64_t rotateBytes = 0;
+  int fsyncPolicy = TAP_FSYNC_ROTATE;
+  size_t batchSize = 0;
+  size_t maxBuffered = 0;
+  unsigned flushMs = 0;
+
+  // only the writer thread touches these while running
+  int file = -1;
+  uint64_t fileBytes = 0;
+
+  // shared with the writer thread
+  uv_mutex_t mutex;
+  uv_cond_t cond;
+  uv_thread_t thread;
+  std::vector<uint8_t> batch;
+  uint64_t bytes = 0;
+  uint64_t written = 0;
+  uint64_t dropped = 0;
+  uint32_t rotations = 0;
+  int error = 0;
+  bool flushing = false;
+  bool stopping = false;
+  bool running = false;
+
+  void loop();
+  int writeOut(const uint8_t* data, size_t length);
+  int rotate();
+  int openFile();
+  void finish();
+  Napi::Object statsObject(Napi::Env env);
+
+  void record(const Napi::CallbackInfo& info);
+  Napi::Value stats(const Napi::CallbackInfo& info);
+  void flush(const Napi::CallbackInfo& info);
+  Napi::Value close(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_TAP_H_
@@ -0,0 +1,197 @@
+#include <napi.h>
+#include <uv.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include "./serialport.h"
+#include "./tty_index.h"
+
+// how far above the tty's device to look for the USB device, usb-serial ports sit two levels below it
+#define TTY_INDEX_MAX_DEPTH 8
+
+static bool readAttribute(const std::string& dir, const char* name, std::string* value) {
+  int fd = open((dir + "/" + name).c_str(), O_RDONLY | O_CLOEXEC);
+  if (-1 == fd) {
+    return false;
+  }
+  char buffer[256];
+  ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (length < 0) {
+    return false;
+  }
+  while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == ' ')) {
+    length--;
+  }
+  value->assign(buffer, length);
+  return true;
+}
+
+static bool resolvePath(const std::string& path, std::string* resolved) {
+  char buffer[PATH_MAX];
+  if (nullptr == realpath(path.c_str(), buffer)) {
+    return false;
+  }
+  resolved->assign(buffer);
+  return true;
+}
+
+TtyIndex::TtyIndex(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TtyIndex>(info) {
+  if (info[0].IsString()) {
+    classDir = info[0].As<Napi::String>().Utf8Value();
+  }
+  if (info[1].IsString()) {
+    devDir = info[1].As<Napi::String>().Utf8Value();
+  }
+}
+
+Napi::Object TtyIndex::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "TtyIndex", {
+    InstanceMethod("refresh", &TtyIndex::refresh),
+    InstanceMethod("find", &TtyIndex::find),
+  });
+
+  exports.Set("TtyIndex", func);
+  return exports;
+}
+
+void TtyIndex::readEntry(const std::string& name, TtyIndexEntry* entry) {
+  entry->device = false;
+  entry->usb = false;
+  entry->manufacturer.clear();
+  entry->serialNumber.clear();
+  entry->locationId.clear();
+  entry->vendorId.clear();
+  entry->productId.clear();
+
+  // virtual consoles and ptys have no device
+  std::string dir;
+  if (!resolvePath(classDir + "/" + name + "/device", &dir)) {
+    return;
+  }
+  entry->device = true;
+
+  for (int depth = 0; depth < TTY_INDEX_MAX_DEPTH && dir.size() > 1; depth++) {
+    if (readAttribute(dir, "idVendor", &entry->vendorId)) {
+      entry->usb = true;
+      readAttribute(dir, "idProduct", &entry->productId);
+      readAttribute(dir, "serial", &entry->serialNumber);
+      readAttribute(dir, "manufacturer", &entry->manufacturer);
+      // the USB device is named after the bus and the hub ports it hangs off, which stays put across re-enumeration
+      entry->locationId = dir.substr(dir.rfind('/') + 1);
+      return;
+    }
+    dir.resize(dir.rfind('/'));
+  }
+}
+
+// refresh() => { added, removed, ports }
+Napi::Value TtyIndex::refresh(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  DIR* dir = opendir(classDir.c_str());
+  if (nullptr == dir) {
+    throwErrno(env, errno, ("list " + classDir).c_str());
+    return env.Undefined();
+  }
+
+  for (auto& it : entries) {
+    it.second.seen = false;
+  }
+  uint32_t added = 0;
+  uint32_t removed = 0;
+  struct dirent* item;
+  while (nullptr != (item = readdir(dir))) {
+    if ('.' == item->d_name[0]) {
+      continue;
+    }
+    std::string name(item->d_name);
+    // class entries are links into /sys/devices, a readlink and a stat are enough to tell if the tty changed
+    char link[PATH_MAX];
+    ssize_t length = readlinkat(dirfd(dir), item->d_name, link, sizeof(link));
+    std::string target = length > 0 ? std::string(link, length) : name;
+    struct stat st;
+    if (0 != fstatat(dirfd(dir), item->d_name, &st, 0)) {
+      continue;  // went away while we were looking
+    }
+    auto it = entries.find(name);
+    if (it != entries.end() && it->second.target == target && it->second.ino == st.st_ino) {
+      it->second.seen = true;
+      continue;
+    }
+    TtyIndexEntry& entry = entries[name];
+    entry.target = target;
+    entry.ino = st.st_ino;
+    entry.seen = true;
+    readEntry(name, &entry);
+    added++;
+  }
+  closedir(dir);
+
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->second.seen) {
+      ++it;
+    } else {
+      it = entries.erase(it);
+      removed++;
+    }
+  }
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("added", Napi::Number::New(env, added));
+  result.Set("removed", Napi::Number::New(env, removed));
+  result.Set("ports", Napi::Number::New(env, entries.size()));
+  return result;
+}
+
+static bool matches(Napi::Object query, const char* key, const std::string& value) {
+  Napi::Value wanted = query.Get(key);
+  if (!wanted.IsString()) {
+    return true;
+  }
+  return wanted.As<Napi::String>().Utf8Value() == value;
+}
+
+static void setIfKnown(Napi::Object port, const char* key, const std::string& value) {
+  if (!value.empty()) {
+    port.Set(key, Napi::String::New(port.Env(), value));
+  }
+}
+
+// find({ serialNumber, locationId, vendorId, productId }) => [{ path, manufacturer, ... }]
+// Only looks at what the last refresh() found.
+Napi::Value TtyIndex::find(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsObject()) {
+    Napi::TypeError::New(env, "First argument must be an object").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Object query = info[0].As<Napi::Object>();
+
+  Napi::Array result = Napi::Array::New(env);
+  uint32_t count = 0;
+  for (auto& it : entries) {
+    const TtyIndexEntry& entry = it.second;
+    if (!entry.device) {
+      continue;
+    }
+    if (!matches(query, "serialNumber", entry.serialNumber) || !matches(query, "locationId", entry.locationId) ||
+        !matches(query, "vendorId", entry.vendorId) || !matches(query, "productId", entry.productId)) {
+      continue;
+    }
+    Napi::Object port = Napi::Object::New(env);
+    port.Set("path", Napi::String::New(env, devDir + "/" + it.first));
+    setIfKnown(port, "manufacturer", entry.manufacturer);
+    setIfKnown(port, "serialNumber", entry.serialNumber);
+    setIfKnown(port, "locationId", entry.locationId);
+    setIfKnown(port, "vendorId", entry.vendorId);
+    setIfKnown(port, "productId", entry.productId);
+    result.Set(count++, port);
+  }
+  return result;
+}
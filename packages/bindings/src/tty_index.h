@@ -0,0 +1,42 @@
+#ifndef PACKAGES_SERIALPORT_SRC_TTY_INDEX_H_
+#define PACKAGES_SERIALPORT_SRC_TTY_INDEX_H_
+
+#include <napi.h>
+#include <sys/types.h>
+#include <string>
+#include <unordered_map>
+
+struct TtyIndexEntry {
+  // the class entry's link and its inode, a tty that was re-created gets a new inode even at the same path
+  std::string target;
+  ino_t ino = 0;
+  bool device = false;
+  bool usb = false;
+  std::string manufacturer;
+  std::string serialNumber;
+  std::string locationId;
+  std::string vendorId;
+  std::string productId;
+  bool seen = false;
+};
+
+// Maps the sysfs attributes of each tty to its device node. refresh() lists the class directory and only reads
+// the attributes of ttys that appeared or were re-created since the last call, so it costs a readdir and a stat
+// per tty rather than a udev query.
+class TtyIndex : public Napi::ObjectWrap<TtyIndex> {
+ public:
+  TtyIndex(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+ private:
+  std::string classDir = "/sys/class/tty";
+  std::string devDir = "/dev";
+  std::unordered_map<std::string, TtyIndexEntry> entries;
+
+  void readEntry(const std::string& name, TtyIndexEntry* entry);
+
+  Napi::Value refresh(const Napi::CallbackInfo& info);
+  Napi::Value find(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_TTY_INDEX_H_
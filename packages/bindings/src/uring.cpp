@@ -0,0 +1,234 @@
+#include <napi.h>
+#include <uv.h>
+#include <poll.h>
+#include <string.h>
+#include "./serialport.h"
+#include "./uring.h"
+
+// user_data tags, ops are heap pointers so the low bits are free
+#define URING_TAG_POLL 1
+#define URING_TAG_CANCEL 2
+#define URING_TAG_MASK 3
+#define URING_REAP_BATCH 64
+
+Uring::Uring(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Uring>(info), env(info.Env()) {
+  unsigned entries = 256;
+  if (info[0].IsNumber()) {
+    entries = info[0].As<Napi::Number>().Uint32Value();
+  }
+
+  this->ring.reset(new IoUring());
+  int err = this->ring->setup(entries);
+  if (0 != err) {
+    this->ring.reset();
+    Napi::Error::New(env, uv_strerror(uv_translate_sys_error(-err))).ThrowAsJavaScriptException();
+    return;
+  }
+
+  this->poll_handle = new uv_poll_t();
+  memset(this->poll_handle, 0, sizeof(uv_poll_t));
+  poll_handle->data = this;
+  int status = uv_poll_init(getLoop(env), poll_handle, this->ring->eventFd());
+  if (0 != status) {
+    delete poll_handle;
+    poll_handle = nullptr;
+    Napi::Error::New(env, uv_strerror(status)).ThrowAsJavaScriptException();
+    return;
+  }
+  uv_poll_start(poll_handle, UV_READABLE, Uring::onCompletion);
+
+  this->prepare_handle = new uv_prepare_t();
+  uv_prepare_init(getLoop(env), prepare_handle);
+  prepare_handle->data = this;
+  updateRef();
+}
+
+Uring::~Uring() {
+  if (poll_handle) {
+    uv_poll_stop(poll_handle);
+    uv_close(reinterpret_cast<uv_handle_t*>(poll_handle), Uring::onClose);
+  }
+  if (prepare_handle) {
+    uv_prepare_stop(prepare_handle);
+    uv_close(reinterpret_cast<uv_handle_t*>(prepare_handle), Uring::onClose);
+  }
+  // tear the ring down before releasing the buffers the kernel may still be using
+  ring.reset();
+  for (UringOp* op : inflight) {
+    delete op;
+  }
+}
+
+void Uring::onClose(uv_handle_t* handle) {
+  if (UV_POLL == handle->type) {
+    delete reinterpret_cast<uv_poll_t*>(handle);
+  } else {
+    delete reinterpret_cast<uv_prepare_t*>(handle);
+  }
+}
+
+Napi::Object Uring::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "Uring", {
+    InstanceMethod("read", &Uring::read),
+    InstanceMethod("write", &Uring::write),
+    InstanceMethod("cancel", &Uring::cancel),
+  });
+
+  exports.Set("Uring", func);
+  return exports;
+}
+
+// The loop only stays alive while there is something in flight
+void Uring::updateRef() {
+  if (inflight.empty()) {
+    uv_unref(reinterpret_cast<uv_handle_t*>(poll_handle));
+  } else {
+    uv_ref(reinterpret_cast<uv_handle_t*>(poll_handle));
+  }
+}
+
+// Submissions are batched and handed to the kernel once per loop iteration, just before it blocks for I/O
+void Uring::scheduleSubmit() {
+  uv_prepare_start(prepare_handle, Uring::onPrepare);
+}
+
+void Uring::onPrepare(uv_prepare_t* handle) {
+  Uring* obj = static_cast<Uring*>(handle->data);
+  uv_prepare_stop(handle);
+  obj->ring->submit();
+}
+
+// Make room for a linked chain, the chain must not be split by a full queue
+int Uring::reserve(unsigned entries) {
+  if (ring->sqSpace() >= entries) {
+    return 0;
+  }
+  int submitted = ring->submit();
+  if (submitted < 0) {
+    return submitted;
+  }
+  return ring->sqSpace() >= entries ? 0 : -EBUSY;
+}
+
+void Uring::queue(const Napi::CallbackInfo& info, bool write) {
+  auto env = info.Env();
+
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  int fd = info[0].As<Napi::Number>().Int32Value();
+
+  if (!info[1].IsBuffer()) {
+    Napi::TypeError::New(env, "buffer must be a Buffer").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Buffer<char> buffer = info[1].As<Napi::Buffer<char>>();
+
+  if (!info[2].IsNumber() || !info[3].IsNumber()) {
+    Napi::TypeError::New(env, "offset and length must be ints").ThrowAsJavaScriptException();
+    return;
+  }
+  size_t offset = info[2].As<Napi::Number>().Uint32Value();
+  size_t length = info[3].As<Napi::Number>().Uint32Value();
+  if (offset + length > buffer.Length()) {
+    Napi::RangeError::New(env, "offset and length exceed the buffer").ThrowAsJavaScriptException();
+    return;
+  }
+
+  if (!info[4].IsFunction()) {
+    Napi::TypeError::New(env, "cb must be a function").ThrowAsJavaScriptException();
+    return;
+  }
+
+  int err = reserve(2);
+  if (0 != err) {
+    Napi::Error::New(env, uv_strerror(uv_translate_sys_error(-err))).ThrowAsJavaScriptException();
+    return;
+  }
+
+  UringOp* op = new UringOp();
+  op->fd = fd;
+  op->write = write;
+  op->buffer = Napi::Persistent(info[1].As<Napi::Object>());
+  op->callback.Reset(info[4].As<Napi::Function>(), 1);
+
+  // Wait for the tty to become ready and only then run the transfer, our fds are O_NONBLOCK
+  // so a bare read or write would just complete with EAGAIN
+  uint64_t userData = reinterpret_cast<uint64_t>(op);
+  ring->prepPoll(fd, write ? POLLOUT : POLLIN, userData | URING_TAG_POLL, true);
+  if (write) {
+    ring->prepWrite(fd, buffer.Data() + offset, length, userData);
+  } else {
+    ring->prepRead(fd, buffer.Data() + offset, length, userData);
+  }
+
+  inflight.insert(op);
+  updateRef();
+  scheduleSubmit();
+}
+
+void Uring::read(const Napi::CallbackInfo& info) {
+  queue(info, false);
+}
+
+void Uring::write(const Napi::CallbackInfo& info) {
+  queue(info, true);
+}
+
+// Cancels every read and write in flight for the fd, they complete with ECANCELED
+void Uring::cancel(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  if (!info[0].IsNumber()) {
+    Napi::TypeError::New(env, "fd must be an int").ThrowAsJavaScriptException();
+    return;
+  }
+  int fd = info[0].As<Napi::Number>().Int32Value();
+
+  for (UringOp* op : inflight) {
+    if (op->fd != fd) {
+      continue;
+    }
+    if (0 != reserve(2)) {
+      break;
+    }
+    uint64_t userData = reinterpret_cast<uint64_t>(op);
+    ring->prepCancel(userData | URING_TAG_POLL, URING_TAG_CANCEL);
+    ring->prepCancel(userData, URING_TAG_CANCEL);
+  }
+  // cancel right away so it lands before the fd is closed
+  ring->submit();
+}
+
+void Uring::complete(UringOp* op, int res) {
+  if (res < 0) {
+    Napi::Error err = errnoError(env, -res, op->write ? "cannot write" : "cannot read");
+    op->callback.Call({ err.Value(), env.Undefined() });
+  } else {
+    op->callback.Call({ env.Null(), Napi::Number::New(env, res) });
+  }
+}
+
+void Uring::onCompletion(uv_poll_t* handle, int status, int events) {
+  Uring* obj = static_cast<Uring*>(handle->data);
+  Napi::HandleScope scope(obj->env);
+  UringCompletion completions[URING_REAP_BATCH];
+
+  obj->ring->clearEvent();
+  size_t count;
+  do {
+    count = obj->ring->reap(completions, URING_REAP_BATCH);
+    for (size_t i = 0; i < count; i++) {
+      if (completions[i].userData & URING_TAG_MASK) {
+        // polls and cancels only matter through the linked transfer
+        continue;
+      }
+      UringOp* op = reinterpret_cast<UringOp*>(completions[i].userData);
+      obj->inflight.erase(op);
+      obj->complete(op, completions[i].res);
+      delete op;
+    }
+  } while (count == URING_REAP_BATCH);
+  obj->updateRef();
+}
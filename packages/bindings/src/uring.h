@@ -0,0 +1,44 @@
+#ifndef PACKAGES_SERIALPORT_SRC_URING_H_
+#define PACKAGES_SERIALPORT_SRC_URING_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <memory>
+#include <unordered_set>
+#include "./uring_linux.h"
+
+struct UringOp {
+  int fd = 0;
+  bool write = false;
+  Napi::ObjectReference buffer;
+  Napi::FunctionReference callback;
+};
+
+class Uring : public Napi::ObjectWrap<Uring> {
+ public:
+  Uring(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void onCompletion(uv_poll_t* handle, int status, int events);
+  static void onPrepare(uv_prepare_t* handle);
+  static void onClose(uv_handle_t* handle);
+  ~Uring();
+
+ private:
+  std::unique_ptr<IoUring> ring;
+  Napi::Env env;
+  uv_poll_t* poll_handle = nullptr;
+  uv_prepare_t* prepare_handle = nullptr;
+  std::unordered_set<UringOp*> inflight;
+
+  int reserve(unsigned entries);
+  void scheduleSubmit();
+  void updateRef();
+  void complete(UringOp* op, int res);
+  void queue(const Napi::CallbackInfo& info, bool write);
+
+  void read(const Napi::CallbackInfo& info);
+  void write(const Napi::CallbackInfo& info);
+  void cancel(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_URING_H_
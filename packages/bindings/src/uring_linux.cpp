@@ -0,0 +1,257 @@
+#include "./uring_linux.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// IORING_FEAT_POLL_32BITS arrived with the 5.9 headers, which also carry every opcode we use
+#if defined(IORING_FEAT_POLL_32BITS)
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <endian.h>
+#include <stdlib.h>
+
+#define URING_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define URING_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static int uringSetup(unsigned entries, struct io_uring_params* p) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0));
+}
+
+static int uringRegister(int fd, unsigned opcode, void* arg, unsigned nrArgs) {
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+IoUring::IoUring() {}
+
+IoUring::~IoUring() {
+  // closing the ring cancels everything still in flight
+  if (sqes) munmap(sqes, sqes_size);
+  if (cq_ptr && cq_ptr != sq_ptr) munmap(cq_ptr, cq_size);
+  if (sq_ptr) munmap(sq_ptr, sq_size);
+  if (-1 != ring_fd) close(ring_fd);
+  if (-1 != event_fd) close(event_fd);
+}
+
+int IoUring::setup(unsigned entries) {
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  ring_fd = uringSetup(entries, &p);
+  if (-1 == ring_fd) {
+    return -errno;
+  }
+
+  // Make sure the kernel knows every opcode we rely on, older kernels reject them per request
+  size_t probeSize = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+  struct io_uring_probe* probe = static_cast<struct io_uring_probe*>(calloc(1, probeSize));
+  if (!probe) {
+    return -ENOMEM;
+  }
+  int supported = 0 == uringRegister(ring_fd, IORING_REGISTER_PROBE, probe, 256);
+  const int ops[] = { IORING_OP_POLL_ADD, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_ASYNC_CANCEL };
+  for (int op : ops) {
+    supported = supported && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+  }
+  free(probe);
+  if (!supported) {
+    return -ENOSYS;
+  }
+
+  sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_size = cq_size = sq_size > cq_size ? sq_size : cq_size;
+  }
+
+  sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (MAP_FAILED == sq_ptr) {
+    sq_ptr = nullptr;
+    return -errno;
+  }
+
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ptr = sq_ptr;
+  } else {
+    cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    if (MAP_FAILED == cq_ptr) {
+      cq_ptr = nullptr;
+      return -errno;
+    }
+  }
+
+  sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (MAP_FAILED == sqes) {
+    sqes = nullptr;
+    return -errno;
+  }
+
+  char* sq = static_cast<char*>(sq_ptr);
+  sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+  sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+  sq_mask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+  sq_entries = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_entries);
+  sq_flags = reinterpret_cast<unsigned*>(sq + p.sq_off.flags);
+  sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+
+  char* cq = static_cast<char*>(cq_ptr);
+  cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+  cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+  cq_mask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+  cqes = cq + p.cq_off.cqes;
+
+  event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (-1 == event_fd) {
+    return -errno;
+  }
+  if (-1 == uringRegister(ring_fd, IORING_REGISTER_EVENTFD, &event_fd, 1)) {
+    return -errno;
+  }
+  return 0;
+}
+
+unsigned IoUring::sqSpace() const {
+  return *sq_entries - (*sq_tail - URING_LOAD_ACQUIRE(sq_head));
+}
+
+void* IoUring::getSqe() {
+  if (0 == sqSpace()) {
+    return nullptr;
+  }
+  unsigned tail = *sq_tail;
+  unsigned index = tail & *sq_mask;
+  struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array[index] = index;
+  URING_STORE_RELEASE(sq_tail, tail + 1);
+  pending++;
+  return sqe;
+}
+
+int IoUring::prepPoll(int fd, uint32_t events, uint64_t userData, bool link) {
+  struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(getSqe());
+  if (!sqe) {
+    return -EBUSY;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+#if __BYTE_ORDER == __BIG_ENDIAN
+  events = (events << 16) | (events >> 16);
+#endif
+  sqe->poll32_events = events;
+  sqe->user_data = userData;
+  if (link) {
+    sqe->flags |= IOSQE_IO_LINK;
+  }
+  return 0;
+}
+
+int IoUring::prepRead(int fd, void* buf, unsigned len, uint64_t userData) {
+  struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(getSqe());
+  if (!sqe) {
+    return -EBUSY;
+  }
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf);
+  sqe->len = len;
+  // ttys are not seekable, -1 means use (and ignore) the file position
+  sqe->off = static_cast<uint64_t>(-1);
+  sqe->user_data = userData;
+  return 0;
+}
+
+int IoUring::prepWrite(int fd, const void* buf, unsigned len, uint64_t userData) {
+  struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(getSqe());
+  if (!sqe) {
+    return -EBUSY;
+  }
+  sqe->opcode = IORING_OP_WRITE;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf);
+  sqe->len = len;
+  sqe->off = static_cast<uint64_t>(-1);
+  sqe->user_data = userData;
+  return 0;
+}
+
+int IoUring::prepCancel(uint64_t target, uint64_t userData) {
+  struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(getSqe());
+  if (!sqe) {
+    return -EBUSY;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = target;
+  sqe->user_data = userData;
+  return 0;
+}
+
+int IoUring::submit() {
+  if (0 == pending) {
+    return 0;
+  }
+  int submitted = uringEnter(ring_fd, pending, 0, 0);
+  if (-1 == submitted) {
+    return -errno;
+  }
+  pending -= submitted;
+  return submitted;
+}
+
+size_t IoUring::reap(UringCompletion* out, size_t max) {
+  size_t count = 0;
+  unsigned head = *cq_head;
+  unsigned tail = URING_LOAD_ACQUIRE(cq_tail);
+
+  // completions the kernel could not fit are flushed into the ring by entering it
+  if (head == tail && (URING_LOAD_ACQUIRE(sq_flags) & IORING_SQ_CQ_OVERFLOW)) {
+    uringEnter(ring_fd, 0, 0, IORING_ENTER_GETEVENTS);
+    tail = URING_LOAD_ACQUIRE(cq_tail);
+  }
+
+  while (head != tail && count < max) {
+    struct io_uring_cqe* cqe = static_cast<struct io_uring_cqe*>(cqes) + (head & *cq_mask);
+    out[count].userData = cqe->user_data;
+    out[count].res = cqe->res;
+    count++;
+    head++;
+  }
+  URING_STORE_RELEASE(cq_head, head);
+  return count;
+}
+
+void IoUring::clearEvent() {
+  uint64_t value;
+  ssize_t ignored = read(event_fd, &value, sizeof(value));
+  (void)ignored;
+}
+
+#else
+
+IoUring::IoUring() {}
+IoUring::~IoUring() {}
+int IoUring::setup(unsigned entries) { return -ENOSYS; }
+unsigned IoUring::sqSpace() const { return 0; }
+void* IoUring::getSqe() { return nullptr; }
+int IoUring::prepPoll(int fd, uint32_t events, uint64_t userData, bool link) { return -ENOSYS; }
+int IoUring::prepRead(int fd, void* buf, unsigned len, uint64_t userData) { return -ENOSYS; }
+int IoUring::prepWrite(int fd, const void* buf, unsigned len, uint64_t userData) { return -ENOSYS; }
+int IoUring::prepCancel(uint64_t target, uint64_t userData) { return -ENOSYS; }
+int IoUring::submit() { return -ENOSYS; }
+size_t IoUring::reap(UringCompletion* out, size_t max) { return 0; }
+void IoUring::clearEvent() {}
+
+#endif
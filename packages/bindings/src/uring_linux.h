@@ -0,0 +1,60 @@
+#ifndef PACKAGES_SERIALPORT_SRC_URING_LINUX_H_
+#define PACKAGES_SERIALPORT_SRC_URING_LINUX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct UringCompletion {
+  uint64_t userData;
+  int32_t res;
+};
+
+// A minimal io_uring submission/completion queue talking to the kernel with raw syscalls.
+// Completions are signalled on an eventfd so they can be reaped from an event loop.
+class IoUring {
+ public:
+  IoUring();
+  ~IoUring();
+
+  // returns 0 or a negative errno, -ENOSYS when io_uring or a required opcode is unavailable
+  int setup(unsigned entries);
+  int eventFd() const { return event_fd; }
+  unsigned sqSpace() const;
+
+  int prepPoll(int fd, uint32_t events, uint64_t userData, bool link);
+  int prepRead(int fd, void* buf, unsigned len, uint64_t userData);
+  int prepWrite(int fd, const void* buf, unsigned len, uint64_t userData);
+  int prepCancel(uint64_t target, uint64_t userData);
+
+  // returns the number of submitted entries or a negative errno
+  int submit();
+  size_t reap(UringCompletion* out, size_t max);
+  void clearEvent();
+
+ private:
+  void* getSqe();
+
+  int ring_fd = -1;
+  int event_fd = -1;
+  unsigned pending = 0;
+
+  void* sq_ptr = nullptr;
+  size_t sq_size = 0;
+  void* cq_ptr = nullptr;
+  size_t cq_size = 0;
+  void* sqes = nullptr;
+  size_t sqes_size = 0;
+
+  unsigned* sq_head = nullptr;
+  unsigned* sq_tail = nullptr;
+  unsigned* sq_mask = nullptr;
+  unsigned* sq_entries = nullptr;
+  unsigned* sq_flags = nullptr;
+  unsigned* sq_array = nullptr;
+  unsigned* cq_head = nullptr;
+  unsigned* cq_tail = nullptr;
+  unsigned* cq_mask = nullptr;
+  void* cqes = nullptr;
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_URING_LINUX_H_
@@ -0,0 +1,326 @@
+#include <napi.h>
+#include <uv.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <math.h>
+#include "./serialport.h"
+#include "./virtual_port.h"
+
+// Stop reading the port while this much is waiting to be echoed back
+#define VIRTUAL_PORT_MAX_ECHO (1 << 20)
+// How long to back off when the master end reports a hang up
+#define VIRTUAL_PORT_HANGUP_BACKOFF_MS 10
+
+VirtualPort::VirtualPort(const Napi::CallbackInfo& info) : Napi::ObjectWrap<VirtualPort>(info) {
+  Napi::Env env = info.Env();
+
+  if (!info[0].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return;
+  }
+  this->echo = info[0].As<Napi::Object>().Get("echo").ToBoolean();
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0) {
+    throwErrno(env, errno, "open a pseudo terminal");
+    return;
+  }
+  fcntl(master, F_SETFD, FD_CLOEXEC);
+  char path[256];
+#ifdef __linux__
+  int err = (grantpt(master) || unlockpt(master) || ptsname_r(master, path, sizeof(path))) ? errno : 0;
+#else
+  const char* name = nullptr;
+  int err = (grantpt(master) || unlockpt(master) || !(name = ptsname(master))) ? errno : 0;
+  if (!err) {
+    snprintf(path, sizeof(path), "%s", name);
+  }
+#endif
+  if (err) {
+    closeFds();
+    throwErrno(env, err, "set up the pseudo terminal");
+    return;
+  }
+
+  slave = ::open(path, O_RDWR | O_NOCTTY);
+  if (slave < 0) {
+    err = errno;
+    closeFds();
+    throwErrno(env, err, "open the pseudo terminal");
+    return;
+  }
+  fcntl(slave, F_SETFD, FD_CLOEXEC);
+  // no echo or line editing until a binding sets the port up
+  struct termios options;
+  if (tcgetattr(slave, &options) == 0) {
+    cfmakeraw(&options);
+    tcsetattr(slave, TCSANOW, &options);
+  }
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  if (0 != pipe(wake_fds)) {
+    err = errno;
+    closeFds();
+    throwErrno(env, err, "create a pipe");
+    return;
+  }
+  fcntl(wake_fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_fds[1], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_fds[0], F_SETFL, fcntl(wake_fds[0], F_GETFL) | O_NONBLOCK);
+
+  uv_mutex_init(&mutex);
+  running = true;
+  if (0 != uv_thread_create(&thread, VirtualPort::run, this)) {
+    running = false;
+    uv_mutex_destroy(&mutex);
+    closeFds();
+    Napi::Error::New(env, "Error: cannot start the virtual port thread").ThrowAsJavaScriptException();
+    return;
+  }
+  info.This().As<Napi::Object>().Set("path", Napi::String::New(env, path));
+}
+
+VirtualPort::~VirtualPort() {
+  stopThread();
+  closeFds();
+}
+
+Napi::Object VirtualPort::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "VirtualPort", {
+    InstanceMethod("start", &VirtualPort::start),
+    InstanceMethod("stop", &VirtualPort::stop),
+    InstanceMethod("stats", &VirtualPort::stats),
+    InstanceMethod("close", &VirtualPort::close),
+  });
+
+  exports.Set("VirtualPort", func);
+  return exports;
+}
+
+void VirtualPort::run(void* arg) {
+  static_cast<VirtualPort*>(arg)->loop();
+}
+
+// Echoes take priority over generated traffic, reading never stops for either unless the echo backlog is full
+void VirtualPort::loop() {
+  uint8_t buffer[VIRTUAL_PORT_MAX_CHUNK];
+  std::vector<uint8_t> echoed;
+
+  for (;;) {
+    // how much the generator may write now, and if that's nothing how long until it may
+    size_t allowed = 0;
+    int timeout = -1;
+    uv_mutex_lock(&mutex);
+    if (generating) {
+      allowed = chunkSize;
+      if (limit && limit - generated < allowed) {
+        allowed = static_cast<size_t>(limit - generated);
+      }
+      if (rate > 0) {
+        double due = rate * static_cast<double>(uv_hrtime() - startedAt) / 1e9 - static_cast<double>(generated);
+        if (due < static_cast<double>(allowed)) {
+          // chunks go out whole, wait until all of the next one is due
+          timeout = static_cast<int>(ceil((static_cast<double>(allowed) - due) * 1000 / rate));
+          timeout = timeout < 1 ? 1 : timeout;
+          allowed = 0;
+        }
+      }
+    }
+    uv_mutex_unlock(&mutex);
+
+    struct pollfd fds[2];
+    fds[0].fd = wake_fds[0];
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = master;
+    fds[1].events = (echoed.size() < VIRTUAL_PORT_MAX_ECHO ? POLLIN : 0) | (allowed || !echoed.empty() ? POLLOUT : 0);
+    fds[1].revents = 0;
+    int ready = poll(fds, 2, timeout);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready < 0) {
+      __atomic_store_n(&error, errno, __ATOMIC_RELAXED);
+      return;
+    }
+    if (fds[0].revents) {
+      char drained[16];
+      while (::read(wake_fds[0], drained, sizeof(drained)) > 0) {
+      }
+      if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        return;
+      }
+      continue;
+    }
+    if (fds[1].revents & POLLNVAL) {
+      __atomic_store_n(&error, EBADF, __ATOMIC_RELAXED);
+      return;
+    }
+    if (fds[1].revents & POLLIN) {
+      ssize_t bytesRead = ::read(master, buffer, sizeof(buffer));
+      if (bytesRead > 0) {
+        __atomic_fetch_add(&bytesReceived, static_cast<uint64_t>(bytesRead), __ATOMIC_RELAXED);
+        if (echo) {
+          echoed.insert(echoed.end(), buffer, buffer + bytesRead);
+        }
+      }
+    } else if (fds[1].revents & (POLLHUP | POLLERR)) {
+      // nothing to read, don't spin until the tty side is usable again
+      struct pollfd stopped = { wake_fds[0], POLLIN, 0 };
+      poll(&stopped, 1, VIRTUAL_PORT_HANGUP_BACKOFF_MS);
+      continue;
+    }
+    if (!(fds[1].revents & POLLOUT)) {
+      continue;
+    }
+    if (!echoed.empty()) {
+      ssize_t written = ::write(master, echoed.data(), echoed.size());
+      if (written > 0) {
+        echoed.erase(echoed.begin(), echoed.begin() + written);
+        __atomic_fetch_add(&bytesSent, static_cast<uint64_t>(written), __ATOMIC_RELAXED);
+        __atomic_fetch_add(&writes, 1, __ATOMIC_RELAXED);
+      }
+      continue;
+    }
+
+    // start() may swap the pattern, copy the chunk out under the lock
+    uv_mutex_lock(&mutex);
+    if (!generating || pattern.empty()) {
+      uv_mutex_unlock(&mutex);
+      continue;
+    }
+    for (size_t copied = 0; copied < allowed;) {
+      size_t length = pattern.size() - patternOffset;
+      length = length < allowed - copied ? length : allowed - copied;
+      memcpy(buffer + copied, pattern.data() + patternOffset, length);
+      copied += length;
+      patternOffset = (patternOffset + length) % pattern.size();
+    }
+    uv_mutex_unlock(&mutex);
+
+    ssize_t written = ::write(master, buffer, allowed);
+    if (written < 0) {
+      written = 0;
+    }
+    uv_mutex_lock(&mutex);
+    // whatever didn't fit goes first in the next chunk
+    patternOffset = (patternOffset + pattern.size() - (allowed - written) % pattern.size()) % pattern.size();
+    generated += written;
+    if (limit && generated >= limit) {
+      generating = false;
+    }
+    uv_mutex_unlock(&mutex);
+    if (written > 0) {
+      __atomic_fetch_add(&bytesSent, static_cast<uint64_t>(written), __ATOMIC_RELAXED);
+      __atomic_fetch_add(&writes, 1, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+void VirtualPort::wake() {
+  char byte = 0;
+  ssize_t written;
+  do {
+    written = ::write(wake_fds[1], &byte, 1);
+  } while (written < 0 && errno == EINTR);
+}
+
+void VirtualPort::stopThread() {
+  if (!running) {
+    return;
+  }
+  __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+  wake();
+  uv_thread_join(&thread);
+  uv_mutex_destroy(&mutex);
+}
+
+void VirtualPort::closeFds() {
+  int* fds[] = { &master, &slave, &wake_fds[0], &wake_fds[1] };
+  for (int* fd : fds) {
+    if (*fd >= 0) {
+      ::close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+// start({ pattern, rate, chunkSize, limit }), replaces whatever was being generated
+Napi::Value VirtualPort::start(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!running) {
+    Napi::Error::New(env, "Virtual port is closed").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!info[0].IsObject()) {
+    Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Object options = info[0].As<Napi::Object>();
+  Napi::Value patternValue = options.Get("pattern");
+  if (!patternValue.IsBuffer() || patternValue.As<Napi::Buffer<uint8_t>>().Length() == 0) {
+    Napi::TypeError::New(env, "pattern must be a Buffer with data").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Buffer<uint8_t> source = patternValue.As<Napi::Buffer<uint8_t>>();
+  uint32_t chunk = options.Get("chunkSize").ToNumber().Uint32Value();
+  if (chunk < 1 || chunk > VIRTUAL_PORT_MAX_CHUNK) {
+    Napi::RangeError::New(env, "chunkSize must be between 1 and 65536").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  uv_mutex_lock(&mutex);
+  pattern.assign(source.Data(), source.Data() + source.Length());
+  patternOffset = 0;
+  rate = options.Get("rate").ToNumber().DoubleValue();
+  chunkSize = chunk;
+  limit = static_cast<uint64_t>(options.Get("limit").ToNumber().DoubleValue());
+  startedAt = uv_hrtime();
+  generated = 0;
+  generating = true;
+  uv_mutex_unlock(&mutex);
+  wake();
+  return env.Undefined();
+}
+
+void VirtualPort::stop(const Napi::CallbackInfo& info) {
+  if (!running) {
+    return;
+  }
+  uv_mutex_lock(&mutex);
+  generating = false;
+  uv_mutex_unlock(&mutex);
+  wake();
+}
+
+Napi::Value VirtualPort::stats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  bool active = false;
+  if (running) {
+    uv_mutex_lock(&mutex);
+    active = generating;
+    uv_mutex_unlock(&mutex);
+  }
+  stats.Set("generating", Napi::Boolean::New(env, active));
+  stats.Set("bytesSent", Napi::Number::New(env, static_cast<double>(__atomic_load_n(&bytesSent, __ATOMIC_RELAXED))));
+  stats.Set("bytesReceived",
+    Napi::Number::New(env, static_cast<double>(__atomic_load_n(&bytesReceived, __ATOMIC_RELAXED))));
+  stats.Set("writes", Napi::Number::New(env, static_cast<double>(__atomic_load_n(&writes, __ATOMIC_RELAXED))));
+  int err = __atomic_load_n(&error, __ATOMIC_RELAXED);
+  if (err) {
+    stats.Set("error", Napi::String::New(env, uv_err_name(uv_translate_sys_error(err))));
+  }
+  return stats;
+}
+
+// Stops the thread and hangs up, a binding with the port open sees the device go away
+void VirtualPort::close(const Napi::CallbackInfo& info) {
+  stopThread();
+  closeFds();
+}
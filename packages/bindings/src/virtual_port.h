@@ -0,0 +1,58 @@
+#ifndef PACKAGES_SERIALPORT_SRC_VIRTUAL_PORT_H_
+#define PACKAGES_SERIALPORT_SRC_VIRTUAL_PORT_H_
+
+#include <napi.h>
+#include <uv.h>
+#include <stdint.h>
+#include <vector>
+
+#define VIRTUAL_PORT_MAX_CHUNK 65536
+
+// The device end of a pseudo terminal. The other end is a tty any binding can open, a thread of its own generates
+// traffic into it and reads (or echoes) whatever is written to it.
+class VirtualPort : public Napi::ObjectWrap<VirtualPort> {
+ public:
+  VirtualPort(const Napi::CallbackInfo& info);
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static void run(void* arg);
+  ~VirtualPort();
+
+ private:
+  int master = -1;
+  // held open so the master doesn't see a hang up while no binding has the port open
+  int slave = -1;
+  bool echo = false;
+
+  int wake_fds[2] = { -1, -1 };
+  uv_thread_t thread;
+  bool running = false;
+
+  // generator settings, shared with the thread
+  uv_mutex_t mutex;
+  std::vector<uint8_t> pattern;
+  size_t patternOffset = 0;
+  double rate = 0;
+  size_t chunkSize = 0;
+  uint64_t limit = 0;
+  uint64_t startedAt = 0;
+  uint64_t generated = 0;
+  bool generating = false;
+
+  // counters, only written by the thread
+  uint64_t bytesSent = 0;
+  uint64_t bytesReceived = 0;
+  uint64_t writes = 0;
+  int error = 0;
+
+  void loop();
+  void wake();
+  void stopThread();
+  void closeFds();
+
+  Napi::Value start(const Napi::CallbackInfo& info);
+  void stop(const Napi::CallbackInfo& info);
+  Napi::Value stats(const Napi::CallbackInfo& info);
+  void close(const Napi::CallbackInfo& info);
+};
+
+#endif  // PACKAGES_SERIALPORT_SRC_VIRTUAL_PORT_H_
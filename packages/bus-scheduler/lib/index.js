@@ -0,0 +1,436 @@
+const EventEmitter = require('events')
+const debug = require('debug')('serialport/bus-scheduler')
+
+const now = () => {
+  const [seconds, nanoseconds] = process.hrtime()
+  return seconds * 1e3 + nanoseconds / 1e6
+}
+
+// bits on the wire per character, start bit included
+const charBits = ({ dataBits = 8, parity = 'none', stopBits = 1 }) => 1 + dataBits + (parity === 'none' ? 0 : 1) + stopBits
+
+/**
+ * The length of the complete response at the start of `data`, 0 while it's incomplete
+ * @param {object|Function} until `{ delimiter }`, `{ length }`, `{ lengthField: { offset, size, littleEndian, adjust } }` or a function that gets the bytes so far and returns the same
+ * @param {Buffer} data the bytes received so far
+ * @returns {number} the response length
+ */
+const matchResponse = (until, data) => {
+  if (typeof until === 'function') {
+    return until(data) || 0
+  }
+  if (until.delimiter !== undefined) {
+    const delimiter = Buffer.from(until.delimiter)
+    const position = data.indexOf(delimiter)
+    return position === -1 ? 0 : position + delimiter.length
+  }
+  if (until.length !== undefined) {
+    return data.length >= until.length ? until.length : 0
+  }
+  const { offset = 0, size = 1, littleEndian = false, adjust = 0 } = until.lengthField
+  if (data.length < offset + size) {
+    return 0
+  }
+  const length = littleEndian ? data.readUIntLE(offset, size) : data.readUIntBE(offset, size)
+  const total = offset + size + length + adjust
+  return data.length >= total ? total : 0
+}
+
+const validateUntil = until => {
+  if (typeof until === 'function') {
+    return
+  }
+  if (!until || (until.delimiter === undefined && until.length === undefined && !until.lengthField)) {
+    throw new TypeError('"until" needs a "delimiter", "length", "lengthField" or to be a function')
+  }
+}
+
+const timeoutError = (job, timeoutMs, received) => {
+  const err = new Error(`Slave ${job.slave} did not respond within ${Math.round(timeoutMs)}ms`)
+  err.code = 'ETIMEDOUT'
+  err.response = received
+  return err
+}
+
+/**
+ * Runs request/response transactions on a shared half-duplex bus, one at a time with a turnaround gap between them. Periodic polls and on-demand requests share one queue ordered by priority, a slave that keeps failing is polled less and less often until it answers again.
+ * @extends EventEmitter
+ * @emits response `{ name, slave, request, response, latencyMs, attempts }` for each periodic poll that got an answer
+ * @emits failure an `Error` with `slave` and `task` for each periodic poll that ran out of retries
+ */
+class BusScheduler extends EventEmitter {
+  /**
+   * @param {SerialPort} port an open or opening port, the scheduler owns it from now on
+   * @param {object} [options]
+   * @param {number} [options.timeoutMs=100] default time a slave gets to answer, on top of the time the request takes on the wire
+   * @param {number} [options.retries=2] default number of retries before a transaction fails
+   * @param {number} [options.backoffMs=100] a slave that failed isn't polled again for this long, doubling on every further failure
+   * @param {number} [options.maxBackoffMs=10000] the longest a failing slave goes unpolled
+   * @param {number} [options.turnaroundMs] idle time between transactions, by default `interFrameChars` character times or `minTurnaroundMs`, whichever is longer
+   * @param {number} [options.interFrameChars=3.5] idle characters between transactions, 3.5 is the Modbus RTU frame gap
+   * @param {number} [options.minTurnaroundMs=1.75] lower bound of the computed turnaround, Modbus RTU's gap above 19200 baud
+   * @param {boolean} [options.native=true] use the binding's native `transact()` when it has one
+   */
+  constructor(port, options = {}) {
+    super()
+    if (!port) {
+      throw new TypeError('"port" is required')
+    }
+    this.port = port
+    this.options = {
+      timeoutMs: 100,
+      retries: 2,
+      backoffMs: 100,
+      maxBackoffMs: 10000,
+      interFrameChars: 3.5,
+      minTurnaroundMs: 1.75,
+      native: true,
+      ...options,
+    }
+    this.slaves = new Map()
+    this.periodic = []
+    this.pending = []
+    this.running = false
+    this.busy = false
+    this.timer = null
+    this.busFreeAt = 0
+    this.startedAt = 0
+    this.busyMs = 0
+  }
+
+  /**
+   * The time one character takes on the wire at the port's current settings
+   */
+  get charMs() {
+    const settings = this.port.settings || {}
+    const baudRate = settings.baudRate || this.port.baudRate || 9600
+    return (charBits(settings) * 1000) / baudRate
+  }
+
+  get turnaroundMs() {
+    if (this.options.turnaroundMs !== undefined) {
+      return this.options.turnaroundMs
+    }
+    return Math.max(this.options.interFrameChars * this.charMs, this.options.minTurnaroundMs)
+  }
+
+  /**
+   * Overrides the defaults for one slave
+   * @param {*} id the slave address or any other key
+   * @param {object} [options] `timeoutMs`, `retries` and `backoffMs`
+   * @returns {BusScheduler} itself
+   */
+  addSlave(id, options = {}) {
+    const slave = this.slave(id)
+    Object.assign(slave.options, options)
+    return this
+  }
+
+  slave(id) {
+    if (!this.slaves.has(id)) {
+      this.slaves.set(id, {
+        id,
+        options: {},
+        backoffMs: 0,
+        offlineUntil: 0,
+        stats: {
+          requests: 0,
+          responses: 0,
+          timeouts: 0,
+          errors: 0,
+          retries: 0,
+          failures: 0,
+          latency: { count: 0, totalMs: 0, minMs: Infinity, maxMs: 0, lastMs: 0 },
+        },
+      })
+    }
+    return this.slaves.get(id)
+  }
+
+  slaveOption(slave, name) {
+    return slave.options[name] !== undefined ? slave.options[name] : this.options[name]
+  }
+
+  /**
+   * Polls a slave on an interval
+   * @param {object} task
+   * @param {string} task.name identifies the poll in events and `removePeriodic()`
+   * @param {*} task.slave the slave id
+   * @param {Buffer|Function} task.request the request, or a function returning a fresh one for each poll
+   * @param {object|Function} task.until when the response is complete, see `matchResponse()`
+   * @param {number} task.intervalMs time between the start of polls, a poll that is late runs as soon as the bus is free but doesn't catch up on missed ones
+   * @param {number} [task.priority=0] higher runs first
+   * @returns {BusScheduler} itself
+   */
+  addPeriodic({ name, slave, request, until, intervalMs, priority = 0 }) {
+    if (typeof intervalMs !== 'number' || intervalMs <= 0) {
+      throw new TypeError('"intervalMs" must be a positive number')
+    }
+    if (!request) {
+      throw new TypeError('"request" is required')
+    }
+    validateUntil(until)
+    this.slave(slave)
+    this.periodic.push({ name, slave, request, until, intervalMs, priority, nextDue: now(), inFlight: false })
+    this.schedule()
+    return this
+  }
+
+  removePeriodic(name) {
+    this.periodic = this.periodic.filter(task => task.name !== name)
+  }
+
+  /**
+   * Queues a one off transaction, it goes ahead of periodic polls with the same priority
+   * @param {object} transaction `slave`, `request`, `until`, `priority` and optionally `timeoutMs` and `retries` like `addPeriodic()`
+   * @returns {Promise<Buffer>} Resolves with the response
+   */
+  request({ slave, request, until, priority = 0, timeoutMs, retries }) {
+    if (!Buffer.isBuffer(request)) {
+      return Promise.reject(new TypeError('"request" is not a Buffer'))
+    }
+    try {
+      validateUntil(until)
+    } catch (err) {
+      return Promise.reject(err)
+    }
+    this.slave(slave)
+    return new Promise((resolve, reject) => {
+      // on-demand requests sort ahead of periodic polls that became due at the same time
+      this.pending.push({ slave, request, until, priority, timeoutMs, retries, resolve, reject, dueAt: -Infinity, attempts: 0 })
+      this.schedule()
+    })
+  }
+
+  start() {
+    if (this.running) {
+      return
+    }
+    debug('starting')
+    this.running = true
+    this.startedAt = now()
+    this.busyMs = 0
+    this.schedule()
+  }
+
+  /**
+   * Stops after the transaction in progress, queued requests stay queued until `start()`
+   */
+  stop() {
+    debug('stopping')
+    this.running = false
+    clearTimeout(this.timer)
+    this.timer = null
+  }
+
+  // Picks the next job that can run right now
+  next(time) {
+    let best = null
+    const consider = job => {
+      if (!best || job.priority > best.priority || (job.priority === best.priority && job.dueAt < best.dueAt)) {
+        best = job
+      }
+    }
+    this.pending.forEach(consider)
+    this.periodic.forEach(task => {
+      if (!task.inFlight && task.nextDue <= time && this.slave(task.slave).offlineUntil <= time) {
+        consider({ task, slave: task.slave, request: task.request, until: task.until, priority: task.priority, dueAt: task.nextDue, attempts: 0 })
+      }
+    })
+    const index = this.pending.indexOf(best)
+    if (index !== -1) {
+      this.pending.splice(index, 1)
+    }
+    return best
+  }
+
+  // The earliest time a periodic poll becomes due
+  nextWake() {
+    return this.periodic.reduce((earliest, task) => {
+      if (task.inFlight) {
+        return earliest
+      }
+      return Math.min(earliest, Math.max(task.nextDue, this.slave(task.slave).offlineUntil))
+    }, Infinity)
+  }
+
+  schedule() {
+    if (!this.running || this.busy) {
+      return
+    }
+    clearTimeout(this.timer)
+    this.timer = null
+    const time = now()
+    if (time < this.busFreeAt) {
+      this.timer = setTimeout(() => this.schedule(), this.busFreeAt - time)
+      return
+    }
+    const job = this.next(time)
+    if (job) {
+      this.execute(job)
+      return
+    }
+    const wake = this.nextWake()
+    if (wake !== Infinity) {
+      this.timer = setTimeout(() => this.schedule(), Math.max(0, wake - time))
+    }
+  }
+
+  async execute(job) {
+    const slave = this.slave(job.slave)
+    const { stats } = slave
+    const timeoutMs = job.timeoutMs !== undefined ? job.timeoutMs : this.slaveOption(slave, 'timeoutMs')
+    const retries = job.retries !== undefined ? job.retries : this.slaveOption(slave, 'retries')
+    const request = typeof job.request === 'function' ? job.request() : job.request
+    this.busy = true
+    if (job.task) {
+      job.task.inFlight = true
+    }
+    job.attempts++
+    stats.requests++
+    const started = now()
+    let response = null
+    let error = null
+    try {
+      response = await this.exchange(job, request, timeoutMs + this.charMs * request.length)
+    } catch (err) {
+      error = err
+    }
+    if (!response && !error) {
+      error = new Error('No response')
+    }
+    const finished = now()
+    this.busyMs += finished - started
+    this.busy = false
+    this.busFreeAt = finished + this.turnaroundMs
+
+    if (response) {
+      const latencyMs = finished - started
+      const { latency } = stats
+      stats.responses++
+      latency.count++
+      latency.totalMs += latencyMs
+      latency.minMs = Math.min(latency.minMs, latencyMs)
+      latency.maxMs = Math.max(latency.maxMs, latencyMs)
+      latency.lastMs = latencyMs
+      slave.backoffMs = 0
+      slave.offlineUntil = 0
+      this.finish(job, null, { name: job.task && job.task.name, slave: job.slave, request, response, latencyMs, attempts: job.attempts })
+    } else {
+      if (error.code === 'ETIMEDOUT') {
+        stats.timeouts++
+      } else {
+        stats.errors++
+      }
+      if (job.attempts <= retries && this.port.isOpen) {
+        debug('retrying', job.slave, error.message)
+        stats.retries++
+        // retries go first so a slow answer isn't mistaken for the next poll's
+        this.pending.unshift({ ...job, priority: Infinity })
+      } else {
+        stats.failures++
+        slave.backoffMs = slave.backoffMs
+          ? Math.min(slave.backoffMs * 2, this.options.maxBackoffMs)
+          : Math.min(this.slaveOption(slave, 'backoffMs'), this.options.maxBackoffMs)
+        slave.offlineUntil = finished + slave.backoffMs
+        debug('slave', job.slave, 'failed, backing off for', slave.backoffMs, 'ms')
+        error.slave = job.slave
+        error.task = job.task ? job.task.name : undefined
+        this.finish(job, error)
+      }
+    }
+    this.schedule()
+  }
+
+  finish(job, err, result) {
+    if (job.task) {
+      const task = job.task
+      task.inFlight = false
+      task.nextDue = Math.max(task.nextDue + task.intervalMs, now())
+      if (err) {
+        this.emit('failure', err)
+      } else {
+        this.emit('response', result)
+      }
+      return
+    }
+    if (err) {
+      job.reject(err)
+    } else {
+      job.resolve(result.response)
+    }
+  }
+
+  exchange(job, request, timeoutMs) {
+    const { binding } = this.port
+    if (this.options.native && binding && typeof binding.transact === 'function' && typeof job.until !== 'function') {
+      // resolves with the response itself, anything read after it stays with the binding
+      return binding.transact(request, { until: job.until, timeoutMs: Math.ceil(timeoutMs) })
+    }
+    return new Promise((resolve, reject) => {
+      let received = Buffer.alloc(0)
+      const cleanup = () => {
+        clearTimeout(timer)
+        this.port.removeListener('data', onData)
+        this.port.removeListener('close', onClose)
+      }
+      const onData = data => {
+        received = Buffer.concat([received, data])
+        const length = matchResponse(job.until, received)
+        if (length > 0) {
+          cleanup()
+          resolve(received.slice(0, length))
+        }
+      }
+      const onClose = () => {
+        cleanup()
+        reject(new Error('Port closed'))
+      }
+      const timer = setTimeout(() => {
+        cleanup()
+        reject(timeoutError(job, timeoutMs, received))
+      }, timeoutMs)
+      this.port.on('data', onData)
+      this.port.once('close', onClose)
+      this.port.write(request, err => {
+        if (err) {
+          cleanup()
+          reject(err)
+        }
+      })
+    })
+  }
+
+  /**
+   * @returns {object} `utilization` is the share of the time since `start()` spent in transactions, `slaves` holds counters and latency per slave
+   */
+  stats() {
+    const elapsedMs = this.startedAt ? now() - this.startedAt : 0
+    const slaves = {}
+    this.slaves.forEach(({ id, stats, backoffMs }) => {
+      const { latency } = stats
+      slaves[id] = {
+        ...stats,
+        backoffMs,
+        latency: {
+          minMs: latency.count ? latency.minMs : 0,
+          maxMs: latency.maxMs,
+          meanMs: latency.count ? latency.totalMs / latency.count : 0,
+          lastMs: latency.lastMs,
+        },
+      }
+    })
+    return {
+      elapsedMs,
+      busyMs: this.busyMs,
+      utilization: elapsedMs ? Math.min(1, this.busyMs / elapsedMs) : 0,
+      turnaroundMs: this.turnaroundMs,
+      queued: this.pending.length,
+      slaves,
+    }
+  }
+}
+
+BusScheduler.matchResponse = matchResponse
+
+module.exports = BusScheduler
@@ -0,0 +1,208 @@
+const SerialPort = require('@serialport/stream')
+const MockBinding = require('@serialport/binding-mock')
+const BusScheduler = require('../')
+
+SerialPort.Binding = MockBinding
+
+const until = { delimiter: '\n' }
+
+// Answers every request written to the port with whatever `reply` returns, nothing when it returns null
+const respond = (port, reply) => {
+  const written = []
+  const write = port.binding.write.bind(port.binding)
+  port.binding.write = async data => {
+    await write(data)
+    written.push(data.toString())
+    const answer = reply(data.toString())
+    if (answer !== null) {
+      setImmediate(() => port.binding.emitData(answer))
+    }
+  }
+  return written
+}
+
+const openPort = () =>
+  new Promise((resolve, reject) => {
+    MockBinding.createPort('/dev/bus', { echo: false, record: false })
+    const port = new SerialPort('/dev/bus', { baudRate: 9600 }, err => (err ? reject(err) : resolve(port)))
+  })
+
+const delay = ms => new Promise(resolve => setTimeout(resolve, ms))
+
+describe('BusScheduler', () => {
+  let port
+  let scheduler
+  beforeEach(async () => {
+    port = await openPort()
+  })
+  afterEach(done => {
+    if (scheduler) {
+      scheduler.stop()
+      scheduler = null
+    }
+    MockBinding.reset()
+    port.close(() => done())
+  })
+
+  describe('.matchResponse', () => {
+    const { matchResponse } = BusScheduler
+    it('matches a delimiter', () => {
+      assert.equal(matchResponse({ delimiter: '\r\n' }, Buffer.from('ok\r\nmore')), 4)
+      assert.equal(matchResponse({ delimiter: '\r\n' }, Buffer.from('ok\r')), 0)
+    })
+    it('matches a length', () => {
+      assert.equal(matchResponse({ length: 3 }, Buffer.from('abcd')), 3)
+      assert.equal(matchResponse({ length: 3 }, Buffer.from('ab')), 0)
+    })
+    it('matches a length field', () => {
+      const until = { lengthField: { offset: 2, adjust: 2 } }
+      assert.equal(matchResponse(until, Buffer.from([1, 3, 2, 0, 10, 0xaa, 0xbb])), 7)
+      assert.equal(matchResponse(until, Buffer.from([1, 3, 2, 0, 10, 0xaa])), 0)
+      assert.equal(matchResponse(until, Buffer.from([1, 3])), 0)
+    })
+    it('calls a predicate', () => {
+      assert.equal(matchResponse(data => (data[0] === 1 ? 1 : 0), Buffer.from([1])), 1)
+    })
+  })
+
+  it('throws without a port', () => {
+    assert.throws(() => new BusScheduler(), TypeError)
+  })
+
+  it('computes the turnaround from the port settings', () => {
+    scheduler = new BusScheduler(port)
+    // 10 bits per character at 9600 baud, 3.5 characters
+    assert.closeTo(scheduler.turnaroundMs, (3.5 * 10 * 1000) / 9600, 0.001)
+    port.settings.parity = 'even'
+    assert.closeTo(scheduler.turnaroundMs, (3.5 * 11 * 1000) / 9600, 0.001)
+    port.settings.baudRate = 115200
+    assert.equal(scheduler.turnaroundMs, 1.75)
+    assert.equal(new BusScheduler(port, { turnaroundMs: 0 }).turnaroundMs, 0)
+  })
+
+  it('resolves on-demand requests', async () => {
+    respond(port, request => `${request.trim()} ok\n`)
+    scheduler = new BusScheduler(port)
+    scheduler.start()
+    const response = await scheduler.request({ slave: 1, request: Buffer.from('ping\n'), until })
+    assert.deepEqual(response, Buffer.from('ping ok\n'))
+  })
+
+  it("uses the binding's native transact()", async () => {
+    const calls = []
+    port.binding.transact = async (request, options) => {
+      calls.push({ request: request.toString(), options })
+      return Buffer.from(`${request.toString().trim()} ok\n`)
+    }
+    scheduler = new BusScheduler(port, { turnaroundMs: 0 })
+    scheduler.start()
+    const response = await scheduler.request({ slave: 1, request: Buffer.from('ping\n'), until, timeoutMs: 100 })
+    assert.deepEqual(response, Buffer.from('ping ok\n'))
+    assert.equal(calls[0].request, 'ping\n')
+    assert.deepEqual(calls[0].options.until, until)
+    assert.isAtLeast(calls[0].options.timeoutMs, 100)
+  })
+
+  it('keeps going when the native transact() resolves without a response', async () => {
+    const answers = [undefined, Buffer.from('ok\n')]
+    port.binding.transact = async () => answers.shift()
+    scheduler = new BusScheduler(port, { turnaroundMs: 0, retries: 0 })
+    scheduler.start()
+    const err = await shouldReject(scheduler.request({ slave: 1, request: Buffer.from('ping\n'), until }))
+    assert.equal(err.slave, 1)
+    const response = await scheduler.request({ slave: 2, request: Buffer.from('ping\n'), until })
+    assert.deepEqual(response, Buffer.from('ok\n'))
+  })
+
+  it('rejects invalid requests', async () => {
+    scheduler = new BusScheduler(port)
+    await shouldReject(scheduler.request({ slave: 1, request: 'ping', until }), TypeError)
+    await shouldReject(scheduler.request({ slave: 1, request: Buffer.from('ping'), until: {} }), TypeError)
+    assert.throws(() => scheduler.addPeriodic({ slave: 1, request: Buffer.from('ping'), until, intervalMs: 0 }), TypeError)
+  })
+
+  it('polls periodically', async () => {
+    respond(port, () => 'ok\n')
+    scheduler = new BusScheduler(port, { turnaroundMs: 0 })
+    const responses = []
+    scheduler.on('response', response => responses.push(response))
+    scheduler.addPeriodic({ name: 'status', slave: 1, request: () => Buffer.from('status\n'), until, intervalMs: 20 })
+    scheduler.start()
+    await delay(90)
+    assert.isAtLeast(responses.length, 3)
+    assert.containSubset(responses[0], { name: 'status', slave: 1, request: Buffer.from('status\n'), response: Buffer.from('ok\n'), attempts: 1 })
+    scheduler.removePeriodic('status')
+    const count = responses.length
+    await delay(50)
+    assert.equal(responses.length, count)
+  })
+
+  it('runs higher priorities first', async () => {
+    const written = respond(port, request => `${request}`)
+    scheduler = new BusScheduler(port, { turnaroundMs: 0 })
+    const requests = [
+      scheduler.request({ slave: 1, request: Buffer.from('low\n'), until }),
+      scheduler.request({ slave: 1, request: Buffer.from('high\n'), until, priority: 5 }),
+      scheduler.request({ slave: 2, request: Buffer.from('normal\n'), until, priority: 1 }),
+    ]
+    scheduler.start()
+    await Promise.all(requests)
+    assert.deepEqual(written, ['high\n', 'normal\n', 'low\n'])
+  })
+
+  it('retries, fails and backs off a slave that does not answer', async () => {
+    const written = respond(port, () => null)
+    scheduler = new BusScheduler(port, { timeoutMs: 10, retries: 1, backoffMs: 1000, turnaroundMs: 0 })
+    const failures = []
+    scheduler.on('failure', err => failures.push(err))
+    scheduler.addPeriodic({ name: 'status', slave: 7, request: Buffer.from('status\n'), until, intervalMs: 5 })
+    scheduler.start()
+    await delay(100)
+    assert.equal(failures.length, 1)
+    assert.equal(failures[0].code, 'ETIMEDOUT')
+    assert.equal(failures[0].slave, 7)
+    assert.equal(failures[0].task, 'status')
+    // one attempt and one retry, then nothing while the slave is backed off
+    assert.equal(written.length, 2)
+    const { slaves } = scheduler.stats()
+    assert.containSubset(slaves[7], { requests: 2, responses: 0, timeouts: 2, retries: 1, failures: 1, backoffMs: 1000 })
+  })
+
+  it('rejects an on-demand request once retries run out', async () => {
+    respond(port, () => null)
+    scheduler = new BusScheduler(port, { timeoutMs: 5, retries: 0 })
+    scheduler.start()
+    const err = await shouldReject(scheduler.request({ slave: 3, request: Buffer.from('ping\n'), until }))
+    assert.equal(err.code, 'ETIMEDOUT')
+    assert.equal(err.slave, 3)
+  })
+
+  it('uses per slave options', async () => {
+    let calls = 0
+    respond(port, () => (++calls === 3 ? 'ok\n' : null))
+    scheduler = new BusScheduler(port, { timeoutMs: 5, retries: 0, turnaroundMs: 0 })
+    scheduler.addSlave(2, { retries: 2 })
+    scheduler.start()
+    const response = await scheduler.request({ slave: 2, request: Buffer.from('ping\n'), until })
+    assert.deepEqual(response, Buffer.from('ok\n'))
+    assert.equal(scheduler.stats().slaves[2].retries, 2)
+  })
+
+  it('reports stats', async () => {
+    respond(port, () => 'ok\n')
+    scheduler = new BusScheduler(port)
+    scheduler.start()
+    await scheduler.request({ slave: 1, request: Buffer.from('ping\n'), until })
+    await scheduler.request({ slave: 1, request: Buffer.from('ping\n'), until })
+    const stats = scheduler.stats()
+    assert.isAbove(stats.elapsedMs, 0)
+    assert.isAbove(stats.busyMs, 0)
+    assert.isAbove(stats.utilization, 0)
+    assert.isAtMost(stats.utilization, 1)
+    assert.equal(stats.queued, 0)
+    const slave = stats.slaves[1]
+    assert.containSubset(slave, { requests: 2, responses: 2, timeouts: 0, failures: 0 })
+    assert.isAbove(slave.latency.meanMs, 0)
+    assert.isAtLeast(slave.latency.maxMs, slave.latency.minMs)
+  })
+})
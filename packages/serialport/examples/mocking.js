@@ -15,6 +15,9 @@ const portPath = 'COM_ANYTHING'
 // writes will be recorded into a single buffer for the lifetime of the port
 // it can be read from `port.binding.recording`.
 
+// With `baudTiming: true` received bytes become readable one character time
+// apart at the port's `baudRate` and writes take as long as they would on the wire.
+
 // Create a port
 MockBinding.createPort(portPath, { echo: false, record: false })
 
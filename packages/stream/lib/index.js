@@ -1,6 +1,7 @@
 const stream = require('stream')
 const util = require('util')
 const debug = require('debug')('serialport/stream')
+const Subscription = require('./subscription')
 
 //  VALIDATION
 const DATABITS = Object.freeze([5, 6, 7, 8])
@@ -24,6 +25,20 @@ const defaultSettings = Object.freeze({
   highWaterMark: 64 * 1024,
 })
 
+const defaultCoalesce = Object.freeze({
+  maxBytes: 1024,
+  maxDelayUs: 1000,
+  alignToOutq: false,
+})
+
+const defaultReconnect = Object.freeze({
+  intervalMs: 250,
+  timeoutMs: 0,
+  writes: 'replay',
+})
+
+const RECONNECT_WRITES = Object.freeze(['replay', 'drop'])
+
 const defaultSetFlags = Object.freeze({
   brk: false,
   cts: false,
@@ -32,6 +47,11 @@ const defaultSetFlags = Object.freeze({
   rts: true,
 })
 
+const elapsedMs = start => {
+  const [seconds, nanoseconds] = process.hrtime(start)
+  return seconds * 1e3 + nanoseconds / 1e6
+}
+
 function allocNewReadPool(poolSize) {
   const pool = Buffer.allocUnsafe(poolSize)
   pool.used = 0
@@ -67,10 +87,24 @@ function allocNewReadPool(poolSize) {
  * @property {boolean} [xon=false] flow control setting
  * @property {boolean} [xoff=false] flow control setting
  * @property {boolean} [xany=false] flow control setting
+ * @property {object} [coalesce] Gathers small writes into a single binding write. Writes are held until `maxBytes` are waiting, `maxDelayUs` after the first one, or until `flushWrites()`, `drain()` or `close()` is called. Write callbacks and the `drain` event still wait for the data to be written.
+ * @property {number} [coalesce.maxBytes=1024] Send as soon as this many bytes are waiting.
+ * @property {number} [coalesce.maxDelayUs=1000] The longest a write is held, rounded up to the timer resolution. `0` gathers the writes of the current tick.
+ * @property {boolean} [coalesce.alignToOutq=false] Once `maxDelayUs` passes keep holding writes while the OS output queue is still transmitting, so the next batch goes out as the queue empties. Uses `binding.getQueueSizes()`.
+ * @property {(object|boolean)} [reconnect] Keeps the stream, its pipes and subscriptions alive when the device goes away. Instead of `close` the port emits `disconnect`, reopens with the same settings once the device is back, sets the modem lines last given to `set()` again and emits `open` and `reconnect`. `true` uses the defaults.
+ * @property {object} [reconnect.query] Finds the device again by `serialNumber`, `locationId`, `vendorId` or `productId` rather than its path, for devices that come back under another name. Needs a binding with `resolve()`, like LinuxBinding.
+ * @property {number} [reconnect.intervalMs=250] How long to wait between attempts to reopen.
+ * @property {number} [reconnect.timeoutMs=0] Give up and close with the disconnect error after this long, `0` keeps trying.
+ * @property {string} [reconnect.writes='replay'] Writes made while disconnected wait and are sent after the reconnect with `'replay'`, and are thrown away with `'drop'`. A write the disconnect cut short is sent again in full with `'replay'`.
  * @property {object=} bindingOptions sets binding-specific options
  * @property {Binding=} binding The hardware access binding. `Bindings` are how Node-Serialport talks to the underlying system. By default we auto detect Windows (`WindowsBinding`), Linux (`LinuxBinding`) and OS X (`DarwinBinding`) and load the appropriate module for your system.
  * @property {number} [bindingOptions.vmin=1] see [`man termios`](http://linux.die.net/man/3/termios) LinuxBinding and DarwinBinding
  * @property {number} [bindingOptions.vtime=0] see [`man termios`](http://linux.die.net/man/3/termios) LinuxBinding and DarwinBinding
+ * @property {string} [bindingOptions.ioBackend='poll'] LinuxBinding only. `'io_uring'` moves reads and writes onto an io_uring shared by every port on the thread, falling back to `'poll'` when the kernel doesn't support it.
+ * @property {number} [bindingOptions.maxQueueMs=0] LinuxBinding only. Paces writes so the OS output queue holds at most this many milliseconds of data at the current baud rate, the rest waits in user space where `flush()` drops it. Keeps a write that follows a large one from waiting behind seconds of queued data. `0` hands everything to the OS right away.
+ * @property {string[]} [bindingOptions.writeLanes=['high', 'normal']] LinuxBinding only. Write lanes from highest to lowest priority for `write(data, { priority })`, at most 8. A priority write goes ahead of lower lane data that is still waiting in the binding. Without `maxQueueMs` that is little more than the rest of the write in progress, everything else is already in the OS output queue and goes out first, so set `maxQueueMs` for a bounded delay.
+ * @property {object} [bindingOptions.framing] LinuxBinding only. Splits incoming data into frames in native code so each `data` event carries at most one frame, `{ type: 'delimiter', delimiter }`, `{ type: 'byteLength', length }`, `{ type: 'lengthPrefixed', lengthBytes }` or `{ type: 'slip' }`. See `Framer` in `@serialport/bindings` for all the options.
+ * @property {object} [bindingOptions.flowGuard] LinuxBinding only. Drops RTS (or sends XOFF) from a native thread once more than `highWater` received bytes wait unread in the OS, a ring reader and the stream's buffer, and lets the sender go again at `lowWater`, `{ highWater, lowWater, mode: 'rts' | 'xoff', intervalUs }`. See `FlowGuard` in `@serialport/bindings`.
  */
 
 /**
@@ -142,6 +176,34 @@ function SerialPort(path, options, openCallback) {
     }
   })
 
+  if (settings.coalesce) {
+    settings.coalesce = { ...defaultCoalesce, ...settings.coalesce }
+    const { maxBytes, maxDelayUs } = settings.coalesce
+    if (!Number.isInteger(maxBytes) || maxBytes < 1) {
+      throw new TypeError(`"coalesce.maxBytes" must be a positive integer: ${maxBytes}`)
+    }
+    if (typeof maxDelayUs !== 'number' || maxDelayUs < 0) {
+      throw new TypeError(`"coalesce.maxDelayUs" must be a positive number: ${maxDelayUs}`)
+    }
+  }
+
+  if (settings.reconnect) {
+    settings.reconnect = { ...defaultReconnect, ...(settings.reconnect === true ? {} : settings.reconnect) }
+    const { query, intervalMs, timeoutMs, writes } = settings.reconnect
+    if (typeof intervalMs !== 'number' || intervalMs <= 0) {
+      throw new TypeError(`"reconnect.intervalMs" must be a positive number: ${intervalMs}`)
+    }
+    if (typeof timeoutMs !== 'number' || timeoutMs < 0) {
+      throw new TypeError(`"reconnect.timeoutMs" must be a positive number or 0: ${timeoutMs}`)
+    }
+    if (RECONNECT_WRITES.indexOf(writes) === -1) {
+      throw new TypeError(`"reconnect.writes" is invalid: ${writes}`)
+    }
+    if (query !== undefined && typeof Binding.resolve !== 'function') {
+      throw new TypeError('"reconnect.query" needs a binding that can resolve ports')
+    }
+  }
+
   const binding = new Binding({
     bindingOptions: settings.bindingOptions,
   })
@@ -153,6 +215,8 @@ function SerialPort(path, options, openCallback) {
     },
     path: {
       enumerable: true,
+      // a reconnect by query can find the device under another path
+      configurable: true,
       value: path,
     },
     settings: {
@@ -165,6 +229,14 @@ function SerialPort(path, options, openCallback) {
   this.closing = false
   this._pool = allocNewReadPool(this.settings.highWaterMark)
   this._kMinPoolSpace = 128
+  this._coalescing = false
+  this._coalesceBatch = 0
+  this._coalesceTimer = null
+  this._subscriptions = []
+  this._subscriptionsBlocked = false
+  this._modemFlags = null
+  this._reconnecting = null
+  this._reconnectStats = settings.reconnect ? { reconnects: 0, lastMs: 0, maxMs: 0, totalMs: 0, droppedBytes: 0 } : null
 
   if (this.settings.autoOpen) {
     this.open(openCallback)
@@ -177,7 +249,7 @@ Object.defineProperties(SerialPort.prototype, {
   isOpen: {
     enumerable: true,
     get() {
-      return this.binding.isOpen && !this.closing
+      return this.binding.isOpen && !this.closing && !this._reconnecting
     },
   },
   baudRate: {
@@ -225,6 +297,10 @@ SerialPort.prototype.open = function (openCallback) {
     return this._asyncError(new Error('Port is opening'), openCallback)
   }
 
+  if (this._reconnecting) {
+    return this._asyncError(new Error('Port is reconnecting'), openCallback)
+  }
+
   this.opening = true
   debug('opening', `path: ${this.path}`)
   this.binding.open(this.path, this.settings).then(
@@ -245,9 +321,10 @@ SerialPort.prototype.open = function (openCallback) {
 }
 
 /**
- * Changes the baud rate for an open port. Throws if you provide a bad argument. Emits an error or calls the callback if the baud rate isn't supported.
- * @param {object=} options Only supports `baudRate`.
+ * Changes the baud rate for an open port. Throws if you provide a bad argument. Emits an error or calls the callback if the baud rate isn't supported. On Linux and macOS nothing is sent to the driver when the baud rate is already set.
+ * @param {object=} options Supports `baudRate` and `flush`.
  * @param {number=} [options.baudRate] The baud rate of the port to be opened. This should match one of the commonly available baud rates, such as 110, 300, 1200, 2400, 4800, 9600, 14400, 19200, 38400, 57600, or 115200. Custom rates are supported best effort per platform. The device connected to the serial port is not guaranteed to support the requested baud rate, even if the port itself supports that baud rate.
+ * @param {boolean=} [options.flush=true] Linux and macOS only. Throw away unread and unsent data when the baud rate changes, `false` keeps it for devices that switch speed mid-conversation.
  * @param {errorCallback=} [callback] Called once the port's baud rate changes. If `.update` is called without a callback, and there is an error, an error event is emitted.
  * @returns {undefined}
  */
@@ -265,7 +342,7 @@ SerialPort.prototype.update = function (options, callback) {
   this.settings.baudRate = settings.baudRate
 
   debug('update', `baudRate: ${settings.baudRate}`)
-  this.binding.update(this.settings).then(
+  this.binding.update({ ...this.settings, flush: settings.flush }).then(
     () => {
       debug('binding.update', 'finished')
       if (callback) {
@@ -279,6 +356,60 @@ SerialPort.prototype.update = function (options, callback) {
   )
 }
 
+/**
+ * Switches the port to new settings in one step, for devices that change protocols. Termios settings and, with `set`, the modem lines are applied in a single call to the binding, which reads back what the driver took and restores the old settings if it didn't take all of them. LinuxBinding and DarwinBinding only.
+ * @param {object} options Any of `baudRate`, `dataBits`, `parity`, `stopBits`, `rtscts`, `xon`, `xoff`, `xany` and `hupcl`, the others keep their current values.
+ * @param {object=} [options.set] `{ rts, dtr, brk }` to set the modem lines as part of the change.
+ * @param {boolean=} [options.flush=true] Throw away unread and unsent data before the change.
+ * @param {errorCallback=} [callback] Called once the port is reconfigured. The error has `rolledBack` set when the old settings were restored. If `.reconfigure` is called without a callback, and there is an error, an error event is emitted.
+ * @returns {undefined}
+ */
+SerialPort.prototype.reconfigure = function (options, callback) {
+  if (typeof options !== 'object') {
+    throw TypeError('"options" is not an object')
+  }
+  const { set, flush, ...changes } = options
+  const settings = { ...this.settings, ...changes }
+  if (typeof settings.baudRate !== 'number') {
+    throw new TypeError(`"baudRate" must be a number: ${settings.baudRate}`)
+  }
+  if (DATABITS.indexOf(settings.dataBits) === -1) {
+    throw new TypeError(`"databits" is invalid: ${settings.dataBits}`)
+  }
+  if (STOPBITS.indexOf(settings.stopBits) === -1) {
+    throw new TypeError(`"stopbits" is invalid: ${settings.stopBits}`)
+  }
+  if (PARITY.indexOf(settings.parity) === -1) {
+    throw new TypeError(`"parity" is invalid: ${settings.parity}`)
+  }
+
+  if (!this.isOpen) {
+    debug('reconfigure attempted, but port is not open')
+    return this._asyncError(new Error('Port is not open'), callback)
+  }
+  if (typeof this.binding.reconfigure !== 'function') {
+    return this._asyncError(new Error('reconfigure is not supported by this binding'), callback)
+  }
+
+  debug('reconfigure', changes)
+  this.binding.reconfigure({ ...changes, set, flush }).then(
+    () => {
+      debug('binding.reconfigure', 'finished')
+      Object.assign(this.settings, changes)
+      if (set) {
+        this._modemFlags = { ...(this._modemFlags || defaultSetFlags), ...set }
+      }
+      if (callback) {
+        callback.call(this, null)
+      }
+    },
+    err => {
+      debug('binding.reconfigure', 'error', err)
+      return this._error(err, callback)
+    }
+  )
+}
+
 /**
  * Writes data to the given serial port. Buffers written data if the port is not open.
 
@@ -294,7 +425,8 @@ From the [stream docs](https://nodejs.org/api/stream.html#stream_writable_write_
 In addition to the usual `stream.write` arguments (`String` and `Buffer`), `write()` can accept arrays of bytes (positive numbers under 256) which is passed to `Buffer.from([])` for conversion. This extra functionality is pretty sweet.
  * @method SerialPort.prototype.write
  * @param  {(string|array|buffer)} data Accepts a [`Buffer`](http://nodejs.org/api/buffer.html) object, or a type that is accepted by the `Buffer` constructor (e.g. an array of bytes or a string).
- * @param  {string=} encoding The encoding, if chunk is a string. Defaults to `'utf8'`. Also accepts `'ascii'`, `'base64'`, `'binary'`, and `'hex'` See [Buffers and Character Encodings](https://nodejs.org/api/buffer.html#buffer_buffers_and_character_encodings) for all available options.
+ * @param  {(string|object)=} encoding The encoding, if chunk is a string. Defaults to `'utf8'`. Also accepts `'ascii'`, `'base64'`, `'binary'`, and `'hex'` See [Buffers and Character Encodings](https://nodejs.org/api/buffer.html#buffer_buffers_and_character_encodings) for all available options. Or an object with `encoding` and `priority`.
+ * @param  {string=} encoding.priority A write lane of the binding, like `'high'`. The write skips the stream's buffer and goes ahead of queued writes in lower lanes as soon as the write in progress reaches the end of a `write()` call. Data already in the OS output queue isn't overtaken, see `bindingOptions.maxQueueMs`. Not counted for `drain` and written as usual when the binding has no lanes.
  * @param  {function=} callback Called once the write operation finishes. Data may not yet be flushed to the underlying port. No arguments.
  * @returns {boolean} `false` if the stream wishes for the calling code to wait for the `'drain'` event to be emitted before continuing to write additional data; otherwise `true`.
  * @since 5.0.0
@@ -304,17 +436,128 @@ SerialPort.prototype.write = function (data, encoding, callback) {
   if (Array.isArray(data)) {
     data = Buffer.from(data)
   }
-  return superWrite.call(this, data, encoding, callback)
+  if (encoding && typeof encoding === 'object') {
+    const { priority } = encoding
+    encoding = encoding.encoding
+    if (priority !== undefined && Array.isArray(this.binding.writeLanes)) {
+      return this._priorityWrite(typeof data === 'string' ? Buffer.from(data, encoding) : data, priority, callback)
+    }
+  }
+  const coalesce = this.settings.coalesce
+  if (!coalesce || this._writableState.ending) {
+    return superWrite.call(this, data, encoding, callback)
+  }
+  if (!this._coalescing) {
+    // corked writes pile up in the writable buffer and reach `_writev` together on uncork
+    this._coalescing = true
+    this._coalesceBatch++
+    this.cork()
+    this._holdWrites(coalesce.maxDelayUs / 1000)
+  }
+  const result = superWrite.call(this, data, encoding, callback)
+  const state = this._writableState
+  if (state.length - (state.writing ? state.writelen : 0) >= coalesce.maxBytes) {
+    this.flushWrites()
+  }
+  return result
+}
+
+SerialPort.prototype._holdWrites = function (delayMs) {
+  if (delayMs > 0) {
+    const timer = setTimeout(() => this._writesHeld(), delayMs)
+    this._coalesceTimer = { timer, immediate: false }
+  } else {
+    const timer = setImmediate(() => this._writesHeld())
+    this._coalesceTimer = { timer, immediate: true }
+  }
+}
+
+SerialPort.prototype._writesHeld = function () {
+  this._coalesceTimer = null
+  const getQueueSizes = this.binding.getQueueSizes
+  if (!this.settings.coalesce.alignToOutq || !this.isOpen || typeof getQueueSizes !== 'function') {
+    return this.flushWrites()
+  }
+  const batch = this._coalesceBatch
+  getQueueSizes.call(this.binding).then(
+    ({ output }) => {
+      if (!this._coalescing || batch !== this._coalesceBatch) {
+        return
+      }
+      if (output > 0) {
+        const { baudRate, dataBits, parity, stopBits } = this.settings
+        const charMs = ((1 + dataBits + (parity === 'none' ? 0 : 1) + stopBits) * 1000) / baudRate
+        debug('holding writes', `${output} bytes in the output queue`)
+        return this._holdWrites(output * charMs)
+      }
+      this.flushWrites()
+    },
+    err => {
+      debug('binding.getQueueSizes', 'error', err)
+      if (batch === this._coalesceBatch) {
+        this.flushWrites()
+      }
+    }
+  )
+}
+
+/**
+ * Sends the writes held back by the `coalesce` option right away. Does nothing when no writes are held.
+ * @returns {undefined}
+ */
+SerialPort.prototype.flushWrites = function () {
+  if (!this._coalescing) {
+    return
+  }
+  debug('flushWrites', `${this._writableState.length} bytes`)
+  const held = this._coalesceTimer
+  if (held) {
+    if (held.immediate) {
+      clearImmediate(held.timer)
+    } else {
+      clearTimeout(held.timer)
+    }
+    this._coalesceTimer = null
+  }
+  this._coalescing = false
+  this.uncork()
+}
+
+SerialPort.prototype._priorityWrite = function (data, priority, callback) {
+  if (typeof callback !== 'function') {
+    callback = err => {
+      if (err) {
+        this.emit('error', err)
+      }
+    }
+  }
+  if (!Buffer.isBuffer(data)) {
+    process.nextTick(callback, new TypeError('"data" must be a string, Buffer or array of bytes'))
+    return true
+  }
+  debug('_priorityWrite', priority)
+  this._writeToBinding(data, { lane: priority }, callback)
+  return true
 }
 
 SerialPort.prototype._write = function (data, encoding, callback) {
+  this._writeToBinding(data, undefined, callback)
+}
+
+SerialPort.prototype._writeToBinding = function (data, options, callback) {
   if (!this.isOpen) {
+    if (this._reconnecting && this.settings.reconnect.writes === 'drop') {
+      debug('_write', `dropping ${data.length} bytes while reconnecting`)
+      this._reconnecting.droppedBytes += data.length
+      this._reconnectStats.droppedBytes += data.length
+      return process.nextTick(callback, null)
+    }
     return this.once('open', function afterOpenWrite() {
-      this._write(data, encoding, callback)
+      this._writeToBinding(data, options, callback)
     })
   }
   debug('_write', `${data.length} bytes of data`)
-  this.binding.write(data).then(
+  this.binding.write(data, options).then(
     () => {
       debug('binding.write', 'write finished')
       callback(null)
@@ -324,6 +567,9 @@ SerialPort.prototype._write = function (data, encoding, callback) {
       if (!err.canceled) {
         this._disconnected(err)
       }
+      if (this._reconnecting) {
+        return this._writeToBinding(data, options, callback)
+      }
       callback(err)
     }
   )
@@ -332,7 +578,10 @@ SerialPort.prototype._write = function (data, encoding, callback) {
 SerialPort.prototype._writev = function (data, callback) {
   debug('_writev', `${data.length} chunks of data`)
   const dataV = data.map(write => write.chunk)
-  this._write(Buffer.concat(dataV), null, callback)
+  // lets a binding with write lanes put a priority write between two of them
+  let end = 0
+  const boundaries = dataV.map(chunk => (end += chunk.length))
+  this._writeToBinding(Buffer.concat(dataV), { boundaries }, callback)
 }
 
 /**
@@ -357,6 +606,11 @@ SerialPort.prototype._read = function (bytesToRead) {
     return
   }
 
+  // a binding that holds the sender back counts what waits in here too
+  if (this.binding.setReadBuffered) {
+    this.binding.setReadBuffered(this._readableState.length)
+  }
+
   if (!this._pool || this._pool.length - this._pool.used < this._kMinPoolSpace) {
     debug('_read', 'discarding the read buffer pool because it is below kMinPoolSpace')
     this._pool = allocNewReadPool(this.settings.highWaterMark)
@@ -382,7 +636,14 @@ SerialPort.prototype._read = function (bytesToRead) {
         return
       }
       pool.used += bytesRead
-      this.push(pool.slice(start, start + bytesRead))
+      const chunk = pool.slice(start, start + bytesRead)
+      if (this._subscriptions.length > 0) {
+        this._fanOut(chunk)
+      }
+      this.push(chunk)
+      if (this.binding.setReadBuffered) {
+        this.binding.setReadBuffered(this._readableState.length)
+      }
     },
     err => {
       debug('binding.read', `error`, err)
@@ -394,6 +655,63 @@ SerialPort.prototype._read = function (bytesToRead) {
   )
 }
 
+/**
+ * Adds a consumer of the received data with a queue of its own, so a slow one can't hold up the others. Subscriptions share the port's read buffers, data isn't copied per subscriber. The port keeps reading while it has subscribers, as long as nothing else pauses it: leave the port itself unpiped, or its slowest reader sets the pace for everyone.
+ * @param {object} [options]
+ * @param {number} [options.maxLag=65536] bytes that may wait unread in the subscription
+ * @param {string} [options.overflow='drop-oldest'] what to do past `maxLag`: `'drop-oldest'` throws away the oldest data, `'disconnect'` destroys the subscription with an error that has `overflow` set, `'block'` pauses the port until the subscription catches up
+ * @returns {Subscription} a `Readable` of the data received from now on, it ends when the port closes
+ * @example
+```js
+const parser = port.subscribe({ overflow: 'block' }).pipe(new Readline())
+port.subscribe({ maxLag: 4096 }).on('data', data => dashboard.send(data))
+```
+ */
+SerialPort.prototype.subscribe = function (options) {
+  const subscription = new Subscription(this, options)
+  this._subscriptions.push(subscription)
+  debug('subscribe', this._subscriptions.length, 'subscribers')
+  if (!this._subscriptionsBlocked) {
+    this.resume()
+  }
+  return subscription
+}
+
+SerialPort.prototype._unsubscribe = function (subscription) {
+  const index = this._subscriptions.indexOf(subscription)
+  if (index !== -1) {
+    this._subscriptions.splice(index, 1)
+  }
+  this._subscriptionCaughtUp()
+}
+
+SerialPort.prototype._fanOut = function (chunk) {
+  // a subscription can go away while it's handed data
+  const subscriptions = this._subscriptions.slice()
+  let blocked = false
+  for (let i = 0; i < subscriptions.length; i++) {
+    subscriptions[i].deliver(chunk)
+    blocked = blocked || subscriptions[i].blocking
+  }
+  if (blocked && !this._subscriptionsBlocked) {
+    debug('pausing for a blocking subscriber')
+    this._subscriptionsBlocked = true
+    this.pause()
+  }
+}
+
+SerialPort.prototype._subscriptionCaughtUp = function () {
+  if (!this._subscriptionsBlocked) {
+    return
+  }
+  if (this._subscriptions.some(subscription => subscription.blocking)) {
+    return
+  }
+  debug('resuming for blocking subscribers')
+  this._subscriptionsBlocked = false
+  this.resume()
+}
+
 SerialPort.prototype._disconnected = function (err) {
   if (!this.isOpen) {
     debug('disconnected aborted because already closed', err)
@@ -401,11 +719,101 @@ SerialPort.prototype._disconnected = function (err) {
   }
   debug('disconnected', err)
   err.disconnected = true
+  if (this.settings.reconnect) {
+    return this._reconnect(err)
+  }
   this.close(null, err)
 }
 
 /**
- * The `close` event's callback is called with no arguments when the port is closed. In the case of a disconnect it will be called with a Disconnect Error object (`err.disconnected == true`). In the event of a close error (unlikely), an error event is triggered.
+ * The `disconnect` event's callback is called with the Disconnect Error (`err.disconnected == true`) when the device goes away from a port opened with `reconnect`. The port is reopened in the background, see the `reconnect` event.
+ * @event disconnect
+ */
+
+/**
+ * The `reconnect` event's callback is called with `{ path, attempts, ms, droppedBytes }` once a port opened with `reconnect` is back, after the `open` event. `ms` is the time since the disconnect and `droppedBytes` counts the writes the `'drop'` policy threw away.
+ * @event reconnect
+ */
+
+SerialPort.prototype._reconnect = function (err) {
+  const reconnecting = { error: err, started: process.hrtime(), attempts: 0, timer: null, droppedBytes: 0 }
+  this._reconnecting = reconnecting
+  this.emit('disconnect', err)
+  this.binding.close().then(
+    () => this._reconnectAttempt(reconnecting),
+    closeErr => {
+      debug('binding.close', 'error while reconnecting', closeErr)
+      this._reconnectAttempt(reconnecting)
+    }
+  )
+}
+
+SerialPort.prototype._reconnectAttempt = async function (reconnecting) {
+  const { query, intervalMs, timeoutMs } = this.settings.reconnect
+  reconnecting.timer = null
+  reconnecting.attempts++
+  let path = this.path
+  let opened = false
+  try {
+    if (query) {
+      const ports = this.binding.constructor.resolve(query)
+      if (ports.length !== 1) {
+        throw new Error(`${ports.length} ports match ${JSON.stringify(query)}`)
+      }
+      path = ports[0].path
+    }
+    await this.binding.open(path, this.settings)
+    opened = true
+    if (this._modemFlags) {
+      await this.binding.set(this._modemFlags)
+    }
+  } catch (err) {
+    debug('reconnect attempt', reconnecting.attempts, 'failed', err.message)
+    if (opened) {
+      await this.binding.close().catch(closeErr => debug('binding.close', 'had an error', closeErr))
+    }
+    if (this._reconnecting !== reconnecting) {
+      return
+    }
+    if (timeoutMs > 0 && elapsedMs(reconnecting.started) + intervalMs > timeoutMs) {
+      debug('giving up reconnecting after', reconnecting.attempts, 'attempts')
+      this._reconnecting = null
+      return this._closed(reconnecting.error)
+    }
+    reconnecting.timer = setTimeout(() => this._reconnectAttempt(reconnecting), intervalMs)
+    return
+  }
+  if (this._reconnecting !== reconnecting) {
+    debug('closed while reconnecting')
+    return this.binding.close().catch(err => debug('binding.close', 'had an error', err))
+  }
+
+  this._reconnecting = null
+  Object.defineProperty(this, 'path', { value: path })
+  const ms = elapsedMs(reconnecting.started)
+  const stats = this._reconnectStats
+  stats.reconnects++
+  stats.lastMs = ms
+  stats.maxMs = Math.max(stats.maxMs, ms)
+  stats.totalMs += ms
+  debug('reconnected', path, `after ${ms}ms`)
+  this.emit('open')
+  this.emit('reconnect', { path, attempts: reconnecting.attempts, ms, droppedBytes: reconnecting.droppedBytes })
+}
+
+/**
+ * Returns how a port opened with `reconnect` has fared, or `null` without it.
+ * @returns {?object} `{ reconnecting, reconnects, lastMs, maxMs, totalMs, droppedBytes }`, the times in milliseconds from disconnect to reconnect
+ */
+SerialPort.prototype.reconnectStats = function () {
+  if (!this._reconnectStats) {
+    return null
+  }
+  return { reconnecting: Boolean(this._reconnecting), ...this._reconnectStats }
+}
+
+/**
+ * The `close` event's callback is called with no arguments when the port is closed. In the case of a disconnect it will be called with a Disconnect Error object (`err.disconnected == true`), with `reconnect` only once the port gives up reconnecting. In the event of a close error (unlikely), an error event is triggered.
  * @event close
  */
 
@@ -421,24 +829,26 @@ SerialPort.prototype._disconnected = function (err) {
 SerialPort.prototype.close = function (callback, disconnectError) {
   disconnectError = disconnectError || null
 
+  if (this._reconnecting) {
+    debug('#close', 'while reconnecting')
+    clearTimeout(this._reconnecting.timer)
+    this._reconnecting = null
+    return process.nextTick(() => this._closed(disconnectError, callback))
+  }
+
   if (!this.isOpen) {
     debug('close attempted, but port is not open')
     return this._asyncError(new Error('Port is not open'), callback)
   }
 
+  this.flushWrites()
   this.closing = true
   debug('#close')
   this.binding.close().then(
     () => {
       this.closing = false
       debug('binding.close', 'finished')
-      this.emit('close', disconnectError)
-      if (this.settings.endOnClose) {
-        this.emit('end')
-      }
-      if (callback) {
-        callback.call(this, disconnectError)
-      }
+      this._closed(disconnectError, callback)
     },
     err => {
       this.closing = false
@@ -448,6 +858,20 @@ SerialPort.prototype.close = function (callback, disconnectError) {
   )
 }
 
+SerialPort.prototype._closed = function (disconnectError, callback) {
+  const subscriptions = this._subscriptions
+  this._subscriptions = []
+  this._subscriptionsBlocked = false
+  subscriptions.forEach(subscription => subscription.finish())
+  this.emit('close', disconnectError)
+  if (this.settings.endOnClose) {
+    this.emit('end')
+  }
+  if (callback) {
+    callback.call(this, disconnectError)
+  }
+}
+
 /**
  * Set control flags on an open port. Uses [`SetCommMask`](https://msdn.microsoft.com/en-us/library/windows/desktop/aa363257(v=vs.85).aspx) for Windows and [`ioctl`](http://linux.die.net/man/4/tty_ioctl) for OS X and Linux.
  * @param {object=} options All options are operating system default when the port is opened. Every flag is set on each call to the provided or default values. If options isn't provided default options is used.
@@ -475,6 +899,7 @@ SerialPort.prototype.set = function (options, callback) {
   this.binding.set(settings).then(
     () => {
       debug('binding.set', 'finished')
+      this._modemFlags = settings
       if (callback) {
         callback.call(this, null)
       }
@@ -555,6 +980,7 @@ function writeAndDrain (data, callback) {
  */
 SerialPort.prototype.drain = function (callback) {
   debug('drain')
+  this.flushWrites()
   if (!this.isOpen) {
     debug('drain queuing on port open')
     return this.once('open', () => {
@@ -653,4 +1079,40 @@ SerialPort.list = async function (callback) {
   return SerialPort.Binding.list()
 }
 
+/**
+ * Opens the one port with the given USB attributes, for devices known by their serial number or the socket they're plugged into rather than a path that changes when they re-enumerate. The binding resolves the path, on Linux from an index of sysfs that only re-reads the ttys that changed, so it's cheap to call on every reconnect.
+ * @param {object} query any of `serialNumber`, `locationId`, `vendorId` and `productId`, a port has to match all of them. On Linux the `locationId` is the USB bus and hub ports, eg `1-1.4`.
+ * @param {openOptions} [options] as for the constructor
+ * @param {ErrorCallback} [openCallback] as for the constructor
+ * @returns {SerialPort} the port, opening unless `autoOpen` is false
+ * @throws {TypeError} When the binding can't resolve ports or the query is invalid.
+ * @throws {Error} With the `code` `'ENOENT'` when no port matches and `'EAMBIGUOUS'` when several do.
+ * @example
+```js
+const port = SerialPort.openBy({ serialNumber: 'A9007Ubg' }, { baudRate: 57600 })
+```
+ */
+SerialPort.openBy = function (query, options, openCallback) {
+  debug('.openBy', query)
+  if (options instanceof Function) {
+    openCallback = options
+    options = {}
+  }
+  const Binding = (options && options.binding) || SerialPort.Binding
+  if (!Binding) {
+    throw new TypeError('"Bindings" is invalid pass it as `options.binding` or set it on `SerialPort.Binding`')
+  }
+  if (typeof Binding.resolve !== 'function') {
+    throw new TypeError('The binding cannot resolve ports')
+  }
+  const ports = Binding.resolve(query)
+  if (ports.length !== 1) {
+    const paths = ports.map(port => port.path).join(', ')
+    const err = new Error(ports.length === 0 ? `No port matches ${JSON.stringify(query)}` : `${JSON.stringify(query)} matches ${paths}`)
+    err.code = ports.length === 0 ? 'ENOENT' : 'EAMBIGUOUS'
+    throw err
+  }
+  return new SerialPort(ports[0].path, options, openCallback)
+}
+
 module.exports = SerialPort
@@ -199,6 +199,41 @@ describe('SerialPort', () => {
         throw new Error('no expected error')
       })
     })
+
+    describe('Serialport#openBy', () => {
+      class ResolvingBinding extends MockBinding {
+        static resolve(query) {
+          return [{ path: '/dev/exists', serialNumber: 'A123' }, { path: '/dev/other', serialNumber: 'B456' }].filter(
+            port => !query.serialNumber || port.serialNumber === query.serialNumber
+          )
+        }
+      }
+
+      it('opens the port the binding resolves', done => {
+        const port = SerialPort.openBy({ serialNumber: 'A123' }, { binding: ResolvingBinding }, err => {
+          assert.isNull(err)
+          assert.isTrue(port.isOpen)
+          done()
+        })
+        assert.equal(port.path, '/dev/exists')
+      })
+
+      it('throws when nothing or more than one port matches', () => {
+        SerialPort.Binding = ResolvingBinding
+        assert.throws(() => SerialPort.openBy({ serialNumber: 'C789' }), /No port matches/)
+        try {
+          SerialPort.openBy({})
+        } catch (e) {
+          assert.equal(e.code, 'EAMBIGUOUS')
+          return
+        }
+        throw new Error('no expected error')
+      })
+
+      it('errors if the binding cannot resolve ports', () => {
+        assert.throws(() => SerialPort.openBy({ serialNumber: 'A123' }), TypeError)
+      })
+    })
   })
 
   describe('property', () => {
@@ -447,6 +482,171 @@ describe('SerialPort', () => {
           port.uncork()
         })
       })
+
+      it('passes the boundaries of combined writes to the binding', done => {
+        const port = new SerialPort('/dev/exists', { autoOpen: false })
+        const spy = sinon.spy(port.binding, 'write')
+        port.open(() => {
+          port.cork()
+          port.write('abc')
+          port.write(Buffer.from('12'), () => {
+            assert.deepEqual(spy.args[0][1], { boundaries: [3, 5] })
+            done()
+          })
+          port.uncork()
+        })
+      })
+
+      describe('priority', () => {
+        it('accepts an options object with an encoding', done => {
+          const port = new SerialPort('/dev/exists')
+          port.on('open', () => {
+            port.write('C0FFEE', { encoding: 'hex', priority: 'high' }, () => {
+              assert.deepEqual(port.binding.lastWrite, Buffer.from('C0FFEE', 'hex'))
+              done()
+            })
+          })
+        })
+
+        it('skips the stream buffer when the binding has write lanes', done => {
+          const port = new SerialPort('/dev/exists')
+          const writes = []
+          port.binding.writeLanes = ['high', 'normal']
+          sinon.stub(port.binding, 'write').callsFake((data, options) => {
+            writes.push({ data: data.toString(), lane: options && options.lane })
+            return new Promise(resolve => setTimeout(resolve, 5))
+          })
+          port.on('open', () => {
+            port.write('bulk1')
+            port.write('bulk2')
+            port.write('stop', { priority: 'high' }, err => {
+              assert.isNull(err)
+              // bulk2 is still in the stream's buffer behind bulk1
+              assert.deepEqual(writes.slice(0, 2), [
+                { data: 'bulk1', lane: undefined },
+                { data: 'stop', lane: 'high' },
+              ])
+              done()
+            })
+          })
+        })
+
+        it('waits for the port to open', done => {
+          const port = new SerialPort('/dev/exists', { autoOpen: false })
+          port.binding.writeLanes = ['high', 'normal']
+          port.write('stop', { priority: 'high' }, err => {
+            assert.isNull(err)
+            assert.deepEqual(port.binding.lastWrite, Buffer.from('stop'))
+            done()
+          })
+          port.open()
+        })
+
+        it('reports binding errors', done => {
+          const port = new SerialPort('/dev/exists')
+          port.binding.writeLanes = ['high', 'normal']
+          sinon.stub(port.binding, 'write').callsFake(() => Promise.reject(new TypeError('"urgent" is not a write lane')))
+          port.on('open', () => {
+            port.write('stop', { priority: 'urgent' })
+          })
+          port.on('error', err => {
+            assert.instanceOf(err, TypeError)
+            done()
+          })
+        })
+      })
+
+      describe('coalesce', () => {
+        it('throws on invalid options', () => {
+          assert.throws(() => new SerialPort('/dev/exists', { autoOpen: false, coalesce: { maxBytes: 0 } }), TypeError)
+          assert.throws(() => new SerialPort('/dev/exists', { autoOpen: false, coalesce: { maxDelayUs: -1 } }), TypeError)
+        })
+
+        it('gathers writes until the delay passes', done => {
+          const port = new SerialPort('/dev/exists', { coalesce: { maxDelayUs: 5000 } })
+          const spy = sinon.spy(port.binding, 'write')
+          port.on('open', () => {
+            port.write('a')
+            port.write('b')
+            port.write('c', () => {
+              assert.equal(spy.callCount, 1)
+              assert.deepEqual(port.binding.lastWrite, Buffer.from('abc'))
+              done()
+            })
+            setTimeout(() => assert.equal(spy.callCount, 0), 1)
+          })
+        })
+
+        it('gathers the writes of one tick', done => {
+          const port = new SerialPort('/dev/exists', { coalesce: { maxDelayUs: 0 } })
+          const spy = sinon.spy(port.binding, 'write')
+          port.on('open', () => {
+            port.write('a')
+            port.write('b', () => {
+              assert.equal(spy.callCount, 1)
+              assert.deepEqual(port.binding.lastWrite, Buffer.from('ab'))
+              done()
+            })
+          })
+        })
+
+        it('sends once maxBytes are waiting', done => {
+          const port = new SerialPort('/dev/exists', { coalesce: { maxBytes: 4, maxDelayUs: 1e6 } })
+          const spy = sinon.spy(port.binding, 'write')
+          port.on('open', () => {
+            port.write('ab')
+            port.write('cd', () => {
+              assert.equal(spy.callCount, 1)
+              assert.deepEqual(port.binding.lastWrite, Buffer.from('abcd'))
+              done()
+            })
+          })
+        })
+
+        it('sends on flushWrites()', done => {
+          const port = new SerialPort('/dev/exists', { coalesce: { maxDelayUs: 1e6 } })
+          port.on('open', () => {
+            port.write('ab', () => {
+              assert.deepEqual(port.binding.lastWrite, Buffer.from('ab'))
+              done()
+            })
+            port.flushWrites()
+          })
+        })
+
+        it('sends held writes before draining', done => {
+          const port = new SerialPort('/dev/exists', { coalesce: { maxDelayUs: 1e6 } })
+          let finishedWrite = false
+          port.write('ab', () => {
+            finishedWrite = true
+          })
+          port.drain(() => {
+            assert.isTrue(finishedWrite)
+            done()
+          })
+        })
+
+        it('keeps holding writes while the output queue is busy', done => {
+          const port = new SerialPort('/dev/exists', { baudRate: 115200, coalesce: { maxDelayUs: 0, alignToOutq: true } })
+          const spy = sinon.spy(port.binding, 'write')
+          let queued = 2
+          sinon.stub(port.binding, 'getQueueSizes').callsFake(async () => {
+            if (queued === 2) {
+              port.write('b')
+            }
+            return { input: 0, output: queued-- > 0 ? 10 : 0 }
+          })
+          port.on('open', () => {
+            port.write('a')
+            port.write('c', () => {
+              assert.equal(spy.callCount, 1)
+              assert.deepEqual(port.binding.lastWrite, Buffer.from('acb'))
+              assert.equal(port.binding.getQueueSizes.callCount, 3)
+              done()
+            })
+          })
+        })
+      })
     })
 
     describe('#close', () => {
@@ -619,6 +819,18 @@ describe('SerialPort', () => {
         })
       })
 
+      it('passes flush on to the binding', done => {
+        const port = new SerialPort('/dev/exists', () => {
+          const spy = sinon.spy(port.binding, 'update')
+          port.update({ baudRate: 14400, flush: false }, err => {
+            assert.isNull(err)
+            assert.isFalse(spy.args[0][0].flush)
+            assert.isUndefined(port.settings.flush)
+            done()
+          })
+        })
+      })
+
       it('handles errors in callback', done => {
         const port = new SerialPort('/dev/exists')
         sinon.stub(port.binding, 'update').callsFake(() => {
@@ -647,6 +859,54 @@ describe('SerialPort', () => {
       })
     })
 
+    describe('#reconfigure', () => {
+      it('throws on invalid settings', done => {
+        const port = new SerialPort('/dev/exists', () => {
+          assert.throws(() => port.reconfigure({ dataBits: 9 }), TypeError)
+          assert.throws(() => port.reconfigure({ parity: 'sometimes' }), TypeError)
+          done()
+        })
+      })
+
+      it('errors when the binding has no reconfigure', done => {
+        const port = new SerialPort('/dev/exists', () => {
+          port.reconfigure({ baudRate: 115200 }, err => {
+            assert.instanceOf(err, Error)
+            assert.equal(port.baudRate, 9600)
+            done()
+          })
+        })
+      })
+
+      it('changes the settings in one binding call', done => {
+        const port = new SerialPort('/dev/exists', () => {
+          port.binding.reconfigure = sinon.stub().resolves()
+          port.reconfigure({ baudRate: 115200, parity: 'even', set: { dtr: false }, flush: false }, err => {
+            assert.isNull(err)
+            assert.equal(port.binding.reconfigure.callCount, 1)
+            assert.deepEqual(port.binding.reconfigure.args[0][0], { baudRate: 115200, parity: 'even', set: { dtr: false }, flush: false })
+            assert.equal(port.baudRate, 115200)
+            assert.equal(port.settings.parity, 'even')
+            assert.isUndefined(port.settings.set)
+            done()
+          })
+        })
+      })
+
+      it('keeps the settings when it fails', done => {
+        const port = new SerialPort('/dev/exists', () => {
+          const err = new Error('rejected')
+          err.rolledBack = true
+          port.binding.reconfigure = sinon.stub().rejects(err)
+          port.reconfigure({ dataBits: 7 }, err => {
+            assert.isTrue(err.rolledBack)
+            assert.equal(port.settings.dataBits, 8)
+            done()
+          })
+        })
+      })
+    })
+
     describe('#set', () => {
       it('errors when serialport not open', done => {
         const port = new SerialPort('/dev/exists', { autoOpen: false })
@@ -987,6 +1247,113 @@ describe('SerialPort', () => {
     })
   })
 
+  describe('subscriptions', () => {
+    const openPort = async () => {
+      const port = new SerialPort('/dev/exists')
+      await new Promise(resolve => port.on('open', resolve))
+      return port
+    }
+
+    const collect = (subscription, length) =>
+      new Promise(resolve => {
+        const chunks = []
+        let received = 0
+        subscription.on('data', chunk => {
+          chunks.push(chunk)
+          received += chunk.length
+          if (received >= length) {
+            resolve(chunks)
+          }
+        })
+      })
+
+    const writeChunks = async (port, chunks) => {
+      for (const chunk of chunks) {
+        await new Promise(resolve => port.write(chunk, resolve))
+        await new Promise(resolve => setTimeout(resolve, 5))
+      }
+    }
+
+    it('hands every subscriber the same buffers', async () => {
+      const port = await openPort()
+      const parser = collect(port.subscribe(), 10)
+      const logger = collect(port.subscribe(), 10)
+      await writeChunks(port, [Buffer.from('0123456789')])
+      const [parsed, logged] = await Promise.all([parser, logger])
+      assert.deepEqual(Buffer.concat(parsed), Buffer.from('0123456789'))
+      assert.strictEqual(parsed[0].buffer, logged[0].buffer)
+      assert.equal(parsed[0].byteOffset, logged[0].byteOffset)
+    })
+
+    it('drops the oldest data for a slow subscriber without holding up the others', async () => {
+      const port = await openPort()
+      const slow = port.subscribe({ maxLag: 150 })
+      const fast = collect(port.subscribe(), 300)
+      const chunks = [0, 1, 2].map(i => Buffer.alloc(100, i))
+      await writeChunks(port, chunks)
+      assert.deepEqual(Buffer.concat(await fast), Buffer.concat(chunks))
+      assert.deepEqual(slow.stats(), { bytes: 300, dropped: 200, lag: 100 })
+      assert.deepEqual(slow.read(), chunks[2])
+    })
+
+    it('disconnects a subscriber that falls behind', async () => {
+      const port = await openPort()
+      const slow = port.subscribe({ maxLag: 150, overflow: 'disconnect' })
+      const error = new Promise(resolve => slow.on('error', resolve))
+      await writeChunks(port, [Buffer.alloc(100), Buffer.alloc(100)])
+      assert.isTrue((await error).overflow)
+      assert.deepEqual(port._subscriptions, [])
+    })
+
+    it('pauses the port for a blocking subscriber until it catches up', async () => {
+      const port = await openPort()
+      const blocking = port.subscribe({ maxLag: 150, overflow: 'block' })
+      await writeChunks(port, [Buffer.alloc(100, 1), Buffer.alloc(100, 2)])
+      assert.isTrue(port.isPaused())
+      assert.equal(blocking.stats().dropped, 0)
+      const received = collect(blocking, 200)
+      assert.deepEqual(Buffer.concat(await received), Buffer.concat([Buffer.alloc(100, 1), Buffer.alloc(100, 2)]))
+      // the subscription asks for more on the next tick
+      await new Promise(resolve => setImmediate(resolve))
+      assert.isFalse(port.isPaused())
+    })
+
+    it('ends the subscriptions when the port closes', async () => {
+      const port = await openPort()
+      const subscription = port.subscribe()
+      const ended = new Promise(resolve => subscription.on('end', resolve))
+      subscription.resume()
+      await new Promise(resolve => port.close(resolve))
+      await ended
+    })
+  })
+
+  describe('simulated devices', () => {
+    it('talks to devices on the virtual clock', async () => {
+      const sim = new MockBinding.Simulation()
+      const model = {
+        turnaroundMs: 20,
+        responders: [{ request: Buffer.from('?'), response: Buffer.from('ok\n') }],
+      }
+      const ports = [0, 1, 2].map(i => {
+        sim.addDevice(`/dev/sim${i}`, model)
+        return new SerialPort(`/dev/sim${i}`, { baudRate: 1200 })
+      })
+      const answer = port =>
+        new Promise(resolve => {
+          port.on('open', () => port.write('?'))
+          port.once('data', data => resolve([data.toString(), sim.now]))
+        })
+      const answers = ports.map(answer)
+      await sim.run()
+      const results = await Promise.all(answers)
+      results.forEach(([data, now]) => {
+        assert.equal(data, 'ok\n')
+        assert.closeTo(now, 20 + (4 * 10000) / 1200, 0.001)
+      })
+    })
+  })
+
   describe('disconnect close errors', () => {
     it('emits as a disconnected close event on a bad read', done => {
       const port = new SerialPort('/dev/exists')
@@ -1002,4 +1369,91 @@ describe('SerialPort', () => {
       port.read()
     })
   })
+
+  describe('reconnect', () => {
+    const openPort = options =>
+      new Promise((resolve, reject) => {
+        const port = new SerialPort('/dev/exists', options, err => (err ? reject(err) : resolve(port)))
+      })
+    const disconnect = port => {
+      const read = sinon.stub(port.binding, 'read').callsFake(async () => {
+        read.restore()
+        throw new Error('EIO')
+      })
+      port.read()
+    }
+    const nextEvent = (port, event) => new Promise(resolve => port.once(event, resolve))
+
+    it('reopens the port once the device is back and replays the writes', async () => {
+      const port = await openPort({ reconnect: { intervalMs: 5 } })
+      await new Promise(resolve => port.set({ dtr: false }, resolve))
+      const set = sinon.spy(port.binding, 'set')
+      port.on('close', () => {
+        throw new Error('should stay open')
+      })
+
+      MockBinding.reset()
+      const disconnected = nextEvent(port, 'disconnect')
+      disconnect(port)
+      assert.isTrue((await disconnected).disconnected)
+      assert.isFalse(port.isOpen)
+      assert.isTrue(port.reconnectStats().reconnecting)
+      port.write('hello')
+
+      await new Promise(resolve => setTimeout(resolve, 20))
+      MockBinding.createPort('/dev/exists', { record: true, readyData: Buffer.from([]) })
+      const reconnected = await nextEvent(port, 'reconnect')
+      assert.isAbove(reconnected.attempts, 1)
+      assert.isTrue(port.isOpen)
+      assert.equal(set.args[0][0].dtr, false)
+
+      await new Promise(resolve => port.drain(resolve))
+      assert.equal(port.binding.recording.toString(), 'hello')
+      const stats = port.reconnectStats()
+      assert.equal(stats.reconnects, 1)
+      assert.equal(stats.lastMs, reconnected.ms)
+      assert.isFalse(stats.reconnecting)
+    })
+
+    it('finds the device again by query', async () => {
+      class ResolvingBinding extends MockBinding {
+        static resolve() {
+          return [{ path: '/dev/moved' }]
+        }
+      }
+      const port = await openPort({ binding: ResolvingBinding, reconnect: { query: { serialNumber: 'A123' }, intervalMs: 5 } })
+      MockBinding.createPort('/dev/moved', { readyData: Buffer.from([]) })
+      disconnect(port)
+      assert.equal((await nextEvent(port, 'reconnect')).path, '/dev/moved')
+      assert.equal(port.path, '/dev/moved')
+    })
+
+    it('drops the writes and gives up after the timeout', async () => {
+      const port = await openPort({ reconnect: { intervalMs: 5, timeoutMs: 30, writes: 'drop' } })
+      MockBinding.reset()
+      disconnect(port)
+      await nextEvent(port, 'disconnect')
+      const written = new Promise(resolve => port.write('hello', resolve))
+      assert(!(await written))
+      const err = await nextEvent(port, 'close')
+      assert.isTrue(err.disconnected)
+      assert.containSubset(port.reconnectStats(), { reconnecting: false, reconnects: 0, droppedBytes: 5 })
+    })
+
+    it('stops reconnecting when closed', async () => {
+      const port = await openPort({ reconnect: true })
+      MockBinding.reset()
+      disconnect(port)
+      await nextEvent(port, 'disconnect')
+      await new Promise((resolve, reject) => port.close(err => (err ? reject(err) : resolve())))
+      assert.isFalse(port.reconnectStats().reconnecting)
+    })
+
+    it('validates its settings', () => {
+      assert.throws(() => new SerialPort('/dev/exists', { reconnect: { writes: 'keep' } }), TypeError)
+      assert.throws(() => new SerialPort('/dev/exists', { reconnect: { intervalMs: 0 } }), TypeError)
+      assert.throws(() => new SerialPort('/dev/exists', { reconnect: { query: { serialNumber: 'A123' } } }), TypeError)
+      assert.isNull(new SerialPort('/dev/exists', { autoOpen: false }).reconnectStats())
+    })
+  })
 })
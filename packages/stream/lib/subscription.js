@@ -0,0 +1,124 @@
+const stream = require('stream')
+const debug = require('debug')('serialport/stream/subscription')
+
+const OVERFLOW_POLICIES = Object.freeze(['drop-oldest', 'disconnect', 'block'])
+
+/**
+ * One consumer of a port's received data, made by `SerialPort.prototype.subscribe()`. Every subscription is handed the same slices of the port's read pool, nothing is copied per subscriber. Data waits in the subscription until it's read, `maxLag` bounds how much and `overflow` says what happens past it.
+ */
+class Subscription extends stream.Readable {
+  /**
+   * @param {SerialPort} port
+   * @param {object} [options]
+   * @param {number} [options.maxLag=65536] bytes that may wait in this subscription
+   * @param {string} [options.overflow='drop-oldest'] past `maxLag`: `'drop-oldest'` throws away the oldest data, `'disconnect'` destroys the subscription with an `overflow` error, `'block'` pauses the port until this subscription catches up
+   */
+  constructor(port, { maxLag = 64 * 1024, overflow = 'drop-oldest' } = {}) {
+    if (!Number.isInteger(maxLag) || maxLag < 1) {
+      throw new TypeError(`"maxLag" must be a positive integer: ${maxLag}`)
+    }
+    if (OVERFLOW_POLICIES.indexOf(overflow) === -1) {
+      throw new TypeError(`"overflow" must be one of ${OVERFLOW_POLICIES.join(', ')}: ${overflow}`)
+    }
+    // the queue below does the buffering, the stream only holds what it was asked for
+    super({ highWaterMark: Math.min(maxLag, 16 * 1024) })
+    this.port = port
+    this.maxLag = maxLag
+    this.overflow = overflow
+    this.queue = []
+    this.queued = 0
+    this.wanted = false
+    this.ending = false
+    this.bytes = 0
+    this.dropped = 0
+  }
+
+  /**
+   * Bytes received but not read yet
+   */
+  get lag() {
+    return this.queued + this._readableState.length
+  }
+
+  // a `'block'` subscription holds the port while it's full and its reader isn't asking for more
+  get blocking() {
+    return this.overflow === 'block' && !this.wanted && this.lag >= this.maxLag
+  }
+
+  deliver(chunk) {
+    if (this.ending || this.destroyed) {
+      return
+    }
+    this.bytes += chunk.length
+    if (this.wanted && this.queue.length === 0) {
+      this.wanted = this.push(chunk)
+      return
+    }
+    this.queue.push(chunk)
+    this.queued += chunk.length
+    if (this.lag <= this.maxLag) {
+      return
+    }
+    if (this.overflow === 'drop-oldest') {
+      // the newest chunk always stays
+      while (this.lag > this.maxLag && this.queue.length > 1) {
+        const dropped = this.queue.shift()
+        this.queued -= dropped.length
+        this.dropped += dropped.length
+      }
+    } else if (this.overflow === 'disconnect') {
+      debug('disconnecting a subscriber', this.lag, 'bytes behind')
+      const err = new Error(`Subscriber fell more than ${this.maxLag} bytes behind`)
+      err.overflow = true
+      this.destroy(err)
+    }
+  }
+
+  // Ends once everything queued has been read
+  finish() {
+    this.ending = true
+    this.flushQueue()
+  }
+
+  flushQueue() {
+    while (this.wanted && this.queue.length > 0) {
+      const chunk = this.queue.shift()
+      this.queued -= chunk.length
+      this.wanted = this.push(chunk)
+    }
+    if (this.ending && this.queue.length === 0 && !this.destroyed) {
+      this.push(null)
+    }
+  }
+
+  /**
+   * @returns {object} `{ bytes, dropped, lag }`, bytes received and dropped over the life of the subscription and bytes waiting to be read
+   */
+  stats() {
+    return { bytes: this.bytes, dropped: this.dropped, lag: this.lag }
+  }
+
+  /**
+   * Stops receiving data, anything not read yet is dropped
+   */
+  unsubscribe() {
+    this.destroy()
+  }
+
+  _read() {
+    this.wanted = true
+    this.flushQueue()
+    if (this.overflow === 'block') {
+      this.port._subscriptionCaughtUp()
+    }
+  }
+
+  _destroy(err, callback) {
+    this.queue = []
+    this.queued = 0
+    this.port._unsubscribe(this)
+    callback(err)
+  }
+}
+
+module.exports = Subscription